@@ -1,10 +1,11 @@
 StructuredBuffer<uint3> in_tex : register(t0);
 RWTexture2D<float4> out_tex : register(u0);
 
+#include "scope_config.hlsli"
+
 [numthreads(8, 8, 1)]
 void main(uint3 DTid: SV_DispatchThreadID) {
-    // TEMP:
-    uint2 resolution = uint2(1024, 512);
+    uint2 resolution = uint2(wf_width, wf_buckets);
 
     uint2 out_res;
     out_tex.GetDimensions(out_res.x, out_res.y);
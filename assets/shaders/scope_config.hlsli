@@ -0,0 +1,13 @@
+// Resolutions of the scope accumulators, the same fields as scope_config_t in scope.h, whose
+// encoding picks a permutation of the passes instead (scope_encoding.hlsli), and the blur of the
+// vectorscope (renderer_set_scope_blur()).
+// The renderer updates it when the quality preset or the blur changes, every scope pass binds it at b1.
+cbuffer ScopeConfig : register(b1) {
+    uint vs_resolution;  // side of the square vectorscope accumulator
+    uint wf_width;       // columns of the waveform buffer
+    uint wf_buckets;     // rows of the waveform buffer, one per level
+    uint vs_zoom;        // magnification of the vectorscope around neutral, 1 to 8
+    uint vs_blur_shape;  // scope_blur_shape_t of scope_blur.h
+    uint vs_blur_radius; // 0 to SCOPE_BLUR_MAX_RADIUS, 0 leaves the bins as they are
+    uint2 scope_config_padding;
+};
@@ -0,0 +1,41 @@
+// Encoding the scopes measure in, the same as scope_encoding_t in scope.h. Every combination is
+// its own permutation of the passes, compiled with SCOPE_MATRIX (601, 709 or 2020) and
+// SCOPE_RANGE_LIMITED (0 or 1) defined, so the weights are literals and nothing is branched on.
+#ifndef SCOPE_MATRIX
+#define SCOPE_MATRIX 709
+#endif
+#ifndef SCOPE_RANGE_LIMITED
+#define SCOPE_RANGE_LIMITED 0
+#endif
+
+#if SCOPE_MATRIX == 601
+static const float3 RGB_to_Y = float3(0.299, 0.587, 0.114);
+static const float3 RGB_to_Cb_full = float3(-0.1687, -0.3313, 0.5);
+static const float3 RGB_to_Cr_full = float3(0.5, -0.4187, -0.0813);
+#elif SCOPE_MATRIX == 2020
+// Non-constant luminance
+static const float3 RGB_to_Y = float3(0.2627, 0.678, 0.0593);
+static const float3 RGB_to_Cb_full = float3(-0.1396, -0.3604, 0.5);
+static const float3 RGB_to_Cr_full = float3(0.5, -0.4598, -0.0402);
+#else
+static const float3 RGB_to_Y = float3(0.2126, 0.7152, 0.0722);
+static const float3 RGB_to_Cb_full = float3(-0.1146, -0.3854, 0.5);
+static const float3 RGB_to_Cr_full = float3(0.5, -0.4542, -0.0458);
+#endif
+
+// Y'CbCr -> R'G'B' of the matrix, from its luma weights like scope_ycbcr_inverse() in scope_internal.h
+static const float YCbCr_R_Cr = 2.0 * (1.0 - RGB_to_Y.r);
+static const float YCbCr_G_Cb = 2.0 * RGB_to_Y.b * (1.0 - RGB_to_Y.b) / RGB_to_Y.g;
+static const float YCbCr_G_Cr = 2.0 * RGB_to_Y.r * (1.0 - RGB_to_Y.r) / RGB_to_Y.g;
+static const float YCbCr_B_Cb = 2.0 * (1.0 - RGB_to_Y.b);
+
+// Limited range puts black at 16 and white at 235 of 255, Cb/Cr span 224 codes around 128
+#if SCOPE_RANGE_LIMITED
+static const float3 RGB_to_Cb = RGB_to_Cb_full * (224.0 / 255.0);
+static const float3 RGB_to_Cr = RGB_to_Cr_full * (224.0 / 255.0);
+#define SCOPE_LEVELS(v) ((v) * (219.0 / 255.0) + 16.0 / 255.0)
+#else
+static const float3 RGB_to_Cb = RGB_to_Cb_full;
+static const float3 RGB_to_Cr = RGB_to_Cr_full;
+#define SCOPE_LEVELS(v) (v)
+#endif
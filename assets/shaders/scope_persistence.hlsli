@@ -0,0 +1,42 @@
+// The fixed point of scope_persistence.c in the 32-bit words Shader Model 5 is limited to: a sum
+// is uint2(high, low) with PERSISTENCE_FRAC_BITS fractional bits, keep is 0.32 fixed point.
+// The persistence passes bind it at b0.
+cbuffer Persistence : register(b0) {
+    uint keep;  // scope_persistence_keep() of one frame, below 1
+    uint add;   // the hits are a new capture, otherwise they only receive the decayed sums
+    uint2 padding;
+};
+
+// SCOPE_PERSISTENCE_FRAC_BITS
+#define PERSISTENCE_FRAC_BITS 16
+
+// a * b as uint2(high, low), from products of the 16-bit halves
+uint2 mul_wide(uint a, uint b) {
+    uint ll = (a & 0xffff) * (b & 0xffff);
+    uint lh = (a & 0xffff) * (b >> 16);
+    uint hl = (a >> 16) * (b & 0xffff);
+    uint hh = (a >> 16) * (b >> 16);
+    uint mid = (ll >> 16) + (lh & 0xffff) + (hl & 0xffff);
+    return uint2(hh + (lh >> 16) + (hl >> 16) + (mid >> 16), (mid << 16) | (ll & 0xffff));
+}
+
+uint2 add_wide(uint2 a, uint2 b) {
+    uint low = a.y + b.y;
+    return uint2(a.x + b.x + (low < a.y ? 1 : 0), low);
+}
+
+// decay_sum() of the sum, then the hits on top
+uint2 persistence_step(uint2 sum, uint hits) {
+    uint2 s = add_wide(mul_wide(sum.x, keep), uint2(0, mul_wide(sum.y, keep).x));
+    if (add != 0) {
+        s = add_wide(s, uint2(hits >> (32 - PERSISTENCE_FRAC_BITS), hits << PERSISTENCE_FRAC_BITS));
+    }
+    return s;
+}
+
+// resolve_sum(), rounded to whole hits and saturated
+uint persistence_resolve(uint2 sum) {
+    uint2 s = add_wide(sum, uint2(0, 1u << (PERSISTENCE_FRAC_BITS - 1)));
+    if ((s.x >> (32 - PERSISTENCE_FRAC_BITS)) != 0) return 0xffffffff;
+    return (s.x << PERSISTENCE_FRAC_BITS) | (s.y >> (32 - PERSISTENCE_FRAC_BITS));
+}
@@ -1,14 +1,10 @@
 Texture2D<float4> input_tex : register(t0);
 RWTexture2D<uint> output_tex : register(u0);
 
-static const float PI = 3.1415926535897932384626433832795;
-
-static const int WIDTH = 1024;
-static const int HEIGHT = 1024;
-static const int CENTER = WIDTH / 2;
+#include "scope_config.hlsli"
+#include "scope_encoding.hlsli"
 
-static const float3 RGB_to_Cb = float3(-0.1146, -0.3854, 0.5);
-static const float3 RGB_to_Cr = float3(0.5, -0.4542, -0.0458);
+static const float PI = 3.1415926535897932384626433832795;
 
 [numthreads(8, 8, 1)]
 void main(uint3 DTid: SV_DispatchThreadID) {
@@ -24,10 +20,15 @@ void main(uint3 DTid: SV_DispatchThreadID) {
     float Cb = dot(rgb, RGB_to_Cb);
     float Cr = dot(rgb, RGB_to_Cr);
 
-    int x = int((Cb + 0.5) * WIDTH);
-    int y = int((Cr + 0.5) * HEIGHT);
+    // Bin into a grid vs_zoom times as fine and keep its centered window, so zooming shows real
+    // detail instead of enlarged bins. Everything outside the window fails the range test.
+    int size = int(vs_resolution);
+    float scale = float(vs_resolution * vs_zoom);
+    int offset = int((vs_zoom - 1) * vs_resolution / 2);
+    int x = int((Cb + 0.5) * scale) - offset;
+    int y = int((Cr + 0.5) * scale) - offset;
 
-    if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
+    if (x >= 0 && x < size && y >= 0 && y < size) {
         InterlockedAdd(output_tex[int2(x, y)], 1);
     }
 }
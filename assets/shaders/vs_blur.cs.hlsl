@@ -1,30 +1,142 @@
-Texture2D<uint> src : register(t0);
+// Blur of the vectorscope bins over the shape and radius of ScopeConfig, scope_blur_apply() on
+// the GPU. Each pass builds tables of running sums over the bins, padded with copies of the edges
+// so samples clamp at the edges, and takes 4 lookups per bin for a box and 8 for a diamond
+// whatever the radius:
+//   rows: prefix sums of every padded row, a thread per row
+//   scan: the summed-area table down the columns for a box, or running sums of the row prefix
+//         sums along both diagonals for a diamond, a thread per column or diagonal
+//   main: the sum over the shape around every bin, averaged into dst
+// A Gaussian is three box passes of the radii in BlurPass. The sums are uints: they wrap around
+// but the differences the lookups take are exact while the sum over the shape is below 2^32.
+// Between passes the box averages are rounded to uints, where the CPU keeps the exact sums.
+
+#include "scope_config.hlsli"
+
+#define SHAPE_DIAMOND 0 // SCOPE_BLUR_DIAMOND in scope_blur.h, box and Gaussian both sum boxes
+
+// Set by the renderer before each pass
+cbuffer BlurPass : register(b0) {
+    uint pass_radius; // the box or diamond of this pass, vs_blur_radius unless it is a Gaussian
+    uint last_pass;   // averages go to dst, otherwise to averages for the next pass
+    uint2 blur_pass_padding;
+};
+
+Texture2D<uint> src : register(t0);     // rows: the bins, or the averages of the pass before
+Texture2D<uint> prefix : register(t1);  // scan
+Texture2D<uint> table_a : register(t2); // main: box table, or down and to the right
+Texture2D<uint> table_d : register(t3); // main: down and to the left
+
 RWTexture2D<float> dst : register(u0);
+RWTexture2D<uint> prefix_out : register(u1);
+RWTexture2D<uint> table_a_out : register(u2);
+RWTexture2D<uint> table_d_out : register(u3);
+RWTexture2D<uint> averages : register(u4);
 
-#define TEXSIZE 1024
-#define RADIUS 2
+bool is_diamond() {
+    return vs_blur_shape == SHAPE_DIAMOND;
+}
 
-[numthreads(8, 8, 1)]
-void main(uint3 dtid: SV_DispatchThreadID) {
-    int2 coord = int2(dtid.xy);
-    if (coord.x >= TEXSIZE || coord.y >= TEXSIZE) return;
-
-    float result = 0.0;
-    int count = 0;
-
-    [unroll]
-    for (int y = -RADIUS; y <= RADIUS; ++y) {
-        [unroll]
-        for (int x = -RADIUS; x <= RADIUS; ++x) {
-            if (abs(x) + abs(y) <= RADIUS) {
-                int2 sample_coord = clamp(coord + int2(x, y), int2(0, 0), TEXSIZE - 1);
-                uint raw = src.Load(int3(sample_coord, 0));
-                result += float(raw);
-                count += 1;
-            }
+// Padding on every side, so every lookup stays inside the tables
+uint pad() {
+    return pass_radius + 1;
+}
+
+uint table_size() {
+    return vs_resolution + 2 * pad();
+}
+
+[numthreads(64, 1, 1)]
+void rows(uint3 dtid: SV_DispatchThreadID) {
+    const int size = int(table_size());
+    const int y = int(dtid.x);
+    if (y >= size) return;
+
+    const int last = int(vs_resolution) - 1;
+    const int source = clamp(y - int(pad()), 0, last);
+
+    uint run = 0;
+    for (int x = 0; x < size; ++x) {
+        run += src.Load(int3(clamp(x - int(pad()), 0, last), source, 0));
+        prefix_out[int2(x, y)] = run;
+    }
+}
+
+// Box: T(y, x) = P(y, x) + T(y - 1, x), a thread per column.
+// Diamond: A(y, x) = P(y, x) + A(y - 1, x - 1) along diagonals x - y = k - (size - 1), and
+// D(y, x) = P(y, x) + D(y - 1, x + 1) along x + y = k, a thread per diagonal of either table.
+// Terms off the table are 0.
+[numthreads(64, 1, 1)]
+void scan(uint3 dtid: SV_DispatchThreadID) {
+    const int size = int(table_size());
+    const int diagonals = 2 * size - 1;
+
+    if (!is_diamond()) {
+        const int x = int(dtid.x);
+        if (x >= size) return;
+
+        uint run = 0;
+        for (int y = 0; y < size; ++y) {
+            run += prefix.Load(int3(x, y, 0));
+            table_a_out[int2(x, y)] = run;
         }
+        return;
     }
-    dst[coord] = result / count;
+
+    const int k = int(dtid.x) % diagonals;
+    if (int(dtid.x) >= 2 * diagonals) return;
+
+    uint run = 0;
+    if (int(dtid.x) < diagonals) {
+        const int offset = k - (size - 1);
+        for (int y = max(0, -offset); y < size && y + offset < size; ++y) {
+            run += prefix.Load(int3(y + offset, y, 0));
+            table_a_out[int2(y + offset, y)] = run;
+        }
+    } else {
+        for (int y = max(0, k - (size - 1)); y < size && k - y >= 0; ++y) {
+            run += prefix.Load(int3(k - y, y, 0));
+            table_d_out[int2(k - y, y)] = run;
+        }
+    }
+}
+
+uint a_at(int y, int x) {
+    return table_a.Load(int3(x, y, 0));
 }
 
+uint d_at(int y, int x) {
+    return table_d.Load(int3(x, y, 0));
+}
 
+[numthreads(8, 8, 1)]
+void main(uint3 dtid: SV_DispatchThreadID) {
+    const int2 coord = int2(dtid.xy);
+    const int size = int(vs_resolution);
+    if (coord.x >= size || coord.y >= size) return;
+
+    const int r = int(pass_radius);
+    const int cx = coord.x + int(pad());
+    const int cy = coord.y + int(pad());
+
+    uint sum;
+    uint taps;
+    if (is_diamond()) {
+        // Upper and lower half of the right edge, minus those of the left edge, each a run of row
+        // prefix sums along a diagonal
+        sum = (a_at(cy, cx + r) - a_at(cy - r - 1, cx - 1)) +
+              (d_at(cy + r, cx) - d_at(cy, cx + r)) -
+              (d_at(cy, cx - r - 1) - d_at(cy - r - 1, cx)) -
+              (a_at(cy + r, cx - 1) - a_at(cy, cx - r - 1));
+        taps = 2 * pass_radius * pass_radius + 2 * pass_radius + 1;
+    } else {
+        sum = a_at(cy + r, cx + r) - a_at(cy - r - 1, cx + r) -
+              a_at(cy + r, cx - r - 1) + a_at(cy - r - 1, cx - r - 1);
+        taps = (2 * pass_radius + 1) * (2 * pass_radius + 1);
+    }
+
+    if (last_pass) {
+        dst[coord] = float(sum) / float(taps);
+    } else {
+        averages[coord] = (sum + taps / 2) / taps;
+    }
+}
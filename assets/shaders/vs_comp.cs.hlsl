@@ -7,14 +7,13 @@ cbuffer VSParams : register(b0) {
     float2 padding;
 };
 
+#include "scope_config.hlsli"
+#include "scope_encoding.hlsli"
+
 // Precompute skintone line direction
 static const float skintone_angle = radians(123.0);
 static const float2 skintone_dir = float2(cos(skintone_angle), sin(skintone_angle));
 
-// Vectors for RGB->YCbCr conversion
-static const float3 RGB_to_Cb = float3(-0.1146, -0.3854, 0.5);
-static const float3 RGB_to_Cr = float3(0.5, -0.4542, -0.0458);
-
 // Main colors -- used mainly for the boxes and their calculations
 static const float3 main_colors[6] = {
     float3(1.0, 0.0, 0.0), // Red
@@ -51,9 +50,9 @@ float3 ycbcr_to_rgb(float3 ycbcr) {
     float Cb = ycbcr.y;
     float Cr = ycbcr.z;
 
-    float r = Y + 1.402 * Cr;
-    float g = Y - 0.344136 * Cb - 0.714136 * Cr;
-    float b = Y + 1.772 * Cb;
+    float r = Y + YCbCr_R_Cr * Cr;
+    float g = Y - YCbCr_G_Cb * Cb - YCbCr_G_Cr * Cr;
+    float b = Y + YCbCr_B_Cb * Cb;
 
     return saturate(float3(r, g, b));
 }
@@ -102,7 +101,7 @@ void main(uint3 DTid: SV_DispatchThreadID) {
     // Boxes -- to indicate max saturation
     for (int i = 0; i < 6; ++i) {
         float2 cbcr = float2(dot(main_colors[i], RGB_to_Cb), dot(main_colors[i], RGB_to_Cr));
-        cbcr *= 2.0 * scope_scale;
+        cbcr *= 2.0 * scope_scale * vs_zoom;
         float outer_box = box_sdf(p, cbcr, float2(box_size, box_size));
         float inner_box = box_sdf(p, cbcr, float2(box_size - line_thickness * 2.0, box_size - line_thickness * 2.0));
         float box_dist = max(outer_box, -inner_box);
@@ -120,14 +119,13 @@ void main(uint3 DTid: SV_DispatchThreadID) {
     float2 scaled_sq_uv = (square_uv - 0.5) / scope_scale + 0.5;
     int2 texel = int2(scaled_sq_uv * texSize);
     float v = vs_blur_tex.Load(int3(texel, 0));
-    // HACK: Adding this as hardcoded for now, as this should be the resolution of the accumulator texture
-    // NOT the composite texture
-    float v_max = 1024.0 * 1024.0;
+    // The maximum is tied to the resolution of the accumulator texture, NOT the composite texture
+    float v_max = float(vs_resolution) * float(vs_resolution);
     float intensity = log(1.0 + v) / log(1.0 + v_max) * 8.0;
     
-    // Calculate how to color the current pixel
-    float Cb = square_uv.x - 0.5;
-    float Cr = square_uv.y - 0.5;
+    // Calculate how to color the current pixel, with the Cb/Cr the bins and boxes are placed at
+    float Cb = (square_uv.x - 0.5) / (scope_scale * vs_zoom);
+    float Cr = (square_uv.y - 0.5) / (scope_scale * vs_zoom);
     float3 ycbcr_color = float3(0.5, Cb, Cr);
     float3 rgb_color = ycbcr_to_rgb(ycbcr_color);
 
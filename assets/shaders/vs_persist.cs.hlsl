@@ -0,0 +1,17 @@
+RWTexture2D<uint> hits : register(u0);
+RWStructuredBuffer<uint2> sums : register(u1);
+
+#include "scope_config.hlsli"
+#include "scope_persistence.hlsli"
+
+// Decays the sum of every bin, adds the bin's hits for a new capture and leaves the resolved sum
+// in its place for the blur
+[numthreads(8, 8, 1)]
+void main(uint3 dtid: SV_DispatchThreadID) {
+    if (dtid.x >= vs_resolution || dtid.y >= vs_resolution) return;
+
+    uint i = dtid.y * vs_resolution + dtid.x;
+    uint2 sum = persistence_step(sums[i], hits[dtid.xy]);
+    sums[i] = sum;
+    hits[dtid.xy] = persistence_resolve(sum);
+}
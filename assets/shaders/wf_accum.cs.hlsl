@@ -33,9 +33,8 @@
 Texture2D<float4> input_tex : register(t0);
 RWStructuredBuffer<uint3> output_tex : register(u0);
 
-static const uint BUCKETS = 512;
-// TEMP: Hardcoding the output_tex's width here
-static const uint out_width = 1024;
+#include "scope_config.hlsli"
+#include "scope_encoding.hlsli"
 
 [numthreads(8, 8, 1)]
 void main(uint3 DTid : SV_DispatchThreadID) {
@@ -47,25 +46,26 @@ void main(uint3 DTid : SV_DispatchThreadID) {
     // Read and clamp pixel to 0–1 range
     float3 pixel = saturate(input_tex[uint2(DTid.x, DTid.y)].rgb);
 
-    // Calculate luma (rec.709 for now)
-    float luma = dot(pixel, float3(0.2126, 0.7152, 0.0722));
+    // Calculate luma with the matrix of the permutation, then move both to the levels of its range
+    float luma = SCOPE_LEVELS(dot(pixel, RGB_to_Y));
+    pixel = SCOPE_LEVELS(pixel);
 
     // Compute vertical bucket index for each channel
-    uint bucket_r = clamp((uint)(pixel.r * BUCKETS), 0, BUCKETS - 1);
-    uint bucket_g = clamp((uint)(pixel.g * BUCKETS), 0, BUCKETS - 1);
-    uint bucket_b = clamp((uint)(pixel.b * BUCKETS), 0, BUCKETS - 1);
-    uint bucket_l = clamp((uint)(luma * BUCKETS), 0, BUCKETS - 1);
+    uint bucket_r = clamp((uint)(pixel.r * wf_buckets), 0, wf_buckets - 1);
+    uint bucket_g = clamp((uint)(pixel.g * wf_buckets), 0, wf_buckets - 1);
+    uint bucket_b = clamp((uint)(pixel.b * wf_buckets), 0, wf_buckets - 1);
+    uint bucket_l = clamp((uint)(luma * wf_buckets), 0, wf_buckets - 1);
 
     // Compute range of output X pixels this input pixel maps to
-    float x_scale = float(out_width) / float(in_dim.x);
+    float x_scale = float(wf_width) / float(in_dim.x);
     float out_x_start = DTid.x * x_scale;
     float out_x_end   = (DTid.x + 1) * x_scale;
 
     for (uint x = (uint)floor(out_x_start); x < (uint)ceil(out_x_end); ++x) {
-        if (x < out_width) {
-            InterlockedAdd(output_tex[x + bucket_r * out_width].r, 1);
-            InterlockedAdd(output_tex[x + bucket_g * out_width].g, 1);
-            InterlockedAdd(output_tex[x + bucket_b * out_width].b, 1);
+        if (x < wf_width) {
+            InterlockedAdd(output_tex[x + bucket_r * wf_width].r, 1);
+            InterlockedAdd(output_tex[x + bucket_g * wf_width].g, 1);
+            InterlockedAdd(output_tex[x + bucket_b * wf_width].b, 1);
         }
     }
 }
@@ -1,6 +1,8 @@
 StructuredBuffer<uint3> in_tex : register(t0);
 RWTexture2D<float4> out_tex : register(u0);
 
+#include "scope_config.hlsli"
+
 static const float line_thickness = 0.002;
 static const float3 overlay_color = float3(0.71f, 0.57f, 0.16f) * 0.5;
 static const float scope_scale = 0.6;
@@ -15,8 +17,9 @@ float line_sdf(float2 p, float2 a, float2 b, float thickness) {
 
 [numthreads(8, 8, 1)]
 void main(uint3 DTid: SV_DispatchThreadID) {
-    // TEMP:
-    float2 resolution = float2(1024, 512);
+    uint2 out_res;
+    out_tex.GetDimensions(out_res.x, out_res.y);
+    float2 resolution = float2(out_res);
 
     uint2 pixel_coord = DTid.xy;
     if (pixel_coord.x >= resolution.x || pixel_coord.y >= resolution.y) return;
@@ -34,9 +37,14 @@ void main(uint3 DTid: SV_DispatchThreadID) {
     
     float3 overlay = overlay_alpha * overlay_color;
 
-    // Waveform scope
-    float3 color = in_tex[uint(DTid.x + DTid.y * resolution.x)];
-    float3 intensity = (log(1.0 + color) / log(1.0 + resolution.y)) * 1.25;
+    // Waveform scope, sampled like parade_comp when the buffer and the composite differ in size
+    uint2 input_uv = uint2(
+        uint((float(DTid.x) + 0.5f) * (float(wf_width) / resolution.x)),
+        uint((float(DTid.y) + 0.5f) * (float(wf_buckets) / resolution.y)));
+    input_uv = min(input_uv, uint2(wf_width, wf_buckets) - 1);
+
+    float3 color = in_tex[input_uv.x + input_uv.y * wf_width];
+    float3 intensity = (log(1.0 + color) / log(1.0 + float(wf_buckets))) * 1.25;
     // intensity = color / resolution.y * 8.0; // This replaces the line above (not sure which one I prefer yet)
 
     out_tex[pixel_coord] = float4(intensity + overlay, 1.0);
@@ -0,0 +1,22 @@
+RWStructuredBuffer<uint3> hits : register(u0);
+RWStructuredBuffer<uint2> sums : register(u1);
+
+#include "scope_config.hlsli"
+#include "scope_persistence.hlsli"
+
+// The same as vs_persist for the R, G and B counts of every waveform cell, with three sums each
+[numthreads(64, 1, 1)]
+void main(uint3 dtid: SV_DispatchThreadID) {
+    uint i = dtid.x;
+    if (i >= wf_width * wf_buckets) return;
+
+    uint3 cell = hits[i];
+    uint3 resolved;
+    [unroll]
+    for (uint c = 0; c < 3; ++c) {
+        uint2 sum = persistence_step(sums[i * 3 + c], cell[c]);
+        sums[i * 3 + c] = sum;
+        resolved[c] = persistence_resolve(sum);
+    }
+    hits[i] = resolved;
+}
@@ -0,0 +1,1605 @@
+// Micro benchmarks for the scope-core CPU passes.
+//
+// Usage: scope-bench [section...]
+// Without arguments every section runs. Frames are synthetic, so results are reproducible.
+
+#include "scope_blur.h"
+#include "scope_convert.h"
+#include "scope_cpu.h"
+#include "scope_hdr.h"
+#include "scope_incremental.h"
+#include "scope_multi.h"
+#include "scope_persistence.h"
+#include "scope_pyramid.h"
+#include "scope_render.h"
+#include "scope_source.h"
+#include "scope_synthetic.h"
+#include "scope_thread.h"
+#include "scope_tiles.h"
+#include "scope_vectorscope.h"
+#include "scope_waveform.h"
+
+#if SCOPE_ENABLE_X11
+#include "scope_source_x11.h"
+#endif
+
+#include "../src/macros.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_BENCH_SECONDS 0.5
+#define MAX_THREADS 64
+
+typedef struct bench_frame {
+    const char *name;
+    uint32_t width;
+    uint32_t height;
+    uint8_t *pixels;
+    scope_image_t image;
+} bench_frame_t;
+
+typedef void (*bench_fn)(void *user_data);
+
+typedef struct bench_section {
+    const char *name;
+    void (*run)(void);
+} bench_section_t;
+
+static bench_frame_t frames[] = {
+    {.name = "1080p", .width = 1920, .height = 1080},
+    {.name = "4K", .width = 3840, .height = 2160},
+    {.name = "8K", .width = 7680, .height = 4320},
+};
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng_next(void) {
+    // xorshift32, good enough for grain
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint8_t clamp_u8(int v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// Something resembling graded footage: a low saturation gradient with a warm blob and grain,
+// so most hits land in a small area of the vectorscope like they do with real images.
+static bool frame_generate(bench_frame_t *frame) {
+    frame->pixels = malloc((size_t)frame->width * frame->height * 4);
+    if (!frame->pixels) return false;
+
+    for (uint32_t y = 0; y < frame->height; ++y) {
+        uint8_t *px = frame->pixels + (size_t)y * frame->width * 4;
+        for (uint32_t x = 0; x < frame->width; ++x, px += 4) {
+            int base = (int)(40 + 160 * x / frame->width);
+            int dx = (int)x - (int)frame->width / 2;
+            int dy = (int)y - (int)frame->height / 2;
+            int warm = ((int64_t)dx * dx + (int64_t)dy * dy) < (int64_t)frame->height * frame->height / 9 ? 30 : 0;
+            int grain = (int)(rng_next() % 17) - 8;
+
+            px[0] = clamp_u8(base - warm + grain);                          // B
+            px[1] = clamp_u8(base + grain + (int)(y * 20 / frame->height)); // G
+            px[2] = clamp_u8(base + warm + grain);                          // R
+            px[3] = 255;
+        }
+    }
+
+    frame->image = (scope_image_t){
+        .data = frame->pixels,
+        .width = frame->width,
+        .height = frame->height,
+        .stride = frame->width * 4,
+        .format = SCOPE_PIXEL_FORMAT_BGRA8,
+    };
+    return true;
+}
+
+// Runs fn until at least MIN_BENCH_SECONDS passed and returns the average time of a call in ms
+static double bench_measure(bench_fn fn, void *user_data) {
+    fn(user_data); // warm up
+
+    uint32_t iterations = 0;
+    double start = scope_cpu_time_seconds();
+    double elapsed = 0.0;
+    do {
+        fn(user_data);
+        iterations++;
+        elapsed = scope_cpu_time_seconds() - start;
+    } while (elapsed < MIN_BENCH_SECONDS);
+
+    return elapsed * 1000.0 / iterations;
+}
+
+static void print_result(const char *label, const bench_frame_t *frame, double ms, double baseline_ms) {
+    double mpix = (double)frame->width * frame->height / (ms * 1000.0);
+    printf("  %-28s %-6s %9.3f ms %9.1f Mpix/s %6.2fx\n", label, frame->name, ms, mpix, baseline_ms / ms);
+}
+
+// Everything a measured call needs. `scope` points at the accumulator under test.
+struct scope_job {
+    void *scope;
+    const scope_image_t *image;
+    scope_thread_pool_t *pool;
+};
+
+static uint32_t bench_max_threads(void) {
+    uint32_t count = scope_cpu_core_count();
+    return count > MAX_THREADS ? MAX_THREADS : count;
+}
+
+// Powers of two, plus the exact core count
+static uint32_t next_thread_count(uint32_t threads, uint32_t max_threads) {
+    return (threads < max_threads && threads * 2 > max_threads) ? max_threads : threads * 2;
+}
+
+// Measures fn on every frame with pools of 1..N threads
+static void bench_thread_scaling(bench_fn fn, void *scope) {
+    uint32_t max_threads = bench_max_threads();
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        double baseline = 0.0;
+
+        for (uint32_t threads = 1; threads <= max_threads; threads = next_thread_count(threads, max_threads)) {
+            scope_thread_pool_t *pool = NULL;
+            if (!scope_thread_pool_create(threads, &pool)) break;
+
+            struct scope_job job = {.scope = scope, .image = &frames[f].image, .pool = pool};
+            double ms = bench_measure(fn, &job);
+            if (threads == 1) baseline = ms;
+
+            char label[32];
+            snprintf(label, sizeof(label), "%u thread(s)", threads);
+            print_result(label, &frames[f], ms, baseline);
+
+            scope_thread_pool_destroy(pool);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Vectorscope kernels per ISA
+// ---------------------------------------------------------------------------
+static void vs_single(void *user_data) {
+    struct scope_job *job = user_data;
+    scope_vectorscope_clear(job->scope);
+    scope_vectorscope_accumulate(job->scope, job->image);
+}
+
+static void vs_parallel(void *user_data) {
+    struct scope_job *job = user_data;
+    scope_vectorscope_clear(job->scope);
+    scope_vectorscope_accumulate_parallel(job->scope, job->image, job->pool);
+}
+
+static void section_isa(void) {
+    scope_vectorscope_t vs;
+    if (!scope_vectorscope_create(&vs)) return;
+
+    vs.kernel = SCOPE_KERNEL_FLOAT;
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        struct scope_job job = {.scope = &vs, .image = &frames[f].image};
+        double baseline = 0.0;
+
+        for (int isa = SCOPE_ISA_SCALAR; isa < SCOPE_ISA_COUNT; ++isa) {
+            if (!scope_cpu_supports((scope_isa_t)isa)) continue;
+
+            vs.isa = (scope_isa_t)isa;
+            double ms = bench_measure(vs_single, &job);
+            if (isa == SCOPE_ISA_SCALAR) baseline = ms;
+            print_result(scope_isa_name((scope_isa_t)isa), &frames[f], ms, baseline);
+        }
+    }
+
+    scope_vectorscope_destroy(&vs);
+}
+
+// ---------------------------------------------------------------------------
+// Parallel vectorscope scaling
+// ---------------------------------------------------------------------------
+static void section_threads(void) {
+    scope_vectorscope_t vs;
+    if (!scope_vectorscope_create(&vs)) return;
+
+    bench_thread_scaling(vs_parallel, &vs);
+    scope_vectorscope_destroy(&vs);
+}
+
+// ---------------------------------------------------------------------------
+// Column partitioned waveform scaling
+// ---------------------------------------------------------------------------
+static void wf_parallel(void *user_data) {
+    struct scope_job *job = user_data;
+    scope_waveform_clear(job->scope);
+    scope_waveform_accumulate_parallel(job->scope, job->image, job->pool);
+}
+
+static void section_waveform(void) {
+    scope_waveform_t wf;
+    if (!scope_waveform_create(&wf)) return;
+
+    bench_thread_scaling(wf_parallel, &wf);
+    scope_waveform_destroy(&wf);
+}
+
+// ---------------------------------------------------------------------------
+// Float vs lookup table kernels
+// ---------------------------------------------------------------------------
+static void wf_single(void *user_data) {
+    struct scope_job *job = user_data;
+    scope_waveform_clear(job->scope);
+    scope_waveform_accumulate(job->scope, job->image);
+}
+
+static void section_lut(void) {
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_vectorscope_create(&vs)) return;
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        struct scope_job vs_job = {.scope = &vs, .image = &frames[f].image};
+        struct scope_job wf_job = {.scope = &wf, .image = &frames[f].image};
+        char label[32];
+
+        vs.kernel = SCOPE_KERNEL_FLOAT;
+        double vs_float = bench_measure(vs_single, &vs_job);
+        snprintf(label, sizeof(label), "vectorscope float (%s)", scope_isa_name(vs.isa));
+        print_result(label, &frames[f], vs_float, vs_float);
+
+        vs.kernel = SCOPE_KERNEL_LUT;
+        print_result("vectorscope lut", &frames[f], bench_measure(vs_single, &vs_job), vs_float);
+
+        wf.kernel = SCOPE_KERNEL_FLOAT;
+        double wf_float = bench_measure(wf_single, &wf_job);
+        print_result("waveform float", &frames[f], wf_float, wf_float);
+
+        wf.kernel = SCOPE_KERNEL_LUT;
+        print_result("waveform lut", &frames[f], bench_measure(wf_single, &wf_job), wf_float);
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+}
+
+// ---------------------------------------------------------------------------
+// Budgeted sampling: cost and error against the full resolution histogram
+// ---------------------------------------------------------------------------
+struct sampled_job {
+    scope_vectorscope_t *vs;
+    scope_waveform_t *wf;
+    const scope_image_t *image;
+    scope_sampling_t sampling;
+};
+
+static void sampled_accumulate(void *user_data) {
+    struct sampled_job *job = user_data;
+    scope_vectorscope_clear(job->vs);
+    scope_waveform_clear(job->wf);
+    scope_vectorscope_accumulate_sampled(job->vs, job->image, &job->sampling);
+    scope_waveform_accumulate_sampled(job->wf, job->image, &job->sampling);
+}
+
+static void section_sampling(void) {
+    static const uint32_t budget_percent[] = {100, 25, 10, 5, 1};
+    static const char *pattern_names[] = {"stratified", "halton"};
+
+    scope_vectorscope_t vs, vs_ref;
+    scope_waveform_t wf, wf_ref;
+    if (!scope_vectorscope_create(&vs) || !scope_vectorscope_create(&vs_ref) ||
+        !scope_waveform_create(&wf) || !scope_waveform_create(&wf_ref)) {
+        return;
+    }
+
+    const size_t vs_bins = (size_t)vs.resolution * vs.resolution;
+    const size_t wf_bins = (size_t)wf.width * wf.buckets * SCOPE_WF_CHANNEL_COUNT;
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        const bench_frame_t *frame = &frames[f];
+        uint32_t pixel_count = frame->width * frame->height;
+
+        scope_vectorscope_accumulate(&vs_ref, &frame->image);
+        scope_waveform_accumulate(&wf_ref, &frame->image);
+
+        double baseline = 0.0;
+        for (uint32_t p = 0; p < ARRAY_LENGTH(pattern_names); ++p) {
+            for (uint32_t b = 0; b < ARRAY_LENGTH(budget_percent); ++b) {
+                struct sampled_job job = {
+                    .vs = &vs,
+                    .wf = &wf,
+                    .image = &frame->image,
+                    .sampling = {
+                        .budget = budget_percent[b] == 100 ? 0 : (uint32_t)((uint64_t)pixel_count * budget_percent[b] / 100),
+                        .pattern = (scope_sample_pattern_t)p,
+                    },
+                };
+
+                double ms = bench_measure(sampled_accumulate, &job);
+                if (baseline == 0.0) baseline = ms;
+
+                // Error of the last measured frame
+                double vs_error = scope_histogram_error(vs_ref.bins, vs.bins, vs_bins);
+                double wf_error = scope_histogram_error(wf_ref.channels[0], wf.channels[0], wf_bins);
+
+                char label[32];
+                snprintf(label, sizeof(label), "%s %u%%", pattern_names[p], budget_percent[b]);
+                print_result(label, frame, ms, baseline);
+                printf("  %-28s        L1 error vs %.4f, wf %.4f\n", "", vs_error, wf_error);
+            }
+        }
+
+        scope_vectorscope_clear(&vs_ref);
+        scope_waveform_clear(&wf_ref);
+    }
+
+    scope_waveform_destroy(&wf_ref);
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs_ref);
+    scope_vectorscope_destroy(&vs);
+}
+
+// ---------------------------------------------------------------------------
+// Persistence: cost of a decaying frame with and without a new capture
+// ---------------------------------------------------------------------------
+struct persistence_job {
+    scope_vectorscope_t *vs;
+    scope_persistence_t *persistence;
+    const scope_image_t *image;
+};
+
+static void persistence_new_frame(void *user_data) {
+    struct persistence_job *job = user_data;
+    scope_vectorscope_clear(job->vs);
+    scope_vectorscope_accumulate(job->vs, job->image);
+    scope_persistence_add_vectorscope(job->persistence, job->vs);
+}
+
+static void persistence_no_frame(void *user_data) {
+    struct persistence_job *job = user_data;
+    scope_persistence_decay_vectorscope(job->persistence, job->vs, 1.0f);
+}
+
+static void section_persistence(void) {
+    scope_vectorscope_t vs;
+    scope_persistence_t persistence;
+    if (!scope_vectorscope_create(&vs)) return;
+    if (!scope_persistence_create(&persistence, 0, 30.0f)) {
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        struct scope_job vs_job = {.scope = &vs, .image = &frames[f].image};
+        struct persistence_job job = {.vs = &vs, .persistence = &persistence, .image = &frames[f].image};
+
+        double baseline = bench_measure(vs_single, &vs_job);
+        print_result("vectorscope, cleared", &frames[f], baseline, baseline);
+        print_result("vectorscope, persistent", &frames[f], bench_measure(persistence_new_frame, &job), baseline);
+
+        // Only the tiles of the trails are visited. A half-life of a million frames keeps them
+        // over the whole run, so every call decays all of them.
+        persistence.half_life = 1e6f;
+        print_result("decay only (no capture)", &frames[f], bench_measure(persistence_no_frame, &job), baseline);
+        persistence.half_life = 30.0f;
+        scope_persistence_clear(&persistence);
+    }
+
+    scope_persistence_destroy(&persistence);
+    scope_vectorscope_destroy(&vs);
+}
+
+// ---------------------------------------------------------------------------
+// Dirty rect updates against full rebuilds, both including frame generation
+// ---------------------------------------------------------------------------
+struct incremental_job {
+    scope_synthetic_source_t *source;
+    scope_incremental_t *inc;
+};
+
+static void incremental_frame(void *user_data) {
+    struct incremental_job *job = user_data;
+    scope_synthetic_next(job->source);
+    scope_incremental_update(job->inc, &job->source->image, job->source->dirty, job->source->dirty_count);
+}
+
+static void rebuild_frame(void *user_data) {
+    struct incremental_job *job = user_data;
+    scope_synthetic_next(job->source);
+    scope_vectorscope_clear(job->inc->vs);
+    scope_vectorscope_accumulate(job->inc->vs, &job->source->image);
+    scope_waveform_clear(job->inc->wf);
+    scope_waveform_accumulate(job->inc->wf, &job->source->image);
+}
+
+static void section_incremental(void) {
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_vectorscope_create(&vs)) return;
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+
+    for (uint32_t f = 0; f < 2; ++f) {
+        const bench_frame_t *frame = &frames[f];
+        const uint32_t w = frame->width;
+        const uint32_t h = frame->height;
+
+        // Blinking cursor, a window playing video, and most of the screen scrolling
+        const scope_synthetic_change_t cursor[] = {
+            {.frame = 0, .rect = {w / 3, h / 3, 2, 24}, .seed = 1},
+            {.frame = 1, .rect = {w / 3, h / 3, 2, 24}, .seed = 0},
+        };
+        const scope_synthetic_change_t video[] = {
+            {.frame = 0, .rect = {w / 4, h / 4, w / 4, h / 4}, .seed = 1},
+            {.frame = 1, .rect = {w / 4, h / 4, w / 4, h / 4}, .seed = 2},
+        };
+        const scope_synthetic_change_t scroll[] = {
+            {.frame = 0, .rect = {0, h / 8, w, h * 5 / 8}, .seed = 1},
+            {.frame = 1, .rect = {0, h / 8, w, h * 5 / 8}, .seed = 2},
+        };
+        const struct {
+            const char *name;
+            const scope_synthetic_change_t *script;
+        } scenarios[] = {{"cursor", cursor}, {"video 6%", video}, {"scroll 62%", scroll}};
+
+        for (uint32_t i = 0; i < ARRAY_LENGTH(scenarios); ++i) {
+            scope_synthetic_source_t source;
+            scope_incremental_t inc;
+            if (!scope_synthetic_create(&source, w, h, SCOPE_PIXEL_FORMAT_BGRA8, scenarios[i].script, 2, 2)) break;
+            scope_incremental_create(&inc, &vs, &wf);
+
+            struct incremental_job job = {.source = &source, .inc = &inc};
+            char label[32];
+
+            double baseline = bench_measure(rebuild_frame, &job);
+            snprintf(label, sizeof(label), "%s, rebuild", scenarios[i].name);
+            print_result(label, frame, baseline, baseline);
+
+            double ms = bench_measure(incremental_frame, &job);
+            snprintf(label, sizeof(label), "%s, %s", scenarios[i].name, inc.rebuilt ? "fallback" : "dirty rects");
+            print_result(label, frame, ms, baseline);
+
+            scope_incremental_destroy(&inc);
+            scope_synthetic_destroy(&source);
+        }
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+}
+
+// ---------------------------------------------------------------------------
+// Full analysis of every frame fed through a frame source
+// ---------------------------------------------------------------------------
+struct source_job {
+    scope_source_t *source;
+    scope_image_t image; // for feeding the scopes directly
+    scope_vectorscope_t *vs;
+    scope_waveform_t *wf;
+    scope_thread_pool_t *pool;
+};
+
+static void direct_frame(void *user_data) {
+    struct source_job *job = user_data;
+    job->image.generation++;
+    scope_vectorscope_update(job->vs, &job->image, job->pool);
+    scope_waveform_update(job->wf, &job->image, job->pool);
+}
+
+static void source_frame(void *user_data) {
+    struct source_job *job = user_data;
+    scope_frame_t frame;
+    if (scope_source_acquire(job->source, 0, &frame) != SCOPE_ACQUIRE_OK) return;
+
+    scope_vectorscope_update(job->vs, &frame.image, job->pool);
+    scope_waveform_update(job->wf, &frame.image, job->pool);
+    scope_source_release(job->source);
+}
+
+static void section_sources(void) {
+    scope_thread_pool_t *pool = NULL;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_thread_pool_create(0, &pool)) return;
+    if (!scope_vectorscope_create(&vs)) {
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+
+    printf("  vectorscope + waveform, %u threads\n", scope_thread_pool_size(pool));
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        const bench_frame_t *frame = &frames[f];
+        struct source_job job = {.image = frame->image, .vs = &vs, .wf = &wf, .pool = pool};
+
+        double baseline = bench_measure(direct_frame, &job);
+        print_result("direct", frame, baseline, baseline);
+
+        if (scope_source_memory_create(&frame->image, 1, 0, 60.0, &job.source)) {
+            double ms = bench_measure(source_frame, &job);
+            print_result("memory source", frame, ms, baseline);
+            scope_source_destroy(job.source);
+        }
+
+        // Regenerates the whole frame every time, so this includes writing the pixels
+        const scope_synthetic_change_t noise[] = {{.frame = 0, .rect = {0, 0, frame->width, frame->height}, .seed = 1}};
+        if (scope_source_synthetic_create(frame->width, frame->height, SCOPE_PIXEL_FORMAT_BGRA8, noise, 1, 1, 0, 60.0, &job.source)) {
+            double ms = bench_measure(source_frame, &job);
+            print_result("synthetic source, full", frame, ms, baseline);
+            scope_source_destroy(job.source);
+        }
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Y'CbCr frames scoped from their planes, against the same frame as BGRA
+// ---------------------------------------------------------------------------
+
+// Rec.709 limited range 4:2:0 copy of a bench frame, chroma taken from the top left pixel of
+// each 2x2 block. 10-bit formats store the 8-bit codes scaled up.
+static bool frame_to_ycbcr(const bench_frame_t *frame, scope_pixel_format_t format, uint8_t **buffer, scope_image_t *image) {
+    const uint32_t width = frame->width;
+    const uint32_t height = frame->height;
+    const uint32_t chroma_width = (width + 1) / 2;
+    const uint32_t chroma_height = (height + 1) / 2;
+    const bool deep = format != SCOPE_PIXEL_FORMAT_YUV420P && format != SCOPE_PIXEL_FORMAT_NV12;
+    const bool interleaved = format == SCOPE_PIXEL_FORMAT_NV12 || format == SCOPE_PIXEL_FORMAT_P010;
+    const uint32_t sample_bytes = deep ? 2 : 1;
+    const size_t luma_size = (size_t)width * height * sample_bytes;
+
+    *buffer = malloc(luma_size + (size_t)chroma_width * chroma_height * 2 * sample_bytes);
+    if (!*buffer) return false;
+
+    *image = (scope_image_t){
+        .data = *buffer,
+        .width = width,
+        .height = height,
+        .stride = width * sample_bytes,
+        .format = format,
+        .chroma = {*buffer + luma_size, interleaved ? NULL : *buffer + luma_size + (size_t)chroma_width * chroma_height * sample_bytes},
+        .chroma_stride = chroma_width * sample_bytes * (interleaved ? 2 : 1),
+        .range = SCOPE_COLOR_RANGE_LIMITED,
+    };
+
+    // P010 keeps its 10 bits at the top of the 16-bit sample
+    const uint32_t shift = format == SCOPE_PIXEL_FORMAT_P010 ? 8 : (deep ? 2 : 0);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const uint8_t *px = frame->pixels + ((size_t)y * width + x) * 4;
+            float r = px[2] / 255.0f, g = px[1] / 255.0f, b = px[0] / 255.0f;
+            uint32_t codes[3] = {
+                (uint32_t)(16.5f + 219.0f * (SCOPE_LUMA_R * r + SCOPE_LUMA_G * g + SCOPE_LUMA_B * b)),
+                (uint32_t)(128.5f + 224.0f * (SCOPE_RGB_TO_CB_R * r + SCOPE_RGB_TO_CB_G * g + SCOPE_RGB_TO_CB_B * b)),
+                (uint32_t)(128.5f + 224.0f * (SCOPE_RGB_TO_CR_R * r + SCOPE_RGB_TO_CR_G * g + SCOPE_RGB_TO_CR_B * b)),
+            };
+
+            uint8_t *out[3] = {(uint8_t *)image->data + (size_t)y * image->stride + (size_t)x * sample_bytes, NULL, NULL};
+            if ((x & 1) == 0 && (y & 1) == 0) {
+                size_t row = (size_t)(y / 2) * image->chroma_stride;
+                out[1] = (uint8_t *)image->chroma[0] + row + (size_t)(x / 2) * sample_bytes * (interleaved ? 2 : 1);
+                out[2] = interleaved ? out[1] + sample_bytes : (uint8_t *)image->chroma[1] + row + (size_t)(x / 2) * sample_bytes;
+            }
+
+            for (uint32_t c = 0; c < 3; ++c) {
+                if (!out[c]) continue;
+                if (deep) {
+                    uint32_t v = codes[c] << shift;
+                    out[c][0] = (uint8_t)v;
+                    out[c][1] = (uint8_t)(v >> 8);
+                } else {
+                    out[c][0] = (uint8_t)codes[c];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static void section_ycbcr(void) {
+    scope_thread_pool_t *pool = NULL;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_thread_pool_create(0, &pool)) return;
+    if (!scope_vectorscope_create(&vs)) {
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+
+    const struct {
+        const char *label;
+        scope_pixel_format_t format;
+    } formats[] = {
+        {"yuv420p", SCOPE_PIXEL_FORMAT_YUV420P},
+        {"nv12", SCOPE_PIXEL_FORMAT_NV12},
+        {"yuv420p10", SCOPE_PIXEL_FORMAT_YUV420P10},
+        {"p010", SCOPE_PIXEL_FORMAT_P010},
+    };
+
+    printf("  vectorscope + waveform, %u threads, lut kernel for bgra\n", scope_thread_pool_size(pool));
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        const bench_frame_t *frame = &frames[f];
+        struct source_job job = {.image = frame->image, .vs = &vs, .wf = &wf, .pool = pool};
+
+        double baseline = bench_measure(direct_frame, &job);
+        print_result("bgra8", frame, baseline, baseline);
+
+        for (uint32_t i = 0; i < ARRAY_LENGTH(formats); ++i) {
+            uint8_t *buffer;
+            if (!frame_to_ycbcr(frame, formats[i].format, &buffer, &job.image)) continue;
+
+            double ms = bench_measure(direct_frame, &job);
+            print_result(formats[i].label, frame, ms, baseline);
+            free(buffer);
+        }
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Frames box filtered to a fixed analysis size before the scopes see them
+// ---------------------------------------------------------------------------
+#define PYRAMID_WIDTH 960
+#define PYRAMID_HEIGHT 540
+
+struct pyramid_job {
+    scope_pyramid_t *pyramid;
+    scope_image_t image;
+    uint32_t level;
+    bool scopes; // also run the scopes on the level, not only the reduction
+    scope_vectorscope_t *vs;
+    scope_waveform_t *wf;
+    scope_thread_pool_t *pool;
+};
+
+static void pyramid_frame(void *user_data) {
+    struct pyramid_job *job = user_data;
+    job->image.generation++;
+    scope_pyramid_update(job->pyramid, &job->image, job->pool);
+    if (!job->scopes) return;
+
+    const scope_image_t *level = scope_pyramid_level(job->pyramid, job->level);
+    scope_vectorscope_update(job->vs, level, job->pool);
+    scope_waveform_update(job->wf, level, job->pool);
+}
+
+static void section_pyramid(void) {
+    scope_thread_pool_t *pool = NULL;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_thread_pool_create(0, &pool)) return;
+    if (!scope_vectorscope_create(&vs)) {
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+
+    printf("  vectorscope + waveform, %u threads, analysis size %ux%u\n", scope_thread_pool_size(pool), PYRAMID_WIDTH, PYRAMID_HEIGHT);
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        const bench_frame_t *frame = &frames[f];
+        struct source_job direct = {.image = frame->image, .vs = &vs, .wf = &wf, .pool = pool};
+
+        double baseline = bench_measure(direct_frame, &direct);
+        print_result("full size", frame, baseline, baseline);
+
+        scope_pyramid_t pyramid;
+        scope_pyramid_create(&pyramid, PYRAMID_WIDTH, PYRAMID_HEIGHT, 3);
+        struct pyramid_job job = {.pyramid = &pyramid, .image = frame->image, .vs = &vs, .wf = &wf, .pool = pool};
+
+        for (uint32_t isa = 0; isa < SCOPE_ISA_COUNT; ++isa) {
+            if (!scope_cpu_supports((scope_isa_t)isa)) continue;
+
+            char label[64];
+            snprintf(label, sizeof(label), "reduce only, %s", scope_isa_name((scope_isa_t)isa));
+            pyramid.isa = (scope_isa_t)isa;
+            double ms = bench_measure(pyramid_frame, &job);
+            print_result(label, frame, ms, baseline);
+        }
+
+        pyramid.isa = scope_cpu_best_isa();
+        job.scopes = true;
+        for (job.level = 0; job.level < pyramid.level_count; ++job.level) {
+            const scope_image_t *level = scope_pyramid_level(&pyramid, job.level);
+
+            char label[64];
+            snprintf(label, sizeof(label), "reduce + scopes, %ux%u", level->width, level->height);
+            double ms = bench_measure(pyramid_frame, &job);
+            print_result(label, frame, ms, baseline);
+        }
+
+        scope_pyramid_destroy(&pyramid);
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Capture on a producer thread, the scopes never waiting for a frame
+// ---------------------------------------------------------------------------
+
+// A render loop iteration: scopes the newest frame if there is one, otherwise moves on
+static void async_frame(void *user_data) {
+    struct source_job *job = user_data;
+    scope_frame_t frame;
+    if (scope_source_acquire(job->source, 0, &frame) != SCOPE_ACQUIRE_OK) return;
+
+    scope_vectorscope_update(job->vs, &frame.image, job->pool);
+    scope_waveform_update(job->wf, &frame.image, job->pool);
+    scope_source_release(job->source);
+}
+
+// Runs the render loop for at least MIN_BENCH_SECONDS and returns the average time between scoped frames in ms
+static double async_measure(struct source_job *job) {
+    scope_async_stats_t stats;
+    scope_source_async_stats(job->source, &stats);
+    const uint64_t scoped = stats.scoped;
+
+    double start = scope_cpu_time_seconds();
+    double elapsed = 0.0;
+    do {
+        uint64_t before = stats.scoped;
+        async_frame(job);
+        scope_source_async_stats(job->source, &stats);
+        if (stats.scoped == before) {
+            scope_thread_sleep_ms(1); // the rest of the render loop, instead of spinning
+        }
+        elapsed = scope_cpu_time_seconds() - start;
+    } while (elapsed < MIN_BENCH_SECONDS || stats.scoped < scoped + 2);
+
+    return elapsed * 1000.0 / (double)(stats.scoped - scoped);
+}
+
+static void section_async(void) {
+    scope_thread_pool_t *pool = NULL;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_thread_pool_create(0, &pool)) return;
+    if (!scope_vectorscope_create(&vs)) {
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+
+    printf("  synthetic source regenerating the whole frame, vectorscope + waveform, %u threads\n", scope_thread_pool_size(pool));
+
+    // 1080p and 4K
+    for (uint32_t f = 0; f < 2; ++f) {
+        const bench_frame_t *frame = &frames[f];
+        const scope_synthetic_change_t noise[] = {{.frame = 0, .rect = {0, 0, frame->width, frame->height}, .seed = 1}};
+        struct source_job job = {.vs = &vs, .wf = &wf, .pool = pool};
+
+        if (!scope_source_synthetic_create(frame->width, frame->height, SCOPE_PIXEL_FORMAT_BGRA8, noise, 1, 1, 0, 60.0, &job.source)) continue;
+        double baseline = bench_measure(source_frame, &job);
+        print_result("capture, then scopes", frame, baseline, baseline);
+        scope_source_destroy(job.source);
+
+        if (!scope_source_synthetic_create(frame->width, frame->height, SCOPE_PIXEL_FORMAT_BGRA8, noise, 1, 1, 0, 60.0, &job.source)) continue;
+        if (!scope_source_async_create(job.source, &job.source)) continue;
+        double ms = async_measure(&job);
+        print_result("async, per scoped frame", frame, ms, baseline);
+
+        scope_async_stats_t stats;
+        scope_source_async_stats(job.source, &stats);
+        printf("  %-28s %-6s %llu captured, %llu dropped, %llu scoped, latency %.2f ms mean %.2f ms max\n", "", frame->name,
+               (unsigned long long)stats.captured, (unsigned long long)stats.dropped, (unsigned long long)stats.scoped,
+               stats.latency_mean * 1000.0, stats.latency_max * 1000.0);
+        scope_source_destroy(job.source);
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Several sources scoped at once, e.g. every monitor of a multi-display setup
+// ---------------------------------------------------------------------------
+#define MULTI_MAX_SOURCES 8
+
+struct multi_job {
+    scope_multi_t *multi;
+    scope_thread_pool_t *pool;
+};
+
+static void multi_frame(void *user_data) {
+    struct multi_job *job = user_data;
+    scope_multi_update(job->multi, 0, job->pool);
+}
+
+static void section_multi(void) {
+    scope_thread_pool_t *pool = NULL;
+    if (!scope_thread_pool_create(0, &pool)) return;
+
+    printf("  memory sources, every frame fully dirty, vectorscope + waveform, %u threads\n", scope_thread_pool_size(pool));
+
+    // 1080p and 4K
+    for (uint32_t f = 0; f < 2; ++f) {
+        const bench_frame_t *frame = &frames[f];
+        double single = 0.0;
+
+        for (uint32_t count = 1; count <= MULTI_MAX_SOURCES; count *= 2) {
+            scope_source_t *sources[MULTI_MAX_SOURCES];
+            uint32_t created = 0;
+            for (; created < count; ++created) {
+                if (!scope_source_memory_create(&frame->image, 1, 0, 60.0, &sources[created])) break;
+            }
+
+            scope_multi_t multi;
+            if (created < count) {
+                for (uint32_t i = 0; i < created; ++i) {
+                    scope_source_destroy(sources[i]);
+                }
+                continue;
+            }
+            if (!scope_multi_create(&multi, sources, count)) continue;
+
+            struct multi_job job = {.multi = &multi, .pool = pool};
+            double ms = bench_measure(multi_frame, &job);
+            if (count == 1) single = ms;
+
+            // Time per source, against a single one
+            char label[64];
+            snprintf(label, sizeof(label), "%u source%s, per source", count, count > 1 ? "s" : "");
+            print_result(label, frame, ms / count, single);
+            scope_multi_destroy(&multi);
+        }
+    }
+
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Tile hashing to find the regions that changed, against scoping the whole frame
+// ---------------------------------------------------------------------------
+struct tiles_job {
+    scope_tiles_t *tiles;
+    scope_image_t image;
+    scope_thread_pool_t *pool;
+};
+
+static void tiles_frame(void *user_data) {
+    struct tiles_job *job = user_data;
+    job->image.generation++;
+    scope_tiles_update(job->tiles, &job->image, job->pool);
+}
+
+static void section_tiles(void) {
+    scope_thread_pool_t *pool = NULL;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_thread_pool_create(0, &pool)) return;
+    if (!scope_vectorscope_create(&vs)) {
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+
+    printf("  %ux%u tiles against vectorscope + waveform, %u threads\n", SCOPE_TILE_SIZE, SCOPE_TILE_SIZE, scope_thread_pool_size(pool));
+
+    scope_tiles_t *tiles = malloc(sizeof(scope_tiles_t));
+    if (tiles) {
+        scope_tiles_create(tiles);
+
+        for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+            const bench_frame_t *frame = &frames[f];
+            struct source_job direct = {.image = frame->image, .vs = &vs, .wf = &wf, .pool = pool};
+
+            double baseline = bench_measure(direct_frame, &direct);
+            print_result("full accumulation", frame, baseline, baseline);
+
+            // The same pixels every time, so these are the comparisons that find nothing changed
+            struct tiles_job job = {.tiles = tiles, .image = frame->image, .pool = pool};
+            for (uint32_t isa = 0; isa < SCOPE_ISA_COUNT; ++isa) {
+                if (!scope_cpu_supports((scope_isa_t)isa)) continue;
+
+                char label[64];
+                snprintf(label, sizeof(label), "hash tiles, %s", scope_isa_name((scope_isa_t)isa));
+                tiles->isa = (scope_isa_t)isa;
+                double ms = bench_measure(tiles_frame, &job);
+                print_result(label, frame, ms, baseline);
+            }
+            tiles->isa = scope_cpu_best_isa();
+        }
+
+        scope_tiles_destroy(tiles);
+        free(tiles);
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// HDR frames binned at full range by signal, against the same frame as BGRA
+// ---------------------------------------------------------------------------
+
+// HDR copy of a bench frame: code values read as 2.2 gamma and scaled up to 4x scRGB white
+// (320 nits) as linear half floats, or PQ encoded into 10-bit codes
+static bool frame_to_hdr(const bench_frame_t *frame, scope_pixel_format_t format, uint8_t **buffer, scope_image_t *image) {
+    const uint32_t pixel_bytes = scope_pixel_format_bytes(format);
+    const size_t pixel_count = (size_t)frame->width * frame->height;
+    *buffer = malloc(pixel_count * pixel_bytes);
+    if (!*buffer) return false;
+
+    *image = (scope_image_t){
+        .data = *buffer,
+        .width = frame->width,
+        .height = frame->height,
+        .stride = frame->width * pixel_bytes,
+        .format = format,
+        .transfer = format == SCOPE_PIXEL_FORMAT_RGBA16F ? SCOPE_TRANSFER_LINEAR : SCOPE_TRANSFER_PQ,
+    };
+
+    // Only 256 distinct values per channel
+    float linear[256];
+    float pq[256];
+    for (uint32_t v = 0; v < 256; ++v) {
+        linear[v] = powf(v / 255.0f, 2.2f) * 4.0f;
+        pq[v] = scope_transfer_signal(SCOPE_TRANSFER_PQ, linear[v] * SCOPE_SCRGB_WHITE_NITS);
+    }
+
+    float *values = malloc(pixel_count * 3 * sizeof(float));
+    if (!values) {
+        free(*buffer);
+        return false;
+    }
+    const float *table = format == SCOPE_PIXEL_FORMAT_RGBA16F ? linear : pq;
+    for (size_t i = 0; i < pixel_count; ++i) {
+        const uint8_t *px = frame->pixels + i * 4;
+        values[i * 3] = table[px[2]];
+        values[i * 3 + 1] = table[px[1]];
+        values[i * 3 + 2] = table[px[0]];
+    }
+
+    scope_converter_t converter;
+    scope_converter_create(&converter);
+    const scope_float_planes_t planes = {
+        .planes = {values, values + 1, values + 2},
+        .width = frame->width,
+        .height = frame->height,
+        .stride = frame->width * 3,
+        .step = 3,
+    };
+    bool ok = scope_convert_from_planes(&converter, &planes, format, *buffer, image->stride, NULL);
+    scope_converter_destroy(&converter);
+    free(values);
+
+    if (!ok) free(*buffer);
+    return ok;
+}
+
+struct level_job {
+    const scope_image_t *image;
+    scope_isa_t isa;
+    scope_light_level_t level;
+};
+
+static void level_frame(void *user_data) {
+    struct level_job *job = user_data;
+    scope_light_level_measure(job->image, job->isa, &job->level);
+}
+
+static void section_hdr(void) {
+    scope_thread_pool_t *pool = NULL;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_thread_pool_create(0, &pool)) return;
+    if (!scope_vectorscope_create(&vs)) {
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+
+    printf("  vectorscope + waveform, %u threads, lut kernel for bgra; light level per ISA\n", scope_thread_pool_size(pool));
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        const bench_frame_t *frame = &frames[f];
+        struct source_job job = {.image = frame->image, .vs = &vs, .wf = &wf, .pool = pool};
+
+        double baseline = bench_measure(direct_frame, &job);
+        print_result("bgra8", frame, baseline, baseline);
+
+        uint8_t *half;
+        if (frame_to_hdr(frame, SCOPE_PIXEL_FORMAT_RGBA16F, &half, &job.image)) {
+            print_result("rgba16f linear", frame, bench_measure(direct_frame, &job), baseline);
+
+            // The conversion itself, scalar against F16C
+            const scope_image_t image = job.image;
+            double scalar = 0.0;
+            for (int isa = SCOPE_ISA_SCALAR; isa < SCOPE_ISA_COUNT; ++isa) {
+                if (!scope_cpu_supports((scope_isa_t)isa) || isa == SCOPE_ISA_SSE41 || isa == SCOPE_ISA_AVX512) continue;
+
+                struct level_job level = {.image = &image, .isa = (scope_isa_t)isa};
+                double ms = bench_measure(level_frame, &level);
+                if (isa == SCOPE_ISA_SCALAR) scalar = ms;
+
+                char label[32];
+                snprintf(label, sizeof(label), "light level %s", isa == SCOPE_ISA_SCALAR ? "scalar" : "f16c");
+                print_result(label, frame, ms, scalar);
+            }
+            free(half);
+        }
+
+        uint8_t *packed;
+        if (frame_to_hdr(frame, SCOPE_PIXEL_FORMAT_RGB10A2, &packed, &job.image)) {
+            print_result("rgb10a2 pq", frame, bench_measure(direct_frame, &job), baseline);
+            free(packed);
+        }
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Pixel format conversion, scalar against SIMD kernels and across the pool
+// ---------------------------------------------------------------------------
+struct convert_job {
+    scope_converter_t *converter;
+    const scope_image_t *image;         // NULL to convert from planes
+    const scope_float_planes_t *planes; // destination if there is an image
+    scope_pixel_format_t format;        // packed destination, SCOPE_PIXEL_FORMAT_COUNT for planes
+    uint8_t *dst;
+    uint32_t dst_stride;
+    scope_thread_pool_t *pool;
+};
+
+static void convert_frame(void *user_data) {
+    struct convert_job *job = user_data;
+    if (!job->image) {
+        scope_convert_from_planes(job->converter, job->planes, job->format, job->dst, job->dst_stride, job->pool);
+    } else if (job->format == SCOPE_PIXEL_FORMAT_COUNT) {
+        scope_convert_to_planes(job->converter, job->image, job->planes, job->pool);
+    } else {
+        scope_convert(job->converter, job->image, job->format, job->dst, job->dst_stride, job->pool);
+    }
+}
+
+// Scalar, the best SIMD kernels, then those across the pool
+static void convert_measure(const char *name, const bench_frame_t *frame, struct convert_job *job, scope_thread_pool_t *pool) {
+    const scope_isa_t best = scope_cpu_best_isa();
+    job->converter->isa = SCOPE_ISA_SCALAR;
+    job->pool = NULL;
+    double scalar = bench_measure(convert_frame, job);
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s scalar", name);
+    print_result(label, frame, scalar, scalar);
+
+    job->converter->isa = best;
+    if (best >= SCOPE_ISA_AVX2) {
+        snprintf(label, sizeof(label), "%s %s", name, scope_isa_name(best));
+        print_result(label, frame, bench_measure(convert_frame, job), scalar);
+    }
+
+    job->pool = pool;
+    snprintf(label, sizeof(label), "%s %ut", name, scope_thread_pool_size(pool));
+    print_result(label, frame, bench_measure(convert_frame, job), scalar);
+}
+
+static void section_convert(void) {
+    scope_thread_pool_t *pool = NULL;
+    if (!scope_thread_pool_create(0, &pool)) return;
+
+    scope_converter_t converter;
+    scope_converter_create(&converter);
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        const bench_frame_t *frame = &frames[f];
+        const size_t pixel_count = (size_t)frame->width * frame->height;
+        uint8_t *dst = malloc(pixel_count * 8);
+        float *values = malloc(pixel_count * 3 * sizeof(float));
+        if (!dst || !values) {
+            free(dst);
+            free(values);
+            continue;
+        }
+
+        const scope_float_planes_t planes = {
+            .planes = {values, values + pixel_count, values + pixel_count * 2},
+            .width = frame->width,
+            .height = frame->height,
+            .stride = frame->width,
+            .step = 1,
+        };
+        struct convert_job job = {.converter = &converter, .image = &frame->image, .format = SCOPE_PIXEL_FORMAT_RGBA8, .dst = dst, .dst_stride = frame->width * 4};
+        convert_measure("bgra8 > rgba8", frame, &job, pool);
+
+        job.planes = &planes;
+        job.format = SCOPE_PIXEL_FORMAT_COUNT;
+        convert_measure("bgra8 > planes", frame, &job, pool);
+
+        job = (struct convert_job){.converter = &converter, .planes = &planes, .format = SCOPE_PIXEL_FORMAT_RGBA16F, .dst = dst, .dst_stride = frame->width * 8};
+        convert_measure("planes > rgba16f", frame, &job, pool);
+
+        const struct {
+            const char *name;
+            scope_pixel_format_t format;
+        } sources[] = {
+            {"rgba16f > bgra8", SCOPE_PIXEL_FORMAT_RGBA16F},
+            {"rgb10a2 > bgra8", SCOPE_PIXEL_FORMAT_RGB10A2},
+            {"nv12 > bgra8", SCOPE_PIXEL_FORMAT_NV12},
+            {"p010 > bgra8", SCOPE_PIXEL_FORMAT_P010},
+        };
+        for (uint32_t i = 0; i < ARRAY_LENGTH(sources); ++i) {
+            uint8_t *buffer;
+            scope_image_t image;
+            bool ok = scope_pixel_format_is_hdr(sources[i].format) ? frame_to_hdr(frame, sources[i].format, &buffer, &image)
+                                                                   : frame_to_ycbcr(frame, sources[i].format, &buffer, &image);
+            if (!ok) continue;
+
+            job = (struct convert_job){.converter = &converter, .image = &image, .format = SCOPE_PIXEL_FORMAT_BGRA8, .dst = dst, .dst_stride = frame->width * 4};
+            convert_measure(sources[i].name, frame, &job, pool);
+            free(buffer);
+        }
+
+        free(dst);
+        free(values);
+    }
+
+    scope_converter_destroy(&converter);
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Vectorscope blur from running sums at growing radii, against the 13 taps of vs_blur
+// ---------------------------------------------------------------------------
+struct blur_job {
+    scope_blur_t *blur; // NULL for the reference
+    const scope_vectorscope_t *vs;
+    const scope_rect_t *occupied; // NULL for the whole plane
+    float *out;
+    scope_thread_pool_t *pool;
+};
+
+static void blur_frame(void *user_data) {
+    struct blur_job *job = user_data;
+    if (job->blur) {
+        scope_blur_apply(job->blur, job->vs->bins, job->vs->resolution, job->occupied, job->out, job->pool);
+    } else {
+        scope_vectorscope_blur(job->vs, job->out);
+    }
+}
+
+static void section_blur(void) {
+    scope_thread_pool_t *pool = NULL;
+    scope_vectorscope_t vs;
+    if (!scope_thread_pool_create(0, &pool)) return;
+    if (!scope_vectorscope_create(&vs)) {
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+
+    float *out = malloc((size_t)vs.resolution * vs.resolution * sizeof(float));
+    if (out) {
+        // Bins of the 4K frame, Mpix/s below are of the frame the bins came from
+        const bench_frame_t *frame = &frames[ARRAY_LENGTH(frames) - 1];
+        scope_vectorscope_update(&vs, &frame->image, pool);
+
+        struct blur_job job = {.vs = &vs, .out = out};
+        const double baseline = bench_measure(blur_frame, &job);
+        print_result("13 taps", frame, baseline, baseline);
+
+        const struct {
+            scope_blur_shape_t shape;
+            uint32_t radius;
+        } configs[] = {
+            {SCOPE_BLUR_DIAMOND, 2},
+            {SCOPE_BLUR_DIAMOND, 8},
+            {SCOPE_BLUR_DIAMOND, 32},
+            {SCOPE_BLUR_BOX, 2},
+            {SCOPE_BLUR_BOX, 32},
+            {SCOPE_BLUR_GAUSSIAN, 8},
+            {SCOPE_BLUR_GAUSSIAN, 32},
+        };
+        for (uint32_t i = 0; i < ARRAY_LENGTH(configs); ++i) {
+            scope_blur_t blur;
+            scope_blur_create(&blur, configs[i].shape, configs[i].radius);
+            job.blur = &blur;
+
+            char label[64];
+            for (int parallel = 0; parallel < 2; ++parallel) {
+                job.pool = parallel ? pool : NULL;
+                snprintf(label, sizeof(label), "%s %u, %u threads", scope_blur_shape_name(configs[i].shape), configs[i].radius, parallel ? scope_thread_pool_size(pool) : 1);
+                print_result(label, frame, bench_measure(blur_frame, &job), baseline);
+            }
+            scope_blur_destroy(&blur);
+        }
+        free(out);
+    }
+
+    scope_vectorscope_destroy(&vs);
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Tile occupancy of the vectorscope on graded footage: clearing only the marked tiles and blurring
+// only their bounds, against clearing and blurring the whole plane
+// ---------------------------------------------------------------------------
+static void whole_clear_frame(void *user_data) {
+    struct scope_job *job = user_data;
+    scope_vectorscope_t *vs = job->scope;
+    memset(vs->bins, 0, (size_t)vs->resolution * vs->resolution * sizeof(uint32_t));
+    memset(vs->tiles, 0, (size_t)vs->tiles_per_row * vs->tiles_per_row);
+    scope_vectorscope_accumulate(vs, job->image);
+}
+
+static void tile_clear_frame(void *user_data) {
+    struct scope_job *job = user_data;
+    scope_vectorscope_clear(job->scope);
+    scope_vectorscope_accumulate(job->scope, job->image);
+}
+
+static void section_occupancy(void) {
+    scope_vectorscope_t vs;
+    if (!scope_vectorscope_create(&vs)) return;
+
+    float *out = malloc((size_t)vs.resolution * vs.resolution * sizeof(float));
+    if (out) {
+        for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+            const bench_frame_t *frame = &frames[f];
+
+            struct scope_job job = {.scope = &vs, .image = &frame->image};
+            double baseline = bench_measure(whole_clear_frame, &job);
+            print_result("rebuild, whole clear", frame, baseline, baseline);
+            print_result("rebuild, tile clear", frame, bench_measure(tile_clear_frame, &job), baseline);
+
+            scope_rect_t bounds;
+            scope_vectorscope_bounds(&vs, &bounds);
+            uint32_t marked = 0;
+            for (uint32_t t = 0; t < vs.tiles_per_row * vs.tiles_per_row; ++t) {
+                marked += vs.tiles[t] != 0;
+            }
+            printf("  %u of %u tiles marked, bounds %ux%u\n", marked, vs.tiles_per_row * vs.tiles_per_row, bounds.width, bounds.height);
+
+            const scope_blur_shape_t shapes[] = {SCOPE_BLUR_DIAMOND, SCOPE_BLUR_GAUSSIAN};
+            for (uint32_t i = 0; i < ARRAY_LENGTH(shapes); ++i) {
+                scope_blur_t blur;
+                scope_blur_create(&blur, shapes[i], 8);
+
+                char label[64];
+                struct blur_job blur_job = {.blur = &blur, .vs = &vs, .out = out};
+                snprintf(label, sizeof(label), "%s 8, whole plane", scope_blur_shape_name(shapes[i]));
+                baseline = bench_measure(blur_frame, &blur_job);
+                print_result(label, frame, baseline, baseline);
+
+                blur_job.occupied = &bounds;
+                snprintf(label, sizeof(label), "%s 8, occupied", scope_blur_shape_name(shapes[i]));
+                print_result(label, frame, bench_measure(blur_frame, &blur_job), baseline);
+                scope_blur_destroy(&blur);
+            }
+        }
+        free(out);
+    }
+
+    scope_vectorscope_destroy(&vs);
+}
+
+// ---------------------------------------------------------------------------
+// Quality presets: the scopes updated, blurred and rendered at every accumulator resolution,
+// against the default preset
+// ---------------------------------------------------------------------------
+struct preset_job {
+    scope_vectorscope_t *vs;
+    scope_waveform_t *wf;
+    scope_blur_t *blur;
+    float *blurred; // sized for the largest preset
+    uint8_t *rgba;
+    const scope_image_t *image;
+    scope_thread_pool_t *pool;
+};
+
+static void preset_update_frame(void *user_data) {
+    struct preset_job *job = user_data;
+    scope_vectorscope_update(job->vs, job->image, job->pool);
+    scope_waveform_update(job->wf, job->image, job->pool);
+}
+
+static void preset_render_frame(void *user_data) {
+    struct preset_job *job = user_data;
+    scope_rect_t bounds;
+    scope_vectorscope_bounds(job->vs, &bounds);
+    scope_blur_apply(job->blur, job->vs->bins, job->vs->resolution, &bounds, job->blurred, job->pool);
+    scope_render_vectorscope(job->blurred, job->vs->resolution, job->vs->zoom, job->vs->encoding, job->rgba, SCOPE_VS_COMPOSITE_WIDTH, SCOPE_VS_COMPOSITE_HEIGHT);
+    scope_render_waveform(job->wf, job->rgba, SCOPE_WF_COMPOSITE_WIDTH, SCOPE_WF_COMPOSITE_HEIGHT);
+    scope_render_parade(job->wf, job->rgba, SCOPE_WF_COMPOSITE_WIDTH, SCOPE_WF_COMPOSITE_HEIGHT);
+}
+
+// Configures the scopes for the preset and times both halves of a frame
+static void preset_measure(struct preset_job *job, scope_quality_t quality, double *update_ms, double *render_ms) {
+    const scope_config_t config = scope_config_preset(quality);
+    scope_vectorscope_configure(job->vs, &config);
+    scope_waveform_configure(job->wf, &config);
+
+    *update_ms = bench_measure(preset_update_frame, job);
+    *render_ms = bench_measure(preset_render_frame, job);
+}
+
+static void section_presets(void) {
+    scope_thread_pool_t *pool = NULL;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_thread_pool_create(0, &pool)) return;
+    if (!scope_vectorscope_create(&vs)) {
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+
+    const uint32_t max_resolution = scope_config_preset(SCOPE_QUALITY_COUNT - 1).vs_resolution;
+    float *blurred = malloc((size_t)max_resolution * max_resolution * sizeof(float));
+    uint8_t *rgba = malloc((size_t)SCOPE_VS_COMPOSITE_WIDTH * SCOPE_VS_COMPOSITE_HEIGHT * 4);
+    if (blurred && rgba) {
+        scope_blur_t blur;
+        scope_blur_create(&blur, SCOPE_BLUR_DIAMOND, 2);
+
+        for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+            const bench_frame_t *frame = &frames[f];
+            struct preset_job job = {.vs = &vs, .wf = &wf, .blur = &blur, .blurred = blurred, .rgba = rgba, .image = &frame->image, .pool = pool};
+
+            double update_baseline, render_baseline;
+            preset_measure(&job, SCOPE_QUALITY_DEFAULT, &update_baseline, &render_baseline);
+
+            for (uint32_t q = 0; q < SCOPE_QUALITY_COUNT; ++q) {
+                double update_ms, render_ms;
+                preset_measure(&job, (scope_quality_t)q, &update_ms, &render_ms);
+
+                char label[64];
+                snprintf(label, sizeof(label), "%u, vs + wf update", vs.resolution);
+                print_result(label, frame, update_ms, update_baseline);
+                snprintf(label, sizeof(label), "%u, blur + render", vs.resolution);
+                print_result(label, frame, render_ms, render_baseline);
+            }
+        }
+        scope_blur_destroy(&blur);
+    }
+    free(rgba);
+    free(blurred);
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+    scope_thread_pool_destroy(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Vectorscope zoom: accumulation at every magnification with both kernels, against no zoom. The
+// window drops most pixels of saturated footage before their bin write
+// ---------------------------------------------------------------------------
+static void section_zoom(void) {
+    scope_vectorscope_t vs;
+    if (!scope_vectorscope_create(&vs)) return;
+
+    const scope_kernel_t kernels[] = {SCOPE_KERNEL_FLOAT, SCOPE_KERNEL_LUT};
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        struct scope_job job = {.scope = &vs, .image = &frames[f].image};
+
+        for (uint32_t k = 0; k < ARRAY_LENGTH(kernels); ++k) {
+            vs.kernel = kernels[k];
+            double baseline = 0.0;
+
+            for (uint32_t zoom = 1; zoom <= SCOPE_VS_MAX_ZOOM; zoom *= 2) {
+                scope_config_t config = scope_config_preset(SCOPE_QUALITY_DEFAULT);
+                config.vs_zoom = zoom;
+                scope_vectorscope_configure(&vs, &config);
+
+                double ms = bench_measure(vs_single, &job);
+                if (zoom == 1) baseline = ms;
+
+                char label[64];
+                snprintf(label, sizeof(label), "%s, zoom %u", kernels[k] == SCOPE_KERNEL_LUT ? "lut" : "float", zoom);
+                print_result(label, &frames[f], ms, baseline);
+            }
+        }
+    }
+
+    scope_vectorscope_destroy(&vs);
+}
+
+// ---------------------------------------------------------------------------
+// Encodings: both scopes with both kernels in every matrix and range, against BT.709 at full
+// range. Every encoding has kernels of its own, so none of them should cost more than another
+// ---------------------------------------------------------------------------
+static void section_encoding(void) {
+    static const char *matrix_names[] = {"601", "709", "2020"};
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_vectorscope_create(&vs)) return;
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+
+    const scope_kernel_t kernels[] = {SCOPE_KERNEL_FLOAT, SCOPE_KERNEL_LUT};
+    const uint32_t reference = scope_encoding_index(scope_config_preset(SCOPE_QUALITY_DEFAULT).encoding);
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        for (uint32_t s = 0; s < 2; ++s) {
+            struct scope_job job = {.scope = s ? (void *)&wf : (void *)&vs, .image = &frames[f].image};
+
+            for (uint32_t k = 0; k < ARRAY_LENGTH(kernels); ++k) {
+                vs.kernel = wf.kernel = kernels[k];
+                double ms[SCOPE_ENCODING_COUNT];
+
+                for (uint32_t e = 0; e < SCOPE_ENCODING_COUNT; ++e) {
+                    scope_config_t config = scope_config_preset(SCOPE_QUALITY_DEFAULT);
+                    config.encoding = scope_encoding_from_index(e);
+                    scope_vectorscope_configure(&vs, &config);
+                    scope_waveform_configure(&wf, &config);
+                    ms[e] = bench_measure(s ? wf_single : vs_single, &job);
+                }
+
+                for (uint32_t e = 0; e < SCOPE_ENCODING_COUNT; ++e) {
+                    const scope_encoding_t encoding = scope_encoding_from_index(e);
+                    char label[64];
+                    snprintf(label, sizeof(label), "%s %s, %s %s", s ? "wf" : "vs", kernels[k] == SCOPE_KERNEL_LUT ? "lut" : "float",
+                             matrix_names[encoding.matrix], encoding.range == SCOPE_COLOR_RANGE_FULL ? "full" : "limited");
+                    print_result(label, &frames[f], ms[e], ms[reference]);
+                }
+            }
+        }
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+}
+
+#if SCOPE_ENABLE_X11
+// ---------------------------------------------------------------------------
+// X11 MIT-SHM capture of the $DISPLAY screen, e.g. Xvfb :99 -screen 0 3840x2160x24
+// ---------------------------------------------------------------------------
+static void x11_capture_frame(void *user_data) {
+    struct source_job *job = user_data;
+    scope_frame_t frame;
+    if (scope_source_acquire(job->source, 0, &frame) == SCOPE_ACQUIRE_OK) {
+        scope_source_release(job->source);
+    }
+}
+
+static void section_x11(void) {
+    scope_thread_pool_t *pool = NULL;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!scope_thread_pool_create(0, &pool)) return;
+    if (!scope_vectorscope_create(&vs)) {
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+    if (!scope_waveform_create(&wf)) {
+        scope_vectorscope_destroy(&vs);
+        scope_thread_pool_destroy(pool);
+        return;
+    }
+
+    // 1080p and 4K
+    for (uint32_t f = 0; f < 2; ++f) {
+        const bench_frame_t *frame = &frames[f];
+        const scope_x11_desc_t desc = {
+            .area = {0, 0, frame->width, frame->height},
+            .every_acquire = true,
+        };
+
+        struct source_job job = {.vs = &vs, .wf = &wf, .pool = pool};
+        if (!scope_source_x11_create(&desc, &job.source)) {
+            printf("  skipped %s, no display that large\n", frame->name);
+            continue;
+        }
+
+        double baseline = bench_measure(x11_capture_frame, &job);
+        print_result("capture", frame, baseline, baseline);
+
+        double ms = bench_measure(source_frame, &job);
+        print_result("capture + vs + wf", frame, ms, baseline);
+
+        scope_source_destroy(job.source);
+    }
+
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+    scope_thread_pool_destroy(pool);
+}
+#endif
+
+static const bench_section_t sections[] = {
+    {"isa", section_isa},
+    {"threads", section_threads},
+    {"waveform", section_waveform},
+    {"lut", section_lut},
+    {"sampling", section_sampling},
+    {"persistence", section_persistence},
+    {"incremental", section_incremental},
+    {"sources", section_sources},
+    {"ycbcr", section_ycbcr},
+    {"pyramid", section_pyramid},
+    {"async", section_async},
+    {"multi", section_multi},
+    {"tiles", section_tiles},
+    {"hdr", section_hdr},
+    {"convert", section_convert},
+    {"blur", section_blur},
+    {"occupancy", section_occupancy},
+    {"presets", section_presets},
+    {"zoom", section_zoom},
+    {"encoding", section_encoding},
+#if SCOPE_ENABLE_X11
+    {"x11", section_x11},
+#endif
+};
+
+int main(int argc, char **argv) {
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        if (!frame_generate(&frames[f])) {
+            fprintf(stderr, "Couldn't allocate %s frame\n", frames[f].name);
+            return 1;
+        }
+    }
+
+    printf("scope-bench: %u logical cores, best ISA %s\n", scope_cpu_core_count(), scope_isa_name(scope_cpu_best_isa()));
+
+    for (uint32_t s = 0; s < ARRAY_LENGTH(sections); ++s) {
+        bool selected = argc <= 1;
+        for (int a = 1; a < argc; ++a) {
+            if (strcmp(argv[a], sections[s].name) == 0) selected = true;
+        }
+        if (!selected) continue;
+
+        printf("[%s]\n", sections[s].name);
+        sections[s].run();
+    }
+
+    for (uint32_t f = 0; f < ARRAY_LENGTH(frames); ++f) {
+        free(frames[f].pixels);
+    }
+
+    return 0;
+}
@@ -0,0 +1,783 @@
+// Headless batch front end of the scope core: loads stills, image sequences or raw video, runs
+// the vectorscope, waveform and parade, and writes the scope images and/or raw histograms.
+
+#include "png.h"
+#include "source_image.h"
+
+#include "scope.h"
+#include "scope_blur.h"
+#include "scope_cpu.h"
+#include "scope_hdr.h"
+#include "scope_multi.h"
+#include "scope_persistence.h"
+#include "scope_render.h"
+#include "scope_source.h"
+#include "scope_thread.h"
+#include "scope_vectorscope.h"
+#include "scope_waveform.h"
+
+#include "../src/macros.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PATH_LENGTH 1024
+
+// Nominal rate of sequences and raw video, only used for the frame timestamps
+#define CLI_FRAME_RATE 24.0
+
+typedef enum cli_stage {
+    CLI_STAGE_LOAD,
+    CLI_STAGE_VECTORSCOPE,
+    CLI_STAGE_WAVEFORM,
+    CLI_STAGE_RENDER,
+    CLI_STAGE_WRITE,
+    CLI_STAGE_COUNT
+} cli_stage_t;
+
+static const char *stage_names[CLI_STAGE_COUNT] = {"load", "vectorscope", "waveform", "render", "write"};
+
+typedef struct cli_options {
+    const char *out_dir;
+    bool images;
+    bool raw;
+    bool verbose;
+    uint32_t threads; // 0 = one per core
+    uint32_t first;   // first index of printf-style sequences
+    uint32_t raw_width; // frame size of raw video inputs
+    uint32_t raw_height;
+    uint32_t analysis_width; // frames are reduced to fit, 0 scopes them at full size
+    uint32_t analysis_height;
+    uint32_t level; // pyramid level scoped when reducing
+    scope_kernel_t kernel;
+    scope_transfer_t transfer; // of HDR raw video
+    bool transfer_given;       // otherwise the default of the input's format
+    scope_blur_shape_t blur_shape; // of the vectorscope image
+    uint32_t blur_radius;
+    scope_quality_t quality;   // resolution of the histograms
+    uint32_t zoom;             // of the vectorscope
+    scope_encoding_t encoding; // the scopes measure in
+    scope_sampling_t sampling; // budget 0 scopes every pixel
+    float half_life;           // of the trails in frames, 0 shows every frame on its own
+    bool together;             // scope every input at once, each with scopes of its own
+} cli_options_t;
+
+typedef struct cli_state {
+    cli_options_t options;
+    scope_thread_pool_t *pool;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    scope_blur_t blur;
+
+    // Trails of the frames of the current input, with --persistence
+    scope_persistence_t vs_persistence;
+    scope_persistence_t wf_persistence;
+
+    float *blurred;
+    uint8_t *vs_rgba;
+    uint8_t *wf_rgba;
+    uint8_t *parade_rgba;
+
+    uint64_t frame_count;
+    uint64_t failed_count;
+    uint64_t pixel_count;
+    double stage_seconds[CLI_STAGE_COUNT];
+
+    // Largest light levels of the HDR frames
+    uint64_t hdr_frame_count;
+    scope_light_level_t hdr_level;
+} cli_state_t;
+
+static void print_usage(void) {
+    fprintf(stderr,
+            "usage: chroma-scopes-cli [options] <input>...\n"
+            "\n"
+            "Inputs are PNG/JPEG/HDR/TGA/BMP files, or printf-style sequences like shot_%%04d.png,\n"
+            "which run from --first until the first missing file. Files ending in .bgra or .rgba are\n"
+            "headerless raw video (e.g. ffmpeg -f rawvideo -pix_fmt bgra) of the --size given, .y4m\n"
+            "files are YUV4MPEG2, scoped from their Y'CbCr planes (luma waveform, no parade). HDR raw\n"
+            "video ends in .rgbaf16 (-pix_fmt rgbaf16le, linear scRGB by default) or .x2bgr10\n"
+            "(-pix_fmt x2bgr10le, PQ by default) and is scoped at full range, with MaxCLL/MaxFALL in\n"
+            "the summary. Video is memory mapped and analyzed as fast as possible.\n"
+            "\n"
+            "  -o, --out <dir>     output directory (default: current directory)\n"
+            "  -t, --threads <n>   worker threads, 0 uses every core (default: 0)\n"
+            "  --first <n>         first index of sequences (default: 0)\n"
+            "  --size <w>x<h>      frame size of raw video inputs\n"
+            "  --analysis <w>x<h>  box filter RGB frames down to fit this size before scoping\n"
+            "  --level <n>         with --analysis, scope the n-th halving of it (default: 0)\n"
+            "  --kernel <name>     float or lut (default: lut)\n"
+            "  --transfer <name>   pq, hlg, linear or sdr, what the values of HDR raw video encode\n"
+            "  --blur <shape>[:<r>]  diamond, box or gaussian blur of the vectorscope with radius r,\n"
+            "                      up to 64 (default: diamond:2, the taps of the app)\n"
+            "  --quality <n>       256, 512, 1024 or 2048, histogram resolution: n x n vectorscope\n"
+            "                      bins, n waveform columns of n / 2 levels (default: 1024)\n"
+            "  --zoom <n>          magnify the vectorscope n times around neutral, up to 8, binning\n"
+            "                      the window finer instead of enlarging the bins (default: 1)\n"
+            "  --matrix <name>     601, 709 or 2020, Y'CbCr matrix of the vectorscope and the luma\n"
+            "                      waveform (default: 709)\n"
+            "  --range <name>      full or limited, levels the scopes show: limited puts black at\n"
+            "                      16 and white at 235 of 255, like the code values (default: full)\n"
+            "  --budget <n>        scope at most n pixels per frame, each weighted by the pixels it\n"
+            "                      stands for (default: 0, every pixel)\n"
+            "  --sample <name>     stratified or halton, positions of the --budget samples, which\n"
+            "                      move from frame to frame (default: stratified)\n"
+            "  --persistence <n>   keep the hits of earlier frames of an input, fading to half\n"
+            "                      every n frames, like a phosphor (default: 0, off)\n"
+            "  --together          scope every input at once, frame by frame, each with scopes of\n"
+            "                      its own (not with --budget or --persistence)\n"
+            "  --raw               also write raw histograms as native-endian uint32:\n"
+            "                        <name>_vectorscope.u32  n x n, row = Cr, column = Cb\n"
+            "                        <name>_waveform.u32     R, G, B, luma planes of n / 2 x n,\n"
+            "                                                row = level bucket, column = x\n"
+            "  --no-images         skip the scope images (analysis only)\n"
+            "  -v, --verbose       print timings of every frame\n");
+}
+
+static bool parse_options(int argc, char **argv, cli_options_t *options, int *first_input) {
+    *options = (cli_options_t){
+        .out_dir = ".",
+        .images = true,
+        .kernel = SCOPE_KERNEL_LUT,
+        .blur_shape = SCOPE_BLUR_DIAMOND,
+        .blur_radius = 2,
+        .quality = SCOPE_QUALITY_DEFAULT,
+        .zoom = 1,
+        .encoding = scope_config_preset(SCOPE_QUALITY_DEFAULT).encoding,
+    };
+
+    int a = 1;
+    for (; a < argc && argv[a][0] == '-'; ++a) {
+        const char *arg = argv[a];
+        const char *value = a + 1 < argc ? argv[a + 1] : NULL;
+
+        if ((strcmp(arg, "-o") == 0 || strcmp(arg, "--out") == 0) && value) {
+            options->out_dir = value;
+            a++;
+        } else if ((strcmp(arg, "-t") == 0 || strcmp(arg, "--threads") == 0) && value) {
+            options->threads = (uint32_t)strtoul(value, NULL, 10);
+            a++;
+        } else if (strcmp(arg, "--first") == 0 && value) {
+            options->first = (uint32_t)strtoul(value, NULL, 10);
+            a++;
+        } else if (strcmp(arg, "--size") == 0 && value) {
+            unsigned width, height;
+            if (sscanf(value, "%ux%u", &width, &height) != 2 || width == 0 || height == 0) {
+                fprintf(stderr, "Invalid frame size '%s'\n", value);
+                return false;
+            }
+            options->raw_width = width;
+            options->raw_height = height;
+            a++;
+        } else if (strcmp(arg, "--analysis") == 0 && value) {
+            unsigned width, height;
+            if (sscanf(value, "%ux%u", &width, &height) != 2 || width == 0 || height == 0) {
+                fprintf(stderr, "Invalid analysis size '%s'\n", value);
+                return false;
+            }
+            options->analysis_width = width;
+            options->analysis_height = height;
+            a++;
+        } else if (strcmp(arg, "--level") == 0 && value) {
+            options->level = (uint32_t)strtoul(value, NULL, 10);
+            if (options->level >= SCOPE_PYRAMID_MAX_LEVELS) {
+                fprintf(stderr, "Level '%s' is past the last pyramid level %u\n", value, SCOPE_PYRAMID_MAX_LEVELS - 1);
+                return false;
+            }
+            a++;
+        } else if (strcmp(arg, "--kernel") == 0 && value) {
+            if (strcmp(value, "float") == 0) {
+                options->kernel = SCOPE_KERNEL_FLOAT;
+            } else if (strcmp(value, "lut") == 0) {
+                options->kernel = SCOPE_KERNEL_LUT;
+            } else {
+                fprintf(stderr, "Unknown kernel '%s'\n", value);
+                return false;
+            }
+            a++;
+        } else if (strcmp(arg, "--transfer") == 0 && value) {
+            static const char *names[] = {"sdr", "pq", "hlg", "linear"};
+            uint32_t t = 0;
+            while (t < ARRAY_LENGTH(names) && strcmp(value, names[t]) != 0) t++;
+            if (t == ARRAY_LENGTH(names)) {
+                fprintf(stderr, "Unknown transfer '%s'\n", value);
+                return false;
+            }
+            options->transfer = (scope_transfer_t)t;
+            options->transfer_given = true;
+            a++;
+        } else if (strcmp(arg, "--blur") == 0 && value) {
+            const char *colon = strchr(value, ':');
+            const size_t length = colon ? (size_t)(colon - value) : strlen(value);
+            uint32_t shape = 0;
+            while (shape < SCOPE_BLUR_SHAPE_COUNT && (strlen(scope_blur_shape_name((scope_blur_shape_t)shape)) != length ||
+                                                      strncmp(value, scope_blur_shape_name((scope_blur_shape_t)shape), length) != 0)) {
+                shape++;
+            }
+            unsigned radius = options->blur_radius;
+            if (shape == SCOPE_BLUR_SHAPE_COUNT || (colon && sscanf(colon + 1, "%u", &radius) != 1) || radius > SCOPE_BLUR_MAX_RADIUS) {
+                fprintf(stderr, "Invalid blur '%s'\n", value);
+                return false;
+            }
+            options->blur_shape = (scope_blur_shape_t)shape;
+            options->blur_radius = radius;
+            a++;
+        } else if (strcmp(arg, "--quality") == 0 && value) {
+            uint32_t quality = 0;
+            while (quality < SCOPE_QUALITY_COUNT && strtoul(value, NULL, 10) != scope_config_preset((scope_quality_t)quality).vs_resolution) {
+                quality++;
+            }
+            if (quality == SCOPE_QUALITY_COUNT) {
+                fprintf(stderr, "Invalid quality '%s'\n", value);
+                return false;
+            }
+            options->quality = (scope_quality_t)quality;
+            a++;
+        } else if (strcmp(arg, "--zoom") == 0 && value) {
+            options->zoom = (uint32_t)strtoul(value, NULL, 10);
+            if (options->zoom < 1 || options->zoom > SCOPE_VS_MAX_ZOOM) {
+                fprintf(stderr, "Invalid zoom '%s'\n", value);
+                return false;
+            }
+            a++;
+        } else if (strcmp(arg, "--matrix") == 0 && value) {
+            static const char *names[] = {"601", "709", "2020"};
+            uint32_t m = 0;
+            while (m < ARRAY_LENGTH(names) && strcmp(value, names[m]) != 0) m++;
+            if (m == ARRAY_LENGTH(names)) {
+                fprintf(stderr, "Unknown matrix '%s'\n", value);
+                return false;
+            }
+            options->encoding.matrix = (scope_matrix_t)m;
+            a++;
+        } else if (strcmp(arg, "--range") == 0 && value) {
+            if (strcmp(value, "full") == 0) {
+                options->encoding.range = SCOPE_COLOR_RANGE_FULL;
+            } else if (strcmp(value, "limited") == 0) {
+                options->encoding.range = SCOPE_COLOR_RANGE_LIMITED;
+            } else {
+                fprintf(stderr, "Unknown range '%s'\n", value);
+                return false;
+            }
+            a++;
+        } else if (strcmp(arg, "--budget") == 0 && value) {
+            options->sampling.budget = (uint32_t)strtoul(value, NULL, 10);
+            a++;
+        } else if (strcmp(arg, "--sample") == 0 && value) {
+            if (strcmp(value, "stratified") == 0) {
+                options->sampling.pattern = SCOPE_SAMPLE_STRATIFIED;
+            } else if (strcmp(value, "halton") == 0) {
+                options->sampling.pattern = SCOPE_SAMPLE_HALTON;
+            } else {
+                fprintf(stderr, "Unknown sample pattern '%s'\n", value);
+                return false;
+            }
+            a++;
+        } else if (strcmp(arg, "--persistence") == 0 && value) {
+            options->half_life = strtof(value, NULL);
+            if (!(options->half_life >= 0.0f)) {
+                fprintf(stderr, "Invalid half-life '%s'\n", value);
+                return false;
+            }
+            a++;
+        } else if (strcmp(arg, "--together") == 0) {
+            options->together = true;
+        } else if (strcmp(arg, "--raw") == 0) {
+            options->raw = true;
+        } else if (strcmp(arg, "--no-images") == 0) {
+            options->images = false;
+        } else if (strcmp(arg, "-v") == 0 || strcmp(arg, "--verbose") == 0) {
+            options->verbose = true;
+        } else {
+            fprintf(stderr, "Unknown or incomplete option '%s'\n", arg);
+            return false;
+        }
+    }
+
+    // The views of scope_multi keep their scopes up to date incrementally, every pixel of them
+    if (options->together && (options->sampling.budget > 0 || options->half_life > 0.0f)) {
+        fprintf(stderr, "--together can't be combined with --budget or --persistence\n");
+        return false;
+    }
+
+    *first_input = a;
+    return a < argc;
+}
+
+static scope_config_t options_config(const cli_options_t *options) {
+    scope_config_t config = scope_config_preset(options->quality);
+    config.vs_zoom = options->zoom;
+    config.encoding = options->encoding;
+    return config;
+}
+
+static bool state_create(cli_state_t *state) {
+    if (!scope_thread_pool_create(state->options.threads, &state->pool)) {
+        fprintf(stderr, "Couldn't create the thread pool\n");
+        return false;
+    }
+
+    scope_config_t config = options_config(&state->options);
+    if (!scope_vectorscope_create(&state->vs) || !scope_waveform_create(&state->wf) ||
+        !scope_vectorscope_configure(&state->vs, &config) || !scope_waveform_configure(&state->wf, &config)) {
+        fprintf(stderr, "Couldn't allocate the scopes\n");
+        return false;
+    }
+    if (!scope_persistence_create(&state->vs_persistence, 0, state->options.half_life) ||
+        !scope_persistence_create(&state->wf_persistence, 0, state->options.half_life)) {
+        fprintf(stderr, "Couldn't allocate the persistence\n");
+        return false;
+    }
+    scope_blur_create(&state->blur, state->options.blur_shape, state->options.blur_radius);
+    state->vs.kernel = state->options.kernel;
+    state->wf.kernel = state->options.kernel;
+
+    if (state->options.images) {
+        state->blurred = malloc((size_t)state->vs.resolution * state->vs.resolution * sizeof(float));
+        state->vs_rgba = malloc((size_t)SCOPE_VS_COMPOSITE_WIDTH * SCOPE_VS_COMPOSITE_HEIGHT * 4);
+        state->wf_rgba = malloc((size_t)SCOPE_WF_COMPOSITE_WIDTH * SCOPE_WF_COMPOSITE_HEIGHT * 4);
+        state->parade_rgba = malloc((size_t)SCOPE_WF_COMPOSITE_WIDTH * SCOPE_WF_COMPOSITE_HEIGHT * 4);
+        if (!state->blurred || !state->vs_rgba || !state->wf_rgba || !state->parade_rgba) {
+            fprintf(stderr, "Couldn't allocate the scope images\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void state_destroy(cli_state_t *state) {
+    free(state->parade_rgba);
+    free(state->wf_rgba);
+    free(state->vs_rgba);
+    free(state->blurred);
+    scope_blur_destroy(&state->blur);
+    scope_persistence_destroy(&state->wf_persistence);
+    scope_persistence_destroy(&state->vs_persistence);
+    scope_waveform_destroy(&state->wf);
+    scope_vectorscope_destroy(&state->vs);
+    scope_thread_pool_destroy(state->pool);
+}
+
+// File name without directories and extension
+static void path_stem(const char *path, char *out, size_t size) {
+    const char *name = path;
+    for (const char *c = path; *c; ++c) {
+        if (*c == '/' || *c == '\\') name = c + 1;
+    }
+
+    const char *dot = strrchr(name, '.');
+    size_t length = dot && dot != name ? (size_t)(dot - name) : strlen(name);
+    length = MIN(length, size - 1);
+
+    memcpy(out, name, length);
+    out[length] = '\0';
+}
+
+static bool write_raw(const char *path, const uint32_t *data, size_t count) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+
+    bool ok = fwrite(data, sizeof(uint32_t), count, file) == count;
+    return (fclose(file) == 0) && ok;
+}
+
+static bool write_outputs(const cli_state_t *state, const scope_vectorscope_t *vs, const scope_waveform_t *wf, const char *input_path, bool ycbcr) {
+    char stem[256];
+    char path[MAX_PATH_LENGTH];
+    path_stem(input_path, stem, sizeof(stem));
+
+    const char *dir = state->options.out_dir;
+
+    if (state->options.images) {
+        const struct {
+            const char *suffix;
+            const uint8_t *rgba;
+            uint32_t width;
+            uint32_t height;
+            bool rgb_only;
+        } images[] = {
+            {"vectorscope", state->vs_rgba, SCOPE_VS_COMPOSITE_WIDTH, SCOPE_VS_COMPOSITE_HEIGHT, false},
+            {"waveform", state->wf_rgba, SCOPE_WF_COMPOSITE_WIDTH, SCOPE_WF_COMPOSITE_HEIGHT, false},
+            {"parade", state->parade_rgba, SCOPE_WF_COMPOSITE_WIDTH, SCOPE_WF_COMPOSITE_HEIGHT, true},
+        };
+
+        for (uint32_t i = 0; i < ARRAY_LENGTH(images); ++i) {
+            if (ycbcr && images[i].rgb_only) continue;
+
+            snprintf(path, sizeof(path), "%s/%s_%s.png", dir, stem, images[i].suffix);
+            if (!png_write_rgb(path, images[i].rgba, images[i].width, images[i].height)) {
+                fprintf(stderr, "%s: couldn't write '%s'\n", input_path, path);
+                return false;
+            }
+        }
+    }
+
+    if (state->options.raw) {
+        const struct {
+            const char *suffix;
+            const uint32_t *data;
+            size_t count;
+        } histograms[] = {
+            {"vectorscope", vs->bins, (size_t)vs->resolution * vs->resolution},
+            {"waveform", wf->channels[0], (size_t)wf->width * wf->buckets * SCOPE_WF_CHANNEL_COUNT},
+        };
+
+        for (uint32_t i = 0; i < ARRAY_LENGTH(histograms); ++i) {
+            snprintf(path, sizeof(path), "%s/%s_%s.u32", dir, stem, histograms[i].suffix);
+            if (!write_raw(path, histograms[i].data, histograms[i].count)) {
+                fprintf(stderr, "%s: couldn't write '%s'\n", input_path, path);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Renders the scope images and writes them out with the histograms, `write_start` is when the
+// rendering was done
+static bool output_scopes(cli_state_t *state, const scope_vectorscope_t *vs, const scope_waveform_t *wf, const char *name, bool ycbcr, double *write_start) {
+    if (state->options.images) {
+        scope_rect_t occupied;
+        scope_vectorscope_bounds(vs, &occupied);
+        if (!scope_blur_apply(&state->blur, vs->bins, vs->resolution, &occupied, state->blurred, state->pool)) {
+            fprintf(stderr, "%s: couldn't allocate the blur\n", name);
+            *write_start = scope_cpu_time_seconds();
+            return false;
+        }
+        scope_render_vectorscope(state->blurred, vs->resolution, vs->zoom, vs->encoding, state->vs_rgba, SCOPE_VS_COMPOSITE_WIDTH, SCOPE_VS_COMPOSITE_HEIGHT);
+        if (ycbcr) {
+            // Only the luma plane is filled, there is no parade
+            scope_render_luma(wf, state->wf_rgba, SCOPE_WF_COMPOSITE_WIDTH, SCOPE_WF_COMPOSITE_HEIGHT);
+        } else {
+            scope_render_waveform(wf, state->wf_rgba, SCOPE_WF_COMPOSITE_WIDTH, SCOPE_WF_COMPOSITE_HEIGHT);
+            scope_render_parade(wf, state->parade_rgba, SCOPE_WF_COMPOSITE_WIDTH, SCOPE_WF_COMPOSITE_HEIGHT);
+        }
+    }
+
+    *write_start = scope_cpu_time_seconds();
+    return write_outputs(state, vs, wf, name, ycbcr);
+}
+
+// Adds the stage times `t` of a frame, from its load to the end of its write, to the totals
+static void account_frame(cli_state_t *state, const scope_image_t *image, const char *name, const double *t) {
+    for (uint32_t s = 0; s < CLI_STAGE_COUNT; ++s) {
+        state->stage_seconds[s] += t[s + 1] - t[s];
+    }
+    state->frame_count++;
+    state->pixel_count += (uint64_t)image->width * image->height;
+
+    if (state->options.verbose) {
+        printf("%s: %ux%u", name, image->width, image->height);
+        for (uint32_t s = 0; s < CLI_STAGE_COUNT; ++s) {
+            printf(" %s %.2f ms", stage_names[s], (t[s + 1] - t[s]) * 1000.0);
+        }
+        printf("\n");
+    }
+}
+
+static bool process_frame(cli_state_t *state, const scope_frame_t *frame, const char *name, double load_start) {
+    const scope_image_t *image = &frame->image;
+    const bool ycbcr = scope_pixel_format_is_ycbcr(image->format);
+
+    double t[CLI_STAGE_COUNT + 1];
+    t[CLI_STAGE_LOAD] = load_start;
+
+    // Sampled frames get new positions every time, so a clip covers every pixel over a few frames
+    scope_sampling_t sampling = state->options.sampling;
+    sampling.frame_index = (uint32_t)state->frame_count;
+
+    t[CLI_STAGE_VECTORSCOPE] = scope_cpu_time_seconds();
+    if (sampling.budget > 0) {
+        scope_vectorscope_clear(&state->vs);
+        scope_vectorscope_accumulate_sampled(&state->vs, image, &sampling);
+    } else {
+        scope_vectorscope_update(&state->vs, image, state->pool);
+    }
+    if (state->options.half_life > 0.0f && !scope_persistence_add_vectorscope(&state->vs_persistence, &state->vs)) {
+        fprintf(stderr, "%s: couldn't allocate the persistence\n", name);
+        return false;
+    }
+
+    t[CLI_STAGE_WAVEFORM] = scope_cpu_time_seconds();
+    if (sampling.budget > 0) {
+        scope_waveform_clear(&state->wf);
+        scope_waveform_accumulate_sampled(&state->wf, image, &sampling);
+    } else {
+        scope_waveform_update(&state->wf, image, state->pool);
+    }
+    if (state->options.half_life > 0.0f && !scope_persistence_add_waveform(&state->wf_persistence, &state->wf)) {
+        fprintf(stderr, "%s: couldn't allocate the persistence\n", name);
+        return false;
+    }
+
+    if (scope_pixel_format_is_hdr(image->format)) {
+        scope_light_level_t level;
+        scope_light_level_measure(image, scope_cpu_best_isa(), &level);
+        state->hdr_level.max_nits = MAX(state->hdr_level.max_nits, level.max_nits);
+        state->hdr_level.average_nits = MAX(state->hdr_level.average_nits, level.average_nits);
+        state->hdr_frame_count++;
+    }
+
+    t[CLI_STAGE_RENDER] = scope_cpu_time_seconds();
+    bool ok = output_scopes(state, &state->vs, &state->wf, name, ycbcr, &t[CLI_STAGE_WRITE]);
+    t[CLI_STAGE_COUNT] = scope_cpu_time_seconds();
+
+    account_frame(state, image, name, t);
+    return ok;
+}
+
+static bool has_extension(const char *path, const char *extension) {
+    size_t length = strlen(path);
+    size_t extension_length = strlen(extension);
+    return length > extension_length && strcmp(path + length - extension_length, extension) == 0;
+}
+
+static bool source_create(const cli_state_t *state, const char *input, bool *video, scope_source_t **source) {
+    bool bgra = has_extension(input, ".bgra");
+    bool y4m = has_extension(input, ".y4m");
+    bool half = has_extension(input, ".rgbaf16");
+    bool packed10 = has_extension(input, ".x2bgr10");
+    *video = bgra || y4m || half || packed10 || has_extension(input, ".rgba");
+    if (!*video) {
+        return source_image_create(input, state->options.first, CLI_FRAME_RATE, source);
+    }
+
+    if (!y4m && state->options.raw_width == 0) {
+        fprintf(stderr, "%s: raw video needs --size\n", input);
+        return false;
+    }
+
+    scope_file_desc_t desc = {
+        .width = state->options.raw_width,
+        .height = state->options.raw_height,
+        .format = bgra ? SCOPE_PIXEL_FORMAT_BGRA8 : SCOPE_PIXEL_FORMAT_RGBA8,
+        .transfer = state->options.transfer,
+        .frame_rate = CLI_FRAME_RATE,
+    };
+    if (half || packed10) {
+        desc.format = half ? SCOPE_PIXEL_FORMAT_RGBA16F : SCOPE_PIXEL_FORMAT_RGB10A2;
+        if (!state->options.transfer_given) {
+            desc.transfer = half ? SCOPE_TRANSFER_LINEAR : SCOPE_TRANSFER_PQ;
+        }
+    }
+    return scope_source_file_create(input, &desc, source);
+}
+
+// Opens `input`, reduced to fit --analysis. `images` is the image source inside it, which names
+// the frames of stills and sequences, or NULL for video.
+static bool input_open(cli_state_t *state, const char *input, const scope_source_t **images, scope_source_t **source) {
+    bool video;
+    if (!source_create(state, input, &video, source)) {
+        return false;
+    }
+    *images = video ? NULL : *source;
+
+    // The reduction is part of the load stage, like it would be part of a capture
+    return state->options.analysis_width == 0 ||
+           scope_source_pyramid_create(*source, state->options.analysis_width, state->options.analysis_height,
+                                       state->options.level, state->pool, source);
+}
+
+// Stills and sequences are named after the file, video frames after their number
+static void frame_name(const char *input, const scope_source_t *images, uint64_t generation, char *name, size_t size) {
+    if (images) {
+        snprintf(name, size, "%s", ((const source_image_t *)images)->path);
+    } else {
+        char stem[256];
+        path_stem(input, stem, sizeof(stem));
+        snprintf(name, size, "%s_%06llu", stem, (unsigned long long)generation);
+    }
+}
+
+static void process_input(cli_state_t *state, const char *input) {
+    scope_source_t *source = NULL;
+    const scope_source_t *images;
+    if (!input_open(state, input, &images, &source)) {
+        state->failed_count++;
+        return;
+    }
+
+    // Every input starts from empty scopes: the frame generations of each source start over, and
+    // the trails of one input do not run into the next
+    scope_vectorscope_clear(&state->vs);
+    scope_waveform_clear(&state->wf);
+    scope_persistence_clear(&state->vs_persistence);
+    scope_persistence_clear(&state->wf_persistence);
+
+    uint32_t count = 0;
+    for (;; ++count) {
+        double load_start = scope_cpu_time_seconds();
+
+        scope_frame_t frame;
+        scope_acquire_result_t result = scope_source_acquire(source, 0, &frame);
+        if (result == SCOPE_ACQUIRE_END) break;
+        if (result != SCOPE_ACQUIRE_OK) {
+            state->failed_count++;
+            continue;
+        }
+
+        char name[MAX_PATH_LENGTH];
+        frame_name(input, images, frame.image.generation, name, sizeof(name));
+        if (!process_frame(state, &frame, name, load_start)) state->failed_count++;
+        scope_source_release(source);
+    }
+
+    if (count == 0) {
+        fprintf(stderr, "%s: no frames found starting at index %u\n", input, state->options.first);
+        state->failed_count++;
+    }
+
+    scope_source_destroy(source);
+}
+
+// With --together every input is a view of one scope_multi, which loads and scopes the next frame
+// of each at once, spread over the pool, until all of them ended
+static void process_together(cli_state_t *state, char **inputs, uint32_t input_count) {
+    scope_source_t **sources = calloc(input_count, sizeof(scope_source_t *));
+    const scope_source_t **images = calloc(input_count, sizeof(scope_source_t *));
+    const char **view_inputs = calloc(input_count, sizeof(const char *));
+    if (!sources || !images || !view_inputs) {
+        fprintf(stderr, "Couldn't allocate the inputs\n");
+        state->failed_count += input_count;
+        free(view_inputs);
+        free(images);
+        free(sources);
+        return;
+    }
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < input_count; ++i) {
+        if (input_open(state, inputs[i], &images[count], &sources[count])) {
+            view_inputs[count++] = inputs[i];
+        } else {
+            state->failed_count++;
+        }
+    }
+
+    scope_multi_t multi = {0};
+    scope_config_t config = options_config(&state->options);
+    if (count > 0 && (!scope_multi_create(&multi, sources, count) || !scope_multi_configure(&multi, &config))) {
+        fprintf(stderr, "Couldn't allocate the scopes\n");
+        state->failed_count += count;
+        count = 0;
+    }
+    for (uint32_t v = 0; v < count; ++v) {
+        multi.views[v].vs.kernel = state->options.kernel;
+        multi.views[v].wf.kernel = state->options.kernel;
+    }
+
+    while (count > 0 && !scope_multi_ended(&multi)) {
+        double update_start = scope_cpu_time_seconds();
+        uint32_t scoped = scope_multi_update(&multi, 0, state->pool);
+        // Loading and scoping are one stage for every view at once, each frame gets its share
+        double share = (scope_cpu_time_seconds() - update_start) / (double)MAX(scoped, 1u);
+
+        for (uint32_t v = 0; v < count; ++v) {
+            const scope_multi_view_t *view = &multi.views[v];
+            if (view->result == SCOPE_ACQUIRE_ERROR || (view->result == SCOPE_ACQUIRE_OK && view->failed)) {
+                state->failed_count++;
+                continue;
+            }
+            if (view->result != SCOPE_ACQUIRE_OK) continue;
+
+            char name[MAX_PATH_LENGTH];
+            frame_name(view_inputs[v], images[v], view->frame.image.generation, name, sizeof(name));
+
+            double render_start = scope_cpu_time_seconds();
+            double write_start;
+            bool ycbcr = scope_pixel_format_is_ycbcr(view->frame.image.format);
+            if (!output_scopes(state, &view->vs, &view->wf, name, ycbcr, &write_start)) state->failed_count++;
+            double end = scope_cpu_time_seconds();
+
+            const double t[CLI_STAGE_COUNT + 1] = {0.0, 0.0, share, share, share + write_start - render_start, share + end - render_start};
+            account_frame(state, &view->frame.image, name, t);
+        }
+    }
+
+    for (uint32_t v = 0; v < count; ++v) {
+        if (multi.views[v].scoped == 0) {
+            fprintf(stderr, "%s: no frames found starting at index %u\n", view_inputs[v], state->options.first);
+            state->failed_count++;
+        }
+    }
+
+    // Zeroed if it was never created
+    scope_multi_destroy(&multi);
+    free(view_inputs);
+    free(images);
+    free(sources);
+}
+
+static void print_summary(const cli_state_t *state, double wall_seconds) {
+    if (state->frame_count == 0) return;
+
+    printf("%llu frame(s), %.1f Mpix, %u thread(s), %s kernel, best ISA %s\n",
+           (unsigned long long)state->frame_count,
+           (double)state->pixel_count / 1e6,
+           scope_thread_pool_size(state->pool),
+           state->options.kernel == SCOPE_KERNEL_LUT ? "lut" : "float",
+           scope_isa_name(scope_cpu_best_isa()));
+
+    for (uint32_t s = 0; s < CLI_STAGE_COUNT; ++s) {
+        printf("  %-12s %10.2f ms total %8.2f ms/frame\n",
+               stage_names[s], state->stage_seconds[s] * 1000.0, state->stage_seconds[s] * 1000.0 / (double)state->frame_count);
+    }
+
+    if (state->options.sampling.budget > 0) {
+        printf("  %s sampling, at most %u pixels per frame\n",
+               state->options.sampling.pattern == SCOPE_SAMPLE_HALTON ? "halton" : "stratified", state->options.sampling.budget);
+    }
+
+    if (state->options.half_life > 0.0f) {
+        printf("  persistence, half-life of %g frames\n", state->options.half_life);
+    }
+
+    if (state->options.together) {
+        printf("  inputs scoped together, the vectorscope stage includes loading and the waveform\n");
+    }
+
+    if (state->hdr_frame_count > 0) {
+        printf("  %llu HDR frame(s), MaxCLL %.0f nits, MaxFALL %.0f nits\n",
+               (unsigned long long)state->hdr_frame_count, state->hdr_level.max_nits, state->hdr_level.average_nits);
+    }
+
+    double analysis = state->stage_seconds[CLI_STAGE_VECTORSCOPE] + state->stage_seconds[CLI_STAGE_WAVEFORM];
+    printf("  %.2f fps overall, %.2f fps analysis only\n",
+           (double)state->frame_count / wall_seconds,
+           analysis > 0.0 ? (double)state->frame_count / analysis : 0.0);
+}
+
+int main(int argc, char **argv) {
+    cli_state_t state = {0};
+    int first_input;
+    if (!parse_options(argc, argv, &state.options, &first_input)) {
+        print_usage();
+        return 2;
+    }
+
+    if (!state_create(&state)) {
+        state_destroy(&state);
+        return 1;
+    }
+
+    double start = scope_cpu_time_seconds();
+    if (state.options.together) {
+        process_together(&state, argv + first_input, (uint32_t)(argc - first_input));
+    } else {
+        for (int a = first_input; a < argc; ++a) {
+            process_input(&state, argv[a]);
+        }
+    }
+    print_summary(&state, scope_cpu_time_seconds() - start);
+
+    state_destroy(&state);
+
+    if (state.failed_count > 0) {
+        fprintf(stderr, "%llu input(s) failed\n", (unsigned long long)state.failed_count);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "png.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest payload of a stored deflate block
+#define STORED_BLOCK_MAX 65535
+
+static uint32_t crc_table[256];
+
+static void crc_table_init(void) {
+    if (crc_table[1] != 0) return;
+
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        crc = crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void put_u32_be(uint8_t *out, uint32_t v) {
+    out[0] = (uint8_t)(v >> 24);
+    out[1] = (uint8_t)(v >> 16);
+    out[2] = (uint8_t)(v >> 8);
+    out[3] = (uint8_t)v;
+}
+
+static bool write_chunk(FILE *file, const char type[4], const uint8_t *data, uint32_t size) {
+    uint8_t header[8];
+    put_u32_be(header, size);
+    memcpy(header + 4, type, 4);
+
+    uint32_t crc = crc_update(0xffffffffu, header + 4, 4);
+    crc = crc_update(crc, data, size) ^ 0xffffffffu;
+
+    uint8_t footer[4];
+    put_u32_be(footer, crc);
+
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+           (size == 0 || fwrite(data, 1, size, file) == size) &&
+           fwrite(footer, 1, sizeof(footer), file) == sizeof(footer);
+}
+
+bool png_write_rgb(const char *path, const uint8_t *rgba, uint32_t width, uint32_t height) {
+    crc_table_init();
+
+    // Scanlines with a leading filter byte (0, none)
+    size_t row_size = 1 + (size_t)width * 3;
+    size_t raw_size = row_size * height;
+    size_t block_count = (raw_size + STORED_BLOCK_MAX - 1) / STORED_BLOCK_MAX;
+    size_t zlib_size = 2 + raw_size + block_count * 5 + 4;
+    if (zlib_size > UINT32_MAX) {
+        return false;
+    }
+
+    uint8_t *raw = malloc(raw_size);
+    uint8_t *zlib = malloc(zlib_size);
+    if (!raw || !zlib) {
+        free(raw);
+        free(zlib);
+        return false;
+    }
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t *out = raw + row_size * y;
+        const uint8_t *in = rgba + (size_t)y * width * 4;
+        *out++ = 0;
+        for (uint32_t x = 0; x < width; ++x, in += 4, out += 3) {
+            out[0] = in[0];
+            out[1] = in[1];
+            out[2] = in[2];
+        }
+    }
+
+    // zlib stream of stored deflate blocks
+    uint8_t *z = zlib;
+    *z++ = 0x78;
+    *z++ = 0x01;
+
+    uint32_t adler_a = 1;
+    uint32_t adler_b = 0;
+    for (size_t offset = 0; offset < raw_size; offset += STORED_BLOCK_MAX) {
+        size_t size = raw_size - offset < STORED_BLOCK_MAX ? raw_size - offset : STORED_BLOCK_MAX;
+        bool last = offset + size == raw_size;
+
+        *z++ = last ? 1 : 0;
+        *z++ = (uint8_t)size;
+        *z++ = (uint8_t)(size >> 8);
+        *z++ = (uint8_t)~size;
+        *z++ = (uint8_t)(~size >> 8);
+        memcpy(z, raw + offset, size);
+        z += size;
+
+        // 5552 bytes is the most that can be summed before adler_b could overflow 32 bits
+        for (size_t i = 0; i < size;) {
+            size_t run_end = i + 5552 < size ? i + 5552 : size;
+            for (; i < run_end; ++i) {
+                adler_a += raw[offset + i];
+                adler_b += adler_a;
+            }
+            adler_a %= 65521;
+            adler_b %= 65521;
+        }
+    }
+    put_u32_be(z, (adler_b << 16) | adler_a);
+
+    uint8_t ihdr[13];
+    put_u32_be(ihdr, width);
+    put_u32_be(ihdr + 4, height);
+    ihdr[8] = 8;  // bit depth
+    ihdr[9] = 2;  // color type RGB
+    ihdr[10] = 0; // compression
+    ihdr[11] = 0; // filter
+    ihdr[12] = 0; // interlace
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+    bool ok = false;
+    FILE *file = fopen(path, "wb");
+    if (file) {
+        ok = fwrite(signature, 1, sizeof(signature), file) == sizeof(signature) &&
+             write_chunk(file, "IHDR", ihdr, sizeof(ihdr)) &&
+             write_chunk(file, "IDAT", zlib, (uint32_t)zlib_size) &&
+             write_chunk(file, "IEND", NULL, 0);
+        ok = (fclose(file) == 0) && ok;
+    }
+
+    free(raw);
+    free(zlib);
+    return ok;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* @brief Writes tightly packed RGBA8 pixels as an 8-bit RGB PNG. The image data is stored without
+ * compression, which keeps writing as cheap as a memcpy and needs no zlib. */
+bool png_write_rgb(const char *path, const uint8_t *rgba, uint32_t width, uint32_t height);
@@ -0,0 +1,145 @@
+#include "source_image.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool file_exists(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+    fclose(file);
+    return true;
+}
+
+// Radiance files hold linear float RGB, converted to half floats instead of tone mapping
+static scope_acquire_result_t acquire_hdr(source_image_t *impl, scope_frame_t *frame) {
+    int width, height, channels;
+    float *values = stbi_loadf(impl->path, &width, &height, &channels, 3);
+    if (!values) {
+        fprintf(stderr, "%s: %s\n", impl->path, stbi_failure_reason());
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    const size_t size = (size_t)width * height * 8;
+    if (size > impl->half_capacity) {
+        uint8_t *half_pixels = realloc(impl->half_pixels, size);
+        if (!half_pixels) {
+            stbi_image_free(values);
+            return SCOPE_ACQUIRE_ERROR;
+        }
+        impl->half_pixels = half_pixels;
+        impl->half_capacity = size;
+    }
+
+    const scope_float_planes_t planes = {
+        .planes = {values, values + 1, values + 2},
+        .width = (uint32_t)width,
+        .height = (uint32_t)height,
+        .stride = (uint32_t)width * 3,
+        .step = 3,
+    };
+    const bool converted = scope_convert_from_planes(&impl->converter, &planes, SCOPE_PIXEL_FORMAT_RGBA16F, impl->half_pixels, (uint32_t)width * 8, NULL);
+    stbi_image_free(values);
+    if (!converted) {
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    impl->full = (scope_rect_t){0, 0, (uint32_t)width, (uint32_t)height};
+    *frame = (scope_frame_t){
+        .image = {
+            .data = impl->half_pixels,
+            .width = (uint32_t)width,
+            .height = (uint32_t)height,
+            .stride = (uint32_t)width * 8,
+            .format = SCOPE_PIXEL_FORMAT_RGBA16F,
+            .generation = impl->generation,
+            .transfer = SCOPE_TRANSFER_LINEAR,
+        },
+        .dirty = &impl->full,
+        .dirty_count = 1,
+        .timestamp = (double)(impl->generation - 1) / impl->frame_rate,
+    };
+    return SCOPE_ACQUIRE_OK;
+}
+
+static scope_acquire_result_t image_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    (void)timeout_ms;
+    source_image_t *impl = (source_image_t *)source;
+
+    if (impl->sequence) {
+        snprintf(impl->path, sizeof(impl->path), impl->pattern, impl->index);
+        if (!file_exists(impl->path)) {
+            return SCOPE_ACQUIRE_END;
+        }
+    } else if (impl->generation > 0) {
+        return SCOPE_ACQUIRE_END;
+    }
+    impl->index++;
+    impl->generation++;
+
+    if (stbi_is_hdr(impl->path)) {
+        return acquire_hdr(impl, frame);
+    }
+
+    int width, height, channels;
+    impl->pixels = stbi_load(impl->path, &width, &height, &channels, 4);
+    if (!impl->pixels) {
+        fprintf(stderr, "%s: %s\n", impl->path, stbi_failure_reason());
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    impl->full = (scope_rect_t){0, 0, (uint32_t)width, (uint32_t)height};
+    *frame = (scope_frame_t){
+        .image = {
+            .data = impl->pixels,
+            .width = (uint32_t)width,
+            .height = (uint32_t)height,
+            .stride = (uint32_t)width * 4,
+            .format = SCOPE_PIXEL_FORMAT_RGBA8,
+            .generation = impl->generation,
+        },
+        .dirty = &impl->full,
+        .dirty_count = 1,
+        .timestamp = (double)(impl->generation - 1) / impl->frame_rate,
+    };
+    return SCOPE_ACQUIRE_OK;
+}
+
+static void image_release(scope_source_t *source) {
+    source_image_t *impl = (source_image_t *)source;
+    stbi_image_free(impl->pixels);
+    impl->pixels = NULL;
+}
+
+static void image_destroy(scope_source_t *source) {
+    source_image_t *impl = (source_image_t *)source;
+    scope_converter_destroy(&impl->converter);
+    free(impl->half_pixels);
+    free(source);
+}
+
+bool source_image_create(const char *pattern, uint32_t first, double frame_rate, scope_source_t **source) {
+    source_image_t *impl = malloc(sizeof(source_image_t));
+    if (!impl) return false;
+
+    *impl = (source_image_t){
+        .base = {
+            .name = "image",
+            .interface = {image_acquire, image_release, image_destroy},
+        },
+        .pattern = pattern,
+        .sequence = strchr(pattern, '%') != NULL,
+        .index = first,
+        .frame_rate = frame_rate,
+    };
+    scope_converter_create(&impl->converter);
+    if (!impl->sequence) {
+        snprintf(impl->path, sizeof(impl->path), "%s", pattern);
+    }
+
+    *source = &impl->base;
+    return true;
+}
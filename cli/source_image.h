@@ -0,0 +1,33 @@
+#pragma once
+
+#include "scope_convert.h"
+#include "scope_source.h"
+
+#include <stdint.h>
+
+#define SOURCE_IMAGE_PATH_LENGTH 1024
+
+// Frame source over stills and printf-style image sequences (shot_%04d.png), decoded with
+// stb_image. Sequences run from `first` until the first missing file. Radiance .hdr files come
+// out as linear RGBA16F, with 1.0 at scRGB white, instead of being tone mapped to 8 bits.
+
+typedef struct source_image {
+    scope_source_t base;
+
+    const char *pattern;
+    bool sequence;
+    uint32_t index; // of the next frame
+    uint64_t generation;
+    double frame_rate;
+
+    uint8_t *pixels; // of the acquired frame
+    uint8_t *half_pixels; // RGBA16F of .hdr files, reused from frame to frame
+    size_t half_capacity;
+    scope_converter_t converter;
+    scope_rect_t full;
+    char path[SOURCE_IMAGE_PATH_LENGTH]; // of the acquired frame
+} source_image_t;
+
+/* @brief The pattern is not copied and has to outlive the source. Frames of a sequence are
+ * timestamped at `frame_rate`. */
+bool source_image_create(const char *pattern, uint32_t first, double frame_rate, scope_source_t **source);
@@ -1,10 +1,12 @@
 #include "application.h"
 
 #include "capture.h"
+#include "capture_source.h"
 #include "input.h"
 #include "logger.h"
 #include "macros.h"
 #include "renderer.h"
+#include "scope_multi.h"
 #include "texture.h"
 #include "ui.h"
 #include "vectorscope.h"
@@ -22,6 +24,18 @@ static input_state_t input;
 
 static texture_t spritesheet;
 
+// The desktop area the scopes show, captured on a producer thread by an async scope source and
+// uploaded into renderer.blit_texture. `capture_generation` is that of the last frame uploaded.
+static const rect_t capture_area = {0, 0, 500, 500};
+static scope_source_t *capture_source;
+static uint64_t capture_generation;
+
+// Every capturable monitor as a whole, each with CPU scopes of its own, scoped at the same time on
+// `monitor_pool` through a duplication per monitor, so switching the active monitor never tears
+// down the others. Their sources use the immediate context and stay on this thread.
+static scope_multi_t monitor_scopes;
+static scope_thread_pool_t *monitor_pool;
+
 typedef struct overlay_state {
     window_t window;
     rect_t selection;
@@ -62,6 +76,10 @@ typedef struct app_state {
 static bool application_initialize(void);
 static void application_terminate(void);
 static void application_update(double dt);
+static void upload_capture(void);
+static bool set_scope_config(const scope_config_t *config);
+static void monitor_scopes_create(void);
+static void monitor_scopes_destroy(void);
 static bool application_run(void);
 
 static bool interact_close(ui_element_t *el);
@@ -315,11 +333,30 @@ static bool application_initialize(void) {
 
     capture_set_monitor(&renderer.capture, renderer.device, 1);
 
+    // Shares the duplication of the active monitor, which must not change while the producer runs
+    if (!capture_source_create(&renderer.capture, renderer.device, renderer.context, capture_area, &capture_source) ||
+        !scope_source_async_create(capture_source, &capture_source)) {
+        LOG("Failed to create the capture source");
+        capture_source = NULL;
+        return false;
+    }
+
+    monitor_scopes_create();
+
     return true;
 }
 
 static void application_terminate(void) {
     LOG("Application is terminating");
+    if (capture_source) {
+        scope_async_stats_t stats;
+        scope_source_async_stats(capture_source, &stats);
+        LOG("Captured %llu frames, scoped %llu, dropped %llu, failed %llu, latency %.2f ms mean, %.2f ms max",
+            stats.captured, stats.scoped, stats.dropped, stats.failed, stats.latency_mean * 1000.0, stats.latency_max * 1000.0);
+        scope_source_destroy(capture_source);
+        capture_source = NULL;
+    }
+    monitor_scopes_destroy();
     window_destroy(&window);
 
     renderer_terminate(&renderer);
@@ -333,6 +370,70 @@ static void application_update(double dt) {
         window_set_always_on_top(&window, (on_top = !on_top));
     }
 
+    // Ctrl+1..4 pick the scope quality, from 256 up to 2048 bins a side
+    if (input_is_key_down(KEY_CTRL)) {
+        for (uint32_t quality = 0; quality < SCOPE_QUALITY_COUNT; ++quality) {
+            if (input_is_key_pressed((keycode_t)(KEY_1 + quality))) {
+                scope_config_t config = scope_config_preset((scope_quality_t)quality);
+                config.vs_zoom = renderer.scope_config.vs_zoom;
+                config.encoding = renderer.scope_config.encoding;
+                if (!set_scope_config(&config)) {
+                    LOG("Failed to switch scope quality");
+                }
+            }
+        }
+    }
+
+    // Ctrl+0 steps the vectorscope zoom through 1x, 2x, 4x and 8x
+    if (input_is_key_down(KEY_CTRL) && input_is_key_pressed(KEY_0)) {
+        scope_config_t config = renderer.scope_config;
+        config.vs_zoom = config.vs_zoom < SCOPE_VS_MAX_ZOOM ? config.vs_zoom * 2 : 1;
+        if (!set_scope_config(&config)) {
+            LOG("Failed to switch vectorscope zoom");
+        }
+    }
+
+    // Ctrl+T steps the trails of the scopes through off and half-lives of 4, 15 and 60 frames
+    if (input_is_key_down(KEY_CTRL) && input_is_key_pressed(KEY_T)) {
+        static const float half_lives[] = {0.0f, 4.0f, 15.0f, 60.0f};
+        static uint32_t persistence = 0;
+        persistence = (persistence + 1) % ARRAY_LENGTH(half_lives);
+        if (!renderer_set_scope_persistence(&renderer, half_lives[persistence])) {
+            LOG("Failed to switch scope persistence");
+        }
+    }
+
+    // Ctrl+U steps the vectorscope blur through diamond, box and Gaussian, Ctrl+I its radius
+    // through 1 to 64 in doublings, 2 the diamond it starts out with
+    if (input_is_key_down(KEY_CTRL) && (input_is_key_pressed(KEY_U) || input_is_key_pressed(KEY_I))) {
+        scope_blur_shape_t shape = renderer.vs_blur_shape;
+        uint32_t radius = renderer.vs_blur_radius;
+        if (input_is_key_pressed(KEY_U)) {
+            shape = (scope_blur_shape_t)((shape + 1) % SCOPE_BLUR_SHAPE_COUNT);
+        }
+        if (input_is_key_pressed(KEY_I)) {
+            radius = radius < SCOPE_BLUR_MAX_RADIUS ? MAX(radius * 2, 1) : 1;
+        }
+        if (!renderer_set_scope_blur(&renderer, shape, radius)) {
+            LOG("Failed to switch vectorscope blur");
+        }
+    }
+
+    // Ctrl+Y steps the Y'CbCr matrix through BT.601, BT.709 and BT.2020, Ctrl+R toggles full and
+    // limited range. Each is a permutation of the passes that is already compiled.
+    if (input_is_key_down(KEY_CTRL) && (input_is_key_pressed(KEY_Y) || input_is_key_pressed(KEY_R))) {
+        scope_config_t config = renderer.scope_config;
+        if (input_is_key_pressed(KEY_Y)) {
+            config.encoding.matrix = (scope_matrix_t)((config.encoding.matrix + 1) % SCOPE_MATRIX_COUNT);
+        }
+        if (input_is_key_pressed(KEY_R)) {
+            config.encoding.range = config.encoding.range == SCOPE_COLOR_RANGE_FULL ? SCOPE_COLOR_RANGE_LIMITED : SCOPE_COLOR_RANGE_FULL;
+        }
+        if (!set_scope_config(&config)) {
+            LOG("Failed to switch scope encoding");
+        }
+    }
+
     if (input_is_mouse_button_pressed(MOUSE_BUTTON_LEFT)) {
         if (ui.curr_hovered_element_id != -1) {
             ui_element_t *el = &ui.elements[ui.curr_hovered_element_id];
@@ -446,7 +547,89 @@ static void application_update(double dt) {
     //     }
     // }
 
-    capture_frame(&renderer.capture, (rect_t){0, 0, 500, 500}, renderer.context, &renderer.blit_texture);
+    upload_capture();
+    if (monitor_scopes.view_count > 0) {
+        scope_multi_update(&monitor_scopes, 0, monitor_pool);
+    }
+}
+
+// Copies the dirty rects of a new desktop frame into the blit texture. The shared duplication is
+// never float16, so the frames are BGRA8 like the texture.
+static void upload_capture(void) {
+    scope_frame_t frame;
+    if (scope_source_acquire(capture_source, 0, &frame) != SCOPE_ACQUIRE_OK) {
+        return;
+    }
+
+    if (frame.image.format == SCOPE_PIXEL_FORMAT_BGRA8) {
+        ID3D11DeviceContext1 *context = renderer.context;
+        for (uint32_t i = 0; i < frame.dirty_count; ++i) {
+            const scope_rect_t *rect = &frame.dirty[i];
+            D3D11_BOX box = {
+                .left = rect->x,
+                .top = rect->y,
+                .right = rect->x + rect->width,
+                .bottom = rect->y + rect->height,
+                .front = 0,
+                .back = 1,
+            };
+            const uint8_t *pixels = frame.image.data + (size_t)rect->y * frame.image.stride + (size_t)rect->x * 4;
+            context->lpVtbl->UpdateSubresource(context, (ID3D11Resource *)renderer.blit_texture.texture, 0, &box, pixels, frame.image.stride, 0);
+        }
+        capture_generation = frame.image.generation;
+    } else {
+        LOG("The capture source delivers pixel format %u, the blit texture is BGRA8", frame.image.format);
+    }
+
+    scope_source_release(capture_source);
+}
+
+// The GPU scopes and those of every monitor always measure with the same settings
+static bool set_scope_config(const scope_config_t *config) {
+    if (!renderer_set_scope_config(&renderer, config)) {
+        return false;
+    }
+    return monitor_scopes.view_count == 0 || scope_multi_configure(&monitor_scopes, config);
+}
+
+// Monitors that can't be duplicated are left out, the app runs on without them
+static void monitor_scopes_create(void) {
+    if (!scope_thread_pool_create(0, &monitor_pool)) {
+        LOG("Failed to create the monitor scope pool");
+        return;
+    }
+
+    scope_source_t *sources[CS_MAX_MONITORS];
+    uint32_t source_count = 0;
+    for (uint32_t i = 0; i < renderer.capture.monitor_count; ++i) {
+        if (!renderer.capture.monitors[i].can_capture) {
+            continue;
+        }
+        if (capture_source_create_monitor(&renderer.capture, renderer.device, renderer.context, i, &sources[source_count])) {
+            source_count++;
+        } else {
+            LOG("Monitor %u is not scoped", i);
+        }
+    }
+
+    if (source_count == 0 || !scope_multi_create(&monitor_scopes, sources, source_count)) {
+        LOG("No monitor is scoped");
+        return;
+    }
+    if (!scope_multi_configure(&monitor_scopes, &renderer.scope_config)) {
+        LOG("Failed to configure the monitor scopes");
+    }
+    LOG("Scoping %u monitors on %u threads", source_count, scope_thread_pool_size(monitor_pool));
+}
+
+static void monitor_scopes_destroy(void) {
+    for (uint32_t i = 0; i < monitor_scopes.view_count; ++i) {
+        const scope_multi_view_t *view = &monitor_scopes.views[i];
+        LOG("Monitor view %u scoped %llu frames of %ux%u", i, view->scoped, view->frame.image.width, view->frame.image.height);
+    }
+    scope_multi_destroy(&monitor_scopes);
+    scope_thread_pool_destroy(monitor_pool);
+    monitor_pool = NULL;
 }
 
 static bool application_run(void) {
@@ -481,8 +664,10 @@ static bool application_run(void) {
         // could add interpolation for rendering as well
         renderer_begin_frame(&renderer);
 
-        vectorscope_render(&renderer.vectorscope, &renderer, &renderer.blit_texture);
-        waveform_render(&renderer.waveform, &renderer, &renderer.blit_texture);
+        // Each scope skips its passes when the capture has no new frame since its last render and
+        // it has no trails left to fade
+        vectorscope_render(&renderer.vectorscope, &renderer, &renderer.blit_texture, capture_generation);
+        waveform_render(&renderer.waveform, &renderer, &renderer.blit_texture, capture_generation);
         parade_render(&renderer.waveform, &renderer);
 
         renderer_draw_ui(&renderer, &ui, &ui.elements[0], false);
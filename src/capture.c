@@ -9,6 +9,10 @@
 
 #include <shellscalingapi.h>
 
+// The render loop polls for a new desktop frame and moves on without one, rather than blocking
+// until the next present. Scoping stale pixels beats stalling the UI.
+#define CAPTURE_ACQUIRE_TIMEOUT_MS 0
+
 struct monitor_enum_context {
     monitor_info_t *monitors;
     uint32_t count;
@@ -79,7 +83,7 @@ bool capture_frame(capture_t *capture, rect_t area, ID3D11DeviceContext1 *contex
 
     // Acquire next frame
     IDXGIResource *desktop_resource = NULL;
-    HRESULT hr = capture->duplication->lpVtbl->AcquireNextFrame(capture->duplication, 50, &capture->frame_info, &desktop_resource);
+    HRESULT hr = capture->duplication->lpVtbl->AcquireNextFrame(capture->duplication, CAPTURE_ACQUIRE_TIMEOUT_MS, &capture->frame_info, &desktop_resource);
     if (hr == DXGI_ERROR_WAIT_TIMEOUT) {
         // Not an error, we just have no new frames...
         return true;
@@ -91,6 +95,15 @@ bool capture_frame(capture_t *capture, rect_t area, ID3D11DeviceContext1 *contex
         return false;
     }
 
+    // Only the mouse pointer changed, the output texture already holds this desktop image
+    bool same_area = area.x == capture->frame_area.x && area.y == capture->frame_area.y &&
+                     area.width == capture->frame_area.width && area.height == capture->frame_area.height;
+    if (capture->frame_info.LastPresentTime.QuadPart == 0 && capture->frame_generation > 0 && same_area) {
+        desktop_resource->lpVtbl->Release(desktop_resource);
+        capture->duplication->lpVtbl->ReleaseFrame(capture->duplication);
+        return true;
+    }
+
     // Get texture interface
     ID3D11Texture2D *desktop_texture = NULL;
     hr = desktop_resource->lpVtbl->QueryInterface(desktop_resource, IID_PPV_ARGS_C(ID3D11Texture2D, &desktop_texture));
@@ -117,6 +130,9 @@ bool capture_frame(capture_t *capture, rect_t area, ID3D11DeviceContext1 *contex
                                            (ID3D11Resource *)out_texture->texture, 0, 0, 0, 0,
                                            (ID3D11Resource *)desktop_texture, 0, &src_box);
 
+    capture->frame_generation++;
+    capture->frame_area = area;
+
     // Cleanup
     desktop_texture->lpVtbl->Release(desktop_texture);
     desktop_resource->lpVtbl->Release(desktop_resource);
@@ -157,6 +173,27 @@ bool capture_set_monitor(capture_t *capture, ID3D11Device1 *device, uint8_t moni
     // Get the monitor info
     monitor_info_t *monitor = &capture->monitors[monitor_id];
 
+    if (!capture_duplicate_monitor(device, monitor, false, &capture->output, &capture->duplication)) {
+        return false;
+    }
+
+    // Get and store the output description for capture setup
+    DXGI_OUTDUPL_DESC desc = {0};
+    capture->duplication->lpVtbl->GetDesc(capture->duplication, &desc);
+    capture->format = desc.ModeDesc.Format;
+
+    // Update active monitor index
+    capture->active_monitor = monitor_id;
+
+    // Make sure the first frame of the new monitor is copied even if only the pointer moved
+    capture->frame_area = (rect_t){0};
+
+    LOG("Successfully set capture to monitor %u (adapter %u, output %u)", monitor_id, monitor->adapter_index, monitor->output_index);
+
+    return true;
+}
+
+bool capture_duplicate_monitor(ID3D11Device1 *device, const monitor_info_t *monitor, bool float16, IDXGIOutput1 **out_output, IDXGIOutputDuplication **out_duplication) {
     // Create DXGI factory to get the specific adapter
     IDXGIFactory *factory = NULL;
     HRESULT hr = CreateDXGIFactory(IID_PPV_ARGS_C(IDXGIFactory, &factory));
@@ -169,7 +206,7 @@ bool capture_set_monitor(capture_t *capture, ID3D11Device1 *device, uint8_t moni
     IDXGIAdapter *adapter = NULL;
     hr = factory->lpVtbl->EnumAdapters(factory, monitor->adapter_index, &adapter);
     if (FAILED(hr)) {
-        LOG("Failed to get DXGI Adapter %u for monitor %u", monitor->adapter_index, monitor_id);
+        LOG("Failed to get DXGI Adapter %u for monitor %u", monitor->adapter_index, monitor->id);
         factory->lpVtbl->Release(factory);
         return false;
     }
@@ -178,7 +215,7 @@ bool capture_set_monitor(capture_t *capture, ID3D11Device1 *device, uint8_t moni
     IDXGIOutput *output = NULL;
     hr = adapter->lpVtbl->EnumOutputs(adapter, monitor->output_index, &output);
     if (FAILED(hr)) {
-        LOG("Failed to get output %u on adapter %u for monitor %u", monitor->output_index, monitor->adapter_index, monitor_id);
+        LOG("Failed to get output %u on adapter %u for monitor %u", monitor->output_index, monitor->adapter_index, monitor->id);
         adapter->lpVtbl->Release(adapter);
         factory->lpVtbl->Release(factory);
         return false;
@@ -195,10 +232,20 @@ bool capture_set_monitor(capture_t *capture, ID3D11Device1 *device, uint8_t moni
         return false;
     }
 
-    // Create the new duplication interface and cache it
-    hr = output1->lpVtbl->DuplicateOutput(output1, (IUnknown *)device, &capture->duplication);
+    // Create the duplication interface. DuplicateOutput1 picks the first of the formats the desktop
+    // can be handed out in, older systems only have DuplicateOutput.
+    hr = E_NOINTERFACE;
+    IDXGIOutput5 *output5 = NULL;
+    if (float16 && SUCCEEDED(output->lpVtbl->QueryInterface(output, IID_PPV_ARGS_C(IDXGIOutput5, &output5)))) {
+        const DXGI_FORMAT formats[] = {DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_B8G8R8A8_UNORM};
+        hr = output5->lpVtbl->DuplicateOutput1(output5, (IUnknown *)device, 0, ARRAY_LENGTH(formats), formats, out_duplication);
+        output5->lpVtbl->Release(output5);
+    }
+    if (FAILED(hr)) {
+        hr = output1->lpVtbl->DuplicateOutput(output1, (IUnknown *)device, out_duplication);
+    }
     if (FAILED(hr)) {
-        LOG("Failed to create new duplication interface for monitor %u (HRESULT: 0x%08x)", monitor_id, hr);
+        LOG("Failed to create new duplication interface for monitor %u (HRESULT: 0x%08x)", monitor->id, hr);
         output1->lpVtbl->Release(output1);
         output->lpVtbl->Release(output);
         adapter->lpVtbl->Release(adapter);
@@ -206,18 +253,7 @@ bool capture_set_monitor(capture_t *capture, ID3D11Device1 *device, uint8_t moni
         return false;
     }
 
-    // Store the output interface for later use
-    capture->output = output1;
-
-    // Get and store the output description for capture setup
-    DXGI_OUTDUPL_DESC desc = {0};
-    capture->duplication->lpVtbl->GetDesc(capture->duplication, &desc);
-    capture->format = desc.ModeDesc.Format;
-
-    // Update active monitor index
-    capture->active_monitor = monitor_id;
-
-    LOG("Successfully set capture to monitor %u (adapter %u, output %u)", monitor_id, monitor->adapter_index, monitor->output_index);
+    *out_output = output1;
 
     // Cleanup
     output->lpVtbl->Release(output);
@@ -6,7 +6,7 @@
 #include <stdint.h>
 
 #include <d3d11_1.h>
-#include <dxgi1_2.h>
+#include <dxgi1_5.h>
 
 #define CS_MAX_MONITORS 3
 
@@ -36,6 +36,11 @@ typedef struct capture {
     DXGI_FORMAT format;
     DXGI_OUTDUPL_FRAME_INFO frame_info;
 
+    // Incremented every time a new desktop image is copied into the output texture, so consumers
+    // can tell a new frame from a timed out acquire or a pointer-only update. 0 before the first one.
+    uint64_t frame_generation;
+    rect_t frame_area;
+
     monitor_info_t monitors[CS_MAX_MONITORS];
     uint32_t monitor_count;
     uint32_t active_monitor;
@@ -45,5 +50,9 @@ bool capture_initialize(ID3D11Device1 *device, capture_t *capture);
 void capture_terminate(capture_t *capture);
 bool capture_frame(capture_t *capture, rect_t area, ID3D11DeviceContext1 *context, struct texture *out_texture);
 bool capture_set_monitor(capture_t *capture, ID3D11Device1 *device, uint8_t monitor_id);
+/* @brief Opens a duplication of `monitor` independent of the active one, e.g. to capture several
+ * monitors at once. With `float16`, HDR desktops come as R16G16B16A16_FLOAT scRGB instead of being
+ * tone mapped to 8 bits, where the OS supports it. The caller releases both interfaces. */
+bool capture_duplicate_monitor(ID3D11Device1 *device, const monitor_info_t *monitor, bool float16, IDXGIOutput1 **out_output, IDXGIOutputDuplication **out_duplication);
 uint32_t capture_enumerate_monitors(monitor_info_t *monitors, uint32_t max_count);
 monitor_info_t *capture_find_best_monitor_for_rect(capture_t *capture, rect_t selection);
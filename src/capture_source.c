@@ -0,0 +1,342 @@
+#include "capture_source.h"
+
+#include "logger.h"
+#include "macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+typedef struct capture_source {
+    scope_source_t base;
+
+    capture_t *capture; // NULL if the source duplicates a monitor of its own
+    IDXGIOutput1 *output;
+    IDXGIOutputDuplication *duplication; // owned along with `output` if `capture` is NULL
+    ID3D11DeviceContext1 *context;
+    ID3D11Texture2D *staging;
+    scope_rect_t area; // in pixels of the output
+    scope_pixel_format_t format;
+    scope_transfer_t transfer;
+    double ticks_per_second;
+    uint64_t generation;
+
+    // Move and dirty rects as DXGI reports them
+    uint8_t *metadata;
+    uint32_t metadata_capacity;
+
+    // The same, clipped to the area
+    scope_rect_t *dirty;
+    uint32_t dirty_count;
+    uint32_t dirty_capacity;
+} capture_source_t;
+
+// The shared duplication follows capture_set_monitor()
+static IDXGIOutputDuplication *get_duplication(const capture_source_t *impl) {
+    return impl->capture ? impl->capture->duplication : impl->duplication;
+}
+
+static bool push_dirty(capture_source_t *impl, RECT rect) {
+    LONG left = MAX(rect.left, (LONG)impl->area.x);
+    LONG top = MAX(rect.top, (LONG)impl->area.y);
+    LONG right = MIN(rect.right, (LONG)(impl->area.x + impl->area.width));
+    LONG bottom = MIN(rect.bottom, (LONG)(impl->area.y + impl->area.height));
+    if (left >= right || top >= bottom) {
+        return true;
+    }
+
+    if (impl->dirty_count == impl->dirty_capacity) {
+        uint32_t capacity = MAX(16u, impl->dirty_capacity * 2);
+        scope_rect_t *dirty = realloc(impl->dirty, capacity * sizeof(scope_rect_t));
+        if (!dirty) {
+            return false;
+        }
+        impl->dirty = dirty;
+        impl->dirty_capacity = capacity;
+    }
+
+    impl->dirty[impl->dirty_count++] = (scope_rect_t){
+        .x = (uint32_t)left - impl->area.x,
+        .y = (uint32_t)top - impl->area.y,
+        .width = (uint32_t)(right - left),
+        .height = (uint32_t)(bottom - top),
+    };
+    return true;
+}
+
+// Moved regions only change at their destination, the source of a move is reported as dirty too
+static bool collect_dirty(capture_source_t *impl, const DXGI_OUTDUPL_FRAME_INFO *info) {
+    IDXGIOutputDuplication *duplication = get_duplication(impl);
+    impl->dirty_count = 0;
+
+    if (impl->generation == 0) {
+        RECT full = {
+            .left = (LONG)impl->area.x,
+            .top = (LONG)impl->area.y,
+            .right = (LONG)(impl->area.x + impl->area.width),
+            .bottom = (LONG)(impl->area.y + impl->area.height),
+        };
+        return push_dirty(impl, full);
+    }
+
+    if (info->TotalMetadataBufferSize > impl->metadata_capacity) {
+        uint8_t *metadata = realloc(impl->metadata, info->TotalMetadataBufferSize);
+        if (!metadata) {
+            return false;
+        }
+        impl->metadata = metadata;
+        impl->metadata_capacity = info->TotalMetadataBufferSize;
+    }
+
+    UINT move_size = 0;
+    HRESULT hr = duplication->lpVtbl->GetFrameMoveRects(duplication, impl->metadata_capacity, (DXGI_OUTDUPL_MOVE_RECT *)impl->metadata, &move_size);
+    if (FAILED(hr)) {
+        LOG("Failed to get the move rects");
+        return false;
+    }
+
+    const DXGI_OUTDUPL_MOVE_RECT *moves = (const DXGI_OUTDUPL_MOVE_RECT *)impl->metadata;
+    for (UINT i = 0; i < move_size / sizeof(DXGI_OUTDUPL_MOVE_RECT); ++i) {
+        if (!push_dirty(impl, moves[i].DestinationRect)) {
+            return false;
+        }
+    }
+
+    UINT dirty_size = 0;
+    RECT *rects = (RECT *)(impl->metadata + move_size);
+    hr = duplication->lpVtbl->GetFrameDirtyRects(duplication, impl->metadata_capacity - move_size, rects, &dirty_size);
+    if (FAILED(hr)) {
+        LOG("Failed to get the dirty rects");
+        return false;
+    }
+
+    for (UINT i = 0; i < dirty_size / sizeof(RECT); ++i) {
+        if (!push_dirty(impl, rects[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Copies the area of an acquired desktop image into the staging texture and maps it
+static scope_acquire_result_t copy_frame(capture_source_t *impl, IDXGIResource *desktop_resource, const DXGI_OUTDUPL_FRAME_INFO *info, scope_frame_t *frame) {
+    ID3D11Texture2D *desktop_texture = NULL;
+    HRESULT hr = desktop_resource->lpVtbl->QueryInterface(desktop_resource, IID_PPV_ARGS_C(ID3D11Texture2D, &desktop_texture));
+    if (FAILED(hr)) {
+        LOG("Failed to get desktop texture");
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    if (!collect_dirty(impl, info)) {
+        desktop_texture->lpVtbl->Release(desktop_texture);
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    D3D11_BOX src_box = {
+        .left = impl->area.x,
+        .top = impl->area.y,
+        .right = impl->area.x + impl->area.width,
+        .bottom = impl->area.y + impl->area.height,
+        .front = 0,
+        .back = 1,
+    };
+    impl->context->lpVtbl->CopySubresourceRegion(impl->context,
+                                                 (ID3D11Resource *)impl->staging, 0, 0, 0, 0,
+                                                 (ID3D11Resource *)desktop_texture, 0, &src_box);
+    desktop_texture->lpVtbl->Release(desktop_texture);
+    impl->context->lpVtbl->Flush(impl->context);
+
+    // Waits for the copy without blocking in Map, which would hold the context's lock and stall
+    // the render thread while the source runs on a thread of its own
+    D3D11_MAPPED_SUBRESOURCE mapped = {0};
+    while ((hr = impl->context->lpVtbl->Map(impl->context, (ID3D11Resource *)impl->staging, 0, D3D11_MAP_READ,
+                                            D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped)) == DXGI_ERROR_WAS_STILL_DRAWING) {
+        Sleep(1);
+    }
+    if (FAILED(hr)) {
+        LOG("Failed to map the staging texture");
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    impl->generation++;
+    *frame = (scope_frame_t){
+        .image = {
+            .data = mapped.pData,
+            .width = impl->area.width,
+            .height = impl->area.height,
+            .stride = mapped.RowPitch,
+            .format = impl->format,
+            .generation = impl->generation,
+            .transfer = impl->transfer,
+        },
+        .dirty = impl->dirty,
+        .dirty_count = impl->dirty_count,
+        .timestamp = (double)info->LastPresentTime.QuadPart / impl->ticks_per_second,
+    };
+    return SCOPE_ACQUIRE_OK;
+}
+
+static scope_acquire_result_t capture_source_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    capture_source_t *impl = (capture_source_t *)source;
+    IDXGIOutputDuplication *duplication = get_duplication(impl);
+
+    DXGI_OUTDUPL_FRAME_INFO info = {0};
+    IDXGIResource *desktop_resource = NULL;
+    HRESULT hr = duplication->lpVtbl->AcquireNextFrame(duplication, timeout_ms, &info, &desktop_resource);
+    if (hr == DXGI_ERROR_WAIT_TIMEOUT) {
+        return SCOPE_ACQUIRE_TIMEOUT;
+    }
+    if (FAILED(hr)) {
+        LOG("Failed to acquire next frame");
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    // Only the mouse pointer changed, the staging texture already holds this desktop image
+    scope_acquire_result_t result = SCOPE_ACQUIRE_TIMEOUT;
+    if (info.LastPresentTime.QuadPart != 0 || impl->generation == 0) {
+        result = copy_frame(impl, desktop_resource, &info, frame);
+    }
+
+    desktop_resource->lpVtbl->Release(desktop_resource);
+    duplication->lpVtbl->ReleaseFrame(duplication);
+    return result;
+}
+
+static void capture_source_release(scope_source_t *source) {
+    capture_source_t *impl = (capture_source_t *)source;
+    impl->context->lpVtbl->Unmap(impl->context, (ID3D11Resource *)impl->staging, 0);
+}
+
+static void release_duplication(IDXGIOutput1 *output, IDXGIOutputDuplication *duplication) {
+    if (duplication) {
+        duplication->lpVtbl->Release(duplication);
+    }
+    if (output) {
+        output->lpVtbl->Release(output);
+    }
+}
+
+static void capture_source_destroy(scope_source_t *source) {
+    capture_source_t *impl = (capture_source_t *)source;
+    if (impl->staging) {
+        impl->staging->lpVtbl->Release(impl->staging);
+    }
+    release_duplication(impl->output, impl->duplication);
+    free(impl->metadata);
+    free(impl->dirty);
+    free(impl);
+}
+
+static bool create(capture_t *capture, IDXGIOutput1 *output, IDXGIOutputDuplication *duplication, DXGI_FORMAT dxgi_format,
+                   ID3D11Device1 *device, ID3D11DeviceContext1 *context, rect_t area, scope_source_t **source);
+
+bool capture_source_create(capture_t *capture, ID3D11Device1 *device, ID3D11DeviceContext1 *context, rect_t area, scope_source_t **source) {
+    assert(capture && capture->duplication && "Capture must be initialized");
+
+    monitor_info_t *monitor = &capture->monitors[capture->active_monitor];
+    if (area.x < 0 || area.y < 0 || area.width <= 0 || area.height <= 0 ||
+        area.x + area.width > monitor->bounds.width || area.y + area.height > monitor->bounds.height) {
+        LOG("The capture source area is invalid");
+        return false;
+    }
+
+    return create(capture, NULL, NULL, capture->format, device, context, area, source);
+}
+
+bool capture_source_create_monitor(capture_t *capture, ID3D11Device1 *device, ID3D11DeviceContext1 *context, uint32_t monitor_id, scope_source_t **source) {
+    assert(capture);
+
+    if (monitor_id >= capture->monitor_count || !capture->monitors[monitor_id].can_capture) {
+        LOG("Monitor %u cannot be captured", monitor_id);
+        return false;
+    }
+
+    IDXGIOutput1 *output = NULL;
+    IDXGIOutputDuplication *duplication = NULL;
+    if (!capture_duplicate_monitor(device, &capture->monitors[monitor_id], true, &output, &duplication)) {
+        return false;
+    }
+
+    DXGI_OUTDUPL_DESC desc = {0};
+    duplication->lpVtbl->GetDesc(duplication, &desc);
+
+    // The whole desktop image of the monitor, which is in pixels of the output already
+    rect_t area = {0.0f, 0.0f, (float)desc.ModeDesc.Width, (float)desc.ModeDesc.Height};
+    return create(NULL, output, duplication, desc.ModeDesc.Format, device, context, area, source);
+}
+
+// Takes ownership of `output` and `duplication`, which are NULL when sharing the ones of `capture`
+static bool create(capture_t *capture, IDXGIOutput1 *output, IDXGIOutputDuplication *duplication, DXGI_FORMAT dxgi_format,
+                   ID3D11Device1 *device, ID3D11DeviceContext1 *context, rect_t area, scope_source_t **source) {
+    scope_pixel_format_t format;
+    scope_transfer_t transfer = SCOPE_TRANSFER_SDR;
+    switch (dxgi_format) {
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        format = SCOPE_PIXEL_FORMAT_BGRA8;
+        break;
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        format = SCOPE_PIXEL_FORMAT_RGBA8;
+        break;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        // scRGB, what DWM composes HDR desktops in
+        format = SCOPE_PIXEL_FORMAT_RGBA16F;
+        transfer = SCOPE_TRANSFER_LINEAR;
+        break;
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+        // HDR10 desktops
+        format = SCOPE_PIXEL_FORMAT_RGB10A2;
+        transfer = SCOPE_TRANSFER_PQ;
+        break;
+    default:
+        LOG("Desktop format %u has no CPU scope support", dxgi_format);
+        release_duplication(output, duplication);
+        return false;
+    }
+
+    capture_source_t *impl = malloc(sizeof(capture_source_t));
+    if (!impl) {
+        LOG("Allocation for the capture source failed");
+        release_duplication(output, duplication);
+        return false;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    *impl = (capture_source_t){
+        .base = {
+            .name = "dxgi",
+            .interface = {capture_source_acquire, capture_source_release, capture_source_destroy},
+        },
+        .capture = capture,
+        .output = output,
+        .duplication = duplication,
+        .context = context,
+        .area = {(uint32_t)area.x, (uint32_t)area.y, (uint32_t)area.width, (uint32_t)area.height},
+        .format = format,
+        .transfer = transfer,
+        .ticks_per_second = (double)frequency.QuadPart,
+    };
+
+    D3D11_TEXTURE2D_DESC desc = {
+        .Width = impl->area.width,
+        .Height = impl->area.height,
+        .MipLevels = 1,
+        .ArraySize = 1,
+        .Format = dxgi_format,
+        .SampleDesc = {.Count = 1, .Quality = 0},
+        .Usage = D3D11_USAGE_STAGING,
+        .CPUAccessFlags = D3D11_CPU_ACCESS_READ,
+    };
+    HRESULT hr = device->lpVtbl->CreateTexture2D(device, &desc, NULL, &impl->staging);
+    if (FAILED(hr)) {
+        LOG("Failed to create the capture staging texture (HRESULT: 0x%08x)", hr);
+        capture_source_destroy(&impl->base);
+        return false;
+    }
+
+    *source = &impl->base;
+    return true;
+}
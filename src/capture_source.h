@@ -0,0 +1,20 @@
+#pragma once
+
+#include "capture.h"
+#include "math.h"
+
+#include "scope_source.h"
+
+/* @brief CPU frame source over the active monitor of `capture` (see scope_source.h). Every
+ * acquired frame is `area` of the desktop, copied into a staging texture and mapped, with the
+ * DXGI move and dirty rects clipped to it. Shares the duplication of `capture`, so it must not be
+ * used alongside capture_frame or capture_set_monitor, and the capture has to outlive it.
+ * Pointer-only updates count as timeouts. Can acquire on a thread of its own (see
+ * scope_source_async_create) if `context` is multithread protected. */
+bool capture_source_create(capture_t *capture, ID3D11Device1 *device, ID3D11DeviceContext1 *context, rect_t area, scope_source_t **source);
+
+/* @brief CPU frame source over the whole of monitor `monitor_id`, with a duplication of its own, so
+ * any number of monitors can be scoped at once (see scope_multi.h) without switching the active
+ * one. HDR desktops are duplicated as half float scRGB and scoped at full range. All of them
+ * acquire through `context` and must stay on the thread that uses it. */
+bool capture_source_create_monitor(capture_t *capture, ID3D11Device1 *device, ID3D11DeviceContext1 *context, uint32_t monitor_id, scope_source_t **source);
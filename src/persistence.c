@@ -0,0 +1,149 @@
+#include "persistence.h"
+
+#include "logger.h"
+#include "renderer.h"
+
+#include "scope_persistence.h"
+
+#include <string.h>
+
+// Persistence in scope_persistence.hlsli
+struct persistence_cbuffer {
+    uint32_t keep;
+    uint32_t add;
+    uint32_t padding[2];
+};
+
+static bool create_sums(persistence_t *p, ID3D11Device1 *device, uint32_t count);
+static void destroy_sums(persistence_t *p);
+
+bool persistence_setup(persistence_t *p, struct renderer *renderer) {
+    ID3D11Device1 *device = renderer->device;
+
+    D3D11_BUFFER_DESC desc = {
+        .Usage = D3D11_USAGE_DYNAMIC,
+        .ByteWidth = sizeof(struct persistence_cbuffer),
+        .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+        .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE,
+    };
+
+    HRESULT hr = device->lpVtbl->CreateBuffer(device, &desc, NULL, &p->cbuffer);
+    if (FAILED(hr)) {
+        LOG("Failed to create constant buffer for persistence");
+        return false;
+    }
+
+    return true;
+}
+
+bool persistence_configure(persistence_t *p, struct renderer *renderer, uint32_t count, float half_life) {
+    p->half_life = half_life;
+    p->bound = 0.0;
+
+    if (half_life <= 0.0f) {
+        destroy_sums(p);
+        return true;
+    }
+
+    if (!p->sums || p->count != count) {
+        destroy_sums(p);
+        if (!create_sums(p, renderer->device, count)) {
+            return false;
+        }
+    }
+
+    // New buffers are undefined too
+    unsigned int zero[4] = {0, 0, 0, 0};
+    renderer->context->lpVtbl->ClearUnorderedAccessViewUint(renderer->context, p->sums_uav, zero);
+    return true;
+}
+
+bool persistence_is_decaying(const persistence_t *p) {
+    return p->sums && p->bound >= 1.0;
+}
+
+void persistence_apply(persistence_t *p, struct renderer *renderer, shader_pipeline_t *pass, ID3D11UnorderedAccessView *hits, bool captured, uint64_t pixels, const uint32_t groups[3]) {
+    if (!p->sums) {
+        return;
+    }
+
+    ID3D11DeviceContext1 *context = renderer->context;
+    ID3D11UnorderedAccessView *nulluavs[2] = {NULL, NULL};
+
+    // A half-life of years would round to 1, which 0.32 can't hold
+    uint64_t keep = scope_persistence_keep(p->half_life, 1.0f);
+    struct persistence_cbuffer cb = {
+        .keep = keep > UINT32_MAX ? UINT32_MAX : (uint32_t)keep,
+        .add = captured,
+    };
+
+    // Every hit of the capture could land in the same bin
+    p->bound = p->bound * ((double)cb.keep / 4294967296.0);
+    if (captured) {
+        p->bound += (double)pixels * (double)(1 << SCOPE_PERSISTENCE_FRAC_BITS);
+    }
+
+    D3D11_MAPPED_SUBRESOURCE map;
+    context->lpVtbl->Map(context, (ID3D11Resource *)p->cbuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
+    memcpy(map.pData, &cb, sizeof(cb));
+    context->lpVtbl->Unmap(context, (ID3D11Resource *)p->cbuffer, 0);
+
+    // The hits may still be bound for reading from the scope's last passes
+    ID3D11ShaderResourceView *nullsrv = NULL;
+    ID3D11UnorderedAccessView *uavs[2] = {hits, p->sums_uav};
+    shader_pipeline_bind(context, pass);
+    context->lpVtbl->CSSetShaderResources(context, 0, 1, &nullsrv);
+    context->lpVtbl->CSSetConstantBuffers(context, 0, 1, &p->cbuffer);
+    context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 2, uavs, NULL);
+    context->lpVtbl->Dispatch(context, groups[0], groups[1], groups[2]);
+    context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 2, nulluavs, NULL);
+}
+
+static bool create_sums(persistence_t *p, ID3D11Device1 *device, uint32_t count) {
+    D3D11_BUFFER_DESC buffer_desc = {
+        .Usage = D3D11_USAGE_DEFAULT,
+        .ByteWidth = 2 * sizeof(uint32_t) * count,
+        .BindFlags = D3D11_BIND_UNORDERED_ACCESS,
+        .MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED,
+        .StructureByteStride = 2 * sizeof(uint32_t),
+    };
+
+    HRESULT hr = device->lpVtbl->CreateBuffer(device, &buffer_desc, NULL, &p->sums);
+    if (FAILED(hr)) {
+        LOG("Failed to create the persistence sums");
+        return false;
+    }
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uav_desc = {
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .ViewDimension = D3D11_UAV_DIMENSION_BUFFER,
+        .Buffer = {
+            .FirstElement = 0,
+            .NumElements = count,
+        },
+    };
+
+    hr = device->lpVtbl->CreateUnorderedAccessView(device, (ID3D11Resource *)p->sums, &uav_desc, &p->sums_uav);
+    if (FAILED(hr)) {
+        LOG("Failed to create UAV for the persistence sums");
+        destroy_sums(p);
+        return false;
+    }
+
+    p->count = count;
+    return true;
+}
+
+static void destroy_sums(persistence_t *p) {
+    if (p->sums_uav) {
+        p->sums_uav->lpVtbl->Release(p->sums_uav);
+        p->sums_uav = NULL;
+    }
+
+    if (p->sums) {
+        p->sums->lpVtbl->Release(p->sums);
+        p->sums = NULL;
+    }
+
+    p->count = 0;
+}
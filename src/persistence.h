@@ -0,0 +1,39 @@
+#pragma once
+
+#include "shader.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <d3d11_1.h>
+
+struct renderer;
+
+// Phosphor trails of a scope, scope_persistence.h on the GPU: a persistence pass
+// (vs_persist.cs.hlsl, wf_persist.cs.hlsl) adds the accumulated hits of a new capture to decaying
+// sums, or only decays them, and puts the resolved sums in place of the hits before the scope is
+// blurred and composited.
+typedef struct persistence {
+    // (high, low) words of the fixed point sums, one per hit count. Only allocated while the
+    // half-life is non-zero.
+    ID3D11Buffer *sums;
+    ID3D11UnorderedAccessView *sums_uav;
+    uint32_t count;
+
+    float half_life; // in frames, 0 is off
+
+    // Largest sum the frames so far could have left, in fixed point. Below 1 every sum is zero and
+    // the trails are gone, decaying them is skipped until the next capture.
+    double bound;
+
+    ID3D11Buffer *cbuffer;
+} persistence_t;
+
+bool persistence_setup(persistence_t *p, struct renderer *renderer);
+// Sizes the sums for `count` hit counts and empties them, for a new scope config or half-life
+bool persistence_configure(persistence_t *p, struct renderer *renderer, uint32_t count, float half_life);
+// Whether there are trails left to decay on a frame without a new capture
+bool persistence_is_decaying(const persistence_t *p);
+// Dispatches `pass` over `hits`, adding them if they are a new capture of `pixels` pixels or else
+// only decaying the sums. Does nothing while the half-life is 0.
+void persistence_apply(persistence_t *p, struct renderer *renderer, shader_pipeline_t *pass, ID3D11UnorderedAccessView *hits, bool captured, uint64_t pixels, const uint32_t groups[3]);
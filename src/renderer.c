@@ -10,8 +10,10 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <d3d11_1.h>
+#include <d3d11_4.h>
 
 struct per_frame_data {
     float4x4_t projection;
@@ -25,6 +27,17 @@ struct per_ui_mesh_data {
     float4_t color;
 };
 
+// ScopeConfig in scope_config.hlsli, the sizes of scope_config_t filling one register
+struct scope_config_data {
+    uint32_t vs_resolution;
+    uint32_t wf_width;
+    uint32_t wf_buckets;
+    uint32_t vs_zoom;
+    uint32_t vs_blur_shape;
+    uint32_t vs_blur_radius;
+    uint32_t padding[2];
+};
+
 static bool create_device(ID3D11Device1 **device, ID3D11DeviceContext1 **context, D3D_FEATURE_LEVEL *feature_level);
 static bool create_swapchain(ID3D11Device1 *device, HWND hwnd, texture_t *swapchain_texture, IDXGISwapChain3 **swapchain);
 static void destroy_swapchain(swapchain_t *swapchain);
@@ -32,7 +45,11 @@ static void destroy_swapchain(swapchain_t *swapchain);
 static bool create_pipeline_states(renderer_t *renderer);
 static bool create_textures(renderer_t *renderer);
 static bool create_shader_pipelines(renderer_t *renderer);
+static bool create_encoding_passes(ID3D11Device1 *device, const char *path, shader_t *shaders, shader_pipeline_t *passes);
 static bool create_constant_buffers(renderer_t *renderer);
+static struct scope_config_data scope_config_data(const renderer_t *renderer, const scope_config_t *config);
+static bool write_scope_config(renderer_t *renderer, const scope_config_t *config);
+static void restore_scope_config(renderer_t *renderer);
 
 bool renderer_initialize(window_t *window, renderer_t *out_renderer) {
     assert(out_renderer && "Renderer pointer MUST NOT be NULL");
@@ -66,6 +83,16 @@ bool renderer_initialize(window_t *window, renderer_t *out_renderer) {
     LOG("D3D11 Annotation interface was successfully queried");
 #endif
 
+    // The capture source copies and maps desktop frames on a thread of its own through the
+    // immediate context, which serializes every call on it from here on
+    ID3D11Multithread *multithread = NULL;
+    if (FAILED(out_renderer->context->lpVtbl->QueryInterface(out_renderer->context, IID_PPV_ARGS_C(ID3D11Multithread, &multithread)))) {
+        LOG("Failed to get the multithread interface");
+        return false;
+    }
+    multithread->lpVtbl->SetMultithreadProtected(multithread, TRUE);
+    multithread->lpVtbl->Release(multithread);
+
     // Initialize capture interface
     if (!capture_initialize(out_renderer->device, &out_renderer->capture)) {
         LOG("Failed to initialize capture interface");
@@ -92,6 +119,9 @@ bool renderer_initialize(window_t *window, renderer_t *out_renderer) {
     }
 
     // Create buffers
+    out_renderer->scope_config = scope_config_preset(SCOPE_QUALITY_DEFAULT);
+    out_renderer->vs_blur_shape = SCOPE_BLUR_DIAMOND;
+    out_renderer->vs_blur_radius = 2;
     if (!create_constant_buffers(out_renderer)) {
         LOG("Failed to create necessary buffers");
         return false;
@@ -141,6 +171,83 @@ void renderer_begin_frame(renderer_t *renderer) {
     context->lpVtbl->Unmap(context, (ID3D11Resource *)renderer->per_frame_buffer, 0);
 
     context->lpVtbl->VSSetConstantBuffers(context, 0, 1, &renderer->per_frame_buffer);
+    context->lpVtbl->CSSetConstantBuffers(context, 1, 1, &renderer->scope_config_buffer);
+}
+
+bool renderer_set_scope_config(renderer_t *renderer, const scope_config_t *config) {
+    const scope_config_t *current = &renderer->scope_config;
+    if (current->vs_resolution == config->vs_resolution &&
+        current->wf_width == config->wf_width &&
+        current->wf_buckets == config->wf_buckets &&
+        current->vs_zoom == config->vs_zoom &&
+        scope_encoding_index(current->encoding) == scope_encoding_index(config->encoding)) {
+        return true;
+    }
+
+    // The scopes are resized first, the config and its constant buffer only change once all of it
+    // succeeded. Otherwise the scopes go back to the current config, which a retry compares against.
+    if (!vectorscope_configure(&renderer->vectorscope, renderer, config)) {
+        LOG("Failed to configure vectorscope");
+        restore_scope_config(renderer);
+        return false;
+    }
+
+    if (!waveform_configure(&renderer->waveform, renderer, config)) {
+        LOG("Failed to configure waveform");
+        restore_scope_config(renderer);
+        return false;
+    }
+
+    if (!write_scope_config(renderer, config)) {
+        restore_scope_config(renderer);
+        return false;
+    }
+    renderer->scope_config = *config;
+
+    static const char *matrix_names[] = {"BT.601", "BT.709", "BT.2020"};
+    LOG("Scopes accumulating at %u, zoom %ux (vectorscope), %ux%u (waveform) in %s %s range", config->vs_resolution, config->vs_zoom, config->wf_width, config->wf_buckets,
+        matrix_names[config->encoding.matrix], config->encoding.range == SCOPE_COLOR_RANGE_FULL ? "full" : "limited");
+    return true;
+}
+
+bool renderer_set_scope_persistence(renderer_t *renderer, float half_life) {
+    if (!vectorscope_set_persistence(&renderer->vectorscope, renderer, half_life) ||
+        !waveform_set_persistence(&renderer->waveform, renderer, half_life)) {
+        LOG("Failed to set scope persistence");
+        return false;
+    }
+
+    if (half_life > 0.0f) {
+        LOG("Scope trails fading to half in %.0f frames", half_life);
+    } else {
+        LOG("Scope trails off");
+    }
+    return true;
+}
+
+bool renderer_set_scope_blur(renderer_t *renderer, scope_blur_shape_t shape, uint32_t radius) {
+    assert(shape < SCOPE_BLUR_SHAPE_COUNT && radius <= SCOPE_BLUR_MAX_RADIUS);
+
+    // The tables are sized for the widest pass, and the constant buffer only changes once they are
+    if (!vectorscope_set_blur(&renderer->vectorscope, renderer, shape, radius)) {
+        LOG("Failed to set vectorscope blur");
+        vectorscope_set_blur(&renderer->vectorscope, renderer, renderer->vs_blur_shape, renderer->vs_blur_radius);
+        return false;
+    }
+
+    const scope_blur_shape_t current_shape = renderer->vs_blur_shape;
+    const uint32_t current_radius = renderer->vs_blur_radius;
+    renderer->vs_blur_shape = shape;
+    renderer->vs_blur_radius = radius;
+    if (!write_scope_config(renderer, &renderer->scope_config)) {
+        renderer->vs_blur_shape = current_shape;
+        renderer->vs_blur_radius = current_radius;
+        vectorscope_set_blur(&renderer->vectorscope, renderer, current_shape, current_radius);
+        return false;
+    }
+
+    LOG("Vectorscope blurred with a %s of radius %u", scope_blur_shape_name(shape), radius);
+    return true;
 }
 
 void renderer_draw_scopes(renderer_t *renderer) {
@@ -899,94 +1006,111 @@ static bool create_shader_pipelines(renderer_t *renderer) {
 
     // Create shader pipelines for vectorscope
     {
-        if (!shader_create_from_file(
+        if (!create_encoding_passes(
                 device,
                 "assets/shaders/vs_accum.cs.hlsl",
-                SHADER_STAGE_CS,
-                "main",
-                &renderer->shaders.vs_accum_cs)) {
-            LOG("Failed to create compute shader for Vectorscope Accumulation Pass");
-            return false;
-        }
-
-        shader_t *shaders[] = {&renderer->shaders.vs_accum_cs};
-        if (!shader_pipeline_create(
-                device,
-                shaders,
-                ARRAYSIZE(shaders),
-                NULL,
-                0,
-                &renderer->passes.vs_accum)) {
-            LOG("Failed to create shader pipeline for Vectorscope Accumulation Pass");
+                renderer->shaders.vs_accum_cs,
+                renderer->passes.vs_accum)) {
+            LOG("Failed to create shader pipelines for Vectorscope Accumulation Pass");
             return false;
         }
 
         if (!shader_create_from_file(
                 device,
-                "assets/shaders/vs_blur.cs.hlsl",
+                "assets/shaders/vs_persist.cs.hlsl",
                 SHADER_STAGE_CS,
                 "main",
-                &renderer->shaders.vs_blur_cs)) {
-            LOG("Failed to create compute shader for Vectorscope Blur Pass");
+                &renderer->shaders.vs_persist_cs)) {
+            LOG("Failed to create compute shader for Vectorscope Persistence Pass");
             return false;
         }
 
-        shader_t *shaders1[] = {&renderer->shaders.vs_blur_cs};
+        shader_t *shaders0[] = {&renderer->shaders.vs_persist_cs};
         if (!shader_pipeline_create(
                 device,
-                shaders1,
-                ARRAYSIZE(shaders1),
+                shaders0,
+                ARRAYSIZE(shaders0),
                 NULL,
                 0,
-                &renderer->passes.vs_blur)) {
-            LOG("Failed to create shader pipeline for Vectorscope Blur Pass");
+                &renderer->passes.vs_persist)) {
+            LOG("Failed to create shader pipeline for Vectorscope Persistence Pass");
             return false;
         }
 
-        if (!shader_create_from_file(
-                device,
-                "assets/shaders/vs_comp.cs.hlsl",
-                SHADER_STAGE_CS,
-                "main",
-                &renderer->shaders.vs_comp_cs)) {
-            LOG("Failed to create compute shader for Vectorscope Composite Pass");
-            return false;
+        // The blur builds its tables in the rows and scan entry points, main averages from them
+        struct {
+            const char *entry_point;
+            shader_t *shader;
+            shader_pipeline_t *pass;
+        } blur_passes[] = {
+            {"rows", &renderer->shaders.vs_blur_rows_cs, &renderer->passes.vs_blur_rows},
+            {"scan", &renderer->shaders.vs_blur_scan_cs, &renderer->passes.vs_blur_scan},
+            {"main", &renderer->shaders.vs_blur_cs, &renderer->passes.vs_blur},
+        };
+        for (size_t i = 0; i < ARRAYSIZE(blur_passes); ++i) {
+            if (!shader_create_from_file(
+                    device,
+                    "assets/shaders/vs_blur.cs.hlsl",
+                    SHADER_STAGE_CS,
+                    blur_passes[i].entry_point,
+                    blur_passes[i].shader)) {
+                LOG("Failed to create compute shader for Vectorscope Blur Pass (%s)", blur_passes[i].entry_point);
+                return false;
+            }
+
+            shader_t *shaders1[] = {blur_passes[i].shader};
+            if (!shader_pipeline_create(
+                    device,
+                    shaders1,
+                    ARRAYSIZE(shaders1),
+                    NULL,
+                    0,
+                    blur_passes[i].pass)) {
+                LOG("Failed to create shader pipeline for Vectorscope Blur Pass (%s)", blur_passes[i].entry_point);
+                return false;
+            }
         }
 
-        shader_t *shaders2[] = {&renderer->shaders.vs_comp_cs};
-        if (!shader_pipeline_create(
+        if (!create_encoding_passes(
                 device,
-                shaders2,
-                ARRAYSIZE(shaders2),
-                NULL,
-                0,
-                &renderer->passes.vs_comp)) {
-            LOG("Failed to create shader pipeline for Vectorscope Composite Pass");
+                "assets/shaders/vs_comp.cs.hlsl",
+                renderer->shaders.vs_comp_cs,
+                renderer->passes.vs_comp)) {
+            LOG("Failed to create shader pipelines for Vectorscope Composite Pass");
             return false;
         }
     }
 
     // Create shader pipelines for waveform and parade
     {
-        if (!shader_create_from_file(
+        if (!create_encoding_passes(
                 device,
                 "assets/shaders/wf_accum.cs.hlsl",
+                renderer->shaders.wf_accum_cs,
+                renderer->passes.wf_accum)) {
+            LOG("Failed to create shader pipelines for Waveform Accumulation Pass");
+            return false;
+        }
+
+        if (!shader_create_from_file(
+                device,
+                "assets/shaders/wf_persist.cs.hlsl",
                 SHADER_STAGE_CS,
                 "main",
-                &renderer->shaders.wf_accum_cs)) {
-            LOG("Failed to create compute shader for Waveform Accumulation Pass");
+                &renderer->shaders.wf_persist_cs)) {
+            LOG("Failed to create compute shader for Waveform Persistence Pass");
             return false;
         }
 
-        shader_t *shaders[] = {&renderer->shaders.wf_accum_cs};
+        shader_t *shaders4[] = {&renderer->shaders.wf_persist_cs};
         if (!shader_pipeline_create(
                 device,
-                shaders,
-                ARRAYSIZE(shaders),
+                shaders4,
+                ARRAYSIZE(shaders4),
                 NULL,
                 0,
-                &renderer->passes.wf_accum)) {
-            LOG("Failed to create shader pipeline for Waveform Accumulation Pass");
+                &renderer->passes.wf_persist)) {
+            LOG("Failed to create shader pipeline for Waveform Persistence Pass");
             return false;
         }
 
@@ -1100,6 +1224,33 @@ static bool create_shader_pipelines(renderer_t *renderer) {
     return true;
 }
 
+// Compiles a compute pass once per encoding, with SCOPE_MATRIX and SCOPE_RANGE_LIMITED of
+// scope_encoding.hlsli defined, into the arrays indexed by scope_encoding_index()
+static bool create_encoding_passes(ID3D11Device1 *device, const char *path, shader_t *shaders, shader_pipeline_t *passes) {
+    static const char *matrix_defines[SCOPE_MATRIX_COUNT] = {"601", "709", "2020"};
+
+    for (uint32_t i = 0; i < SCOPE_ENCODING_COUNT; ++i) {
+        const scope_encoding_t encoding = scope_encoding_from_index(i);
+        const D3D_SHADER_MACRO defines[] = {
+            {"SCOPE_MATRIX", matrix_defines[encoding.matrix]},
+            {"SCOPE_RANGE_LIMITED", encoding.range == SCOPE_COLOR_RANGE_LIMITED ? "1" : "0"},
+            {NULL, NULL},
+        };
+
+        if (!shader_create_permutation_from_file(device, path, SHADER_STAGE_CS, "main", defines, &shaders[i])) {
+            LOG("Failed to compile %s with SCOPE_MATRIX=%s SCOPE_RANGE_LIMITED=%s", path, defines[0].Definition, defines[1].Definition);
+            return false;
+        }
+
+        shader_t *stages[] = {&shaders[i]};
+        if (!shader_pipeline_create(device, stages, ARRAYSIZE(stages), NULL, 0, &passes[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static bool create_constant_buffers(renderer_t *renderer) {
     ID3D11Device1 *device = renderer->device;
 
@@ -1135,5 +1286,57 @@ static bool create_constant_buffers(renderer_t *renderer) {
         }
     }
 
+    // Create Constant Buffer for Scope Config, starting out with the renderer's
+    {
+        D3D11_BUFFER_DESC desc = {
+            .Usage = D3D11_USAGE_DYNAMIC,
+            .ByteWidth = sizeof(struct scope_config_data),
+            .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+            .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE,
+        };
+
+        const struct scope_config_data data = scope_config_data(renderer, &renderer->scope_config);
+        const D3D11_SUBRESOURCE_DATA initial_data = {.pSysMem = &data};
+
+        HRESULT hr = device->lpVtbl->CreateBuffer(device, &desc, &initial_data, &renderer->scope_config_buffer);
+        if (FAILED(hr)) {
+            LOG("Failed to create constant buffer for Scope Config");
+            return false;
+        }
+    }
+
     return true;
 }
+
+static struct scope_config_data scope_config_data(const renderer_t *renderer, const scope_config_t *config) {
+    return (struct scope_config_data){
+        .vs_resolution = config->vs_resolution,
+        .wf_width = config->wf_width,
+        .wf_buckets = config->wf_buckets,
+        .vs_zoom = config->vs_zoom,
+        .vs_blur_shape = (uint32_t)renderer->vs_blur_shape,
+        .vs_blur_radius = renderer->vs_blur_radius,
+    };
+}
+
+// Uploads `config` and the blur of the renderer to the constant buffer of the scope passes
+static bool write_scope_config(renderer_t *renderer, const scope_config_t *config) {
+    ID3D11DeviceContext1 *context = renderer->context;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    HRESULT hr = context->lpVtbl->Map(context, (ID3D11Resource *)renderer->scope_config_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+    if (FAILED(hr)) {
+        LOG("Failed to map constant buffer for Scope Config");
+        return false;
+    }
+    *(struct scope_config_data *)mapped.pData = scope_config_data(renderer, config);
+    context->lpVtbl->Unmap(context, (ID3D11Resource *)renderer->scope_config_buffer, 0);
+    return true;
+}
+
+// Back to the sizes of the current config after a failed change, as far as the device lets us
+static void restore_scope_config(renderer_t *renderer) {
+    if (!vectorscope_configure(&renderer->vectorscope, renderer, &renderer->scope_config) ||
+        !waveform_configure(&renderer->waveform, renderer, &renderer->scope_config)) {
+        LOG("Failed to restore the scopes to the current config");
+    }
+}
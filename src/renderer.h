@@ -1,6 +1,8 @@
 #pragma once
 
 #include "capture.h"
+#include "scope.h"
+#include "scope_blur.h"
 #include "shader.h"
 #include "texture.h"
 #include "vectorscope.h"
@@ -54,21 +56,30 @@ struct shaders {
     shader_t composite_ps;
     shader_t ui_ps;
 
-    shader_t vs_accum_cs;
+    // Passes that measure color have a permutation per encoding, indexed by scope_encoding_index()
+    shader_t vs_accum_cs[SCOPE_ENCODING_COUNT];
+    shader_t vs_persist_cs;
+    shader_t vs_blur_rows_cs;
+    shader_t vs_blur_scan_cs;
     shader_t vs_blur_cs;
-    shader_t vs_comp_cs;
+    shader_t vs_comp_cs[SCOPE_ENCODING_COUNT];
 
-    shader_t wf_accum_cs;
+    shader_t wf_accum_cs[SCOPE_ENCODING_COUNT];
+    shader_t wf_persist_cs;
     shader_t wf_comp_cs;
     shader_t parade_comp_cs;
 };
 
 struct passes {
-    shader_pipeline_t vs_accum;
+    shader_pipeline_t vs_accum[SCOPE_ENCODING_COUNT];
+    shader_pipeline_t vs_persist;
+    shader_pipeline_t vs_blur_rows;
+    shader_pipeline_t vs_blur_scan;
     shader_pipeline_t vs_blur;
-    shader_pipeline_t vs_comp;
+    shader_pipeline_t vs_comp[SCOPE_ENCODING_COUNT];
 
-    shader_pipeline_t wf_accum;
+    shader_pipeline_t wf_accum[SCOPE_ENCODING_COUNT];
+    shader_pipeline_t wf_persist;
     shader_pipeline_t wf_comp;
     shader_pipeline_t parade_comp;
 
@@ -101,9 +112,14 @@ typedef struct renderer {
     ID3D11BlendState *blend_states[BLEND_STATE_COUNT];
     ID3D11SamplerState *sampler_states[SAMPLER_STATE_COUNT];
 
-    // Scope modules
+    // Scope modules, accumulating at the resolutions of scope_config
     vectorscope_t vectorscope;
     waveform_t waveform;
+    scope_config_t scope_config;
+
+    // Blur of the vectorscope, set with renderer_set_scope_blur() and passed to vs_blur in ScopeConfig
+    scope_blur_shape_t vs_blur_shape;
+    uint32_t vs_blur_radius;
 
     // Shaders and pipelines
     struct shaders shaders;
@@ -112,6 +128,7 @@ typedef struct renderer {
     // Buffers
     ID3D11Buffer *per_frame_buffer;
     ID3D11Buffer *per_ui_mesh_buffer;
+    ID3D11Buffer *scope_config_buffer; // scope_config for the scope passes, ScopeConfig in scope_config.hlsli
 
     struct window *window;
 } renderer_t;
@@ -127,6 +144,11 @@ void renderer_overlay_begin_frame(renderer_t *renderer);
 void renderer_draw_overlay(renderer_t *renderer);
 void renderer_overlay_end_frame(renderer_t *renderer);
 
+bool renderer_set_scope_config(renderer_t *renderer, const scope_config_t *config);
+// Phosphor trails of every scope, fading to half over `half_life` frames; 0 turns them off
+bool renderer_set_scope_persistence(renderer_t *renderer, float half_life);
+// Blur of the vectorscope bins, any shape of scope_blur.h up to SCOPE_BLUR_MAX_RADIUS
+bool renderer_set_scope_blur(renderer_t *renderer, scope_blur_shape_t shape, uint32_t radius);
 void renderer_draw_scopes(renderer_t *renderer);
 void renderer_calculate_vectorscope(renderer_t *renderer, const texture_t* in_texture, texture_t *out_texture);
 void renderer_calculate_waveform(renderer_t *renderer, const texture_t *in_texture, texture_t *out_texture);
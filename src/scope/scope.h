@@ -0,0 +1,218 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Default internal resolutions of the scopes, the 1024 preset of scope_config_preset(). The GPU
+// passes get theirs from the same scope_config_t (scope_config.hlsli), so both paths bin identically.
+#define SCOPE_VS_RESOLUTION 1024
+#define SCOPE_WF_WIDTH 1024
+#define SCOPE_WF_BUCKETS 512
+
+// BT.709 RGB -> Cb/Cr vectors, same as RGB_to_Cb / RGB_to_Cr of the default permutation of
+// the shaders (scope_encoding.hlsli)
+#define SCOPE_RGB_TO_CB_R -0.1146f
+#define SCOPE_RGB_TO_CB_G -0.3854f
+#define SCOPE_RGB_TO_CB_B 0.5f
+#define SCOPE_RGB_TO_CR_R 0.5f
+#define SCOPE_RGB_TO_CR_G -0.4542f
+#define SCOPE_RGB_TO_CR_B -0.0458f
+
+// Rec.709 luma
+#define SCOPE_LUMA_R 0.2126f
+#define SCOPE_LUMA_G 0.7152f
+#define SCOPE_LUMA_B 0.0722f
+
+typedef enum scope_pixel_format {
+    SCOPE_PIXEL_FORMAT_BGRA8,
+    SCOPE_PIXEL_FORMAT_RGBA8,
+
+    // HDR RGB, the meaning of the values is given by the image's transfer
+    SCOPE_PIXEL_FORMAT_RGBA16F, // half floats, DXGI_FORMAT_R16G16B16A16_FLOAT
+    SCOPE_PIXEL_FORMAT_RGB10A2, // 32-bit little endian words, R in the low 10 bits, DXGI_FORMAT_R10G10B10A2_UNORM
+
+    // Planar Y'CbCr: `data` is the Y plane, `chroma` holds the Cb and Cr planes
+    SCOPE_PIXEL_FORMAT_YUV420P, // 8-bit 4:2:0, I420
+    SCOPE_PIXEL_FORMAT_YUV422P,
+    SCOPE_PIXEL_FORMAT_YUV444P,
+    SCOPE_PIXEL_FORMAT_YUV420P10, // 10 bits in the low bits of little endian 16-bit samples
+    SCOPE_PIXEL_FORMAT_YUV422P10,
+    SCOPE_PIXEL_FORMAT_YUV444P10,
+
+    // Semi-planar Y'CbCr 4:2:0: `chroma[0]` is one plane of interleaved Cb, Cr pairs
+    SCOPE_PIXEL_FORMAT_NV12,
+    SCOPE_PIXEL_FORMAT_P010, // 10 bits in the high bits of little endian 16-bit samples
+
+    SCOPE_PIXEL_FORMAT_COUNT
+} scope_pixel_format_t;
+
+// Code values of Y'CbCr samples, for 8 bits Y is 16-235 and CbCr 16-240 in limited range
+typedef enum scope_color_range {
+    SCOPE_COLOR_RANGE_LIMITED,
+    SCOPE_COLOR_RANGE_FULL,
+} scope_color_range_t;
+
+// Y'CbCr matrices of the delivery standards
+typedef enum scope_matrix {
+    SCOPE_MATRIX_BT601,
+    SCOPE_MATRIX_BT709,
+    SCOPE_MATRIX_BT2020, // non-constant luminance
+    SCOPE_MATRIX_COUNT
+} scope_matrix_t;
+
+// RGB -> Y', Cb and Cr weights of a matrix, to four places like the published equations
+typedef struct scope_matrix_weights {
+    float luma[3];
+    float cb[3];
+    float cr[3];
+} scope_matrix_weights_t;
+
+static inline scope_matrix_weights_t scope_matrix_weights(scope_matrix_t matrix) {
+    switch (matrix) {
+        case SCOPE_MATRIX_BT601:
+            return (scope_matrix_weights_t){{0.299f, 0.587f, 0.114f}, {-0.1687f, -0.3313f, 0.5f}, {0.5f, -0.4187f, -0.0813f}};
+        case SCOPE_MATRIX_BT2020:
+            return (scope_matrix_weights_t){{0.2627f, 0.678f, 0.0593f}, {-0.1396f, -0.3604f, 0.5f}, {0.5f, -0.4598f, -0.0402f}};
+        default:
+            return (scope_matrix_weights_t){
+                {SCOPE_LUMA_R, SCOPE_LUMA_G, SCOPE_LUMA_B},
+                {SCOPE_RGB_TO_CB_R, SCOPE_RGB_TO_CB_G, SCOPE_RGB_TO_CB_B},
+                {SCOPE_RGB_TO_CR_R, SCOPE_RGB_TO_CR_G, SCOPE_RGB_TO_CR_B},
+            };
+    }
+}
+
+/* @brief Y'CbCr encoding the scopes measure in: the matrix gives the luma weights and the Cb/Cr
+ * vectors of RGB, the range where code values sit on the scopes. Full range spans the whole
+ * axis. Limited range shows the codes of 0-255 as they are, black and white at 16 and 235
+ * with room for sub-blacks and super-whites, and Cb/Cr over 224 of 256 codes.
+ * Y'CbCr frames already carry their codes, only the range applies to them. */
+typedef struct scope_encoding {
+    scope_matrix_t matrix;
+    scope_color_range_t range;
+} scope_encoding_t;
+
+// Every matrix in both ranges, indexed by scope_encoding_index()
+#define SCOPE_ENCODING_COUNT (SCOPE_MATRIX_COUNT * 2)
+
+static inline uint32_t scope_encoding_index(scope_encoding_t encoding) {
+    return (uint32_t)encoding.matrix * 2 + (encoding.range == SCOPE_COLOR_RANGE_FULL);
+}
+
+static inline scope_encoding_t scope_encoding_from_index(uint32_t index) {
+    return (scope_encoding_t){(scope_matrix_t)(index / 2), index % 2 ? SCOPE_COLOR_RANGE_FULL : SCOPE_COLOR_RANGE_LIMITED};
+}
+
+// What the values of HDR frames encode
+typedef enum scope_transfer {
+    SCOPE_TRANSFER_SDR,    // display referred signal, 0-1 shown as is
+    SCOPE_TRANSFER_PQ,     // SMPTE ST 2084, 0-1 covers 0-10000 nits
+    SCOPE_TRANSFER_HLG,    // ARIB STD-B67, 0-1 covers 0-1000 nits at the reference display peak
+    SCOPE_TRANSFER_LINEAR, // scRGB, linear light with 1.0 at 80 nits, negative outside the sRGB gamut
+} scope_transfer_t;
+
+// How the accumulators turn pixels into bins
+typedef enum scope_kernel {
+    SCOPE_KERNEL_FLOAT, // float math, identical to the GPU passes
+    SCOPE_KERNEL_LUT,   // integer table lookups, no float math per pixel
+} scope_kernel_t;
+
+/* @brief Non-owning view of a frame in CPU memory */
+typedef struct scope_image {
+    const uint8_t *data;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride; // bytes per row
+    scope_pixel_format_t format;
+    uint64_t generation; // increases with every new frame of the source, 0 if unknown
+
+    // Y'CbCr formats only, `data` and `stride` then describe the Y plane
+    const uint8_t *chroma[2];
+    uint32_t chroma_stride;
+    scope_color_range_t range;
+
+    // HDR formats only
+    scope_transfer_t transfer;
+} scope_image_t;
+
+/* @brief Pixel rectangle of a frame, e.g. a region that changed since the previous frame */
+typedef struct scope_rect {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} scope_rect_t;
+
+/* @brief Sizes and encoding of the scope accumulators. The CPU scopes take them as a parameter,
+ * the GPU passes get the sizes through the ScopeConfig constant buffer and the encoding as a
+ * permutation of the passes. Smaller scopes are cheaper to clear, blur and draw,
+ * larger ones resolve finer detail on big panels. */
+typedef struct scope_config {
+    uint32_t vs_resolution; // vectorscope bins per side
+    uint32_t wf_width;      // waveform columns
+    uint32_t wf_buckets;    // waveform levels
+    uint32_t vs_zoom;       // 1 to SCOPE_VS_MAX_ZOOM, magnification of the vectorscope around neutral
+    scope_encoding_t encoding;
+} scope_config_t;
+
+// A zoomed vectorscope bins Cb/Cr at resolution * zoom bins per side and keeps the centered
+// resolution x resolution window, so the magnified detail is real rather than enlarged bins
+#define SCOPE_VS_MAX_ZOOM 8
+
+// Quality presets, named after the vectorscope bins per side
+typedef enum scope_quality {
+    SCOPE_QUALITY_256,
+    SCOPE_QUALITY_512,
+    SCOPE_QUALITY_1024,
+    SCOPE_QUALITY_2048,
+    SCOPE_QUALITY_COUNT
+} scope_quality_t;
+
+#define SCOPE_QUALITY_DEFAULT SCOPE_QUALITY_1024
+
+// The waveform gets as many columns as the vectorscope has bins per side and half as many levels.
+// Presets measure in BT.709 at full range.
+static inline scope_config_t scope_config_preset(scope_quality_t quality) {
+    const uint32_t side = 256u << quality;
+    return (scope_config_t){
+        .vs_resolution = side,
+        .wf_width = side,
+        .wf_buckets = side / 2,
+        .vs_zoom = 1,
+        .encoding = {SCOPE_MATRIX_BT709, SCOPE_COLOR_RANGE_FULL},
+    };
+}
+
+static inline bool scope_pixel_format_is_ycbcr(scope_pixel_format_t format) {
+    return format >= SCOPE_PIXEL_FORMAT_YUV420P && format < SCOPE_PIXEL_FORMAT_COUNT;
+}
+
+// The 8-bit RGB formats, the only ones with per pixel replacement, pyramids and tile hashes
+static inline bool scope_pixel_format_is_rgb8(scope_pixel_format_t format) {
+    return format == SCOPE_PIXEL_FORMAT_BGRA8 || format == SCOPE_PIXEL_FORMAT_RGBA8;
+}
+
+static inline bool scope_pixel_format_is_hdr(scope_pixel_format_t format) {
+    return format == SCOPE_PIXEL_FORMAT_RGBA16F || format == SCOPE_PIXEL_FORMAT_RGB10A2;
+}
+
+// Bytes per pixel of the packed formats, of the Y plane for Y'CbCr
+static inline uint32_t scope_pixel_format_bytes(scope_pixel_format_t format) {
+    switch (format) {
+        case SCOPE_PIXEL_FORMAT_RGBA16F: return 8;
+        case SCOPE_PIXEL_FORMAT_YUV420P10:
+        case SCOPE_PIXEL_FORMAT_YUV422P10:
+        case SCOPE_PIXEL_FORMAT_YUV444P10:
+        case SCOPE_PIXEL_FORMAT_P010: return 2;
+        case SCOPE_PIXEL_FORMAT_YUV420P:
+        case SCOPE_PIXEL_FORMAT_YUV422P:
+        case SCOPE_PIXEL_FORMAT_YUV444P:
+        case SCOPE_PIXEL_FORMAT_NV12: return 1;
+        default: return 4;
+    }
+}
+
+static inline const uint8_t *scope_image_row(const scope_image_t *image, uint32_t y) {
+    return image->data + (size_t)y * image->stride;
+}
@@ -0,0 +1,365 @@
+#include "scope_blur.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GAUSSIAN_PASSES SCOPE_BLUR_MAX_PASSES
+
+// One box or diamond pass over padded tables
+struct blur_job {
+    // Input, the bins or the sums of the previous pass
+    const uint32_t *bins;
+    const uint64_t *sums_in;
+    uint32_t resolution;
+    scope_rect_t region; // the bins that are summed, everything outside is zero
+
+    scope_blur_shape_t shape; // box or diamond
+    uint32_t radius;
+    uint32_t pad;    // radius + 1, so every lookup stays inside the table
+    uint32_t width;  // of the padded tables, the region and the padding on both sides
+    uint32_t height;
+
+    // Box: the summed-area table, T(y, x) = P(y, x) + T(y - 1, x) over row prefix sums P.
+    // Diamond: T(y, x) = P(y, x) + T(y - 1, x - 1) and P(y, x) + T(y - 1, x + 1).
+    uint32_t table_count;
+    int32_t directions[2];
+    uint64_t *tables[2];
+
+    uint32_t band_count; // of table rows
+    uint64_t *prefix;    // a row per band
+    uint64_t *carries;   // true last row of the band above, per band and table
+
+    uint32_t out_band_count; // of region rows
+    uint64_t *sums_out;      // sums, or averages as floats into `out`
+    float *out;
+    double weight; // taps of all passes so far
+};
+
+static bool reserve(uint64_t **buffer, size_t *capacity, size_t count);
+static void run_pass(struct blur_job *job, scope_thread_pool_t *pool);
+static void sum_band_task(void *user_data, uint32_t band);
+static void carry_band_task(void *user_data, uint32_t band);
+static void output_band_task(void *user_data, uint32_t band);
+
+void scope_blur_create(scope_blur_t *blur, scope_blur_shape_t shape, uint32_t radius) {
+    assert(blur);
+    assert(shape < SCOPE_BLUR_SHAPE_COUNT);
+    assert(radius <= SCOPE_BLUR_MAX_RADIUS);
+
+    *blur = (scope_blur_t){.shape = shape, .radius = radius};
+}
+
+void scope_blur_destroy(scope_blur_t *blur) {
+    if (blur) {
+        free(blur->tables);
+        free(blur->rows);
+        free(blur->sums);
+        *blur = (scope_blur_t){0};
+    }
+}
+
+const char *scope_blur_shape_name(scope_blur_shape_t shape) {
+    switch (shape) {
+        case SCOPE_BLUR_DIAMOND: return "diamond";
+        case SCOPE_BLUR_BOX: return "box";
+        case SCOPE_BLUR_GAUSSIAN: return "gaussian";
+        default: return "unknown";
+    }
+}
+
+// Radii of three boxes whose succession approximates a Gaussian (Kovesi, "Fast almost-Gaussian
+// filtering"), sigma a third of the radius so the radius covers about the whole bell
+static void gaussian_radii(uint32_t radius, uint32_t radii[GAUSSIAN_PASSES]) {
+    const double sigma = radius / 3.0;
+    const double variance = 12.0 * sigma * sigma;
+
+    int lower = (int)floor(sqrt(variance / GAUSSIAN_PASSES + 1.0));
+    if (lower % 2 == 0) lower--;
+    const double boxes = (variance - GAUSSIAN_PASSES * lower * lower - 4.0 * GAUSSIAN_PASSES * lower - 3.0 * GAUSSIAN_PASSES) / (-4.0 * lower - 4.0);
+    const int lower_count = (int)floor(boxes + 0.5);
+
+    for (int i = 0; i < GAUSSIAN_PASSES; ++i) {
+        radii[i] = (uint32_t)((i < lower_count ? lower : lower + 2) - 1) / 2;
+    }
+}
+
+uint32_t scope_blur_passes(scope_blur_shape_t shape, uint32_t radius, uint32_t radii[SCOPE_BLUR_MAX_PASSES]) {
+    assert(shape < SCOPE_BLUR_SHAPE_COUNT);
+
+    if (shape == SCOPE_BLUR_GAUSSIAN) {
+        gaussian_radii(radius, radii);
+        return GAUSSIAN_PASSES;
+    }
+    radii[0] = radius;
+    return 1;
+}
+
+bool scope_blur_apply(scope_blur_t *blur, const uint32_t *bins, uint32_t resolution, const scope_rect_t *occupied, float *out, scope_thread_pool_t *pool) {
+    assert(blur);
+    assert(bins && out);
+
+    if (resolution == 0) {
+        return true;
+    }
+
+    uint32_t radii[SCOPE_BLUR_MAX_PASSES];
+    const uint32_t pass_count = scope_blur_passes(blur->shape, blur->radius, radii);
+
+    // Every pass works over the occupied bins and a halo wider than all passes together spread
+    // them. The edges of the region are then zero or those of the grid, so padding the tables
+    // with copies of them reads the same as clamping at the edges of the whole grid.
+    scope_rect_t region = {0, 0, resolution, resolution};
+    if (occupied) {
+        if (occupied->width == 0 || occupied->height == 0) {
+            memset(out, 0, (size_t)resolution * resolution * sizeof(float));
+            return true;
+        }
+
+        uint32_t halo = 1;
+        for (uint32_t p = 0; p < pass_count; ++p) {
+            halo += radii[p];
+        }
+        const uint32_t x_end = MIN(occupied->x + occupied->width + halo, resolution);
+        const uint32_t y_end = MIN(occupied->y + occupied->height + halo, resolution);
+        region.x = occupied->x > halo ? occupied->x - halo : 0;
+        region.y = occupied->y > halo ? occupied->y - halo : 0;
+        region.width = x_end - region.x;
+        region.height = y_end - region.y;
+    }
+
+    if (pass_count > 1 && !reserve(&blur->sums, &blur->sum_capacity, (size_t)resolution * resolution)) {
+        return false;
+    }
+
+    // Room for the widest pass
+    uint32_t max_radius = 0;
+    for (uint32_t p = 0; p < pass_count; ++p) {
+        max_radius = MAX(max_radius, radii[p]);
+    }
+    const uint32_t max_width = region.width + 2 * (max_radius + 1);
+    const uint32_t max_height = region.height + 2 * (max_radius + 1);
+    const uint32_t table_count = blur->shape == SCOPE_BLUR_DIAMOND ? 2 : 1;
+    const uint32_t band_count = MIN(scope_thread_pool_size(pool), max_height);
+    if (!reserve(&blur->tables, &blur->table_capacity, (size_t)max_width * max_height * table_count) ||
+        !reserve(&blur->rows, &blur->row_capacity, (size_t)max_width * band_count * (1 + table_count))) {
+        return false;
+    }
+
+    // Each pass sums its input into the next, the weights multiply up and divide only once
+    double weight = 1.0;
+    for (uint32_t p = 0; p < pass_count; ++p) {
+        const uint32_t r = radii[p];
+        const uint32_t width = region.width + 2 * (r + 1);
+        const uint32_t height = region.height + 2 * (r + 1);
+        const bool last = p + 1 == pass_count;
+
+        weight *= blur->shape == SCOPE_BLUR_DIAMOND ? (double)(2 * r * r + 2 * r + 1) : (double)((2 * r + 1) * (2 * r + 1));
+
+        struct blur_job job = {
+            .bins = p == 0 ? bins : NULL,
+            .sums_in = p == 0 ? NULL : blur->sums,
+            .resolution = resolution,
+            .region = region,
+            .shape = blur->shape == SCOPE_BLUR_DIAMOND ? SCOPE_BLUR_DIAMOND : SCOPE_BLUR_BOX,
+            .radius = r,
+            .pad = r + 1,
+            .width = width,
+            .height = height,
+            .table_count = table_count,
+            .directions = {table_count == 2 ? -1 : 0, 1},
+            .tables = {blur->tables, blur->tables + (size_t)width * height},
+            .band_count = MIN(band_count, height),
+            .prefix = blur->rows,
+            .carries = blur->rows + (size_t)width * band_count,
+            .out_band_count = MIN(band_count, region.height),
+            .sums_out = last ? NULL : blur->sums,
+            .out = last ? out : NULL,
+            .weight = weight,
+        };
+        run_pass(&job, pool);
+    }
+    return true;
+}
+
+static bool reserve(uint64_t **buffer, size_t *capacity, size_t count) {
+    if (count <= *capacity) {
+        return true;
+    }
+
+    free(*buffer);
+    *buffer = malloc(count * sizeof(uint64_t));
+    *capacity = *buffer ? count : 0;
+    return *buffer != NULL;
+}
+
+static inline uint32_t band_begin(uint32_t count, uint32_t band, uint32_t band_count) {
+    return (uint32_t)((uint64_t)count * band / band_count);
+}
+
+// Running sum of a table `rows` rows below the row it was carried from, 0 once off the table
+static inline uint64_t carried(const uint64_t *carry, const struct blur_job *job, int32_t direction, uint32_t x, uint32_t rows) {
+    const int64_t source = (int64_t)x + (int64_t)direction * rows;
+    return source >= 0 && source < job->width ? carry[source] : 0;
+}
+
+static void run_pass(struct blur_job *job, scope_thread_pool_t *pool) {
+    scope_thread_pool_run(job->band_count > 1 ? pool : NULL, job->band_count, sum_band_task, job);
+
+    // Carries down the bands, each from the resolved last row of the band above
+    for (uint32_t band = 1; band < job->band_count; ++band) {
+        const uint32_t above = band_begin(job->height, band - 1, job->band_count);
+        const uint32_t last = band_begin(job->height, band, job->band_count) - 1;
+
+        for (uint32_t t = 0; t < job->table_count; ++t) {
+            const uint64_t *local = job->tables[t] + (size_t)last * job->width;
+            const uint64_t *carry_above = job->carries + ((size_t)(band - 1) * job->table_count + t) * job->width;
+            uint64_t *carry = job->carries + ((size_t)band * job->table_count + t) * job->width;
+
+            for (uint32_t x = 0; x < job->width; ++x) {
+                carry[x] = local[x] + (band > 1 ? carried(carry_above, job, job->directions[t], x, last - above + 1) : 0);
+            }
+        }
+    }
+
+    if (job->band_count > 1) {
+        scope_thread_pool_run(pool, job->band_count - 1, carry_band_task, job);
+    }
+    scope_thread_pool_run(job->out_band_count > 1 ? pool : NULL, job->out_band_count, output_band_task, job);
+}
+
+// Prefix sums of padded row `y`, the edges of the region repeated `pad` times on either side
+static void prefix_row(const struct blur_job *job, uint32_t y, uint64_t *prefix) {
+    const scope_rect_t region = job->region;
+    const uint32_t source = region.y + (uint32_t)CLAMP((int64_t)y - job->pad, 0, (int64_t)region.height - 1);
+    const size_t offset = (size_t)source * job->resolution + region.x;
+    const uint32_t w = region.width;
+
+    uint64_t run = 0;
+    uint32_t x = 0;
+    if (job->bins) {
+        const uint32_t *row = job->bins + offset;
+        for (; x < job->pad; ++x) prefix[x] = run += row[0];
+        for (uint32_t i = 0; i < w; ++i, ++x) prefix[x] = run += row[i];
+        for (; x < job->width; ++x) prefix[x] = run += row[w - 1];
+    } else {
+        const uint64_t *row = job->sums_in + offset;
+        for (; x < job->pad; ++x) prefix[x] = run += row[0];
+        for (uint32_t i = 0; i < w; ++i, ++x) prefix[x] = run += row[i];
+        for (; x < job->width; ++x) prefix[x] = run += row[w - 1];
+    }
+}
+
+// The rows of a band summed as if the band started the table. Sums wrap around 64 bits, the
+// differences the lookups take are exact either way.
+static void sum_band_task(void *user_data, uint32_t band) {
+    const struct blur_job *job = user_data;
+    const uint32_t y_begin = band_begin(job->height, band, job->band_count);
+    const uint32_t y_end = band_begin(job->height, band + 1, job->band_count);
+    const uint32_t width = job->width;
+    uint64_t *prefix = job->prefix + (size_t)band * width;
+
+    for (uint32_t y = y_begin; y < y_end; ++y) {
+        prefix_row(job, y, prefix);
+
+        for (uint32_t t = 0; t < job->table_count; ++t) {
+            uint64_t *row = job->tables[t] + (size_t)y * width;
+            if (y == y_begin) {
+                memcpy(row, prefix, (size_t)width * sizeof(uint64_t));
+                continue;
+            }
+
+            const uint64_t *above = row - width;
+            const int32_t direction = job->directions[t];
+            if (direction == 0) {
+                for (uint32_t x = 0; x < width; ++x) row[x] = prefix[x] + above[x];
+            } else if (direction < 0) {
+                row[0] = prefix[0];
+                for (uint32_t x = 1; x < width; ++x) row[x] = prefix[x] + above[x - 1];
+            } else {
+                for (uint32_t x = 0; x + 1 < width; ++x) row[x] = prefix[x] + above[x + 1];
+                row[width - 1] = prefix[width - 1];
+            }
+        }
+    }
+}
+
+// Adds the running sums of every band above, task i is band i + 1
+static void carry_band_task(void *user_data, uint32_t task) {
+    const struct blur_job *job = user_data;
+    const uint32_t band = task + 1;
+    const uint32_t y_begin = band_begin(job->height, band, job->band_count);
+    const uint32_t y_end = band_begin(job->height, band + 1, job->band_count);
+
+    for (uint32_t t = 0; t < job->table_count; ++t) {
+        const uint64_t *carry = job->carries + ((size_t)band * job->table_count + t) * job->width;
+        for (uint32_t y = y_begin; y < y_end; ++y) {
+            uint64_t *row = job->tables[t] + (size_t)y * job->width;
+            for (uint32_t x = 0; x < job->width; ++x) {
+                row[x] += carried(carry, job, job->directions[t], x, y - y_begin + 1);
+            }
+        }
+    }
+}
+
+static inline void zero_floats(float *out, size_t count) {
+    memset(out, 0, count * sizeof(float));
+}
+
+// Output rows of a band of the region. Bins outside the region are too far from any hit to get
+// one: the last pass writes them as zero, the first and last band taking the rows above and
+// below, and the passes before never read them.
+static void output_band_task(void *user_data, uint32_t band) {
+    const struct blur_job *job = user_data;
+    const uint32_t res = job->resolution;
+    const scope_rect_t region = job->region;
+    const uint32_t y_begin = region.y + band_begin(region.height, band, job->out_band_count);
+    const uint32_t y_end = region.y + band_begin(region.height, band + 1, job->out_band_count);
+    const size_t width = job->width;
+    const uint32_t r = job->radius;
+
+    if (job->out && band == 0) {
+        zero_floats(job->out, (size_t)region.y * res);
+    }
+    if (job->out && band + 1 == job->out_band_count) {
+        zero_floats(job->out + (size_t)y_end * res, (size_t)(res - y_end) * res);
+    }
+
+    for (uint32_t by = y_begin; by < y_end; ++by) {
+        const size_t cy = by - region.y + job->pad;
+        if (job->out) {
+            zero_floats(job->out + (size_t)by * res, region.x);
+            zero_floats(job->out + (size_t)by * res + region.x + region.width, res - region.x - region.width);
+        }
+
+        for (uint32_t bx = region.x; bx < region.x + region.width; ++bx) {
+            const size_t cx = bx - region.x + job->pad;
+
+            uint64_t sum;
+            if (job->shape == SCOPE_BLUR_BOX) {
+                const uint64_t *s = job->tables[0];
+                sum = s[(cy + r) * width + cx + r] - s[(cy - r - 1) * width + cx + r] -
+                      s[(cy + r) * width + cx - r - 1] + s[(cy - r - 1) * width + cx - r - 1];
+            } else {
+                // Upper and lower half of the right edge, minus those of the left edge, each a run
+                // of row prefix sums along a diagonal
+                const uint64_t *a = job->tables[0]; // down and to the right
+                const uint64_t *d = job->tables[1]; // down and to the left
+                sum = (a[cy * width + cx + r] - a[(cy - r - 1) * width + cx - 1]) +
+                      (d[(cy + r) * width + cx] - d[cy * width + cx + r]) -
+                      (d[cy * width + cx - r - 1] - d[(cy - r - 1) * width + cx]) -
+                      (a[(cy + r) * width + cx - 1] - a[cy * width + cx - r - 1]);
+            }
+
+            if (job->out) {
+                // Both exact below 2^24, then the same float as dividing floats
+                job->out[(size_t)by * res + bx] = (float)((double)sum / job->weight);
+            } else {
+                job->sums_out[(size_t)by * res + bx] = sum;
+            }
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_thread.h"
+
+// Blur of the vectorscope bins at any radius for the same cost per bin. Sums come from tables of
+// running sums over the bins, padded with copies of the edges so samples clamp at the edges like
+// vs_blur: a summed-area table for boxes, and running sums along both diagonals of the row
+// prefix sums for diamonds, 4 and 8 lookups per bin whatever the radius. The sums are integers
+// and exact, so the radius 2 diamond gives the same floats as scope_vectorscope_blur() as long as
+// its float sums are exact, i.e. below 2^24.
+//
+// Footage mostly fills a small part of the plane, so the tables can cover just the occupied
+// bins and the halo the blur spreads them over.
+//
+// Building the tables is a scan down the rows: bands of rows are summed on their own in
+// parallel, the running sums carried between bands are resolved band by band, and the bands add
+// them in parallel again.
+
+#define SCOPE_BLUR_MAX_RADIUS 64
+#define SCOPE_BLUR_MAX_PASSES 3
+
+typedef enum scope_blur_shape {
+    SCOPE_BLUR_DIAMOND, // the taps of vs_blur, |dx| + |dy| <= radius
+    SCOPE_BLUR_BOX,
+    SCOPE_BLUR_GAUSSIAN, // three boxes approximating a Gaussian with sigma = radius / 3
+    SCOPE_BLUR_SHAPE_COUNT
+} scope_blur_shape_t;
+
+typedef struct scope_blur {
+    scope_blur_shape_t shape;
+    uint32_t radius; // at most SCOPE_BLUR_MAX_RADIUS, 0 copies the bins
+
+    uint64_t *tables; // one or two padded tables of running sums
+    size_t table_capacity;
+    uint64_t *rows; // prefix sums of a padded row per band, then the carries into every band
+    size_t row_capacity;
+    uint64_t *sums; // box sums between the passes of a Gaussian
+    size_t sum_capacity;
+} scope_blur_t;
+
+void scope_blur_create(scope_blur_t *blur, scope_blur_shape_t shape, uint32_t radius);
+void scope_blur_destroy(scope_blur_t *blur);
+
+/* @brief Averages the `resolution` x `resolution` bins over the shape into `out`. If `occupied` is
+ * not NULL, every bin outside it must be zero (see scope_vectorscope_bounds()): only the rect and
+ * a halo as wide as the blur are summed, the rest of `out` is zeroed. Bands of rows are spread
+ * over the pool, which may be NULL. Returns false on allocation failure. */
+bool scope_blur_apply(scope_blur_t *blur, const uint32_t *bins, uint32_t resolution, const scope_rect_t *occupied, float *out, scope_thread_pool_t *pool);
+
+/* @brief Radius of each box or diamond pass the shape is blurred with, the radius itself or the
+ * three boxes of a Gaussian. Returns the pass count. vs_blur on the GPU runs the same passes. */
+uint32_t scope_blur_passes(scope_blur_shape_t shape, uint32_t radius, uint32_t radii[SCOPE_BLUR_MAX_PASSES]);
+
+/* @brief Name of the shape, as the CLI takes it */
+const char *scope_blur_shape_name(scope_blur_shape_t shape);
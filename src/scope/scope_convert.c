@@ -0,0 +1,392 @@
+#include "scope_convert.h"
+
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef void (*decode_rgb8_fn)(const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, float *const out[3]);
+typedef void (*decode_fn)(const uint8_t *row, uint32_t width, float *const out[3]);
+typedef void (*decode_ycbcr_fn)(const uint8_t *luma, const uint8_t *cb, const uint8_t *cr, uint32_t width, const scope_ycbcr_decode_t *decode, float *const out[3]);
+typedef void (*encode_rgb8_fn)(const float *const in[3], uint32_t width, scope_rgb8_layout_t layout, uint8_t *row);
+typedef void (*encode_fn)(const float *const in[3], uint32_t width, uint8_t *row);
+typedef void (*swap_fn)(const uint8_t *in, uint32_t width, uint8_t *out);
+
+struct kernels {
+    decode_rgb8_fn decode_rgb8;
+    decode_fn decode_rgb10a2;
+    decode_fn decode_rgba16f;
+    decode_ycbcr_fn decode_ycbcr;
+    encode_rgb8_fn encode_rgb8;
+    encode_fn encode_rgb10a2;
+    encode_fn encode_rgba16f;
+    swap_fn swap_rgb8;
+};
+
+struct convert_job {
+    // Source, a frame or float planes
+    const scope_image_t *image;
+    const scope_float_planes_t *src_planes;
+
+    // Destination, packed rows or float planes
+    scope_pixel_format_t format;
+    uint8_t *dst;
+    uint32_t dst_stride;
+    const scope_float_planes_t *dst_planes;
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t band_count;
+    float *scratch;
+    struct kernels kernels;
+    scope_ycbcr_decode_t ycbcr;
+};
+
+static struct kernels get_kernels(scope_isa_t isa);
+static bool run(scope_converter_t *converter, struct convert_job *job, scope_thread_pool_t *pool);
+static void convert_band_task(void *user_data, uint32_t band);
+
+static bool is_packed_destination(scope_pixel_format_t format) {
+    return scope_pixel_format_is_rgb8(format) || scope_pixel_format_is_hdr(format);
+}
+
+void scope_converter_create(scope_converter_t *converter) {
+    assert(converter);
+    *converter = (scope_converter_t){.isa = scope_cpu_best_isa(), .matrix = SCOPE_MATRIX_BT709};
+}
+
+void scope_converter_destroy(scope_converter_t *converter) {
+    if (converter) {
+        free(converter->scratch);
+        *converter = (scope_converter_t){0};
+    }
+}
+
+bool scope_convert(scope_converter_t *converter, const scope_image_t *image, scope_pixel_format_t format, uint8_t *dst, uint32_t dst_stride, scope_thread_pool_t *pool) {
+    assert(converter);
+    assert(image && image->data);
+    assert(dst);
+
+    if (!is_packed_destination(format)) {
+        return false;
+    }
+
+    struct convert_job job = {
+        .image = image,
+        .format = format,
+        .dst = dst,
+        .dst_stride = dst_stride,
+        .width = image->width,
+        .height = image->height,
+    };
+    return run(converter, &job, pool);
+}
+
+bool scope_convert_to_planes(scope_converter_t *converter, const scope_image_t *image, const scope_float_planes_t *planes, scope_thread_pool_t *pool) {
+    assert(converter);
+    assert(image && image->data);
+    assert(planes && planes->width == image->width && planes->height == image->height);
+
+    struct convert_job job = {
+        .image = image,
+        .dst_planes = planes,
+        .width = image->width,
+        .height = image->height,
+    };
+    return run(converter, &job, pool);
+}
+
+bool scope_convert_from_planes(scope_converter_t *converter, const scope_float_planes_t *planes, scope_pixel_format_t format, uint8_t *dst, uint32_t dst_stride, scope_thread_pool_t *pool) {
+    assert(converter);
+    assert(planes);
+    assert(dst);
+
+    if (!is_packed_destination(format)) {
+        return false;
+    }
+
+    struct convert_job job = {
+        .src_planes = planes,
+        .format = format,
+        .dst = dst,
+        .dst_stride = dst_stride,
+        .width = planes->width,
+        .height = planes->height,
+    };
+    return run(converter, &job, pool);
+}
+
+static bool run(scope_converter_t *converter, struct convert_job *job, scope_thread_pool_t *pool) {
+    if (job->width == 0 || job->height == 0) {
+        return true;
+    }
+
+    job->band_count = MIN(scope_thread_pool_size(pool), job->height);
+    job->kernels = get_kernels(converter->isa);
+
+    const size_t scratch_size = (size_t)job->width * 3 * job->band_count;
+    if (scratch_size > converter->scratch_capacity) {
+        float *scratch = realloc(converter->scratch, scratch_size * sizeof(float));
+        if (!scratch) {
+            return false;
+        }
+        converter->scratch = scratch;
+        converter->scratch_capacity = scratch_size;
+    }
+    job->scratch = converter->scratch;
+
+    if (job->image && scope_pixel_format_is_ycbcr(job->image->format)) {
+        // Nominal code ranges, as in scope_code_lut_update()
+        const scope_ycbcr_layout_t layout = scope_ycbcr_layout(job->image->format);
+        const uint32_t codes = 1u << layout.bits;
+        const uint32_t scale_8 = 1u << (layout.bits - 8);
+        const bool full = job->image->range == SCOPE_COLOR_RANGE_FULL;
+        job->ycbcr = (scope_ycbcr_decode_t){
+            .layout = layout,
+            .y_zero = full ? 0.0f : (float)(16 * scale_8),
+            .y_span = full ? (float)(codes - 1) : (float)(219 * scale_8),
+            .c_zero = (float)(codes / 2),
+            .c_span = full ? (float)(codes - 1) : (float)(224 * scale_8),
+            .inverse = scope_ycbcr_inverse(converter->matrix),
+        };
+    }
+
+    scope_thread_pool_run(job->band_count > 1 ? pool : NULL, job->band_count, convert_band_task, job);
+    return true;
+}
+
+static void decode_row(const struct convert_job *job, uint32_t y, float *const out[3]) {
+    const scope_image_t *image = job->image;
+    const uint8_t *row = scope_image_row(image, y);
+
+    switch (image->format) {
+    case SCOPE_PIXEL_FORMAT_BGRA8:
+    case SCOPE_PIXEL_FORMAT_RGBA8:
+        job->kernels.decode_rgb8(row, image->width, scope_rgb8_layout(image->format), out);
+        break;
+    case SCOPE_PIXEL_FORMAT_RGB10A2:
+        job->kernels.decode_rgb10a2(row, image->width, out);
+        break;
+    case SCOPE_PIXEL_FORMAT_RGBA16F:
+        job->kernels.decode_rgba16f(row, image->width, out);
+        break;
+    default: {
+        const scope_ycbcr_layout_t *layout = &job->ycbcr.layout;
+        const size_t offset = (size_t)(y >> layout->y_shift) * image->chroma_stride;
+        const uint8_t *cb = image->chroma[0] + offset;
+        const uint8_t *cr = layout->interleaved ? cb + layout->sample_bytes : image->chroma[1] + offset;
+        job->kernels.decode_ycbcr(row, cb, cr, image->width, &job->ycbcr, out);
+        break;
+    }
+    }
+}
+
+static void encode_row(const struct convert_job *job, const float *const in[3], uint8_t *row) {
+    switch (job->format) {
+    case SCOPE_PIXEL_FORMAT_RGB10A2: job->kernels.encode_rgb10a2(in, job->width, row); break;
+    case SCOPE_PIXEL_FORMAT_RGBA16F: job->kernels.encode_rgba16f(in, job->width, row); break;
+    default: job->kernels.encode_rgb8(in, job->width, scope_rgb8_layout(job->format), row); break;
+    }
+}
+
+// Rows of planes that interleave go through the band's scratch rows, separate planes are used in place
+static void gather_row(const scope_float_planes_t *planes, uint32_t y, float *const scratch[3], float *out[3]) {
+    for (uint32_t c = 0; c < 3; ++c) {
+        const float *in = planes->planes[c] + (size_t)y * planes->stride;
+        if (planes->step == 1) {
+            out[c] = (float *)in;
+            continue;
+        }
+        for (uint32_t x = 0; x < planes->width; ++x) {
+            scratch[c][x] = in[(size_t)x * planes->step];
+        }
+        out[c] = scratch[c];
+    }
+}
+
+static void scatter_row(const scope_float_planes_t *planes, uint32_t y, const float *const in[3]) {
+    for (uint32_t c = 0; c < 3; ++c) {
+        float *out = planes->planes[c] + (size_t)y * planes->stride;
+        for (uint32_t x = 0; x < planes->width; ++x) {
+            out[(size_t)x * planes->step] = in[c][x];
+        }
+    }
+}
+
+static void convert_band_task(void *user_data, uint32_t band) {
+    const struct convert_job *job = user_data;
+    const uint32_t y_begin = (uint32_t)((uint64_t)job->height * band / job->band_count);
+    const uint32_t y_end = (uint32_t)((uint64_t)job->height * (band + 1) / job->band_count);
+
+    float *const scratch[3] = {
+        job->scratch + (size_t)job->width * 3 * band,
+        job->scratch + (size_t)job->width * (3 * band + 1),
+        job->scratch + (size_t)job->width * (3 * band + 2),
+    };
+    const scope_pixel_format_t src_format = job->image ? job->image->format : SCOPE_PIXEL_FORMAT_COUNT;
+
+    for (uint32_t y = y_begin; y < y_end; ++y) {
+        uint8_t *dst = job->dst ? job->dst + (size_t)y * job->dst_stride : NULL;
+
+        if (dst && src_format == job->format) {
+            memcpy(dst, scope_image_row(job->image, y), (size_t)job->width * scope_pixel_format_bytes(job->format));
+            continue;
+        }
+        if (dst && scope_pixel_format_is_rgb8(src_format) && scope_pixel_format_is_rgb8(job->format)) {
+            job->kernels.swap_rgb8(scope_image_row(job->image, y), job->width, dst);
+            continue;
+        }
+
+        float *rgb[3];
+        if (job->src_planes) {
+            gather_row(job->src_planes, y, scratch, rgb);
+        } else if (job->dst_planes && job->dst_planes->step == 1) {
+            // Straight into the destination
+            for (uint32_t c = 0; c < 3; ++c) {
+                rgb[c] = job->dst_planes->planes[c] + (size_t)y * job->dst_planes->stride;
+            }
+            decode_row(job, y, rgb);
+        } else {
+            memcpy(rgb, scratch, sizeof(rgb));
+            decode_row(job, y, rgb);
+        }
+
+        if (job->dst_planes) {
+            if (job->dst_planes->step != 1) {
+                scatter_row(job->dst_planes, y, (const float *const *)rgb);
+            }
+        } else {
+            encode_row(job, (const float *const *)rgb, dst);
+        }
+    }
+}
+
+static inline uint32_t load_word(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store_word(uint8_t *p, uint32_t word) {
+    p[0] = (uint8_t)word;
+    p[1] = (uint8_t)(word >> 8);
+    p[2] = (uint8_t)(word >> 16);
+    p[3] = (uint8_t)(word >> 24);
+}
+
+void scope_decode_rgb8_row_scalar(const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, float *const out[3]) {
+    for (uint32_t x = 0; x < width; ++x, row += 4) {
+        out[0][x] = (float)row[layout.r] / 255.0f;
+        out[1][x] = (float)row[layout.g] / 255.0f;
+        out[2][x] = (float)row[layout.b] / 255.0f;
+    }
+}
+
+void scope_decode_rgb10a2_row_scalar(const uint8_t *row, uint32_t width, float *const out[3]) {
+    for (uint32_t x = 0; x < width; ++x, row += 4) {
+        const uint32_t word = load_word(row);
+        out[0][x] = (float)(word & 0x3ffu) / 1023.0f;
+        out[1][x] = (float)((word >> 10) & 0x3ffu) / 1023.0f;
+        out[2][x] = (float)((word >> 20) & 0x3ffu) / 1023.0f;
+    }
+}
+
+void scope_decode_rgba16f_row_scalar(const uint8_t *row, uint32_t width, float *const out[3]) {
+    for (uint32_t x = 0; x < width; ++x, row += 8) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            out[c][x] = scope_half_to_float((uint16_t)(row[2 * c] | (row[2 * c + 1] << 8)));
+        }
+    }
+}
+
+void scope_decode_ycbcr_row_scalar(const uint8_t *luma, const uint8_t *cb, const uint8_t *cr, uint32_t width, const scope_ycbcr_decode_t *decode, float *const out[3]) {
+    const scope_ycbcr_layout_t *layout = &decode->layout;
+    const uint32_t chroma_step = layout->sample_bytes * (layout->interleaved ? 2 : 1);
+
+    for (uint32_t x = 0; x < width; ++x) {
+        const size_t c = (size_t)(x >> layout->x_shift) * chroma_step;
+        const uint32_t y_code = scope_ycbcr_sample(luma + (size_t)x * layout->sample_bytes, layout->sample_bytes, layout->sample_shift, layout->bits);
+        const uint32_t cb_code = scope_ycbcr_sample(cb + c, layout->sample_bytes, layout->sample_shift, layout->bits);
+        const uint32_t cr_code = scope_ycbcr_sample(cr + c, layout->sample_bytes, layout->sample_shift, layout->bits);
+
+        const float y = ((float)y_code - decode->y_zero) / decode->y_span;
+        const float u = ((float)cb_code - decode->c_zero) / decode->c_span;
+        const float v = ((float)cr_code - decode->c_zero) / decode->c_span;
+        out[0][x] = y + decode->inverse.r_cr * v;
+        out[1][x] = y - decode->inverse.g_cb * u - decode->inverse.g_cr * v;
+        out[2][x] = y + decode->inverse.b_cb * u;
+    }
+}
+
+void scope_encode_rgb8_row_scalar(const float *const in[3], uint32_t width, scope_rgb8_layout_t layout, uint8_t *row) {
+    for (uint32_t x = 0; x < width; ++x, row += 4) {
+        row[layout.r] = (uint8_t)scope_unorm_code(in[0][x], 255.0f);
+        row[layout.g] = (uint8_t)scope_unorm_code(in[1][x], 255.0f);
+        row[layout.b] = (uint8_t)scope_unorm_code(in[2][x], 255.0f);
+        row[3] = 255;
+    }
+}
+
+void scope_encode_rgb10a2_row_scalar(const float *const in[3], uint32_t width, uint8_t *row) {
+    for (uint32_t x = 0; x < width; ++x, row += 4) {
+        store_word(row, scope_unorm_code(in[0][x], 1023.0f) |
+                        (scope_unorm_code(in[1][x], 1023.0f) << 10) |
+                        (scope_unorm_code(in[2][x], 1023.0f) << 20) |
+                        (3u << 30));
+    }
+}
+
+void scope_encode_rgba16f_row_scalar(const float *const in[3], uint32_t width, uint8_t *row) {
+    for (uint32_t x = 0; x < width; ++x, row += 8) {
+        const uint16_t half[4] = {scope_float_to_half(in[0][x]), scope_float_to_half(in[1][x]), scope_float_to_half(in[2][x]), 0x3c00};
+        for (uint32_t c = 0; c < 4; ++c) {
+            row[2 * c] = (uint8_t)half[c];
+            row[2 * c + 1] = (uint8_t)(half[c] >> 8);
+        }
+    }
+}
+
+void scope_swap_rgb8_row_scalar(const uint8_t *in, uint32_t width, uint8_t *out) {
+    for (uint32_t x = 0; x < width; ++x, in += 4, out += 4) {
+        const uint8_t r = in[0];
+        out[0] = in[2];
+        out[1] = in[1];
+        out[2] = r;
+        out[3] = in[3];
+    }
+}
+
+static struct kernels get_kernels(scope_isa_t isa) {
+    if (!scope_cpu_supports(isa)) {
+        isa = scope_cpu_best_isa();
+    }
+
+    switch (isa) {
+#if SCOPE_X86_SIMD
+        case SCOPE_ISA_AVX512:
+        case SCOPE_ISA_AVX2:
+            return (struct kernels){
+                scope_decode_rgb8_row_avx2,
+                scope_decode_rgb10a2_row_avx2,
+                scope_decode_rgba16f_row_avx2,
+                scope_decode_ycbcr_row_avx2,
+                scope_encode_rgb8_row_avx2,
+                scope_encode_rgb10a2_row_avx2,
+                scope_encode_rgba16f_row_avx2,
+                scope_swap_rgb8_row_avx2,
+            };
+#endif
+        default:
+            return (struct kernels){
+                scope_decode_rgb8_row_scalar,
+                scope_decode_rgb10a2_row_scalar,
+                scope_decode_rgba16f_row_scalar,
+                scope_decode_ycbcr_row_scalar,
+                scope_encode_rgb8_row_scalar,
+                scope_encode_rgb10a2_row_scalar,
+                scope_encode_rgba16f_row_scalar,
+                scope_swap_rgb8_row_scalar,
+            };
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_cpu.h"
+#include "scope_thread.h"
+
+// Pixel format conversion shared by the sources and the scopes. Values are converted as code
+// values, not color managed: 8-bit, 10-bit and half float RGB all map to 0-1 (half floats may go
+// past it), Y'CbCr is turned into R'G'B' with the converter's matrix in its range, and the transfer
+// of the frame is kept. Every conversion decodes a row into planar floats and encodes those into
+// the destination, except BGRA8 <-> RGBA8, which swaps bytes directly. Alpha is dropped, packed
+// destinations get it opaque.
+//
+// Kernels are picked from the CPU features at creation. The SIMD kernels give the same bytes as
+// the scalar ones: decoding and encoding use the same float operations in the same order, and
+// half floats round to nearest even like F16C.
+
+/* @brief Planar float RGB, the intermediate of every conversion and a format of its own for analysis.
+ * Planes that point into one buffer of interleaved RGB(A) floats work as well. */
+typedef struct scope_float_planes {
+    float *planes[3]; // R, G, B
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride; // floats from one row of a plane to the next
+    uint32_t step;   // floats from one pixel to the next, 1 for separate planes, 3 or 4 when interleaved
+} scope_float_planes_t;
+
+typedef struct scope_converter {
+    // Kernels used, picked at creation from the CPU features
+    scope_isa_t isa;
+    // Y'CbCr frames are decoded with, BT.709 unless changed after creation
+    scope_matrix_t matrix;
+
+    float *scratch; // three rows of planar floats per band
+    size_t scratch_capacity;
+} scope_converter_t;
+
+void scope_converter_create(scope_converter_t *converter);
+void scope_converter_destroy(scope_converter_t *converter);
+
+/* @brief Converts `image`, of any format, into rows of `format` at `dst`, `dst_stride` bytes apart.
+ * `format` has to be BGRA8, RGBA8, RGBA16F or RGB10A2. Values outside 0-1 saturate, except in
+ * RGBA16F. Bands of rows are spread over the pool, which may be NULL.
+ * Returns false for other destination formats and on allocation failure. */
+bool scope_convert(scope_converter_t *converter, const scope_image_t *image, scope_pixel_format_t format, uint8_t *dst, uint32_t dst_stride, scope_thread_pool_t *pool);
+
+/* @brief Converts `image` into float planes of the same size. */
+bool scope_convert_to_planes(scope_converter_t *converter, const scope_image_t *image, const scope_float_planes_t *planes, scope_thread_pool_t *pool);
+
+/* @brief Converts float planes into rows of `format`, as scope_convert(). */
+bool scope_convert_from_planes(scope_converter_t *converter, const scope_float_planes_t *planes, scope_pixel_format_t format, uint8_t *dst, uint32_t dst_stride, scope_thread_pool_t *pool);
@@ -0,0 +1,221 @@
+#include "scope_internal.h"
+
+// AVX2 versions of the scalar conversion kernels, eight pixels at a time with the rest of a row
+// going through the scalar kernel. Integer to float conversions are exact, the divisions, clamps
+// and rounding are the same IEEE operations in the same order, and F16C rounds to nearest even
+// like scope_float_to_half(), so the output is bit-identical.
+
+#if SCOPE_X86_SIMD
+
+#include <immintrin.h>
+
+#define TARGET_AVX2 __attribute__((target("avx2,f16c")))
+
+// Rest of a row from pixel `x` on
+#define OFFSET_PLANES(planes, x) {(planes)[0] + (x), (planes)[1] + (x), (planes)[2] + (x)}
+
+TARGET_AVX2 static inline __m256 unorm_channel(__m256i words, __m128i shift, __m256i mask, __m256 max) {
+    return _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(words, shift), mask)), max);
+}
+
+TARGET_AVX2 static inline __m256i unorm_code(__m256 v, __m256 max) {
+    v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, max), _mm256_set1_ps(0.5f)));
+}
+
+TARGET_AVX2 void scope_decode_rgb8_row_avx2(const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, float *const out[3]) {
+    const __m128i shifts[3] = {
+        _mm_cvtsi32_si128((int)layout.r * 8),
+        _mm_cvtsi32_si128((int)layout.g * 8),
+        _mm_cvtsi32_si128((int)layout.b * 8),
+    };
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m256 max = _mm256_set1_ps(255.0f);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i words = _mm256_loadu_si256((const __m256i *)(row + (size_t)x * 4));
+        for (uint32_t c = 0; c < 3; ++c) {
+            _mm256_storeu_ps(out[c] + x, unorm_channel(words, shifts[c], mask, max));
+        }
+    }
+
+    float *const rest[3] = OFFSET_PLANES(out, x);
+    scope_decode_rgb8_row_scalar(row + (size_t)x * 4, width - x, layout, rest);
+}
+
+TARGET_AVX2 void scope_decode_rgb10a2_row_avx2(const uint8_t *row, uint32_t width, float *const out[3]) {
+    const __m128i shifts[3] = {_mm_cvtsi32_si128(0), _mm_cvtsi32_si128(10), _mm_cvtsi32_si128(20)};
+    const __m256i mask = _mm256_set1_epi32(0x3ff);
+    const __m256 max = _mm256_set1_ps(1023.0f);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i words = _mm256_loadu_si256((const __m256i *)(row + (size_t)x * 4));
+        for (uint32_t c = 0; c < 3; ++c) {
+            _mm256_storeu_ps(out[c] + x, unorm_channel(words, shifts[c], mask, max));
+        }
+    }
+
+    float *const rest[3] = OFFSET_PLANES(out, x);
+    scope_decode_rgb10a2_row_scalar(row + (size_t)x * 4, width - x, rest);
+}
+
+TARGET_AVX2 void scope_decode_rgba16f_row_avx2(const uint8_t *row, uint32_t width, float *const out[3]) {
+    // Pixels come out of the 4 x 4 transposes as 0 2 4 6 1 3 5 7
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const uint8_t *p = row + (size_t)x * 8;
+        const __m256 v0 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p));
+        const __m256 v1 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(p + 16)));
+        const __m256 v2 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(p + 32)));
+        const __m256 v3 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(p + 48)));
+
+        const __m256 rg01 = _mm256_unpacklo_ps(v0, v1);
+        const __m256 ba01 = _mm256_unpackhi_ps(v0, v1);
+        const __m256 rg23 = _mm256_unpacklo_ps(v2, v3);
+        const __m256 ba23 = _mm256_unpackhi_ps(v2, v3);
+
+        _mm256_storeu_ps(out[0] + x, _mm256_permutevar8x32_ps(_mm256_shuffle_ps(rg01, rg23, _MM_SHUFFLE(1, 0, 1, 0)), order));
+        _mm256_storeu_ps(out[1] + x, _mm256_permutevar8x32_ps(_mm256_shuffle_ps(rg01, rg23, _MM_SHUFFLE(3, 2, 3, 2)), order));
+        _mm256_storeu_ps(out[2] + x, _mm256_permutevar8x32_ps(_mm256_shuffle_ps(ba01, ba23, _MM_SHUFFLE(1, 0, 1, 0)), order));
+    }
+
+    float *const rest[3] = OFFSET_PLANES(out, x);
+    scope_decode_rgba16f_row_scalar(row + (size_t)x * 8, width - x, rest);
+}
+
+TARGET_AVX2 void scope_decode_ycbcr_row_avx2(const uint8_t *luma, const uint8_t *cb, const uint8_t *cr, uint32_t width, const scope_ycbcr_decode_t *decode, float *const out[3]) {
+    const scope_ycbcr_layout_t *layout = &decode->layout;
+    if (!layout->interleaved || layout->x_shift != 1) {
+        // Planar formats stay scalar
+        scope_decode_ycbcr_row_scalar(luma, cb, cr, width, decode, out);
+        return;
+    }
+
+    // Each Cb, Cr pair is one 32-bit lane once widened, and covers two pixels
+    const __m256i duplicate = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m128i shift = _mm_cvtsi32_si128((int)layout->sample_shift);
+    const __m256i mask = _mm256_set1_epi32((int)((1u << layout->bits) - 1));
+    const __m256 y_zero = _mm256_set1_ps(decode->y_zero);
+    const __m256 y_span = _mm256_set1_ps(decode->y_span);
+    const __m256 c_zero = _mm256_set1_ps(decode->c_zero);
+    const __m256 c_span = _mm256_set1_ps(decode->c_span);
+    const __m256 r_cr = _mm256_set1_ps(decode->inverse.r_cr);
+    const __m256 g_cb = _mm256_set1_ps(decode->inverse.g_cb);
+    const __m256 g_cr = _mm256_set1_ps(decode->inverse.g_cr);
+    const __m256 b_cb = _mm256_set1_ps(decode->inverse.b_cb);
+    const bool wide = layout->sample_bytes == 2;
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i y_codes, pairs;
+        if (wide) {
+            y_codes = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(luma + (size_t)x * 2)));
+            pairs = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(cb + (size_t)x * 2)));
+        } else {
+            y_codes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(luma + x)));
+            pairs = _mm256_castsi128_si256(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(cb + x))));
+        }
+        pairs = _mm256_permutevar8x32_epi32(pairs, duplicate);
+
+        y_codes = _mm256_and_si256(_mm256_srl_epi32(y_codes, shift), mask);
+        const __m256i cb_codes = _mm256_and_si256(_mm256_srl_epi32(_mm256_and_si256(pairs, _mm256_set1_epi32(0xffff)), shift), mask);
+        const __m256i cr_codes = _mm256_and_si256(_mm256_srl_epi32(_mm256_srli_epi32(pairs, 16), shift), mask);
+
+        const __m256 y = _mm256_div_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(y_codes), y_zero), y_span);
+        const __m256 u = _mm256_div_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(cb_codes), c_zero), c_span);
+        const __m256 v = _mm256_div_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(cr_codes), c_zero), c_span);
+
+        const __m256 g = _mm256_sub_ps(_mm256_sub_ps(y, _mm256_mul_ps(g_cb, u)), _mm256_mul_ps(g_cr, v));
+        _mm256_storeu_ps(out[0] + x, _mm256_add_ps(y, _mm256_mul_ps(r_cr, v)));
+        _mm256_storeu_ps(out[1] + x, g);
+        _mm256_storeu_ps(out[2] + x, _mm256_add_ps(y, _mm256_mul_ps(b_cb, u)));
+    }
+
+    const size_t chroma = (size_t)x * layout->sample_bytes; // x / 2 pairs of two samples
+    float *const rest[3] = OFFSET_PLANES(out, x);
+    scope_decode_ycbcr_row_scalar(luma + (size_t)x * layout->sample_bytes, cb + chroma, cr + chroma, width - x, decode, rest);
+}
+
+TARGET_AVX2 void scope_encode_rgb8_row_avx2(const float *const in[3], uint32_t width, scope_rgb8_layout_t layout, uint8_t *row) {
+    const __m128i shift_r = _mm_cvtsi32_si128((int)layout.r * 8);
+    const __m128i shift_g = _mm_cvtsi32_si128((int)layout.g * 8);
+    const __m128i shift_b = _mm_cvtsi32_si128((int)layout.b * 8);
+    const __m256i alpha = _mm256_set1_epi32((int)0xff000000u);
+    const __m256 max = _mm256_set1_ps(255.0f);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i words = _mm256_or_si256(alpha, _mm256_sll_epi32(unorm_code(_mm256_loadu_ps(in[0] + x), max), shift_r));
+        words = _mm256_or_si256(words, _mm256_sll_epi32(unorm_code(_mm256_loadu_ps(in[1] + x), max), shift_g));
+        words = _mm256_or_si256(words, _mm256_sll_epi32(unorm_code(_mm256_loadu_ps(in[2] + x), max), shift_b));
+        _mm256_storeu_si256((__m256i *)(row + (size_t)x * 4), words);
+    }
+
+    const float *const rest[3] = OFFSET_PLANES(in, x);
+    scope_encode_rgb8_row_scalar(rest, width - x, layout, row + (size_t)x * 4);
+}
+
+TARGET_AVX2 void scope_encode_rgb10a2_row_avx2(const float *const in[3], uint32_t width, uint8_t *row) {
+    const __m256i alpha = _mm256_set1_epi32((int)0xc0000000u);
+    const __m256 max = _mm256_set1_ps(1023.0f);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i words = _mm256_or_si256(alpha, unorm_code(_mm256_loadu_ps(in[0] + x), max));
+        words = _mm256_or_si256(words, _mm256_slli_epi32(unorm_code(_mm256_loadu_ps(in[1] + x), max), 10));
+        words = _mm256_or_si256(words, _mm256_slli_epi32(unorm_code(_mm256_loadu_ps(in[2] + x), max), 20));
+        _mm256_storeu_si256((__m256i *)(row + (size_t)x * 4), words);
+    }
+
+    const float *const rest[3] = OFFSET_PLANES(in, x);
+    scope_encode_rgb10a2_row_scalar(rest, width - x, row + (size_t)x * 4);
+}
+
+TARGET_AVX2 void scope_encode_rgba16f_row_avx2(const float *const in[3], uint32_t width, uint8_t *row) {
+    const __m256 alpha = _mm256_set1_ps(1.0f);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256 r = _mm256_loadu_ps(in[0] + x);
+        const __m256 g = _mm256_loadu_ps(in[1] + x);
+        const __m256 b = _mm256_loadu_ps(in[2] + x);
+
+        // Pixels n and n + 4 share a register after the transposes
+        const __m256 rg_lo = _mm256_unpacklo_ps(r, g);
+        const __m256 rg_hi = _mm256_unpackhi_ps(r, g);
+        const __m256 ba_lo = _mm256_unpacklo_ps(b, alpha);
+        const __m256 ba_hi = _mm256_unpackhi_ps(b, alpha);
+        const __m256 p04 = _mm256_shuffle_ps(rg_lo, ba_lo, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 p15 = _mm256_shuffle_ps(rg_lo, ba_lo, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 p26 = _mm256_shuffle_ps(rg_hi, ba_hi, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 p37 = _mm256_shuffle_ps(rg_hi, ba_hi, _MM_SHUFFLE(3, 2, 3, 2));
+
+        uint8_t *p = row + (size_t)x * 8;
+        _mm_storeu_si128((__m128i *)p, _mm256_cvtps_ph(_mm256_permute2f128_ps(p04, p15, 0x20), _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128((__m128i *)(p + 16), _mm256_cvtps_ph(_mm256_permute2f128_ps(p26, p37, 0x20), _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128((__m128i *)(p + 32), _mm256_cvtps_ph(_mm256_permute2f128_ps(p04, p15, 0x31), _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128((__m128i *)(p + 48), _mm256_cvtps_ph(_mm256_permute2f128_ps(p26, p37, 0x31), _MM_FROUND_TO_NEAREST_INT));
+    }
+
+    const float *const rest[3] = OFFSET_PLANES(in, x);
+    scope_encode_rgba16f_row_scalar(rest, width - x, row + (size_t)x * 8);
+}
+
+TARGET_AVX2 void scope_swap_rgb8_row_avx2(const uint8_t *in, uint32_t width, uint8_t *out) {
+    const __m256i swap = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                          2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i px = _mm256_loadu_si256((const __m256i *)(in + (size_t)x * 4));
+        _mm256_storeu_si256((__m256i *)(out + (size_t)x * 4), _mm256_shuffle_epi8(px, swap));
+    }
+
+    scope_swap_rgb8_row_scalar(in + (size_t)x * 4, width - x, out + (size_t)x * 4);
+}
+
+#endif
@@ -0,0 +1,140 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "scope_cpu.h"
+
+#if SCOPE_X86_SIMD
+#include <cpuid.h>
+#endif
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Bit positions from the Intel SDM
+#define CPUID_1_ECX_SSE41 (1u << 19)
+#define CPUID_1_ECX_OSXSAVE (1u << 27)
+#define CPUID_1_ECX_AVX (1u << 28)
+#define CPUID_1_ECX_F16C (1u << 29)
+#define CPUID_7_EBX_AVX2 (1u << 5)
+#define CPUID_7_EBX_AVX512F (1u << 16)
+
+// XCR0 state components that the OS has to save for the wider registers
+#define XCR0_AVX_STATE 0x06u
+#define XCR0_AVX512_STATE 0xE0u
+
+static bool features_detected = false;
+static bool features[SCOPE_ISA_COUNT];
+
+#if SCOPE_X86_SIMD
+static uint32_t read_xcr0(void) {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+}
+
+static void detect_features(void) {
+    uint32_t eax, ebx, ecx, edx;
+
+    features[SCOPE_ISA_SCALAR] = true;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return;
+    }
+
+    features[SCOPE_ISA_SSE41] = (ecx & CPUID_1_ECX_SSE41) != 0;
+
+    // AVX needs both CPU support and the OS to preserve the YMM registers
+    if (!(ecx & CPUID_1_ECX_AVX) || !(ecx & CPUID_1_ECX_OSXSAVE)) {
+        return;
+    }
+
+    uint32_t xcr0 = read_xcr0();
+    if ((xcr0 & XCR0_AVX_STATE) != XCR0_AVX_STATE) {
+        return;
+    }
+
+    const uint32_t ecx_1 = ecx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return;
+    }
+
+    // Every AVX2 CPU also converts half floats, the HDR kernels count on it
+    features[SCOPE_ISA_AVX2] = (ebx & CPUID_7_EBX_AVX2) != 0 && (ecx_1 & CPUID_1_ECX_F16C) != 0;
+    features[SCOPE_ISA_AVX512] = features[SCOPE_ISA_AVX2] &&
+                                 (ebx & CPUID_7_EBX_AVX512F) != 0 &&
+                                 (xcr0 & XCR0_AVX512_STATE) == XCR0_AVX512_STATE;
+}
+#else
+static void detect_features(void) {
+    features[SCOPE_ISA_SCALAR] = true;
+}
+#endif
+
+bool scope_cpu_supports(scope_isa_t isa) {
+    if (isa >= SCOPE_ISA_COUNT) {
+        return false;
+    }
+
+    // Detection is idempotent, so a race on first use only repeats the same work
+    if (!features_detected) {
+        detect_features();
+        features_detected = true;
+    }
+
+    return features[isa];
+}
+
+scope_isa_t scope_cpu_best_isa(void) {
+    for (int isa = SCOPE_ISA_COUNT - 1; isa > SCOPE_ISA_SCALAR; --isa) {
+        if (scope_cpu_supports((scope_isa_t)isa)) {
+            return (scope_isa_t)isa;
+        }
+    }
+    return SCOPE_ISA_SCALAR;
+}
+
+const char *scope_isa_name(scope_isa_t isa) {
+    static const char *names[SCOPE_ISA_COUNT] = {
+        [SCOPE_ISA_SCALAR] = "scalar",
+        [SCOPE_ISA_SSE41] = "sse4.1",
+        [SCOPE_ISA_AVX2] = "avx2",
+        [SCOPE_ISA_AVX512] = "avx512",
+    };
+    return isa < SCOPE_ISA_COUNT ? names[isa] : "unknown";
+}
+
+uint32_t scope_cpu_core_count(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (uint32_t)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1;
+#endif
+}
+
+double scope_cpu_time_seconds(void) {
+#if defined(_WIN32)
+    static double tick = 0.0;
+    if (tick == 0.0) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        tick = 1.0 / (double)frequency.QuadPart;
+    }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * tick;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && (defined(__GNUC__) || defined(__clang__))
+#define SCOPE_X86_SIMD 1
+#else
+#define SCOPE_X86_SIMD 0
+#endif
+
+// Instruction sets the CPU kernels are specialized for, ordered from least to most capable
+typedef enum scope_isa {
+    SCOPE_ISA_SCALAR,
+    SCOPE_ISA_SSE41,
+    SCOPE_ISA_AVX2, // with F16C
+    SCOPE_ISA_AVX512,
+    SCOPE_ISA_COUNT
+} scope_isa_t;
+
+/* @brief Checks (once, through CPUID/XGETBV) whether the CPU and OS can run kernels for the given ISA */
+bool scope_cpu_supports(scope_isa_t isa);
+/* @brief The most capable ISA supported on this machine */
+scope_isa_t scope_cpu_best_isa(void);
+const char *scope_isa_name(scope_isa_t isa);
+
+/* @brief Number of logical processors available to the process */
+uint32_t scope_cpu_core_count(void);
+/* @brief Monotonic wall clock in seconds, for timing the CPU passes */
+double scope_cpu_time_seconds(void);
@@ -0,0 +1,207 @@
+#include "scope_hdr.h"
+
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+// SMPTE ST 2084
+#define PQ_M1 (2610.0 / 16384.0)
+#define PQ_M2 (2523.0 / 4096.0 * 128.0)
+#define PQ_C1 (3424.0 / 4096.0)
+#define PQ_C2 (2413.0 / 4096.0 * 32.0)
+#define PQ_C3 (2392.0 / 4096.0 * 32.0)
+
+// BT.2100 HLG, with the system gamma of a 1000 nit display
+#define HLG_A 0.17883277
+#define HLG_B 0.28466892
+#define HLG_C 0.55991073
+#define HLG_GAMMA 1.2
+
+#define SDR_GAMMA 2.4
+
+static scope_half_level_row_fn get_level_kernel(scope_isa_t isa);
+
+float scope_transfer_signal(scope_transfer_t axis, float nits) {
+    double v;
+    switch (axis) {
+    case SCOPE_TRANSFER_PQ:
+    case SCOPE_TRANSFER_LINEAR: {
+        double y = pow(CLAMP(nits / SCOPE_PQ_PEAK_NITS, 0.0, 1.0), PQ_M1);
+        v = pow((PQ_C1 + PQ_C2 * y) / (1.0 + PQ_C3 * y), PQ_M2);
+        break;
+    }
+    case SCOPE_TRANSFER_HLG: {
+        // Grey on the reference display, so the OOTF reduces to a power of the scene light
+        double e = pow(CLAMP(nits / SCOPE_HLG_PEAK_NITS, 0.0, 1.0), 1.0 / HLG_GAMMA);
+        v = e <= 1.0 / 12.0 ? sqrt(3.0 * e) : HLG_A * log(12.0 * e - HLG_B) + HLG_C;
+        break;
+    }
+    default:
+        v = pow(CLAMP(nits / SCOPE_SDR_WHITE_NITS, 0.0, 1.0), 1.0 / SDR_GAMMA);
+        break;
+    }
+    return (float)CLAMP(v, 0.0, 1.0);
+}
+
+float scope_transfer_nits(scope_transfer_t axis, float signal) {
+    const double v = CLAMP(signal, 0.0f, 1.0f);
+    switch (axis) {
+    case SCOPE_TRANSFER_PQ:
+    case SCOPE_TRANSFER_LINEAR: {
+        double p = pow(v, 1.0 / PQ_M2);
+        return (float)(pow(MAX(p - PQ_C1, 0.0) / (PQ_C2 - PQ_C3 * p), 1.0 / PQ_M1) * SCOPE_PQ_PEAK_NITS);
+    }
+    case SCOPE_TRANSFER_HLG: {
+        double e = v <= 0.5 ? v * v / 3.0 : (exp((v - HLG_C) / HLG_A) + HLG_B) / 12.0;
+        return (float)(pow(e, HLG_GAMMA) * SCOPE_HLG_PEAK_NITS);
+    }
+    default:
+        return (float)(pow(v, SDR_GAMMA) * SCOPE_SDR_WHITE_NITS);
+    }
+}
+
+float scope_half_to_float(uint16_t half) {
+    const uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1fu;
+    uint32_t mantissa = half & 0x3ffu;
+
+    uint32_t bits;
+    if (exponent == 0x1f) {
+        // NaN comes out quiet, as from F16C
+        bits = sign | 0x7f800000u | (mantissa << 13) | (mantissa ? 0x400000u : 0);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // Subnormal, normalized for the wider exponent
+        uint32_t e = 113;
+        while (!(mantissa & 0x400u)) {
+            mantissa <<= 1;
+            e--;
+        }
+        bits = sign | (e << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+uint16_t scope_float_to_half(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t abs = bits & 0x7fffffffu;
+
+    if (abs >= 0x7f800000u) {
+        return (uint16_t)(sign | 0x7c00u | (abs > 0x7f800000u ? 0x200u | ((abs >> 13) & 0x3ffu) : 0));
+    }
+    if (abs >= 0x477ff000u) {
+        // Halfway past SCOPE_HALF_MAX and up
+        return (uint16_t)(sign | 0x7c00u);
+    }
+    if (abs >= 0x38800000u) {
+        // Normal, rounding may carry into the exponent
+        return (uint16_t)(sign | ((abs + 0xfffu + ((abs >> 13) & 1u) - 0x38000000u) >> 13));
+    }
+    if (abs <= 0x33000000u) {
+        // Half the smallest subnormal or less
+        return (uint16_t)sign;
+    }
+
+    // Subnormal, in units of 2^-24
+    const uint32_t shift = 126 - (abs >> 23);
+    const uint32_t mantissa = (abs & 0x7fffffu) | 0x800000u;
+    const uint32_t rest = mantissa & ((1u << shift) - 1);
+    const uint32_t half = 1u << (shift - 1);
+    uint32_t out = mantissa >> shift;
+    if (rest > half || (rest == half && (out & 1u))) {
+        out++;
+    }
+    return (uint16_t)(sign | out);
+}
+
+void scope_light_level_measure(const scope_image_t *image, scope_isa_t isa, scope_light_level_t *level) {
+    assert(image && image->data);
+    assert(scope_pixel_format_is_hdr(image->format));
+    assert(level);
+
+    const scope_transfer_t axis = scope_transfer_axis(image->transfer);
+    float max = 0.0f;
+    double sum = 0.0;
+
+    if (image->format == SCOPE_PIXEL_FORMAT_RGBA16F && image->transfer == SCOPE_TRANSFER_LINEAR) {
+        // Light is linear, so the brightest component of every pixel only needs scaling at the end
+        const scope_half_level_row_fn row_fn = get_level_kernel(isa);
+        for (uint32_t y = 0; y < image->height; ++y) {
+            float sums[4];
+            max = MAX(max, row_fn(scope_image_row(image, y), image->width, sums));
+            sum += (double)((sums[0] + sums[1]) + (sums[2] + sums[3]));
+        }
+        max *= SCOPE_SCRGB_WHITE_NITS;
+        sum *= SCOPE_SCRGB_WHITE_NITS;
+    } else if (image->format == SCOPE_PIXEL_FORMAT_RGBA16F) {
+        // Signals, the transfer is monotonic so the brightest component has the largest signal
+        for (uint32_t y = 0; y < image->height; ++y) {
+            const uint8_t *px = scope_image_row(image, y);
+            for (uint32_t x = 0; x < image->width; ++x, px += 8) {
+                float nits = scope_transfer_nits(axis, scope_half_level_pixel(px));
+                max = MAX(max, nits);
+                sum += nits;
+            }
+        }
+    } else {
+        float nits[1024];
+        for (uint32_t v = 0; v < 1024; ++v) {
+            nits[v] = image->transfer == SCOPE_TRANSFER_LINEAR ? (float)v / 1023.0f * SCOPE_SCRGB_WHITE_NITS
+                                                               : scope_transfer_nits(axis, (float)v / 1023.0f);
+        }
+
+        for (uint32_t y = 0; y < image->height; ++y) {
+            const uint8_t *px = scope_image_row(image, y);
+            for (uint32_t x = 0; x < image->width; ++x, px += 4) {
+                const uint32_t word = (uint32_t)px[0] | ((uint32_t)px[1] << 8) | ((uint32_t)px[2] << 16) | ((uint32_t)px[3] << 24);
+                const uint32_t code = MAX(MAX(word & 0x3ffu, (word >> 10) & 0x3ffu), (word >> 20) & 0x3ffu);
+                max = MAX(max, nits[code]);
+                sum += nits[code];
+            }
+        }
+    }
+
+    const uint64_t pixels = (uint64_t)image->width * image->height;
+    *level = (scope_light_level_t){
+        .max_nits = max,
+        .average_nits = pixels ? (float)(sum / (double)pixels) : 0.0f,
+    };
+}
+
+float scope_half_level_row_scalar(const uint8_t *row, uint32_t width, float sums[4]) {
+    float max = 0.0f;
+    sums[0] = sums[1] = sums[2] = sums[3] = 0.0f;
+
+    for (uint32_t x = 0; x < width; ++x, row += 8) {
+        const float v = scope_half_level_pixel(row);
+        sums[x & 3] += v;
+        max = MAX(max, v);
+    }
+    return max;
+}
+
+static scope_half_level_row_fn get_level_kernel(scope_isa_t isa) {
+    if (!scope_cpu_supports(isa)) {
+        isa = scope_cpu_best_isa();
+    }
+
+    switch (isa) {
+#if SCOPE_X86_SIMD
+        case SCOPE_ISA_AVX512:
+        case SCOPE_ISA_AVX2: return scope_half_level_row_avx2;
+#endif
+        default: return scope_half_level_row_scalar;
+    }
+}
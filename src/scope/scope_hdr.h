@@ -0,0 +1,45 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_cpu.h"
+
+// Transfer functions of the HDR formats. The scopes bin HDR frames by signal, so a waveform of PQ
+// or scRGB input has PQ on its vertical axis and one of HLG input has HLG. Nothing is clipped to
+// SDR white: 0-1 of the axis covers the full range of the transfer.
+
+#define SCOPE_PQ_PEAK_NITS 10000.0f
+#define SCOPE_HLG_PEAK_NITS 1000.0f    // nominal display peak of BT.2100 HLG
+#define SCOPE_SDR_WHITE_NITS 100.0f
+#define SCOPE_SCRGB_WHITE_NITS 80.0f  // linear 1.0 of scRGB
+#define SCOPE_HALF_MAX 65504.0f
+
+/* @brief Transfer of the vertical axis frames with `transfer` are shown on. Linear light has no
+ * signal of its own and goes on the PQ axis. */
+static inline scope_transfer_t scope_transfer_axis(scope_transfer_t transfer) {
+    return transfer == SCOPE_TRANSFER_LINEAR ? SCOPE_TRANSFER_PQ : transfer;
+}
+
+/* @brief Signal in [0, 1] that shows `nits` on the given axis, clamped at the axis' peak.
+ * SDR is a 2.4 gamma display with white at SCOPE_SDR_WHITE_NITS. */
+float scope_transfer_signal(scope_transfer_t axis, float nits);
+/* @brief Inverse of scope_transfer_signal(). */
+float scope_transfer_nits(scope_transfer_t axis, float signal);
+
+/* @brief IEEE 754 half to float, exact for every input including subnormals and infinities. NaN
+ * comes out quiet, like from F16C. */
+float scope_half_to_float(uint16_t half);
+/* @brief Float to IEEE 754 half, rounded to nearest even like F16C. Overflow gives infinity and NaN
+ * stays a quiet NaN with the top bits of its payload. */
+uint16_t scope_float_to_half(float v);
+
+/* @brief Content light levels of a frame, as in CTA-861.3: the brightest R, G or B of any pixel
+ * (MaxCLL) and the average over all pixels of their brightest component (MaxFALL). */
+typedef struct scope_light_level {
+    float max_nits;
+    float average_nits;
+} scope_light_level_t;
+
+/* @brief Measures the light levels of an HDR frame. Half float frames are converted with F16C
+ * when `isa` allows AVX2, with identical results to the scalar conversion. Negative values and
+ * NaN count as 0, infinities as SCOPE_HALF_MAX. */
+void scope_light_level_measure(const scope_image_t *image, scope_isa_t isa, scope_light_level_t *level);
@@ -0,0 +1,56 @@
+#include "scope_internal.h"
+
+// F16C version of scope_half_level_row_scalar. Every conversion is exact, the clamps and maxima
+// resolve NaN and signed zeros like the scalar compares, and each lane adds the same pixels in
+// the same order, so the results are bit-identical.
+
+#if SCOPE_X86_SIMD
+
+#include <immintrin.h>
+
+#define TARGET_AVX2 __attribute__((target("avx2,f16c")))
+
+// Two pixels per register, lanes 0 and 4 end up with the brightest component of each
+TARGET_AVX2 static inline __m256 pixel_levels(__m128i halves) {
+    __m256 v = _mm256_cvtph_ps(halves);
+    v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(SCOPE_HALF_MAX));
+
+    __m256 level = _mm256_max_ps(v, _mm256_permute_ps(v, _MM_SHUFFLE(3, 0, 2, 1)));
+    return _mm256_max_ps(level, _mm256_permute_ps(v, _MM_SHUFFLE(3, 1, 0, 2)));
+}
+
+TARGET_AVX2 float scope_half_level_row_avx2(const uint8_t *row, uint32_t width, float sums[4]) {
+    // acc0 holds pixels 4i and 4i + 1, acc1 pixels 4i + 2 and 4i + 3
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 max = _mm256_setzero_ps();
+
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m256 level0 = pixel_levels(_mm_loadu_si128((const __m128i *)(row + (size_t)x * 8)));
+        __m256 level1 = pixel_levels(_mm_loadu_si128((const __m128i *)(row + (size_t)x * 8 + 16)));
+        acc0 = _mm256_add_ps(acc0, level0);
+        acc1 = _mm256_add_ps(acc1, level1);
+        max = _mm256_max_ps(max, _mm256_max_ps(level0, level1));
+    }
+
+    float lanes0[8], lanes1[8], maxima[8];
+    _mm256_storeu_ps(lanes0, acc0);
+    _mm256_storeu_ps(lanes1, acc1);
+    _mm256_storeu_ps(maxima, max);
+
+    sums[0] = lanes0[0];
+    sums[1] = lanes0[4];
+    sums[2] = lanes1[0];
+    sums[3] = lanes1[4];
+    float level = maxima[0] > maxima[4] ? maxima[0] : maxima[4];
+
+    for (; x < width; ++x) {
+        const float v = scope_half_level_pixel(row + (size_t)x * 8);
+        sums[x & 3] += v;
+        level = level > v ? level : v;
+    }
+    return level;
+}
+
+#endif
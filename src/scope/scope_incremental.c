@@ -0,0 +1,242 @@
+#include "scope_incremental.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool rebuild(scope_incremental_t *inc, const scope_image_t *image);
+static bool same_settings(const scope_incremental_t *inc);
+static bool copy_frame(scope_incremental_t *inc, const scope_image_t *image);
+static uint32_t clip_rects(scope_incremental_t *inc, const scope_image_t *image, const scope_rect_t *dirty, uint32_t dirty_count);
+static void replace_span(scope_incremental_t *inc, const scope_image_t *image, uint32_t y, uint32_t x_begin, uint32_t x_end);
+
+void scope_incremental_create(scope_incremental_t *inc, scope_vectorscope_t *vs, scope_waveform_t *wf) {
+    assert(inc);
+
+    *inc = (scope_incremental_t){
+        .vs = vs,
+        .wf = wf,
+        .rebuild_threshold = SCOPE_INCREMENTAL_REBUILD_THRESHOLD,
+    };
+}
+
+void scope_incremental_destroy(scope_incremental_t *inc) {
+    if (inc) {
+        free(inc->previous);
+        free(inc->rects);
+        *inc = (scope_incremental_t){0};
+    }
+}
+
+void scope_incremental_invalidate(scope_incremental_t *inc) {
+    assert(inc);
+    inc->valid = false;
+}
+
+bool scope_incremental_update(scope_incremental_t *inc, const scope_image_t *image, const scope_rect_t *dirty, uint32_t dirty_count) {
+    assert(inc);
+    assert(image && image->data);
+    assert(dirty || dirty_count == 0);
+
+    const scope_image_t *previous = &inc->previous_image;
+    if (inc->valid && image->generation != 0 && image->generation == previous->generation) {
+        inc->rebuilt = false;
+        inc->dirty_pixels = 0;
+        return true;
+    }
+
+    bool compatible = inc->valid &&
+                      previous->width == image->width &&
+                      previous->height == image->height &&
+                      previous->format == image->format &&
+                      scope_pixel_format_is_rgb8(image->format) &&
+                      same_settings(inc);
+    if (!compatible) {
+        return rebuild(inc, image);
+    }
+
+    uint32_t rect_count = clip_rects(inc, image, dirty, dirty_count);
+    if (rect_count == UINT32_MAX) {
+        inc->valid = false;
+        return false;
+    }
+
+    // Overlaps are counted twice, which only makes the estimate err towards rebuilding
+    uint64_t area = 0;
+    uint32_t y_min = image->height;
+    uint32_t y_max = 0;
+    for (uint32_t i = 0; i < rect_count; ++i) {
+        area += (uint64_t)inc->rects[i].width * inc->rects[i].height;
+        y_min = MIN(y_min, inc->rects[i].y);
+        y_max = MAX(y_max, inc->rects[i].y + inc->rects[i].height);
+    }
+
+    if ((double)area > (double)inc->rebuild_threshold * image->width * image->height) {
+        return rebuild(inc, image);
+    }
+
+    inc->rebuilt = false;
+    inc->dirty_pixels = 0;
+    inc->previous_image.generation = image->generation;
+
+    // Rects are sorted by x, so walking them in order and merging overlaps yields every row's
+    // dirty pixels as disjoint spans, each visited once
+    for (uint32_t y = y_min; y < y_max; ++y) {
+        uint32_t span_begin = 0;
+        uint32_t span_end = 0;
+
+        for (uint32_t i = 0; i < rect_count; ++i) {
+            const scope_rect_t *rect = &inc->rects[i];
+            if (y < rect->y || y >= rect->y + rect->height) continue;
+
+            if (rect->x > span_end) {
+                replace_span(inc, image, y, span_begin, span_end);
+                span_begin = rect->x;
+            }
+            span_end = MAX(span_end, rect->x + rect->width);
+        }
+
+        replace_span(inc, image, y, span_begin, span_end);
+    }
+
+    if (inc->vs) inc->vs->generation = image->generation;
+    if (inc->wf) inc->wf->generation = image->generation;
+
+    return true;
+}
+
+static bool rebuild(scope_incremental_t *inc, const scope_image_t *image) {
+    inc->rebuilt = true;
+    inc->dirty_pixels = (uint64_t)image->width * image->height;
+
+    if (inc->vs) {
+        inc->vs->generation = 0;
+        scope_vectorscope_update(inc->vs, image, inc->pool);
+        inc->vs_kernel = inc->vs->kernel;
+        inc->vs_resolution = inc->vs->resolution;
+        inc->vs_zoom = inc->vs->zoom;
+        inc->vs_encoding = inc->vs->encoding;
+    }
+
+    if (inc->wf) {
+        inc->wf->generation = 0;
+        scope_waveform_update(inc->wf, image, inc->pool);
+        inc->wf_kernel = inc->wf->kernel;
+        inc->wf_width = inc->wf->width;
+        inc->wf_buckets = inc->wf->buckets;
+        inc->wf_encoding = inc->wf->encoding;
+    }
+
+    // Y'CbCr and HDR frames have no per pixel replacement and are always rebuilt, only the
+    // generation is kept to skip repeated frames
+    if (!scope_pixel_format_is_rgb8(image->format)) {
+        inc->previous_image = (scope_image_t){
+            .width = image->width,
+            .height = image->height,
+            .format = image->format,
+            .generation = image->generation,
+        };
+        inc->valid = true;
+        return true;
+    }
+
+    inc->valid = copy_frame(inc, image);
+    return inc->valid;
+}
+
+// Whether the histograms are still configured as they were at the last rebuild. A reconfigure
+// reallocates or clears them, and replacing pixels in bins that no longer hold the previous
+// frame would take hits out of empty bins.
+static bool same_settings(const scope_incremental_t *inc) {
+    const scope_vectorscope_t *vs = inc->vs;
+    const scope_waveform_t *wf = inc->wf;
+
+    bool same = !vs || (vs->kernel == inc->vs_kernel &&
+                        vs->resolution == inc->vs_resolution &&
+                        vs->zoom == inc->vs_zoom &&
+                        scope_encoding_index(vs->encoding) == scope_encoding_index(inc->vs_encoding));
+    return same && (!wf || (wf->kernel == inc->wf_kernel &&
+                             wf->width == inc->wf_width &&
+                             wf->buckets == inc->wf_buckets &&
+                             scope_encoding_index(wf->encoding) == scope_encoding_index(inc->wf_encoding)));
+}
+
+static bool copy_frame(scope_incremental_t *inc, const scope_image_t *image) {
+    size_t row_size = (size_t)image->width * 4;
+    size_t size = row_size * image->height;
+
+    if (size > inc->previous_capacity) {
+        uint8_t *previous = realloc(inc->previous, size);
+        if (!previous) {
+            return false;
+        }
+        inc->previous = previous;
+        inc->previous_capacity = size;
+    }
+
+    for (uint32_t y = 0; y < image->height; ++y) {
+        memcpy(inc->previous + row_size * y, scope_image_row(image, y), row_size);
+    }
+
+    inc->previous_image = (scope_image_t){
+        .data = inc->previous,
+        .width = image->width,
+        .height = image->height,
+        .stride = (uint32_t)row_size,
+        .format = image->format,
+        .generation = image->generation,
+    };
+    return true;
+}
+
+static int compare_rect_x(const void *a, const void *b) {
+    const scope_rect_t *ra = a;
+    const scope_rect_t *rb = b;
+    return (ra->x > rb->x) - (ra->x < rb->x);
+}
+
+// Clips the dirty rects to the frame, drops empty ones and sorts the rest by x. Returns the
+// number of rects kept, or UINT32_MAX on allocation failure.
+static uint32_t clip_rects(scope_incremental_t *inc, const scope_image_t *image, const scope_rect_t *dirty, uint32_t dirty_count) {
+    if (dirty_count > inc->rect_capacity) {
+        scope_rect_t *rects = realloc(inc->rects, dirty_count * sizeof(scope_rect_t));
+        if (!rects) {
+            return UINT32_MAX;
+        }
+        inc->rects = rects;
+        inc->rect_capacity = dirty_count;
+    }
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < dirty_count; ++i) {
+        if (dirty[i].x >= image->width || dirty[i].y >= image->height) continue;
+
+        scope_rect_t rect = dirty[i];
+        rect.width = MIN(rect.width, image->width - rect.x);
+        rect.height = MIN(rect.height, image->height - rect.y);
+        if (rect.width > 0 && rect.height > 0) {
+            inc->rects[count++] = rect;
+        }
+    }
+
+    qsort(inc->rects, count, sizeof(scope_rect_t), compare_rect_x);
+    return count;
+}
+
+// Moves one span of the previous frame to the new frame in every histogram and in the copy
+static void replace_span(scope_incremental_t *inc, const scope_image_t *image, uint32_t y, uint32_t x_begin, uint32_t x_end) {
+    if (x_begin >= x_end) return;
+
+    if (inc->vs) {
+        scope_vectorscope_replace_span(inc->vs, &inc->previous_image, image, y, x_begin, x_end);
+    }
+    if (inc->wf) {
+        scope_waveform_replace_span(inc->wf, &inc->previous_image, image, y, x_begin, x_end);
+    }
+
+    uint8_t *row = inc->previous + (size_t)inc->previous_image.stride * y;
+    memcpy(row + (size_t)x_begin * 4, scope_image_row(image, y) + (size_t)x_begin * 4, (size_t)(x_end - x_begin) * 4);
+    inc->dirty_pixels += x_end - x_begin;
+}
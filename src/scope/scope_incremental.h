@@ -0,0 +1,58 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_thread.h"
+#include "scope_vectorscope.h"
+#include "scope_waveform.h"
+
+// Fraction of the frame above which rebuilding from scratch is cheaper than replacing dirty pixels.
+// Replacing costs two binnings per changed pixel, plus the comparison for unchanged ones.
+#define SCOPE_INCREMENTAL_REBUILD_THRESHOLD 0.35f
+
+// Keeps a vectorscope and/or waveform in sync with a stream of frames that come with dirty rects
+// (e.g. DXGI desktop duplication). Only pixels inside the rects are moved from their old bins to
+// their new ones, everything else is taken from the previous frame, which is kept as a copy.
+
+typedef struct scope_incremental {
+    scope_vectorscope_t *vs; // either may be NULL
+    scope_waveform_t *wf;
+    scope_thread_pool_t *pool; // used for full rebuilds, NULL runs them on the caller thread
+    float rebuild_threshold;
+
+    // Copy of the last frame, tightly packed
+    uint8_t *previous;
+    size_t previous_capacity;
+    scope_image_t previous_image;
+    bool valid;
+
+    // Settings the histograms were built with, changing any of them forces a rebuild
+    scope_kernel_t vs_kernel;
+    uint32_t vs_resolution;
+    uint32_t vs_zoom;
+    scope_encoding_t vs_encoding;
+    scope_kernel_t wf_kernel;
+    uint32_t wf_width;
+    uint32_t wf_buckets;
+    scope_encoding_t wf_encoding;
+
+    // Dirty rects clipped to the frame and sorted by x
+    scope_rect_t *rects;
+    uint32_t rect_capacity;
+
+    // Last update
+    uint64_t dirty_pixels;
+    bool rebuilt;
+} scope_incremental_t;
+
+void scope_incremental_create(scope_incremental_t *inc, scope_vectorscope_t *vs, scope_waveform_t *wf);
+void scope_incremental_destroy(scope_incremental_t *inc);
+/* @brief Forces the next update to rebuild everything, e.g. after the histograms were cleared elsewhere. */
+void scope_incremental_invalidate(scope_incremental_t *inc);
+
+/* @brief Brings the histograms from the previous frame to `image`. Only pixels inside `dirty` may
+ * differ from the previous frame; rects may overlap and extend past the frame. A size or format
+ * change, a missing previous frame, a kernel, resolution, zoom or encoding other than the
+ * histograms were built with, or too much dirty area rebuilds the histograms instead, and so
+ * does every Y'CbCr or HDR frame.
+ * Returns false on allocation failure, in which case the next update rebuilds. */
+bool scope_incremental_update(scope_incremental_t *inc, const scope_image_t *image, const scope_rect_t *dirty, uint32_t dirty_count);
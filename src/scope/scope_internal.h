@@ -0,0 +1,297 @@
+#pragma once
+
+// Helpers shared between the scope core translation units. Not part of the public API.
+
+#include "scope.h"
+#include "scope_cpu.h"
+#include "scope_hdr.h"
+#include "scope_lut.h"
+
+typedef struct scope_rgb8_layout {
+    uint32_t r, g, b;
+} scope_rgb8_layout_t;
+
+// Byte offsets of the color channels inside a 4 byte pixel
+static inline scope_rgb8_layout_t scope_rgb8_layout(scope_pixel_format_t format) {
+    if (format == SCOPE_PIXEL_FORMAT_BGRA8) {
+        return (scope_rgb8_layout_t){2, 1, 0};
+    }
+    return (scope_rgb8_layout_t){0, 1, 2};
+}
+
+// Sample layout of the Y'CbCr formats
+typedef struct scope_ycbcr_layout {
+    uint32_t x_shift; // chroma subsampling
+    uint32_t y_shift;
+    uint32_t bits;
+    uint32_t sample_bytes;
+    uint32_t sample_shift; // from the stored sample down to the code value
+    bool interleaved;      // Cb and Cr alternate in chroma[0]
+} scope_ycbcr_layout_t;
+
+static inline scope_ycbcr_layout_t scope_ycbcr_layout(scope_pixel_format_t format) {
+    switch (format) {
+    case SCOPE_PIXEL_FORMAT_YUV420P: return (scope_ycbcr_layout_t){1, 1, 8, 1, 0, false};
+    case SCOPE_PIXEL_FORMAT_YUV422P: return (scope_ycbcr_layout_t){1, 0, 8, 1, 0, false};
+    case SCOPE_PIXEL_FORMAT_YUV444P: return (scope_ycbcr_layout_t){0, 0, 8, 1, 0, false};
+    case SCOPE_PIXEL_FORMAT_YUV420P10: return (scope_ycbcr_layout_t){1, 1, 10, 2, 0, false};
+    case SCOPE_PIXEL_FORMAT_YUV422P10: return (scope_ycbcr_layout_t){1, 0, 10, 2, 0, false};
+    case SCOPE_PIXEL_FORMAT_YUV444P10: return (scope_ycbcr_layout_t){0, 0, 10, 2, 0, false};
+    case SCOPE_PIXEL_FORMAT_NV12: return (scope_ycbcr_layout_t){1, 1, 8, 1, 0, true};
+    case SCOPE_PIXEL_FORMAT_P010: return (scope_ycbcr_layout_t){1, 1, 10, 2, 6, true};
+    default: return (scope_ycbcr_layout_t){0, 0, 8, 1, 0, false};
+    }
+}
+
+// Code value of the sample at `p`. Out of range bits of 16-bit samples are masked off, so
+// garbage in the padding can't index past the code tables.
+static inline uint32_t scope_ycbcr_sample(const uint8_t *p, uint32_t sample_bytes, uint32_t shift, uint32_t bits) {
+    if (sample_bytes == 1) {
+        return *p;
+    }
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+    return (v >> shift) & ((1u << bits) - 1);
+}
+
+// Signals of R, G and B of an HDR pixel through its format's table, in 0-65535
+static inline void scope_hdr_signals(const uint8_t *px, scope_pixel_format_t format, const scope_signal_lut_t *lut, uint32_t out[3]) {
+    if (format == SCOPE_PIXEL_FORMAT_RGBA16F) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            out[c] = scope_signal_half(lut, (uint16_t)(px[2 * c] | (px[2 * c + 1] << 8)));
+        }
+    } else {
+        const uint32_t word = (uint32_t)px[0] | ((uint32_t)px[1] << 8) | ((uint32_t)px[2] << 16) | ((uint32_t)px[3] << 24);
+        out[0] = lut->signal[word & 0x3ffu];
+        out[1] = lut->signal[(word >> 10) & 0x3ffu];
+        out[2] = lut->signal[(word >> 20) & 0x3ffu];
+    }
+}
+
+// Brightest of R, G and B of a half float pixel, with negative values and NaN as 0 and infinities
+// as SCOPE_HALF_MAX. The compares are ordered like the max/min instructions of the SIMD kernel.
+static inline float scope_half_level_clamp(float v) {
+    v = v > 0.0f ? v : 0.0f;
+    return v < SCOPE_HALF_MAX ? v : SCOPE_HALF_MAX;
+}
+
+static inline float scope_half_level_pixel(const uint8_t *px) {
+    float level = 0.0f;
+    for (uint32_t c = 0; c < 3; ++c) {
+        float v = scope_half_level_clamp(scope_half_to_float((uint16_t)(px[2 * c] | (px[2 * c + 1] << 8))));
+        level = level > v ? level : v;
+    }
+    return level;
+}
+
+// The few values threads share without a lock. C99 has no atomics, so these map to the compiler
+// builtins, or the Interlocked intrinsics on MSVC. Loads acquire, stores release, exchanges do both.
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+
+static inline uint32_t scope_atomic_load(volatile uint32_t *p) { return (uint32_t)_InterlockedOr((volatile long *)p, 0); }
+static inline void scope_atomic_store(volatile uint32_t *p, uint32_t v) { _InterlockedExchange((volatile long *)p, (long)v); }
+static inline uint32_t scope_atomic_exchange(volatile uint32_t *p, uint32_t v) { return (uint32_t)_InterlockedExchange((volatile long *)p, (long)v); }
+static inline uint64_t scope_atomic_load64(volatile uint64_t *p) { return (uint64_t)_InterlockedOr64((volatile __int64 *)p, 0); }
+static inline void scope_atomic_store64(volatile uint64_t *p, uint64_t v) { _InterlockedExchange64((volatile __int64 *)p, (__int64)v); }
+static inline void scope_atomic_add64(volatile uint64_t *p, uint64_t v) { _InterlockedExchangeAdd64((volatile __int64 *)p, (__int64)v); }
+#else
+static inline uint32_t scope_atomic_load(volatile uint32_t *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void scope_atomic_store(volatile uint32_t *p, uint32_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline uint32_t scope_atomic_exchange(volatile uint32_t *p, uint32_t v) { return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL); }
+static inline uint64_t scope_atomic_load64(volatile uint64_t *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void scope_atomic_store64(volatile uint64_t *p, uint64_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline void scope_atomic_add64(volatile uint64_t *p, uint64_t v) { __atomic_add_fetch(p, v, __ATOMIC_ACQ_REL); }
+#endif
+
+// lowbias32 by Chris Wellons, a cheap well mixed 32-bit hash
+static inline uint32_t scope_hash32(uint32_t v) {
+    v ^= v >> 16;
+    v *= 0x7feb352du;
+    v ^= v >> 15;
+    v *= 0x846ca68bu;
+    v ^= v >> 16;
+    return v;
+}
+
+// Side of the square tiles of vectorscope bins whose occupancy is tracked, see scope_vectorscope.h
+#define SCOPE_VS_TILE_SIZE 32
+
+static inline uint32_t scope_vs_tiles_per_row(uint32_t res) {
+    return (res + SCOPE_VS_TILE_SIZE - 1) / SCOPE_VS_TILE_SIZE;
+}
+
+// Adds `count` hits to bin `index` of a res x res grid, and marks its tile if the bin was empty.
+// The branch is on the count the add loads anyway and is next to never taken once the colors of
+// a frame have shown up, so the divisions don't matter.
+static inline void scope_vs_add(uint32_t *bins, uint8_t *tiles, uint32_t res, uint32_t index, uint32_t count) {
+    const uint32_t old = bins[index];
+    bins[index] = old + count;
+    if (old == 0 && count != 0) {
+        tiles[index / res / SCOPE_VS_TILE_SIZE * scope_vs_tiles_per_row(res) + index % res / SCOPE_VS_TILE_SIZE] = 1;
+    }
+}
+
+// Vectorscope grid at a zoom: Cb/Cr are binned as (c + 0.5) * scale, the bins of a res * zoom
+// grid, and the centered res x res window is kept by subtracting `offset` and dropping whatever
+// lands outside. Zoom 1 is the plain grid, with an offset of 0.
+typedef struct scope_vs_grid {
+    int res;
+    float scale;
+    int offset;
+} scope_vs_grid_t;
+
+static inline scope_vs_grid_t scope_vs_grid(uint32_t res, uint32_t zoom) {
+    return (scope_vs_grid_t){(int)res, (float)(res * zoom), (int)((zoom - 1) * res / 2)};
+}
+
+// Kernels doing color math are written once as functions of a scope_encoding_t and instanced for
+// every encoding by SCOPE_ENCODINGS(X), with X(name, matrix, range) in the order of
+// scope_encoding_index(). Each instance inlines the kernel with its encoding as a constant, so
+// the weights are immediates and nothing branches on the encoding per pixel.
+#define SCOPE_ENCODINGS(X) \
+    X(bt601_limited, SCOPE_MATRIX_BT601, SCOPE_COLOR_RANGE_LIMITED) \
+    X(bt601_full, SCOPE_MATRIX_BT601, SCOPE_COLOR_RANGE_FULL) \
+    X(bt709_limited, SCOPE_MATRIX_BT709, SCOPE_COLOR_RANGE_LIMITED) \
+    X(bt709_full, SCOPE_MATRIX_BT709, SCOPE_COLOR_RANGE_FULL) \
+    X(bt2020_limited, SCOPE_MATRIX_BT2020, SCOPE_COLOR_RANGE_LIMITED) \
+    X(bt2020_full, SCOPE_MATRIX_BT2020, SCOPE_COLOR_RANGE_FULL)
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SCOPE_FORCE_INLINE static __forceinline
+#else
+#define SCOPE_FORCE_INLINE static inline __attribute__((always_inline))
+#endif
+
+// Limited range codes on the 0-1 axis of 0-255, the same constants as scope_encoding.hlsli
+#define SCOPE_LIMITED_LEVEL_SCALE (219.0f / 255.0f)
+#define SCOPE_LIMITED_LEVEL_OFFSET (16.0f / 255.0f)
+#define SCOPE_LIMITED_CHROMA_SCALE (224.0f / 255.0f)
+
+// Weights of the color math of an encoding: the matrix's, with Cb/Cr spanning the codes of the range
+static inline scope_matrix_weights_t scope_encoding_weights(scope_encoding_t encoding) {
+    const scope_matrix_weights_t w = scope_matrix_weights(encoding.matrix);
+    // Spelled out so the constants fold in the specialized kernels, * 1 is exact
+    const float s = encoding.range == SCOPE_COLOR_RANGE_LIMITED ? SCOPE_LIMITED_CHROMA_SCALE : 1.0f;
+    return (scope_matrix_weights_t){
+        {w.luma[0], w.luma[1], w.luma[2]},
+        {w.cb[0] * s, w.cb[1] * s, w.cb[2] * s},
+        {w.cr[0] * s, w.cr[1] * s, w.cr[2] * s},
+    };
+}
+
+// A 0-1 level, of R, G, B or Y', where the range puts its code
+static inline float scope_encode_level(float v, scope_color_range_t range) {
+    return range == SCOPE_COLOR_RANGE_LIMITED ? v * SCOPE_LIMITED_LEVEL_SCALE + SCOPE_LIMITED_LEVEL_OFFSET : v;
+}
+
+// Vectorscope row kernels: bin `width` pixels starting at `row` into the grid, marking the tiles
+// of the bins they fill. One per encoding for every ISA, indexed by scope_encoding_index().
+typedef void (*scope_vs_row_fn)(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout);
+
+extern const scope_vs_row_fn scope_vs_rows_scalar[SCOPE_ENCODING_COUNT];
+#if SCOPE_X86_SIMD
+extern const scope_vs_row_fn scope_vs_rows_sse41[SCOPE_ENCODING_COUNT];
+extern const scope_vs_row_fn scope_vs_rows_avx2[SCOPE_ENCODING_COUNT];
+extern const scope_vs_row_fn scope_vs_rows_avx512[SCOPE_ENCODING_COUNT];
+#endif
+
+// Box filter kernels: average `factor` x `factor` blocks of 4-byte pixels starting at `in` into
+// `out_width` pixels at `out`. `sums` has room for out_width * factor * 4 column sums.
+typedef void (*scope_box_row_fn)(uint8_t *out, const uint8_t *in, size_t in_stride, uint32_t out_width, uint32_t factor, uint16_t *sums);
+
+void scope_box_row_scalar(uint8_t *out, const uint8_t *in, size_t in_stride, uint32_t out_width, uint32_t factor, uint16_t *sums);
+#if SCOPE_X86_SIMD
+void scope_box_row_sse41(uint8_t *out, const uint8_t *in, size_t in_stride, uint32_t out_width, uint32_t factor, uint16_t *sums);
+void scope_box_row_avx2(uint8_t *out, const uint8_t *in, size_t in_stride, uint32_t out_width, uint32_t factor, uint16_t *sums);
+#endif
+
+// Tile hash kernels: fold a row of `width` 4-byte pixels, starting at a tile boundary, into the
+// state of the tiles it crosses. Word j of a tile row (8 bytes, the last one zero padded) goes into
+// lane j % 4 of the tile's state through scope_tile_word() with `keys[j]`. The lanes are plain sums,
+// so every kernel ends up with the same state.
+typedef void (*scope_tile_row_fn)(uint64_t *state, const uint8_t *row, uint32_t width, const uint64_t *keys);
+
+void scope_tile_row_scalar(uint64_t *state, const uint8_t *row, uint32_t width, const uint64_t *keys);
+#if SCOPE_X86_SIMD
+void scope_tile_row_sse41(uint64_t *state, const uint8_t *row, uint32_t width, const uint64_t *keys);
+void scope_tile_row_avx2(uint64_t *state, const uint8_t *row, uint32_t width, const uint64_t *keys);
+#endif
+
+static inline uint64_t scope_tile_word(uint64_t word, uint64_t key) {
+    uint64_t mixed = word ^ key;
+    return (mixed & 0xffffffffu) * (mixed >> 32) + word;
+}
+
+// 0.24 fixed point reciprocal of a box's area, rounded up so halves round up. Every kernel
+// averages as (sum * reciprocal + 2^23) >> 24, so they all round the same way.
+static inline uint32_t scope_box_reciprocal(uint32_t factor) {
+    uint32_t area = factor * factor;
+    return ((1u << 24) + area - 1) / area;
+}
+
+// Light level kernels: scope_half_level_pixel() of `width` RGBA16F pixels. Pixel x is added to
+// `sums[x % 4]`, which start from zero, so every kernel sums in the same order. Returns the largest.
+typedef float (*scope_half_level_row_fn)(const uint8_t *row, uint32_t width, float sums[4]);
+
+float scope_half_level_row_scalar(const uint8_t *row, uint32_t width, float sums[4]);
+#if SCOPE_X86_SIMD
+float scope_half_level_row_avx2(const uint8_t *row, uint32_t width, float sums[4]);
+#endif
+
+// Y'CbCr -> R'G'B' of a matrix: R' = Y' + r_cr Cr, G' = Y' - g_cb Cb - g_cr Cr, B' = Y' + b_cb Cb
+typedef struct scope_ycbcr_inverse {
+    float r_cr, g_cb, g_cr, b_cb;
+} scope_ycbcr_inverse_t;
+
+// From the luma weights, so it inverts scope_matrix_weights() of the same matrix
+static inline scope_ycbcr_inverse_t scope_ycbcr_inverse(scope_matrix_t matrix) {
+    const scope_matrix_weights_t weights = scope_matrix_weights(matrix);
+    const float kr = weights.luma[0], kg = weights.luma[1], kb = weights.luma[2];
+    return (scope_ycbcr_inverse_t){
+        .r_cr = 2.0f * (1.0f - kr),
+        .g_cb = 2.0f * kb * (1.0f - kb) / kg,
+        .g_cr = 2.0f * kr * (1.0f - kr) / kg,
+        .b_cb = 2.0f * (1.0f - kb),
+    };
+}
+
+// Code values of a Y'CbCr format to Y' in 0-1 and Cb, Cr in +-0.5, as (code - zero) / span, and
+// on to R'G'B' with the inverse of the matrix
+typedef struct scope_ycbcr_decode {
+    scope_ycbcr_layout_t layout;
+    float y_zero, y_span;
+    float c_zero, c_span;
+    scope_ycbcr_inverse_t inverse;
+} scope_ycbcr_decode_t;
+
+// Conversion kernels, see scope_convert.h. Decoders turn `width` pixels of a row into planar floats
+// at `out`, encoders write `width` pixels of a row from planar floats. Values are rounded as
+// (uint32_t)(saturate(v) * max + 0.5f) and divided back by max, so every kernel gives the same bytes.
+void scope_decode_rgb8_row_scalar(const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, float *const out[3]);
+void scope_decode_rgb10a2_row_scalar(const uint8_t *row, uint32_t width, float *const out[3]);
+void scope_decode_rgba16f_row_scalar(const uint8_t *row, uint32_t width, float *const out[3]);
+// `cb` and `cr` point at the first sample of the chroma rows, interleaved formats have cr one
+// sample after cb
+void scope_decode_ycbcr_row_scalar(const uint8_t *luma, const uint8_t *cb, const uint8_t *cr, uint32_t width, const scope_ycbcr_decode_t *decode, float *const out[3]);
+void scope_encode_rgb8_row_scalar(const float *const in[3], uint32_t width, scope_rgb8_layout_t layout, uint8_t *row);
+void scope_encode_rgb10a2_row_scalar(const float *const in[3], uint32_t width, uint8_t *row);
+void scope_encode_rgba16f_row_scalar(const float *const in[3], uint32_t width, uint8_t *row);
+// BGRA8 <-> RGBA8
+void scope_swap_rgb8_row_scalar(const uint8_t *in, uint32_t width, uint8_t *out);
+#if SCOPE_X86_SIMD
+void scope_decode_rgb8_row_avx2(const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, float *const out[3]);
+void scope_decode_rgb10a2_row_avx2(const uint8_t *row, uint32_t width, float *const out[3]);
+void scope_decode_rgba16f_row_avx2(const uint8_t *row, uint32_t width, float *const out[3]);
+void scope_decode_ycbcr_row_avx2(const uint8_t *luma, const uint8_t *cb, const uint8_t *cr, uint32_t width, const scope_ycbcr_decode_t *decode, float *const out[3]);
+void scope_encode_rgb8_row_avx2(const float *const in[3], uint32_t width, scope_rgb8_layout_t layout, uint8_t *row);
+void scope_encode_rgb10a2_row_avx2(const float *const in[3], uint32_t width, uint8_t *row);
+void scope_encode_rgba16f_row_avx2(const float *const in[3], uint32_t width, uint8_t *row);
+void scope_swap_rgb8_row_avx2(const uint8_t *in, uint32_t width, uint8_t *out);
+#endif
+
+// Saturated code value of a float, the rounding every encoder uses
+static inline uint32_t scope_unorm_code(float v, float max) {
+    v = v > 0.0f ? v : 0.0f;
+    v = v < 1.0f ? v : 1.0f;
+    return (uint32_t)(v * max + 0.5f);
+}
@@ -0,0 +1,153 @@
+#include "scope_lut.h"
+
+#include "scope_hdr.h"
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <math.h>
+
+static int32_t to_fixed(double bins) {
+    return (int32_t)lround(bins * (double)(1 << SCOPE_LUT_FRAC_BITS));
+}
+
+bool scope_chroma_lut_update(scope_chroma_lut_t *lut, uint32_t resolution, uint32_t zoom, scope_encoding_t encoding) {
+    assert(lut);
+    assert(zoom >= 1 && zoom <= SCOPE_VS_MAX_ZOOM);
+
+    if (lut->valid && lut->resolution == resolution && lut->zoom == zoom && scope_encoding_index(lut->encoding) == scope_encoding_index(encoding)) {
+        return false;
+    }
+
+    // The bins of the zoomed grid, the window's offset comes off with the center below
+    const uint32_t size = resolution * zoom;
+    const scope_matrix_weights_t w = scope_encoding_weights(encoding);
+
+    for (uint32_t c = 0; c < 3; ++c) {
+        for (uint32_t v = 0; v < 256; ++v) {
+            double unorm = v / 255.0;
+            lut->cb[c][v] = to_fixed(unorm * w.cb[c] * size);
+            lut->cr[c][v] = to_fixed(unorm * w.cr[c] * size);
+        }
+    }
+
+    // Fold the +0.5 that centers the plane into the red tables, less the bins left of the window.
+    // Both are whole bins, so a sum is the zoomed grid's minus the window offset, bit for bit.
+    int32_t center = to_fixed(0.5 * size) - to_fixed((double)((zoom - 1) * resolution / 2));
+    for (uint32_t v = 0; v < 256; ++v) {
+        lut->cb[0][v] += center;
+        lut->cr[0][v] += center;
+    }
+
+    lut->resolution = resolution;
+    lut->zoom = zoom;
+    lut->encoding = encoding;
+    lut->valid = true;
+    return true;
+}
+
+bool scope_luma_lut_update(scope_luma_lut_t *lut, uint32_t buckets, scope_encoding_t encoding) {
+    assert(lut);
+
+    if (lut->valid && lut->buckets == buckets && scope_encoding_index(lut->encoding) == scope_encoding_index(encoding)) {
+        return false;
+    }
+
+    const scope_matrix_weights_t w = scope_encoding_weights(encoding);
+    const bool limited = encoding.range == SCOPE_COLOR_RANGE_LIMITED;
+    const double level_scale = limited ? SCOPE_LIMITED_LEVEL_SCALE : 1.0;
+
+    for (uint32_t v = 0; v < 256; ++v) {
+        // Same expression as the float path, so single channel buckets match exactly
+        uint32_t bucket = (uint32_t)(scope_encode_level(v / 255.0f, encoding.range) * (float)buckets);
+        lut->bucket[v] = bucket < buckets ? bucket : buckets - 1;
+
+        for (uint32_t c = 0; c < 3; ++c) {
+            lut->luma[c][v] = to_fixed(v / 255.0 * w.luma[c] * level_scale * buckets);
+        }
+    }
+
+    if (limited) {
+        const int32_t black = to_fixed(SCOPE_LIMITED_LEVEL_OFFSET * buckets);
+        for (uint32_t v = 0; v < 256; ++v) {
+            lut->luma[0][v] += black;
+        }
+    }
+
+    lut->buckets = buckets;
+    lut->encoding = encoding;
+    lut->valid = true;
+    return true;
+}
+
+bool scope_code_lut_update(scope_code_lut_t *lut, bool chroma, uint32_t size, uint32_t zoom, uint32_t bits, scope_color_range_t range, scope_color_range_t target_range) {
+    assert(lut);
+    assert(bits >= 8 && bits <= SCOPE_YCBCR_MAX_BITS);
+    assert(size < SCOPE_CODE_OUTSIDE);
+    assert(zoom >= 1 && zoom <= SCOPE_VS_MAX_ZOOM && (chroma || zoom == 1));
+
+    if (lut->valid && lut->chroma == chroma && lut->size == size && lut->zoom == zoom && lut->bits == bits && lut->range == range &&
+        lut->target_range == target_range) {
+        return false;
+    }
+
+    // Chroma window of the zoomed grid, as scope_vs_grid()
+    const float scale = (float)(size * zoom);
+    const int offset = (int)((zoom - 1) * size / 2);
+
+    // Nominal code ranges, scaled up from their 8-bit values for deeper samples
+    const uint32_t codes = 1u << bits;
+    const uint32_t scale_8 = 1u << (bits - 8);
+    const bool full = range == SCOPE_COLOR_RANGE_FULL;
+    const float zero = chroma ? (float)(codes / 2) : (full ? 0.0f : (float)(16 * scale_8));
+    const float span = full ? (float)(codes - 1) : (float)((chroma ? 224 : 219) * scale_8);
+
+    for (uint32_t v = 0; v < codes; ++v) {
+        float unorm = ((float)v - zero) / span;
+
+        if (chroma) {
+            // Same binning as the RGB path once Cb/Cr are known
+            if (target_range == SCOPE_COLOR_RANGE_LIMITED) unorm *= SCOPE_LIMITED_CHROMA_SCALE;
+            int bin = (int)((unorm + 0.5f) * scale) - offset;
+            lut->index[v] = bin >= 0 && bin < (int)size ? (uint16_t)bin : SCOPE_CODE_OUTSIDE;
+        } else {
+            // saturate() like wf_accum, what lies past the ends of the axis piles up there
+            uint32_t bucket = (uint32_t)(CLAMP(scope_encode_level(unorm, target_range), 0.0f, 1.0f) * (float)size);
+            lut->index[v] = (uint16_t)(bucket < size ? bucket : size - 1);
+        }
+    }
+
+    lut->chroma = chroma;
+    lut->size = size;
+    lut->zoom = zoom;
+    lut->bits = bits;
+    lut->range = range;
+    lut->target_range = target_range;
+    lut->valid = true;
+    return true;
+}
+
+bool scope_signal_lut_update(scope_signal_lut_t *lut, scope_pixel_format_t format, scope_transfer_t transfer) {
+    assert(lut);
+    assert(scope_pixel_format_is_hdr(format));
+
+    if (lut->valid && lut->format == format && lut->transfer == transfer) {
+        return false;
+    }
+
+    const uint32_t count = format == SCOPE_PIXEL_FORMAT_RGBA16F ? SCOPE_HALF_FINITE : 1024;
+    for (uint32_t v = 0; v < count; ++v) {
+        float value = format == SCOPE_PIXEL_FORMAT_RGBA16F ? scope_half_to_float((uint16_t)v) : (float)v / 1023.0f;
+
+        // Linear light is encoded for the PQ axis, everything else already is a signal
+        float signal = transfer == SCOPE_TRANSFER_LINEAR ? scope_transfer_signal(SCOPE_TRANSFER_PQ, value * SCOPE_SCRGB_WHITE_NITS)
+                                                         : CLAMP(value, 0.0f, 1.0f);
+        lut->signal[v] = (uint16_t)lroundf(signal * 65535.0f);
+    }
+
+    lut->format = format;
+    lut->transfer = transfer;
+    lut->valid = true;
+    return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "scope.h"
+
+// Fixed-point precision of the table entries, in fractional bits of a bin
+#define SCOPE_LUT_FRAC_BITS 16
+
+// Integer replacement for the float math on 8-bit pixels. Every table holds one color channel's
+// contribution for each of the 256 code values, pre-scaled to bins, so a pixel's bin is the sum of
+// three lookups shifted down by SCOPE_LUT_FRAC_BITS. Channel order in the tables is always R, G, B.
+
+typedef struct scope_chroma_lut {
+    // Cb/Cr offset by half the range, so valid sums are in [0, resolution << SCOPE_LUT_FRAC_BITS).
+    // Zoomed tables are scaled to resolution * zoom bins and offset to its centered window.
+    int32_t cb[3][256];
+    int32_t cr[3][256];
+
+    // What the tables were built for
+    uint32_t resolution;
+    uint32_t zoom;
+    scope_encoding_t encoding;
+    bool valid;
+} scope_chroma_lut_t;
+
+typedef struct scope_luma_lut {
+    // Bucket of a single channel, identical to the float path's bucket for that code value
+    uint32_t bucket[256];
+    // Y' with the black level of the range folded into the red table
+    int32_t luma[3][256];
+
+    uint32_t buckets;
+    scope_encoding_t encoding;
+    bool valid;
+} scope_luma_lut_t;
+
+/* @brief Rebuilds the tables if they were built for a different resolution, zoom or encoding.
+ * Returns true if rebuilt. */
+bool scope_chroma_lut_update(scope_chroma_lut_t *lut, uint32_t resolution, uint32_t zoom, scope_encoding_t encoding);
+/* @brief Rebuilds the tables if they were built for a different bucket count or encoding. Returns true if rebuilt. */
+bool scope_luma_lut_update(scope_luma_lut_t *lut, uint32_t buckets, scope_encoding_t encoding);
+
+// Deepest Y'CbCr samples the code tables cover
+#define SCOPE_YCBCR_MAX_BITS 10
+#define SCOPE_CODE_OUTSIDE UINT16_MAX
+
+// Y'CbCr input already carries Cb, Cr and Y', so a table of every code value gives the bin or
+// bucket of a sample directly, with no color math per pixel and no detour through RGB. The codes
+// are decoded in the range of the samples and placed where the range of the scope's encoding puts
+// them, so a limited range scope shows limited range samples as they are, sub-blacks and all.
+typedef struct scope_code_lut {
+    // Chroma tables: vectorscope bin along Cb or Cr, SCOPE_CODE_OUTSIDE past the edge of the
+    // (zoomed) window.
+    // Luma tables: waveform bucket.
+    uint16_t index[1 << SCOPE_YCBCR_MAX_BITS];
+
+    // What the table was built for
+    bool chroma;
+    uint32_t size; // vectorscope resolution or waveform bucket count
+    uint32_t zoom; // vectorscope zoom, 1 for luma
+    uint32_t bits;
+    scope_color_range_t range;        // of the samples
+    scope_color_range_t target_range; // of the scope
+    bool valid;
+} scope_code_lut_t;
+
+/* @brief Rebuilds the table if it was built for different parameters. Returns true if rebuilt. */
+bool scope_code_lut_update(scope_code_lut_t *lut, bool chroma, uint32_t size, uint32_t zoom, uint32_t bits, scope_color_range_t range, scope_color_range_t target_range);
+
+// Half float patterns from 0x7c00 up are infinities and NaN
+#define SCOPE_HALF_FINITE 0x7c00
+
+// HDR samples to signals on the waveform's axis (see scope_hdr.h), so the scopes bin every pixel by
+// a single lookup per channel and never clip at SDR white. Half floats are looked up by their bit
+// pattern, which is exact, where a float table could only be sampled.
+typedef struct scope_signal_lut {
+    // 0-65535 of the axis, for every non-negative finite half or every 10-bit code
+    uint16_t signal[SCOPE_HALF_FINITE];
+
+    // What the table was built for
+    scope_pixel_format_t format;
+    scope_transfer_t transfer;
+    bool valid;
+} scope_signal_lut_t;
+
+/* @brief Rebuilds the table if it was built for a different HDR format or transfer. Returns true if rebuilt. */
+bool scope_signal_lut_update(scope_signal_lut_t *lut, scope_pixel_format_t format, scope_transfer_t transfer);
+
+// Negative halves have no light and come out as 0, infinities and NaN at the top of the axis
+static inline uint32_t scope_signal_half(const scope_signal_lut_t *lut, uint16_t half) {
+    if (half & 0x8000u) {
+        return 0;
+    }
+    return lut->signal[half < SCOPE_HALF_FINITE ? half : SCOPE_HALF_FINITE - 1];
+}
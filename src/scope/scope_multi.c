@@ -0,0 +1,140 @@
+#include "scope_multi.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+static void view_task(void *user_data, uint32_t index);
+static void scope_view(scope_multi_view_t *view, scope_thread_pool_t *pool);
+
+bool scope_multi_create(scope_multi_t *multi, scope_source_t *const *sources, uint32_t source_count) {
+    assert(multi);
+    assert(sources && source_count > 0);
+
+    *multi = (scope_multi_t){
+        .views = calloc(source_count, sizeof(scope_multi_view_t)),
+        .ready = calloc(source_count, sizeof(uint32_t)),
+    };
+    if (!multi->views || !multi->ready) {
+        for (uint32_t i = 0; i < source_count; ++i) {
+            scope_source_destroy(sources[i]);
+        }
+        scope_multi_destroy(multi);
+        return false;
+    }
+
+    // Views own their sources from here on, so destroying the scopes cleans up after a failure
+    for (uint32_t i = 0; i < source_count; ++i) {
+        multi->views[i].source = sources[i];
+    }
+    multi->view_count = source_count;
+
+    for (uint32_t i = 0; i < source_count; ++i) {
+        scope_multi_view_t *view = &multi->views[i];
+        // Scopes that were never created are zeroed, which destroying tolerates
+        if (!scope_vectorscope_create(&view->vs) || !scope_waveform_create(&view->wf)) {
+            scope_multi_destroy(multi);
+            return false;
+        }
+        scope_incremental_create(&view->inc, &view->vs, &view->wf);
+        view->result = SCOPE_ACQUIRE_TIMEOUT;
+    }
+
+    return true;
+}
+
+void scope_multi_destroy(scope_multi_t *multi) {
+    if (!multi) return;
+
+    for (uint32_t i = 0; i < multi->view_count; ++i) {
+        scope_multi_view_t *view = &multi->views[i];
+        scope_incremental_destroy(&view->inc);
+        scope_waveform_destroy(&view->wf);
+        scope_vectorscope_destroy(&view->vs);
+        scope_source_destroy(view->source);
+    }
+    free(multi->views);
+    free(multi->ready);
+    *multi = (scope_multi_t){0};
+}
+
+bool scope_multi_configure(scope_multi_t *multi, const scope_config_t *config) {
+    assert(multi && multi->views);
+    assert(config);
+
+    bool ok = true;
+    for (uint32_t i = 0; i < multi->view_count; ++i) {
+        scope_multi_view_t *view = &multi->views[i];
+        // Both scopes take the config on their own, one failing must not keep the other on the old one
+        bool vs_ok = scope_vectorscope_configure(&view->vs, config);
+        bool wf_ok = scope_waveform_configure(&view->wf, config);
+        ok = vs_ok && wf_ok && ok;
+        // Emptied or not, the next frame rebuilds with the new config
+        scope_incremental_invalidate(&view->inc);
+    }
+    return ok;
+}
+
+uint32_t scope_multi_update(scope_multi_t *multi, uint32_t timeout_ms, scope_thread_pool_t *pool) {
+    assert(multi && multi->views);
+
+    uint32_t ready_count = 0;
+    for (uint32_t i = 0; i < multi->view_count; ++i) {
+        scope_multi_view_t *view = &multi->views[i];
+        view->failed = false;
+
+        // Ended sources stay ended
+        if (view->result == SCOPE_ACQUIRE_END) continue;
+
+        view->result = scope_source_acquire(view->source, timeout_ms, &view->frame);
+        if (view->result == SCOPE_ACQUIRE_OK) {
+            multi->ready[ready_count++] = i;
+        }
+    }
+
+    if (ready_count >= scope_thread_pool_size(pool)) {
+        scope_thread_pool_run(pool, ready_count, view_task, multi);
+    } else {
+        for (uint32_t i = 0; i < ready_count; ++i) {
+            scope_view(&multi->views[multi->ready[i]], pool);
+        }
+    }
+
+    uint32_t scoped = 0;
+    for (uint32_t i = 0; i < ready_count; ++i) {
+        scope_multi_view_t *view = &multi->views[multi->ready[i]];
+        scope_source_release(view->source);
+        // The size, format and generation still describe the frame that was scoped
+        view->frame.image.data = NULL;
+        view->frame.image.chroma[0] = NULL;
+        view->frame.image.chroma[1] = NULL;
+        view->frame.dirty = NULL;
+        view->frame.dirty_count = 0;
+        if (!view->failed) {
+            view->scoped++;
+            scoped++;
+        }
+    }
+    return scoped;
+}
+
+bool scope_multi_ended(const scope_multi_t *multi) {
+    assert(multi);
+
+    for (uint32_t i = 0; i < multi->view_count; ++i) {
+        if (multi->views[i].result != SCOPE_ACQUIRE_END) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The pool doesn't nest, so a view scoped as a task of its own runs its scopes serially
+static void view_task(void *user_data, uint32_t index) {
+    scope_multi_t *multi = user_data;
+    scope_view(&multi->views[multi->ready[index]], NULL);
+}
+
+static void scope_view(scope_multi_view_t *view, scope_thread_pool_t *pool) {
+    view->inc.pool = pool;
+    view->failed = !scope_incremental_update(&view->inc, &view->frame.image, view->frame.dirty, view->frame.dirty_count);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "scope_incremental.h"
+#include "scope_source.h"
+#include "scope_thread.h"
+
+// Scopes several frame sources at the same time, e.g. every monitor of a multi-display setup. Each
+// source gets a view with its own vectorscope and waveform, kept in sync with its frames through
+// scope_incremental. Sources are acquired and released on the calling thread, so they need not be
+// thread-safe (DXGI sources share the immediate context); only the scoping is spread over the pool.
+
+typedef struct scope_multi_view {
+    scope_source_t *source;
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    scope_incremental_t inc;
+
+    // Last update
+    scope_acquire_result_t result;
+    scope_frame_t frame; // pixels and dirty rects valid during the update only, NULL afterwards
+    bool failed;         // the frame was acquired but couldn't be scoped
+
+    uint64_t scoped; // frames scoped since creation
+} scope_multi_view_t;
+
+typedef struct scope_multi {
+    scope_multi_view_t *views;
+    uint32_t view_count;
+    uint32_t *ready; // views with a new frame during an update
+} scope_multi_t;
+
+/* @brief Creates a view per source. Takes ownership of the sources, which are destroyed with the
+ * scopes, or right away if creation fails. */
+bool scope_multi_create(scope_multi_t *multi, scope_source_t *const *sources, uint32_t source_count);
+void scope_multi_destroy(scope_multi_t *multi);
+
+/* @brief Switches the scopes of every view to the sizes and encoding of `config`, their next frames rebuild them.
+ * Returns false on allocation failure, scopes that failed keep their current sizes. */
+bool scope_multi_configure(scope_multi_t *multi, const scope_config_t *config);
+
+/* @brief Acquires a frame from every source, waiting up to `timeout_ms` for each, scopes the new
+ * ones and releases them again. With at least as many new frames as pool threads every view is a
+ * task of its own, otherwise the views are scoped one after another with the whole pool. Views
+ * without a new frame keep their histograms. Returns the number of views that were scoped. */
+uint32_t scope_multi_update(scope_multi_t *multi, uint32_t timeout_ms, scope_thread_pool_t *pool);
+
+/* @brief True once every source returned SCOPE_ACQUIRE_END */
+bool scope_multi_ended(const scope_multi_t *multi);
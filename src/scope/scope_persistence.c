@@ -0,0 +1,238 @@
+#include "scope_persistence.h"
+
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEEP_ONE ((uint64_t)1 << 32)
+#define HALF_HIT ((uint64_t)1 << (SCOPE_PERSISTENCE_FRAC_BITS - 1))
+
+// s * keep / 2^32 rounded down. keep never exceeds 2^32, so neither partial product can overflow.
+static inline uint64_t decay_sum(uint64_t s, uint64_t keep) {
+    return (s >> 32) * keep + (((s & 0xffffffffu) * keep) >> 32);
+}
+
+static inline uint32_t resolve_sum(uint64_t s) {
+    uint64_t hits = (s + HALF_HIT) >> SCOPE_PERSISTENCE_FRAC_BITS;
+    return hits > UINT32_MAX ? UINT32_MAX : (uint32_t)hits;
+}
+
+static bool fit(scope_persistence_t *persistence, size_t count, uint32_t tiles_per_row, uint32_t layout);
+static void step_tiles(scope_persistence_t *persistence, scope_vectorscope_t *vs, uint64_t keep, bool add);
+static void step_bins(scope_persistence_t *persistence, uint32_t *bins, uint64_t keep, bool add);
+
+bool scope_persistence_create(scope_persistence_t *persistence, size_t count, float half_life) {
+    assert(persistence);
+
+    *persistence = (scope_persistence_t){
+        .sums = count > 0 ? calloc(count, sizeof(uint64_t)) : NULL,
+        .count = count,
+        .half_life = half_life,
+        .empty = true,
+    };
+
+    return count == 0 || persistence->sums != NULL;
+}
+
+void scope_persistence_destroy(scope_persistence_t *persistence) {
+    assert(persistence);
+    free(persistence->sums);
+    free(persistence->tiles);
+    *persistence = (scope_persistence_t){0};
+}
+
+void scope_persistence_clear(scope_persistence_t *persistence) {
+    assert(persistence);
+    if (persistence->sums) memset(persistence->sums, 0, persistence->count * sizeof(uint64_t));
+    if (persistence->tiles) memset(persistence->tiles, 0, (size_t)persistence->tiles_per_row * persistence->tiles_per_row);
+    persistence->empty = true;
+}
+
+uint64_t scope_persistence_keep(float half_life, float frames) {
+    if (frames <= 0.0f) return KEEP_ONE;
+    if (half_life <= 0.0f) return 0;
+
+    double keep = exp2(-(double)frames / half_life);
+    return (uint64_t)llround(keep * (double)KEEP_ONE);
+}
+
+void scope_persistence_add(scope_persistence_t *persistence, const uint32_t *histogram) {
+    assert(persistence);
+    assert(histogram);
+
+    uint64_t keep = scope_persistence_keep(persistence->half_life, 1.0f);
+    uint64_t *sums = persistence->sums;
+    uint64_t any = 0;
+
+    for (size_t i = 0; i < persistence->count; ++i) {
+        uint64_t s = decay_sum(sums[i], keep) + ((uint64_t)histogram[i] << SCOPE_PERSISTENCE_FRAC_BITS);
+        sums[i] = s;
+        any |= s;
+    }
+
+    persistence->empty = any == 0;
+    if (persistence->tiles) memset(persistence->tiles, 1, (size_t)persistence->tiles_per_row * persistence->tiles_per_row);
+}
+
+void scope_persistence_decay(scope_persistence_t *persistence, float frames) {
+    assert(persistence);
+
+    if (persistence->empty) return;
+
+    uint64_t keep = scope_persistence_keep(persistence->half_life, frames);
+    if (keep == KEEP_ONE) return;
+
+    uint64_t *sums = persistence->sums;
+    uint64_t any = 0;
+
+    for (size_t i = 0; i < persistence->count; ++i) {
+        uint64_t s = decay_sum(sums[i], keep);
+        sums[i] = s;
+        any |= s;
+    }
+
+    persistence->empty = any == 0;
+}
+
+void scope_persistence_resolve(const scope_persistence_t *persistence, uint32_t *out) {
+    assert(persistence);
+    assert(out);
+
+    if (persistence->empty) {
+        memset(out, 0, persistence->count * sizeof(uint32_t));
+        return;
+    }
+
+    for (size_t i = 0; i < persistence->count; ++i) {
+        out[i] = resolve_sum(persistence->sums[i]);
+    }
+}
+
+bool scope_persistence_add_vectorscope(scope_persistence_t *persistence, scope_vectorscope_t *vs) {
+    assert(persistence);
+    assert(vs && vs->bins);
+
+    const uint32_t layout = vs->zoom | scope_encoding_index(vs->encoding) << 8;
+    if (!fit(persistence, (size_t)vs->resolution * vs->resolution, vs->tiles_per_row, layout)) return false;
+
+    step_tiles(persistence, vs, scope_persistence_keep(persistence->half_life, 1.0f), true);
+    return true;
+}
+
+bool scope_persistence_decay_vectorscope(scope_persistence_t *persistence, scope_vectorscope_t *vs, float frames) {
+    assert(persistence);
+    assert(vs && vs->bins);
+
+    const uint32_t layout = vs->zoom | scope_encoding_index(vs->encoding) << 8;
+    if (!fit(persistence, (size_t)vs->resolution * vs->resolution, vs->tiles_per_row, layout)) return false;
+
+    uint64_t keep = scope_persistence_keep(persistence->half_life, frames);
+    if (!persistence->empty && keep != KEEP_ONE) step_tiles(persistence, vs, keep, false);
+    return true;
+}
+
+bool scope_persistence_add_waveform(scope_persistence_t *persistence, scope_waveform_t *wf) {
+    assert(persistence);
+    assert(wf && wf->channels[0]);
+
+    // The planes are allocated in one block, channels[0] spans all of them
+    const uint32_t layout = wf->width << 16 | scope_encoding_index(wf->encoding) << 8 | wf->axis;
+    if (!fit(persistence, (size_t)wf->width * wf->buckets * SCOPE_WF_CHANNEL_COUNT, 0, layout)) return false;
+
+    step_bins(persistence, wf->channels[0], scope_persistence_keep(persistence->half_life, 1.0f), true);
+    return true;
+}
+
+bool scope_persistence_decay_waveform(scope_persistence_t *persistence, scope_waveform_t *wf, float frames) {
+    assert(persistence);
+    assert(wf && wf->channels[0]);
+
+    const uint32_t layout = wf->width << 16 | scope_encoding_index(wf->encoding) << 8 | wf->axis;
+    if (!fit(persistence, (size_t)wf->width * wf->buckets * SCOPE_WF_CHANNEL_COUNT, 0, layout)) return false;
+
+    uint64_t keep = scope_persistence_keep(persistence->half_life, frames);
+    if (!persistence->empty && keep != KEEP_ONE) step_bins(persistence, wf->channels[0], keep, false);
+    return true;
+}
+
+static bool fit(scope_persistence_t *persistence, size_t count, uint32_t tiles_per_row, uint32_t layout) {
+    if (persistence->sums && persistence->count == count && persistence->tiles_per_row == tiles_per_row) {
+        if (persistence->layout != layout) {
+            scope_persistence_clear(persistence);
+            persistence->layout = layout;
+        }
+        return true;
+    }
+
+    const size_t tile_count = (size_t)tiles_per_row * tiles_per_row;
+    uint64_t *sums = calloc(count, sizeof(uint64_t));
+    uint8_t *tiles = tile_count > 0 ? calloc(tile_count, 1) : NULL;
+    if (!sums || (tile_count > 0 && !tiles)) {
+        free(sums);
+        free(tiles);
+        return false;
+    }
+
+    free(persistence->sums);
+    free(persistence->tiles);
+    persistence->sums = sums;
+    persistence->count = count;
+    persistence->tiles = tiles;
+    persistence->tiles_per_row = tiles_per_row;
+    persistence->layout = layout;
+    persistence->empty = true;
+    return true;
+}
+
+// Tiles marked in neither hold zero sums and zero bins, which decaying and adding keeps
+static void step_tiles(scope_persistence_t *persistence, scope_vectorscope_t *vs, uint64_t keep, bool add) {
+    const uint32_t res = vs->resolution;
+    const uint32_t tiles_per_row = vs->tiles_per_row;
+    uint64_t any = 0;
+
+    for (uint32_t ty = 0; ty < tiles_per_row; ++ty) {
+        const uint32_t y_end = MIN((ty + 1) * SCOPE_VS_TILE_SIZE, res);
+        for (uint32_t tx = 0; tx < tiles_per_row; ++tx) {
+            const size_t tile = (size_t)ty * tiles_per_row + tx;
+            if (!persistence->tiles[tile] && !vs->tiles[tile]) continue;
+
+            const uint32_t x_begin = tx * SCOPE_VS_TILE_SIZE;
+            const uint32_t x_end = MIN(x_begin + SCOPE_VS_TILE_SIZE, res);
+            uint64_t tile_any = 0;
+            for (uint32_t y = ty * SCOPE_VS_TILE_SIZE; y < y_end; ++y) {
+                uint64_t *sums = persistence->sums + (size_t)y * res;
+                uint32_t *bins = vs->bins + (size_t)y * res;
+                for (uint32_t x = x_begin; x < x_end; ++x) {
+                    uint64_t s = decay_sum(sums[x], keep) + (add ? (uint64_t)bins[x] << SCOPE_PERSISTENCE_FRAC_BITS : 0);
+                    sums[x] = s;
+                    bins[x] = resolve_sum(s);
+                    tile_any |= s;
+                }
+            }
+
+            persistence->tiles[tile] = vs->tiles[tile] = tile_any != 0;
+            any |= tile_any;
+        }
+    }
+
+    persistence->empty = any == 0;
+}
+
+static void step_bins(scope_persistence_t *persistence, uint32_t *bins, uint64_t keep, bool add) {
+    uint64_t *sums = persistence->sums;
+    uint64_t any = 0;
+
+    for (size_t i = 0; i < persistence->count; ++i) {
+        uint64_t s = decay_sum(sums[i], keep) + (add ? (uint64_t)bins[i] << SCOPE_PERSISTENCE_FRAC_BITS : 0);
+        sums[i] = s;
+        bins[i] = resolve_sum(s);
+        any |= s;
+    }
+
+    persistence->empty = any == 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_vectorscope.h"
+#include "scope_waveform.h"
+
+// Fractional bits of the persistent sums
+#define SCOPE_PERSISTENCE_FRAC_BITS 16
+
+// Phosphor-style persistence: instead of starting every frame from an empty histogram, the scope
+// keeps an exponential moving sum S = S * k + H, with k chosen so that a hit loses half its weight
+// every `half_life` frames. Sums are 64-bit fixed point so an 8K frame landing in a single bin for
+// hundreds of frames does not saturate, and decay always rounds down so trails reach zero exactly.
+
+typedef struct scope_persistence {
+    uint64_t *sums;
+    size_t count;
+
+    float half_life; // in frames, 0 keeps only the latest histogram
+    bool empty;      // every sum is zero, decaying is a no-op
+
+    // Sums of a vectorscope are marked in its tiles of 32 x 32 bins, like scope_vectorscope_t:
+    // only the marked tiles and those of the frame being added are visited. NULL for the other
+    // histograms.
+    uint8_t *tiles;
+    uint32_t tiles_per_row;
+
+    // What the sums were added from, packed: zoom or waveform width, encoding and axis. They start
+    // over when it changes.
+    uint32_t layout;
+} scope_persistence_t;
+
+/* @brief Allocates sums for histograms of `count` bins, or none yet if `count` is 0 and the sums
+ * are sized by the first scope added to them. Returns false on allocation failure. */
+bool scope_persistence_create(scope_persistence_t *persistence, size_t count, float half_life);
+void scope_persistence_destroy(scope_persistence_t *persistence);
+void scope_persistence_clear(scope_persistence_t *persistence);
+
+/* @brief Decays the sums by one frame and adds `histogram` (same bin count) on top. */
+void scope_persistence_add(scope_persistence_t *persistence, const uint32_t *histogram);
+/* @brief Decays the sums by `frames` (may be fractional) without adding anything, for frames
+ * where no new capture arrived. */
+void scope_persistence_decay(scope_persistence_t *persistence, float frames);
+/* @brief Writes the sums rounded to whole hits, saturated to 32 bits, in the layout of the
+ * histograms that were added. */
+void scope_persistence_resolve(const scope_persistence_t *persistence, uint32_t *out);
+
+/* @brief Decays the sums by one frame, adds the bins of `vs` and replaces them with the resolved
+ * sums, so that bounding, blurring and rendering `vs` show the trails. Only the tiles marked in
+ * either are visited, and the tiles of `vs` are left marking the trails. The sums start over when
+ * the resolution, zoom or encoding of `vs` changed.
+ * Returns false on allocation failure, leaving `vs` untouched. */
+bool scope_persistence_add_vectorscope(scope_persistence_t *persistence, scope_vectorscope_t *vs);
+/* @brief Decays the sums by `frames` and writes them to the bins of `vs`, for frames where no new
+ * capture arrived. `vs` has to hold the sums resolved by the previous call. */
+bool scope_persistence_decay_vectorscope(scope_persistence_t *persistence, scope_vectorscope_t *vs, float frames);
+/* @brief The same for every plane of a waveform, which start over when its size, encoding or axis
+ * changed. */
+bool scope_persistence_add_waveform(scope_persistence_t *persistence, scope_waveform_t *wf);
+bool scope_persistence_decay_waveform(scope_persistence_t *persistence, scope_waveform_t *wf, float frames);
+
+/* @brief Multiplier applied per `frames` of decay, in 0.32 fixed point. */
+uint64_t scope_persistence_keep(float half_life, float frames);
@@ -0,0 +1,223 @@
+#include "scope_pyramid.h"
+
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct filter_job {
+    const scope_image_t *in;
+    const scope_image_t *out;
+    uint32_t factor;
+    uint32_t band_count;
+    uint16_t *sums;
+    size_t band_sums; // sums per band
+    scope_box_row_fn row_fn;
+};
+
+static scope_box_row_fn get_row_kernel(scope_isa_t isa);
+static bool reserve(scope_pyramid_t *pyramid, size_t pixel_size, size_t sum_count);
+static void filter(scope_pyramid_t *pyramid, const scope_image_t *in, const scope_image_t *out, uint32_t factor, uint32_t band_count, scope_thread_pool_t *pool);
+static void filter_band_task(void *user_data, uint32_t band);
+
+static inline uint32_t div_ceil(uint32_t a, uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+void scope_pyramid_create(scope_pyramid_t *pyramid, uint32_t width, uint32_t height, uint32_t level_count) {
+    assert(pyramid);
+    assert(width > 0 && height > 0);
+    assert(level_count >= 1 && level_count <= SCOPE_PYRAMID_MAX_LEVELS);
+
+    *pyramid = (scope_pyramid_t){
+        .width = width,
+        .height = height,
+        .level_count = level_count,
+        .isa = scope_cpu_best_isa(),
+    };
+}
+
+void scope_pyramid_destroy(scope_pyramid_t *pyramid) {
+    if (pyramid) {
+        free(pyramid->pixels);
+        free(pyramid->sums);
+        *pyramid = (scope_pyramid_t){0};
+    }
+}
+
+bool scope_pyramid_update(scope_pyramid_t *pyramid, const scope_image_t *image, scope_thread_pool_t *pool) {
+    assert(pyramid && pyramid->level_count > 0);
+    assert(image && image->data);
+    assert(scope_pixel_format_is_rgb8(image->format));
+
+    if (image->generation != 0 && image->generation == pyramid->generation) {
+        return true;
+    }
+
+    uint32_t factor = MAX(div_ceil(image->width, pyramid->width), div_ceil(image->height, pyramid->height));
+    factor = MIN(factor, MIN((uint32_t)SCOPE_PYRAMID_MAX_FACTOR, MIN(image->width, image->height)));
+
+    // Level sizes, and the memory for everything that isn't the frame itself
+    uint32_t widths[SCOPE_PYRAMID_MAX_LEVELS] = {image->width / factor};
+    uint32_t heights[SCOPE_PYRAMID_MAX_LEVELS] = {image->height / factor};
+    size_t pixel_size = factor > 1 ? (size_t)widths[0] * heights[0] * 4 : 0;
+    uint32_t count = 1;
+    for (; count < pyramid->level_count && widths[count - 1] >= 2 && heights[count - 1] >= 2; ++count) {
+        widths[count] = widths[count - 1] / 2;
+        heights[count] = heights[count - 1] / 2;
+        pixel_size += (size_t)widths[count] * heights[count] * 4;
+    }
+
+    // Level 0 needs the widest row of sums, the smaller levels reuse it
+    const uint32_t band_count = MIN(scope_thread_pool_size(pool), heights[0]);
+    const size_t band_sums = (size_t)widths[0] * MAX(factor, 2u) * 4;
+    if (!reserve(pyramid, pixel_size, band_sums * band_count)) {
+        return false;
+    }
+
+    uint8_t *pixels = pyramid->pixels;
+    for (uint32_t l = 0; l < count; ++l) {
+        if (l == 0 && factor == 1) {
+            pyramid->levels[0] = *image;
+            continue;
+        }
+
+        pyramid->levels[l] = (scope_image_t){
+            .data = pixels,
+            .width = widths[l],
+            .height = heights[l],
+            .stride = widths[l] * 4,
+            .format = image->format,
+            .generation = image->generation,
+        };
+        pixels += (size_t)widths[l] * heights[l] * 4;
+
+        const scope_image_t *in = l == 0 ? image : &pyramid->levels[l - 1];
+        filter(pyramid, in, &pyramid->levels[l], l == 0 ? factor : 2, MIN(band_count, heights[l]), pool);
+    }
+
+    pyramid->built_count = count;
+    pyramid->factor = factor;
+    pyramid->generation = image->generation;
+    return true;
+}
+
+const scope_image_t *scope_pyramid_level(const scope_pyramid_t *pyramid, uint32_t level) {
+    assert(pyramid && pyramid->built_count > 0);
+    return &pyramid->levels[MIN(level, pyramid->built_count - 1)];
+}
+
+bool scope_pyramid_map_rect(const scope_pyramid_t *pyramid, uint32_t level, const scope_rect_t *rect, scope_rect_t *out) {
+    assert(pyramid && pyramid->built_count > 0);
+    assert(rect && out);
+
+    level = MIN(level, pyramid->built_count - 1);
+    const scope_image_t *image = &pyramid->levels[level];
+    const uint64_t scale = (uint64_t)pyramid->factor << level;
+
+    uint64_t x_begin = rect->x / scale;
+    uint64_t y_begin = rect->y / scale;
+    uint64_t x_end = MIN(((uint64_t)rect->x + rect->width + scale - 1) / scale, (uint64_t)image->width);
+    uint64_t y_end = MIN(((uint64_t)rect->y + rect->height + scale - 1) / scale, (uint64_t)image->height);
+    if (x_begin >= x_end || y_begin >= y_end) {
+        return false;
+    }
+
+    *out = (scope_rect_t){(uint32_t)x_begin, (uint32_t)y_begin, (uint32_t)(x_end - x_begin), (uint32_t)(y_end - y_begin)};
+    return true;
+}
+
+void scope_box_row_scalar(uint8_t *out, const uint8_t *in, size_t in_stride, uint32_t out_width, uint32_t factor, uint16_t *sums) {
+    // Column sums first, so the input is read row by row
+    const size_t count = (size_t)out_width * factor * 4;
+    for (size_t i = 0; i < count; ++i) {
+        sums[i] = in[i];
+    }
+    for (uint32_t r = 1; r < factor; ++r) {
+        const uint8_t *row = in + r * in_stride;
+        for (size_t i = 0; i < count; ++i) {
+            sums[i] += row[i];
+        }
+    }
+
+    const uint32_t reciprocal = scope_box_reciprocal(factor);
+    for (uint32_t x = 0; x < out_width; ++x, out += 4) {
+        const uint16_t *s = sums + (size_t)x * factor * 4;
+        uint32_t acc[4] = {0, 0, 0, 0};
+        for (uint32_t k = 0; k < factor * 4; k += 4) {
+            acc[0] += s[k + 0];
+            acc[1] += s[k + 1];
+            acc[2] += s[k + 2];
+            acc[3] += s[k + 3];
+        }
+        for (uint32_t c = 0; c < 4; ++c) {
+            out[c] = (uint8_t)((acc[c] * reciprocal + (1u << 23)) >> 24);
+        }
+    }
+}
+
+static bool reserve(scope_pyramid_t *pyramid, size_t pixel_size, size_t sum_count) {
+    if (pixel_size > pyramid->pixel_capacity) {
+        uint8_t *pixels = realloc(pyramid->pixels, pixel_size);
+        if (!pixels) {
+            return false;
+        }
+        pyramid->pixels = pixels;
+        pyramid->pixel_capacity = pixel_size;
+    }
+
+    if (sum_count > pyramid->sum_capacity) {
+        uint16_t *sums = realloc(pyramid->sums, sum_count * sizeof(uint16_t));
+        if (!sums) {
+            return false;
+        }
+        pyramid->sums = sums;
+        pyramid->sum_capacity = sum_count;
+    }
+
+    return true;
+}
+
+// Output rows are split into bands, each with its own row of column sums
+static void filter(scope_pyramid_t *pyramid, const scope_image_t *in, const scope_image_t *out, uint32_t factor, uint32_t band_count, scope_thread_pool_t *pool) {
+    struct filter_job job = {
+        .in = in,
+        .out = out,
+        .factor = factor,
+        .band_count = band_count,
+        .sums = pyramid->sums,
+        .band_sums = pyramid->sum_capacity / band_count,
+        .row_fn = get_row_kernel(pyramid->isa),
+    };
+    scope_thread_pool_run(band_count > 1 ? pool : NULL, band_count, filter_band_task, &job);
+}
+
+static void filter_band_task(void *user_data, uint32_t band) {
+    const struct filter_job *job = user_data;
+    const scope_image_t *out = job->out;
+    uint16_t *sums = job->sums + job->band_sums * band;
+
+    uint32_t row_begin = (uint32_t)((uint64_t)out->height * band / job->band_count);
+    uint32_t row_end = (uint32_t)((uint64_t)out->height * (band + 1) / job->band_count);
+    for (uint32_t y = row_begin; y < row_end; ++y) {
+        job->row_fn((uint8_t *)scope_image_row(out, y), scope_image_row(job->in, y * job->factor), job->in->stride, out->width, job->factor, sums);
+    }
+}
+
+static scope_box_row_fn get_row_kernel(scope_isa_t isa) {
+    if (!scope_cpu_supports(isa)) {
+        isa = scope_cpu_best_isa();
+    }
+
+    switch (isa) {
+#if SCOPE_X86_SIMD
+        case SCOPE_ISA_AVX512:
+        case SCOPE_ISA_AVX2: return scope_box_row_avx2;
+        case SCOPE_ISA_SSE41: return scope_box_row_sse41;
+#endif
+        default: return scope_box_row_scalar;
+    }
+}
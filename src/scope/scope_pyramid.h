@@ -0,0 +1,58 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_cpu.h"
+#include "scope_thread.h"
+
+// Reduction of captured frames to a fixed analysis resolution. Level 0 is the frame box filtered
+// by the largest integer factor that fits it into the analysis size, so the scopes see at most
+// width x height pixels (and at least about a quarter of that) whatever the size of the capture.
+// Every further level halves the previous one, cheaper levels trade accuracy for speed.
+// Averaging smooths grain, so spread in the scopes narrows slightly with every level.
+
+#define SCOPE_PYRAMID_MAX_LEVELS 8
+// Largest box, up to 16 x 16 pixels the 32-bit fixed point average rounds exactly. Frames more
+// than this many times the analysis size end up with a larger level 0.
+#define SCOPE_PYRAMID_MAX_FACTOR 16
+
+typedef struct scope_pyramid {
+    // Analysis resolution level 0 is fitted into
+    uint32_t width;
+    uint32_t height;
+
+    uint32_t level_count; // levels to build, level 0 included
+
+    // Levels of the last update. Fewer than level_count are built once a level is down to a pixel.
+    scope_image_t levels[SCOPE_PYRAMID_MAX_LEVELS];
+    uint32_t built_count;
+    uint32_t factor; // box level 0 was filtered with, 1 if the frame already fit
+
+    // Kernel used for filtering, picked at creation from the CPU features
+    scope_isa_t isa;
+
+    uint8_t *pixels; // levels[0] (unless it is the frame itself) and the smaller levels
+    size_t pixel_capacity;
+    uint16_t *sums; // one row of column sums per band
+    size_t sum_capacity;
+
+    // Generation of the frame the levels were last built from, 0 if none
+    uint64_t generation;
+} scope_pyramid_t;
+
+/* @brief Sets up a pyramid of `level_count` levels whose level 0 fits in `width` x `height`.
+ * Buffers are allocated by the first update. */
+void scope_pyramid_create(scope_pyramid_t *pyramid, uint32_t width, uint32_t height, uint32_t level_count);
+void scope_pyramid_destroy(scope_pyramid_t *pyramid);
+
+/* @brief Rebuilds the levels from an RGB8 `image`, unless they already hold the frame with the same
+ * non-zero generation. Columns and rows past the last whole box are dropped. A frame that already
+ * fits becomes level 0 as is, without a copy, so it has to stay valid while level 0 is used. The
+ * levels carry the frame's generation. Returns false on allocation failure. `pool` may be NULL. */
+bool scope_pyramid_update(scope_pyramid_t *pyramid, const scope_image_t *image, scope_thread_pool_t *pool);
+
+/* @brief Level `level` of the last update, or the smallest one built if there are fewer */
+const scope_image_t *scope_pyramid_level(const scope_pyramid_t *pyramid, uint32_t level);
+
+/* @brief Maps a dirty rect of the frame onto `level`, growing it to whole pixels of the level and
+ * clipping it to the level. Returns false if nothing of the rect is left. */
+bool scope_pyramid_map_rect(const scope_pyramid_t *pyramid, uint32_t level, const scope_rect_t *rect, scope_rect_t *out);
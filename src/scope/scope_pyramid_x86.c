@@ -0,0 +1,84 @@
+#include "scope_internal.h"
+
+#include <string.h>
+
+// SIMD versions of scope_box_row_scalar. The column sums are plain 16-bit adds of widened bytes,
+// and the averages use the same fixed point reciprocal, so the output is bit-identical.
+
+#if SCOPE_X86_SIMD
+
+#include <immintrin.h>
+
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+// Averages the boxes of one output row from its column sums, a pixel (4 x 32 bits) at a time
+TARGET_SSE41 static inline void box_average_sse41(uint8_t *out, const uint16_t *sums, uint32_t out_width, uint32_t factor) {
+    const __m128i reciprocal = _mm_set1_epi32((int)scope_box_reciprocal(factor));
+    const __m128i round = _mm_set1_epi32(1 << 23);
+
+    for (uint32_t x = 0; x < out_width; ++x, out += 4) {
+        const uint16_t *s = sums + (size_t)x * factor * 4;
+        __m128i acc = _mm_setzero_si128();
+        for (uint32_t k = 0; k < factor; ++k) {
+            acc = _mm_add_epi32(acc, _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(s + k * 4))));
+        }
+
+        __m128i avg = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(acc, reciprocal), round), 24);
+        avg = _mm_packus_epi16(_mm_packus_epi32(avg, avg), avg);
+        uint32_t px = (uint32_t)_mm_cvtsi128_si32(avg);
+        memcpy(out, &px, 4);
+    }
+}
+
+TARGET_SSE41 void scope_box_row_sse41(uint8_t *out, const uint8_t *in, size_t in_stride, uint32_t out_width, uint32_t factor, uint16_t *sums) {
+    const size_t count = (size_t)out_width * factor * 4;
+    const __m128i zero = _mm_setzero_si128();
+
+    for (uint32_t r = 0; r < factor; ++r) {
+        const uint8_t *row = in + r * in_stride;
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(row + i));
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+            if (r > 0) {
+                lo = _mm_add_epi16(lo, _mm_loadu_si128((const __m128i *)(sums + i)));
+                hi = _mm_add_epi16(hi, _mm_loadu_si128((const __m128i *)(sums + i + 8)));
+            }
+            _mm_storeu_si128((__m128i *)(sums + i), lo);
+            _mm_storeu_si128((__m128i *)(sums + i + 8), hi);
+        }
+        for (; i < count; ++i) {
+            sums[i] = (uint16_t)((r > 0 ? sums[i] : 0) + row[i]);
+        }
+    }
+
+    box_average_sse41(out, sums, out_width, factor);
+}
+
+TARGET_AVX2 void scope_box_row_avx2(uint8_t *out, const uint8_t *in, size_t in_stride, uint32_t out_width, uint32_t factor, uint16_t *sums) {
+    const size_t count = (size_t)out_width * factor * 4;
+
+    for (uint32_t r = 0; r < factor; ++r) {
+        const uint8_t *row = in + r * in_stride;
+        size_t i = 0;
+        for (; i + 32 <= count; i += 32) {
+            __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(row + i)));
+            __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(row + i + 16)));
+            if (r > 0) {
+                lo = _mm256_add_epi16(lo, _mm256_loadu_si256((const __m256i *)(sums + i)));
+                hi = _mm256_add_epi16(hi, _mm256_loadu_si256((const __m256i *)(sums + i + 16)));
+            }
+            _mm256_storeu_si256((__m256i *)(sums + i), lo);
+            _mm256_storeu_si256((__m256i *)(sums + i + 16), hi);
+        }
+        for (; i < count; ++i) {
+            sums[i] = (uint16_t)((r > 0 ? sums[i] : 0) + row[i]);
+        }
+    }
+
+    box_average_sse41(out, sums, out_width, factor);
+}
+
+#endif
@@ -0,0 +1,322 @@
+#include "scope_render.h"
+
+#include "scope_hdr.h"
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <math.h>
+
+// The unclamped path of scope_vectorscope_blur() spells out the 13 taps of this radius
+#define BLUR_RADIUS 2
+
+// vs_comp constants
+#define SKINTONE_ANGLE_DEGREES 123.0f
+#define VS_LINE_THICKNESS 0.004f
+#define VS_BOX_SIZE 0.1f
+#define VS_CIRCLE_RADIUS 0.9f
+#define VS_INTENSITY_SCALE 8.0f
+
+// wf_comp / parade_comp constants
+#define WF_LINE_THICKNESS 0.002f
+#define WF_LINE_COUNT 6
+#define WF_INTENSITY_SCALE 1.25f
+#define WF_HDR_LINE_COUNT 8 // 0, 1, 10, 100, 203 (HDR reference white), 1000, 4000 and 10000 nits
+
+typedef struct float2 {
+    float x, y;
+} float2;
+
+static const float vs_overlay_color[3] = {0.71f * 0.6f, 0.57f * 0.6f, 0.16f * 0.6f};
+static const float wf_overlay_color[3] = {0.71f * 0.5f, 0.57f * 0.5f, 0.16f * 0.5f};
+
+static inline float saturate(float v) {
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+static inline float smoothstep(float edge0, float edge1, float x) {
+    float t = saturate((x - edge0) / (edge1 - edge0));
+    return t * t * (3.0f - 2.0f * t);
+}
+
+static inline float length2(float2 v) {
+    return sqrtf(v.x * v.x + v.y * v.y);
+}
+
+static float line_sdf(float2 p, float2 a, float2 b, float thickness) {
+    float2 pa = {p.x - a.x, p.y - a.y};
+    float2 ba = {b.x - a.x, b.y - a.y};
+    float h = saturate((pa.x * ba.x + pa.y * ba.y) / (ba.x * ba.x + ba.y * ba.y));
+    float2 d = {pa.x - ba.x * h, pa.y - ba.y * h};
+    return length2(d) - thickness * 0.5f;
+}
+
+static float box_sdf(float2 p, float2 center, float size) {
+    float2 d = {fabsf(p.x - center.x) - size * 0.5f, fabsf(p.y - center.y) - size * 0.5f};
+    float2 outside = {MAX(d.x, 0.0f), MAX(d.y, 0.0f)};
+    return length2(outside) + MIN(MAX(d.x, d.y), 0.0f);
+}
+
+// Stores like a UNORM render target does
+static inline void store_rgba(uint8_t *px, float r, float g, float b) {
+    px[0] = (uint8_t)(saturate(r) * 255.0f + 0.5f);
+    px[1] = (uint8_t)(saturate(g) * 255.0f + 0.5f);
+    px[2] = (uint8_t)(saturate(b) * 255.0f + 0.5f);
+    px[3] = 255;
+}
+
+void scope_vectorscope_blur(const scope_vectorscope_t *vs, float *out) {
+    assert(vs && vs->bins);
+    assert(out);
+
+    const int res = (int)vs->resolution;
+    const uint32_t *bins = vs->bins;
+
+    for (int y = 0; y < res; ++y) {
+        // Rows of the diamond, clamped at the edges
+        const uint32_t *rows[2 * BLUR_RADIUS + 1];
+        for (int dy = -BLUR_RADIUS; dy <= BLUR_RADIUS; ++dy) {
+            rows[dy + BLUR_RADIUS] = bins + (size_t)CLAMP(y + dy, 0, res - 1) * res;
+        }
+
+        for (int x = 0; x < res; ++x) {
+            float sum = 0.0f;
+            int count = 0;
+
+            if (x >= BLUR_RADIUS && x < res - BLUR_RADIUS) {
+                // Same taps and summation order as below, without the clamps
+                sum = (float)rows[0][x];
+                sum += (float)rows[1][x - 1];
+                sum += (float)rows[1][x];
+                sum += (float)rows[1][x + 1];
+                sum += (float)rows[2][x - 2];
+                sum += (float)rows[2][x - 1];
+                sum += (float)rows[2][x];
+                sum += (float)rows[2][x + 1];
+                sum += (float)rows[2][x + 2];
+                sum += (float)rows[3][x - 1];
+                sum += (float)rows[3][x];
+                sum += (float)rows[3][x + 1];
+                sum += (float)rows[4][x];
+                count = 13;
+            } else {
+                for (int dy = -BLUR_RADIUS; dy <= BLUR_RADIUS; ++dy) {
+                    const uint32_t *row = rows[dy + BLUR_RADIUS];
+                    for (int dx = -BLUR_RADIUS; dx <= BLUR_RADIUS; ++dx) {
+                        if (ABS(dx) + ABS(dy) > BLUR_RADIUS) continue;
+
+                        sum += (float)row[CLAMP(x + dx, 0, res - 1)];
+                        count++;
+                    }
+                }
+            }
+
+            out[(size_t)y * res + x] = sum / (float)count;
+        }
+    }
+}
+
+// Graticule of vs_comp at p in [-1, 1]^2. Zooming moves the boxes out with the colors, and so does
+// the encoding, the circle and the lines through neutral stay put.
+static float vectorscope_overlay(float2 p, float2 skintone_dir, float zoom, const scope_matrix_weights_t *w) {
+    static const float primaries[6][3] = {
+        {1.0f, 0.0f, 0.0f},
+        {0.0f, 1.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f},
+        {1.0f, 1.0f, 0.0f},
+        {0.0f, 1.0f, 1.0f},
+        {1.0f, 0.0f, 1.0f},
+    };
+
+    const float lt = VS_LINE_THICKNESS;
+
+    // Main circle
+    float circle_dist = fabsf(length2(p) - VS_CIRCLE_RADIUS) - lt * 0.5f;
+    float alpha = 1.0f - smoothstep(lt * 0.2f, lt, circle_dist);
+
+    // Skintone & Q lines
+    float2 origin = {0.0f, 0.0f};
+    float2 skintone_end = {skintone_dir.x * VS_CIRCLE_RADIUS, skintone_dir.y * VS_CIRCLE_RADIUS};
+    float2 q_start = {skintone_dir.y * VS_CIRCLE_RADIUS, -skintone_dir.x * VS_CIRCLE_RADIUS};
+    float2 q_end = {-q_start.x, -q_start.y};
+    float lines = 1.0f - smoothstep(lt * 0.2f, lt, line_sdf(p, origin, skintone_end, lt)) +
+                  1.0f - smoothstep(lt * 0.2f, lt, line_sdf(p, q_start, q_end, lt));
+    alpha = MAX(alpha, lines);
+
+    // Boxes at the primaries and secondaries
+    for (int i = 0; i < 6; ++i) {
+        const float *c = primaries[i];
+        float2 cbcr = {
+            (c[0] * w->cb[0] + c[1] * w->cb[1] + c[2] * w->cb[2]) * 2.0f * SCOPE_VS_SCOPE_SCALE * zoom,
+            (c[0] * w->cr[0] + c[1] * w->cr[1] + c[2] * w->cr[2]) * 2.0f * SCOPE_VS_SCOPE_SCALE * zoom,
+        };
+
+        // The outer box distance bounds box_dist from below, past lt the box adds nothing
+        if (MAX(fabsf(p.x - cbcr.x), fabsf(p.y - cbcr.y)) - VS_BOX_SIZE * 0.5f >= lt) continue;
+
+        float outer = box_sdf(p, cbcr, VS_BOX_SIZE);
+        float inner = box_sdf(p, cbcr, VS_BOX_SIZE - lt * 2.0f);
+        float box_dist = MAX(outer, -inner);
+        alpha = MAX(alpha, 1.0f - smoothstep(-lt * 0.1f, lt, box_dist));
+    }
+
+    return saturate(alpha);
+}
+
+void scope_render_vectorscope(const float *blurred, uint32_t resolution, uint32_t zoom, scope_encoding_t encoding, uint8_t *rgba, uint32_t width, uint32_t height) {
+    assert(blurred && rgba);
+
+    const float side = (float)MIN(width, height);
+    const float2 square_min = {(float)width * 0.5f - side * 0.5f, (float)height * 0.5f - side * 0.5f};
+    // Same as vs_comp, the maximum is tied to the accumulator resolution
+    const float log_max = logf(1.0f + (float)resolution * (float)resolution);
+    const float angle = SKINTONE_ANGLE_DEGREES * 3.14159265358979f / 180.0f;
+    const float2 skintone_dir = {cosf(angle), sinf(angle)};
+    const scope_matrix_weights_t weights = scope_encoding_weights(encoding);
+    const scope_ycbcr_inverse_t inverse = scope_ycbcr_inverse(encoding.matrix);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t *px = rgba + (size_t)y * width * 4;
+
+        for (uint32_t x = 0; x < width; ++x, px += 4) {
+            float2 square_uv = {((float)x - square_min.x) / side, ((float)y - square_min.y) / side};
+            if (square_uv.x < 0.0f || square_uv.x >= 1.0f || square_uv.y < 0.0f || square_uv.y >= 1.0f) {
+                store_rgba(px, 0.0f, 0.0f, 0.0f);
+                continue;
+            }
+
+            float2 p = {square_uv.x * 2.0f - 1.0f, square_uv.y * 2.0f - 1.0f};
+            float overlay = vectorscope_overlay(p, skintone_dir, (float)zoom, &weights);
+
+            // Out of range loads return 0 on the GPU
+            int tx = (int)(((square_uv.x - 0.5f) / SCOPE_VS_SCOPE_SCALE + 0.5f) * (float)resolution);
+            int ty = (int)(((square_uv.y - 0.5f) / SCOPE_VS_SCOPE_SCALE + 0.5f) * (float)resolution);
+            float v = 0.0f;
+            if (tx >= 0 && tx < (int)resolution && ty >= 0 && ty < (int)resolution) {
+                v = blurred[(size_t)ty * resolution + tx];
+            }
+            float intensity = v == 0.0f ? 0.0f : logf(1.0f + v) / log_max * VS_INTENSITY_SCALE;
+
+            // Y = 0.5 with the Cb/Cr of this position, through the matrix of the encoding. They are
+            // mapped like the bins and boxes, so a zoomed plane shows the Cb/Cr of the trace over it.
+            float cb = (square_uv.x - 0.5f) / (SCOPE_VS_SCOPE_SCALE * (float)zoom);
+            float cr = (square_uv.y - 0.5f) / (SCOPE_VS_SCOPE_SCALE * (float)zoom);
+            float r = saturate(0.5f + inverse.r_cr * cr);
+            float g = saturate(0.5f - inverse.g_cb * cb - inverse.g_cr * cr);
+            float b = saturate(0.5f + inverse.b_cb * cb);
+
+            store_rgba(px,
+                       r * intensity + overlay * vs_overlay_color[0],
+                       g * intensity + overlay * vs_overlay_color[1],
+                       b * intensity + overlay * vs_overlay_color[2]);
+        }
+    }
+}
+
+// Bucket and column shown by row y and column x of a composite `height` rows high and `width`
+// columns wide, like parade_comp samples them. Composites as big as the planes show them 1:1.
+static inline uint32_t waveform_row(const scope_waveform_t *wf, uint32_t y, uint32_t height) {
+    return MIN((uint32_t)(((float)y + 0.5f) * ((float)wf->buckets / (float)height)), wf->buckets - 1);
+}
+
+static inline uint32_t waveform_column(const scope_waveform_t *wf, uint32_t x, uint32_t width) {
+    return MIN((uint32_t)(((float)x + 0.5f) * ((float)wf->width / (float)width)), wf->width - 1);
+}
+
+// Level lines of wf_comp at height v in [0, 1]. On an HDR axis they sit at fixed light levels
+// instead, so the waveform reads in nits.
+static float waveform_overlay(const scope_waveform_t *wf, float v) {
+    static const float hdr_nits[WF_HDR_LINE_COUNT] = {0.0f, 1.0f, 10.0f, 100.0f, 203.0f, 1000.0f, 4000.0f, 10000.0f};
+
+    const bool hdr = wf->axis == SCOPE_TRANSFER_PQ || wf->axis == SCOPE_TRANSFER_HLG;
+    const uint32_t count = hdr ? WF_HDR_LINE_COUNT : WF_LINE_COUNT;
+
+    float overlay = 0.0f;
+    for (uint32_t i = 0; i < count; ++i) {
+        float level = hdr ? scope_transfer_signal(wf->axis, hdr_nits[i]) : (float)i / WF_LINE_COUNT;
+        float dist = fabsf(v - level) - WF_LINE_THICKNESS * 0.5f;
+        overlay = MAX(overlay, 1.0f - smoothstep(WF_LINE_THICKNESS * 0.2f, WF_LINE_THICKNESS, dist));
+    }
+    return overlay;
+}
+
+void scope_render_waveform(const scope_waveform_t *wf, uint8_t *rgba, uint32_t width, uint32_t height) {
+    assert(wf && wf->channels[0]);
+    assert(rgba);
+
+    const float log_max = logf(1.0f + (float)wf->buckets);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t *px = rgba + (size_t)y * width * 4;
+
+        // The level lines span the whole width, so their distance only depends on the row
+        float overlay = waveform_overlay(wf, (float)y / (float)height);
+        uint32_t in_y = waveform_row(wf, y, height);
+
+        for (uint32_t x = 0; x < width; ++x, px += 4) {
+            size_t index = (size_t)in_y * wf->width + waveform_column(wf, x, width);
+            float channel[3];
+            for (uint32_t c = 0; c < 3; ++c) {
+                uint32_t count = wf->channels[c][index];
+                channel[c] = count == 0 ? 0.0f : logf(1.0f + (float)count) / log_max * WF_INTENSITY_SCALE;
+            }
+
+            store_rgba(px,
+                       channel[0] + overlay * wf_overlay_color[0],
+                       channel[1] + overlay * wf_overlay_color[1],
+                       channel[2] + overlay * wf_overlay_color[2]);
+        }
+    }
+}
+
+void scope_render_luma(const scope_waveform_t *wf, uint8_t *rgba, uint32_t width, uint32_t height) {
+    assert(wf && wf->channels[0]);
+    assert(rgba);
+
+    const float log_max = logf(1.0f + (float)wf->buckets);
+    const uint32_t *luma = wf->channels[SCOPE_WF_CHANNEL_LUMA];
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t *px = rgba + (size_t)y * width * 4;
+
+        float overlay = waveform_overlay(wf, (float)y / (float)height);
+        uint32_t in_y = waveform_row(wf, y, height);
+
+        for (uint32_t x = 0; x < width; ++x, px += 4) {
+            uint32_t count = luma[(size_t)in_y * wf->width + waveform_column(wf, x, width)];
+            float intensity = count == 0 ? 0.0f : logf(1.0f + (float)count) / log_max * WF_INTENSITY_SCALE;
+            store_rgba(px,
+                       intensity + overlay * wf_overlay_color[0],
+                       intensity + overlay * wf_overlay_color[1],
+                       intensity + overlay * wf_overlay_color[2]);
+        }
+    }
+}
+
+void scope_render_parade(const scope_waveform_t *wf, uint8_t *rgba, uint32_t width, uint32_t height) {
+    assert(wf && wf->channels[0]);
+    assert(rgba);
+
+    const uint32_t channel_width = width / 3;
+    const float log_max = logf(1.0f + (float)wf->buckets);
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t *px = rgba + (size_t)y * width * 4;
+        uint32_t in_y = waveform_row(wf, y, height);
+
+        for (uint32_t x = 0; x < width; ++x, px += 4) {
+            // The leftover columns past 3 * channel_width belong to blue, like in parade_comp
+            uint32_t channel = MIN(x / channel_width, 2u);
+            uint32_t local_x = x % channel_width;
+            uint32_t in_x = waveform_column(wf, local_x, channel_width);
+
+            uint32_t count = wf->channels[channel][(size_t)in_y * wf->width + in_x];
+            float intensity = count == 0 ? 0.0f : logf(1.0f + (float)count) / log_max * WF_INTENSITY_SCALE;
+            store_rgba(px,
+                       channel == 0 ? intensity : 0.0f,
+                       channel == 1 ? intensity : 0.0f,
+                       channel == 2 ? intensity : 0.0f);
+        }
+    }
+}
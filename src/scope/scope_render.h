@@ -0,0 +1,33 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_vectorscope.h"
+#include "scope_waveform.h"
+
+// CPU versions of the display passes (vs_blur + vs_comp, wf_comp, parade_comp). They produce the
+// same images the app shows, as tightly packed RGBA8, including orientation and overlays.
+
+// Composite texture sizes used by the app
+#define SCOPE_VS_COMPOSITE_WIDTH 1024
+#define SCOPE_VS_COMPOSITE_HEIGHT 576
+#define SCOPE_WF_COMPOSITE_WIDTH 1024
+#define SCOPE_WF_COMPOSITE_HEIGHT 512
+
+// Part of the side of the composite square the bins span at every zoom, scope_scale of vs_comp
+#define SCOPE_VS_SCOPE_SCALE 0.6f
+
+/* @brief 13-tap diamond average of the bins (radius 2, clamped at the edges), like vs_blur with
+ * the blur the app starts out with. `out` holds resolution x resolution floats.
+ * scope_blur_apply() blurs at other radii and shapes. */
+void scope_vectorscope_blur(const scope_vectorscope_t *vs, float *out);
+
+/* @brief Log-scaled, Cb/Cr colored vectorscope with the graticule overlay, like vs_comp. `zoom` and
+ * `encoding` are the ones the bins were accumulated with (scope_vectorscope_t), they place the boxes
+ * and the matrix colors the plane. */
+void scope_render_vectorscope(const float *blurred, uint32_t resolution, uint32_t zoom, scope_encoding_t encoding, uint8_t *rgba, uint32_t width, uint32_t height);
+/* @brief R, G and B planes on top of each other with the level lines, like wf_comp. */
+void scope_render_waveform(const scope_waveform_t *wf, uint8_t *rgba, uint32_t width, uint32_t height);
+/* @brief The luma plane in white with the level lines, for Y'CbCr frames whose R, G and B planes are empty. */
+void scope_render_luma(const scope_waveform_t *wf, uint8_t *rgba, uint32_t width, uint32_t height);
+/* @brief R, G and B planes side by side, like parade_comp. */
+void scope_render_parade(const scope_waveform_t *wf, uint8_t *rgba, uint32_t width, uint32_t height);
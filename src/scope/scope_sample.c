@@ -0,0 +1,119 @@
+#include "scope_sample.h"
+
+#include "scope_internal.h"
+
+#include <assert.h>
+#include <math.h>
+
+// Number of frames after which the Halton sequence starts over
+#define HALTON_FRAME_PERIOD 16
+
+// Van der Corput radical inverse, in double so indices past 2^24 keep their digits. Base 2 is
+// an exact bit reversal.
+static double radical_inverse(uint64_t index, uint32_t base) {
+    if (base == 2) {
+        uint64_t reversed = 0;
+        for (uint32_t bit = 0; bit < 64; ++bit, index >>= 1) {
+            reversed = (reversed << 1) | (index & 1);
+        }
+        // The top 53 bits, exactly representable
+        return (double)(reversed >> 11) / 9007199254740992.0;
+    }
+
+    double inv_base = 1.0 / (double)base;
+    double factor = inv_base;
+    double result = 0.0;
+    while (index > 0) {
+        result += (double)(index % base) * factor;
+        index /= base;
+        factor *= inv_base;
+    }
+    return result;
+}
+
+scope_sample_plan_t scope_sample_plan(const scope_sampling_t *sampling, uint32_t width, uint32_t height) {
+    assert(sampling);
+
+    uint64_t pixel_count = (uint64_t)width * height;
+    scope_sample_plan_t plan = {
+        .pattern = sampling->pattern,
+        .width = width,
+        .height = height,
+        .count = (uint32_t)pixel_count,
+        .weight = 1,
+        .cell_size = 1,
+        .cells_x = width,
+        .seed = scope_hash32(sampling->frame_index),
+    };
+
+    if (sampling->budget == 0 || pixel_count <= sampling->budget) {
+        // Everything fits, a 1x1 grid visits every pixel exactly once
+        plan.pattern = SCOPE_SAMPLE_STRATIFIED;
+        return plan;
+    }
+
+    // Square cells with at least pixel_count / budget pixels each, so the budget is never exceeded
+    uint32_t cell_size = (uint32_t)ceil(sqrt((double)pixel_count / sampling->budget));
+    while ((uint64_t)((width + cell_size - 1) / cell_size) * ((height + cell_size - 1) / cell_size) > sampling->budget) {
+        cell_size++;
+    }
+
+    if (plan.pattern == SCOPE_SAMPLE_STRATIFIED) {
+        plan.cell_size = cell_size;
+        plan.cells_x = (width + cell_size - 1) / cell_size;
+        plan.count = plan.cells_x * ((height + cell_size - 1) / cell_size);
+    } else {
+        // Continue the sequence across frames, so consecutive frames fill each other's gaps
+        plan.count = sampling->budget;
+        plan.sequence_offset = (uint64_t)(sampling->frame_index % HALTON_FRAME_PERIOD) * plan.count;
+    }
+
+    // Rounded, so the weighted total of Halton samples stays within half a sample's worth of the
+    // pixel count. Stratified samples of clipped cells weigh less, see scope_sample_position().
+    plan.weight = (uint32_t)((pixel_count + plan.count / 2) / plan.count);
+    return plan;
+}
+
+uint32_t scope_sample_position(const scope_sample_plan_t *plan, uint32_t index, uint32_t *x, uint32_t *y) {
+    if (plan->pattern == SCOPE_SAMPLE_HALTON) {
+        uint64_t n = plan->sequence_offset + index + 1;
+        *x = (uint32_t)(radical_inverse(n, 2) * (double)plan->width);
+        *y = (uint32_t)(radical_inverse(n, 3) * (double)plan->height);
+        if (*x >= plan->width) *x = plan->width - 1;
+        if (*y >= plan->height) *y = plan->height - 1;
+        return plan->weight;
+    }
+
+    uint32_t cell_x = index % plan->cells_x;
+    uint32_t cell_y = index / plan->cells_x;
+    uint32_t x0 = cell_x * plan->cell_size;
+    uint32_t y0 = cell_y * plan->cell_size;
+
+    if (plan->cell_size == 1) {
+        *x = x0;
+        *y = y0;
+        return 1;
+    }
+
+    // Jitter inside the cell, clipped cells at the right/bottom edge only jitter over what's left
+    // and stand for only the pixels they cover
+    uint32_t h = scope_hash32(index ^ plan->seed);
+    uint32_t span_x = plan->width - x0 < plan->cell_size ? plan->width - x0 : plan->cell_size;
+    uint32_t span_y = plan->height - y0 < plan->cell_size ? plan->height - y0 : plan->cell_size;
+    *x = x0 + (h & 0xFFFF) % span_x;
+    *y = y0 + (h >> 16) % span_y;
+    return span_x * span_y;
+}
+
+double scope_histogram_error(const uint32_t *reference, const uint32_t *estimate, size_t count) {
+    assert(reference && estimate);
+
+    double diff = 0.0;
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        diff += fabs((double)estimate[i] - (double)reference[i]);
+        total += reference[i];
+    }
+
+    return total > 0.0 ? diff / total : 0.0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "scope.h"
+
+// Budgeted sampling: instead of binning every pixel, the accumulators visit at most `budget`
+// pixels and add each of them with a weight equal to the number of pixels it stands for. The
+// totals in the bins stay close to the full resolution ones, so the log normalization in
+// vs_comp/wf_comp looks the same no matter the budget.
+
+typedef enum scope_sample_pattern {
+    SCOPE_SAMPLE_STRATIFIED, // one jittered sample per cell of a regular grid
+    SCOPE_SAMPLE_HALTON,     // Halton (2, 3) low discrepancy points
+} scope_sample_pattern_t;
+
+typedef struct scope_sampling {
+    uint32_t budget; // maximum pixels per frame, 0 visits every pixel
+    scope_sample_pattern_t pattern;
+    uint32_t frame_index; // changes the sample positions from frame to frame
+} scope_sampling_t;
+
+// Resolved sampling for one frame size
+typedef struct scope_sample_plan {
+    scope_sample_pattern_t pattern;
+    uint32_t width;
+    uint32_t height;
+    uint32_t count;  // number of samples
+    uint32_t weight; // pixels each sample stands for, except stratified ones in clipped cells
+
+    // Stratified grid
+    uint32_t cell_size;
+    uint32_t cells_x;
+
+    uint32_t seed;
+    uint64_t sequence_offset; // Halton index of the first sample
+} scope_sample_plan_t;
+
+scope_sample_plan_t scope_sample_plan(const scope_sampling_t *sampling, uint32_t width, uint32_t height);
+/* @brief Position of sample `index` of the plan. Stratified samples come in row-major cell order.
+ * Returns the number of pixels the sample stands for: the area of its cell, clipped to the frame,
+ * so stratified weights add up to exactly the pixel count. */
+uint32_t scope_sample_position(const scope_sample_plan_t *plan, uint32_t index, uint32_t *x, uint32_t *y);
+
+/* @brief Normalized L1 distance between two histograms: sum(|estimate - reference|) / sum(reference).
+ * 0 is a perfect match, 2 means no overlap at all. */
+double scope_histogram_error(const uint32_t *reference, const uint32_t *estimate, size_t count);
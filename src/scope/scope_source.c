@@ -0,0 +1,312 @@
+#include "scope_source.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+scope_acquire_result_t scope_source_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    assert(source && frame);
+    assert(!source->acquired && "Release the previous frame first");
+
+    scope_acquire_result_t result = source->interface.acquire(source, timeout_ms, frame);
+    source->acquired = result == SCOPE_ACQUIRE_OK;
+    return result;
+}
+
+void scope_source_release(scope_source_t *source) {
+    assert(source);
+
+    if (source->acquired) {
+        source->interface.release(source);
+        source->acquired = false;
+    }
+}
+
+void scope_source_destroy(scope_source_t *source) {
+    if (source) {
+        scope_source_release(source);
+        source->interface.destroy(source);
+    }
+}
+
+static void release_nothing(scope_source_t *source) {
+    (void)source;
+}
+
+// ==========================================================
+// MEMORY
+// ==========================================================
+typedef struct memory_source {
+    scope_source_t base;
+
+    const scope_image_t *frames;
+    uint32_t frame_count;
+    uint32_t repeat_count;
+    double frame_rate;
+
+    uint64_t generation;
+    scope_rect_t full;
+} memory_source_t;
+
+static scope_acquire_result_t memory_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    (void)timeout_ms;
+    memory_source_t *impl = (memory_source_t *)source;
+
+    if (impl->repeat_count > 0 && impl->generation >= (uint64_t)impl->frame_count * impl->repeat_count) {
+        return SCOPE_ACQUIRE_END;
+    }
+
+    const scope_image_t *image = &impl->frames[impl->generation % impl->frame_count];
+    impl->full = (scope_rect_t){0, 0, image->width, image->height};
+
+    *frame = (scope_frame_t){
+        .image = *image,
+        .dirty = &impl->full,
+        .dirty_count = 1,
+        .timestamp = (double)impl->generation / impl->frame_rate,
+    };
+    frame->image.generation = ++impl->generation;
+    return SCOPE_ACQUIRE_OK;
+}
+
+static void memory_destroy(scope_source_t *source) {
+    free(source);
+}
+
+bool scope_source_memory_create(const scope_image_t *frames, uint32_t frame_count, uint32_t repeat_count,
+                                double frame_rate, scope_source_t **source) {
+    assert(frames && frame_count > 0 && frame_rate > 0.0 && source);
+
+    memory_source_t *impl = malloc(sizeof(memory_source_t));
+    if (!impl) return false;
+
+    *impl = (memory_source_t){
+        .base = {
+            .name = "memory",
+            .interface = {memory_acquire, release_nothing, memory_destroy},
+        },
+        .frames = frames,
+        .frame_count = frame_count,
+        .repeat_count = repeat_count,
+        .frame_rate = frame_rate,
+    };
+
+    *source = &impl->base;
+    return true;
+}
+
+// ==========================================================
+// SYNTHETIC
+// ==========================================================
+typedef struct synthetic_source {
+    scope_source_t base;
+    scope_synthetic_source_t synthetic;
+    uint32_t frame_count;
+    double frame_rate;
+} synthetic_source_t;
+
+static scope_acquire_result_t synthetic_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    (void)timeout_ms;
+    synthetic_source_t *impl = (synthetic_source_t *)source;
+    scope_synthetic_source_t *synthetic = &impl->synthetic;
+
+    // frame_index + 1 wraps to 0 before the first frame
+    if (impl->frame_count > 0 && synthetic->frame_index + 1 >= impl->frame_count) {
+        return SCOPE_ACQUIRE_END;
+    }
+    if (!scope_synthetic_next(synthetic)) {
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    *frame = (scope_frame_t){
+        .image = synthetic->image,
+        .dirty = synthetic->dirty,
+        .dirty_count = synthetic->dirty_count,
+        .timestamp = (double)synthetic->frame_index / impl->frame_rate,
+    };
+    return SCOPE_ACQUIRE_OK;
+}
+
+static void synthetic_destroy(scope_source_t *source) {
+    synthetic_source_t *impl = (synthetic_source_t *)source;
+    scope_synthetic_destroy(&impl->synthetic);
+    free(impl);
+}
+
+bool scope_source_synthetic_create(uint32_t width, uint32_t height, scope_pixel_format_t format,
+                                   const scope_synthetic_change_t *script, uint32_t script_length, uint32_t script_period,
+                                   uint32_t frame_count, double frame_rate, scope_source_t **source) {
+    assert(frame_rate > 0.0 && source);
+
+    synthetic_source_t *impl = malloc(sizeof(synthetic_source_t));
+    if (!impl) return false;
+
+    *impl = (synthetic_source_t){
+        .base = {
+            .name = "synthetic",
+            .interface = {synthetic_acquire, release_nothing, synthetic_destroy},
+        },
+        .frame_count = frame_count,
+        .frame_rate = frame_rate,
+    };
+
+    if (!scope_synthetic_create(&impl->synthetic, width, height, format, script, script_length, script_period)) {
+        synthetic_destroy(&impl->base);
+        return false;
+    }
+
+    *source = &impl->base;
+    return true;
+}
+
+// ==========================================================
+// PYRAMID
+// ==========================================================
+typedef struct pyramid_source {
+    scope_source_t base;
+    scope_source_t *inner;
+    scope_pyramid_t pyramid;
+    uint32_t level;
+    scope_thread_pool_t *pool;
+
+    scope_rect_t *dirty; // of the level handed out
+    uint32_t dirty_capacity;
+} pyramid_source_t;
+
+static scope_acquire_result_t pyramid_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    pyramid_source_t *impl = (pyramid_source_t *)source;
+
+    scope_acquire_result_t result = scope_source_acquire(impl->inner, timeout_ms, frame);
+    if (result != SCOPE_ACQUIRE_OK || !scope_pixel_format_is_rgb8(frame->image.format)) {
+        return result;
+    }
+
+    if (frame->dirty_count > impl->dirty_capacity) {
+        scope_rect_t *dirty = realloc(impl->dirty, frame->dirty_count * sizeof(scope_rect_t));
+        if (!dirty) {
+            scope_source_release(impl->inner);
+            return SCOPE_ACQUIRE_ERROR;
+        }
+        impl->dirty = dirty;
+        impl->dirty_capacity = frame->dirty_count;
+    }
+
+    // The inner frame stays acquired, level 0 may be its pixels
+    if (!scope_pyramid_update(&impl->pyramid, &frame->image, impl->pool)) {
+        scope_source_release(impl->inner);
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    uint32_t dirty_count = 0;
+    for (uint32_t i = 0; i < frame->dirty_count; ++i) {
+        if (scope_pyramid_map_rect(&impl->pyramid, impl->level, &frame->dirty[i], &impl->dirty[dirty_count])) {
+            dirty_count++;
+        }
+    }
+
+    frame->image = *scope_pyramid_level(&impl->pyramid, impl->level);
+    frame->dirty = impl->dirty;
+    frame->dirty_count = dirty_count;
+    return SCOPE_ACQUIRE_OK;
+}
+
+static void pyramid_release(scope_source_t *source) {
+    pyramid_source_t *impl = (pyramid_source_t *)source;
+    scope_source_release(impl->inner);
+}
+
+static void pyramid_destroy(scope_source_t *source) {
+    pyramid_source_t *impl = (pyramid_source_t *)source;
+    scope_source_destroy(impl->inner);
+    scope_pyramid_destroy(&impl->pyramid);
+    free(impl->dirty);
+    free(impl);
+}
+
+bool scope_source_pyramid_create(scope_source_t *inner, uint32_t width, uint32_t height, uint32_t level,
+                                 scope_thread_pool_t *pool, scope_source_t **source) {
+    assert(inner && source);
+    assert(level < SCOPE_PYRAMID_MAX_LEVELS);
+
+    pyramid_source_t *impl = malloc(sizeof(pyramid_source_t));
+    if (!impl) {
+        scope_source_destroy(inner);
+        return false;
+    }
+
+    *impl = (pyramid_source_t){
+        .base = {
+            .name = "pyramid",
+            .interface = {pyramid_acquire, pyramid_release, pyramid_destroy},
+        },
+        .inner = inner,
+        .level = level,
+        .pool = pool,
+    };
+    scope_pyramid_create(&impl->pyramid, width, height, level + 1);
+
+    *source = &impl->base;
+    return true;
+}
+
+// ==========================================================
+// TILES
+// ==========================================================
+typedef struct tiles_source {
+    scope_source_t base;
+    scope_source_t *inner;
+    scope_tiles_t tiles;
+    scope_thread_pool_t *pool;
+} tiles_source_t;
+
+static scope_acquire_result_t tiles_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    tiles_source_t *impl = (tiles_source_t *)source;
+
+    scope_acquire_result_t result = scope_source_acquire(impl->inner, timeout_ms, frame);
+    if (result != SCOPE_ACQUIRE_OK || !scope_pixel_format_is_rgb8(frame->image.format)) {
+        return result;
+    }
+
+    if (!scope_tiles_update(&impl->tiles, &frame->image, impl->pool)) {
+        scope_source_release(impl->inner);
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    frame->dirty = impl->tiles.rects;
+    frame->dirty_count = impl->tiles.rect_count;
+    return SCOPE_ACQUIRE_OK;
+}
+
+static void tiles_release(scope_source_t *source) {
+    tiles_source_t *impl = (tiles_source_t *)source;
+    scope_source_release(impl->inner);
+}
+
+static void tiles_destroy(scope_source_t *source) {
+    tiles_source_t *impl = (tiles_source_t *)source;
+    scope_source_destroy(impl->inner);
+    scope_tiles_destroy(&impl->tiles);
+    free(impl);
+}
+
+bool scope_source_tiles_create(scope_source_t *inner, scope_thread_pool_t *pool, scope_source_t **source) {
+    assert(inner && source);
+
+    tiles_source_t *impl = malloc(sizeof(tiles_source_t));
+    if (!impl) {
+        scope_source_destroy(inner);
+        return false;
+    }
+
+    *impl = (tiles_source_t){
+        .base = {
+            .name = "tiles",
+            .interface = {tiles_acquire, tiles_release, tiles_destroy},
+        },
+        .inner = inner,
+        .pool = pool,
+    };
+    scope_tiles_create(&impl->tiles);
+
+    *source = &impl->base;
+    return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_pyramid.h"
+#include "scope_synthetic.h"
+#include "scope_tiles.h"
+#include "scope_thread.h"
+
+// Pluggable producers of frames for the scopes. A frame is acquired, analyzed in place and
+// released again, like IDXGIOutputDuplication::AcquireNextFrame/ReleaseFrame, so backends can
+// hand out pointers into their own buffers (mapped textures, decoded files, shared memory).
+// Backends embed scope_source_t as their first member and fill in the interface, like the vri
+// devices do.
+
+typedef enum scope_acquire_result {
+    SCOPE_ACQUIRE_OK,      // `frame` holds a new frame until it is released
+    SCOPE_ACQUIRE_TIMEOUT, // no new frame within the timeout, the previous one is still current
+    SCOPE_ACQUIRE_END,     // the source has no more frames
+    SCOPE_ACQUIRE_ERROR,   // this frame failed, later acquires may still succeed or return END
+} scope_acquire_result_t;
+
+typedef struct scope_frame {
+    scope_image_t image; // generation counts the frames of the source, starting at 1
+
+    // Regions that changed since the previous frame, none if only the timestamp moved. The first
+    // frame of a source covers the whole image. Owned by the source.
+    const scope_rect_t *dirty;
+    uint32_t dirty_count;
+
+    double timestamp; // seconds, presentation time for files and capture time for live sources
+} scope_frame_t;
+
+typedef struct scope_source scope_source_t;
+
+typedef struct scope_source_interface {
+    scope_acquire_result_t (*acquire)(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame);
+    void (*release)(scope_source_t *source);
+    void (*destroy)(scope_source_t *source);
+} scope_source_interface_t;
+
+/* @brief Base type of every frame source */
+struct scope_source {
+    const char *name;
+    scope_source_interface_t interface;
+    bool acquired;
+};
+
+/* @brief Waits up to `timeout_ms` for the next frame. Sources that produce frames on demand
+ * (memory, files, synthetic) never time out and return immediately. Release the previous frame
+ * before acquiring the next one. */
+scope_acquire_result_t scope_source_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame);
+/* @brief Hands the acquired frame back, its pixels and dirty rects are invalid afterwards. */
+void scope_source_release(scope_source_t *source);
+/* @brief Releases a frame that is still acquired and frees the source. Accepts NULL. */
+void scope_source_destroy(scope_source_t *source);
+
+/* @brief Cycles through caller owned frames, e.g. to benchmark the analysis at maximum rate.
+ * The frames are not copied and have to outlive the source. Every frame is reported as fully
+ * dirty. Plays the frames `repeat_count` times, 0 repeats forever. */
+bool scope_source_memory_create(const scope_image_t *frames, uint32_t frame_count, uint32_t repeat_count,
+                                double frame_rate, scope_source_t **source);
+
+/* @brief Plays a scope_synthetic script (see scope_synthetic.h) for `frame_count` frames, 0 plays
+ * forever. Dirty rects are the ones the script touched. */
+bool scope_source_synthetic_create(uint32_t width, uint32_t height, scope_pixel_format_t format,
+                                   const scope_synthetic_change_t *script, uint32_t script_length, uint32_t script_period,
+                                   uint32_t frame_count, double frame_rate, scope_source_t **source);
+
+/* @brief Hands out the frames of `inner` reduced to level `level` of a scope_pyramid whose level 0
+ * fits in `width` x `height` (see scope_pyramid.h), with the dirty rects mapped onto that level.
+ * The scopes then cost the same whatever the size of the frames. Y'CbCr and HDR frames pass
+ * through as they are. Takes ownership of `inner`, which is destroyed with the source or if
+ * creation fails.
+ * `pool` may be NULL. */
+bool scope_source_pyramid_create(scope_source_t *inner, uint32_t width, uint32_t height, uint32_t level,
+                                 scope_thread_pool_t *pool, scope_source_t **source);
+
+/* @brief Hands out the frames of `inner` with dirty rects found by hashing tiles of the pixels
+ * (see scope_tiles.h) instead of the ones `inner` reports, so unchanged frames come with none and
+ * incremental updates work for any source. Y'CbCr and HDR frames pass through as they are. Takes
+ * ownership of `inner`, which is destroyed with the source or if creation fails. */
+bool scope_source_tiles_create(scope_source_t *inner, scope_thread_pool_t *pool, scope_source_t **source);
+
+typedef struct scope_async_stats {
+    uint64_t captured; // frames the producer published
+    uint64_t dropped;  // published frames replaced by a newer one before they were acquired
+    uint64_t failed;   // frames the producer couldn't copy, or errors of `inner`
+    uint64_t scoped;   // frames acquired and released again
+
+    // Seconds from `inner` handing out a frame to the consumer releasing it, i.e. capture to
+    // scoped, queueing and the copy included
+    double latency_last;
+    double latency_mean;
+    double latency_max;
+} scope_async_stats_t;
+
+/* @brief Runs `inner` on a producer thread of its own. Every frame is copied into a lock-free
+ * triple buffer (see scope_triple.h) and `inner` released right away. Acquires never block on
+ * `inner`: they return the newest frame published since the last acquire, waiting at most
+ * `timeout_ms` (in 1 ms steps) for one, and frames that were overtaken are dropped. Dirty rects
+ * include the ones of dropped frames. Takes ownership of `inner`, which is destroyed with the
+ * source or if creation fails. `inner` must be usable from another thread. */
+bool scope_source_async_create(scope_source_t *inner, scope_source_t **source);
+/* @brief Counters and latencies of a source made by scope_source_async_create(). */
+void scope_source_async_stats(const scope_source_t *source, scope_async_stats_t *stats);
+
+typedef struct scope_file_desc {
+    // Headerless video only, Y4M files describe themselves
+    uint32_t width;
+    uint32_t height;
+    scope_pixel_format_t format; // packed RGB
+    scope_transfer_t transfer;   // HDR formats only
+    double frame_rate;
+
+    bool realtime; // hand out frames at their timestamps instead of as fast as possible
+} scope_file_desc_t;
+
+/* @brief Replays a video file straight from a read-only memory mapping: frames point into the
+ * mapping, nothing is copied. Files starting with "YUV4MPEG2 " are Y4M, handed out as planar
+ * Y'CbCr frames (limited range unless tagged XCOLORRANGE=FULL, monochrome is rejected). Anything else is
+ * headerless video of back to back frames of width * 4 bytes per row (8 for RGBA16F), as written
+ * by e.g. `ffmpeg -f rawvideo -pix_fmt bgra`, `rgbaf16le` or `x2bgr10le`. A trailing partial
+ * frame is ignored. */
+bool scope_source_file_create(const char *path, const scope_file_desc_t *desc, scope_source_t **source);
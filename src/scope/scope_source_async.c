@@ -0,0 +1,280 @@
+#include "scope_source.h"
+
+#include "scope_cpu.h"
+#include "scope_internal.h"
+#include "scope_triple.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The producer checks for shutdown at least this often while `inner` has nothing new
+#define PRODUCER_TIMEOUT_MS 20
+
+// Dirty rects carried over from dropped frames are merged into one full frame rect past this
+#define MAX_PENDING_RECTS 256
+
+typedef struct async_slot {
+    uint8_t *pixels;
+    size_t capacity;
+    scope_image_t image;
+
+    scope_rect_t *dirty;
+    uint32_t dirty_count;
+    uint32_t dirty_capacity;
+
+    double timestamp;
+    double captured_at; // scope_cpu_time_seconds() when `inner` handed out the frame
+} async_slot_t;
+
+typedef struct async_source {
+    scope_source_t base;
+    scope_source_t *inner;
+    scope_thread_t *producer;
+
+    async_slot_t slots[3];
+    scope_triple_t triple;
+
+    // Producer only: rects that changed since the last frame the consumer is known to have seen
+    scope_rect_t *pending;
+    uint32_t pending_count;
+    uint32_t pending_capacity;
+    uint64_t published_generation;
+
+    // Shared
+    volatile uint32_t quit;
+    volatile uint32_t ended;
+    volatile uint64_t consumed_generation;
+    volatile uint64_t captured;
+    volatile uint64_t dropped;
+    volatile uint64_t failed;
+
+    // Consumer only
+    uint64_t scoped;
+    double latency_last;
+    double latency_sum;
+    double latency_max;
+} async_source_t;
+
+static void producer_main(void *user_data);
+static bool copy_image(async_slot_t *slot, const scope_image_t *image);
+static bool merge_dirty(async_source_t *impl, async_slot_t *slot, const scope_frame_t *frame);
+static bool reserve_rects(scope_rect_t **rects, uint32_t *capacity, uint32_t count);
+
+static scope_acquire_result_t async_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    async_source_t *impl = (async_source_t *)source;
+
+    for (uint32_t waited = 0; !scope_triple_fetch(&impl->triple); ++waited) {
+        // The producer publishes its last frame before it ends
+        if (scope_atomic_load(&impl->ended)) {
+            if (scope_triple_fetch(&impl->triple)) break;
+            return SCOPE_ACQUIRE_END;
+        }
+        if (waited >= timeout_ms) {
+            return SCOPE_ACQUIRE_TIMEOUT;
+        }
+        scope_thread_sleep_ms(1);
+    }
+
+    const async_slot_t *slot = &impl->slots[impl->triple.front];
+    scope_atomic_store64(&impl->consumed_generation, slot->image.generation);
+
+    *frame = (scope_frame_t){
+        .image = slot->image,
+        .dirty = slot->dirty,
+        .dirty_count = slot->dirty_count,
+        .timestamp = slot->timestamp,
+    };
+    return SCOPE_ACQUIRE_OK;
+}
+
+static void async_release(scope_source_t *source) {
+    async_source_t *impl = (async_source_t *)source;
+
+    double latency = scope_cpu_time_seconds() - impl->slots[impl->triple.front].captured_at;
+    impl->scoped++;
+    impl->latency_last = latency;
+    impl->latency_sum += latency;
+    impl->latency_max = MAX(impl->latency_max, latency);
+}
+
+static void async_destroy(scope_source_t *source) {
+    async_source_t *impl = (async_source_t *)source;
+
+    scope_atomic_store(&impl->quit, 1);
+    scope_thread_join(impl->producer);
+    scope_source_destroy(impl->inner);
+
+    for (uint32_t i = 0; i < ARRAY_LENGTH(impl->slots); ++i) {
+        free(impl->slots[i].pixels);
+        free(impl->slots[i].dirty);
+    }
+    free(impl->pending);
+    free(impl);
+}
+
+bool scope_source_async_create(scope_source_t *inner, scope_source_t **source) {
+    assert(inner && source);
+
+    async_source_t *impl = malloc(sizeof(async_source_t));
+    if (!impl) {
+        scope_source_destroy(inner);
+        return false;
+    }
+
+    *impl = (async_source_t){
+        .base = {
+            .name = "async",
+            .interface = {async_acquire, async_release, async_destroy},
+        },
+        .inner = inner,
+    };
+    scope_triple_init(&impl->triple);
+
+    if (!scope_thread_create(producer_main, impl, &impl->producer)) {
+        async_destroy(&impl->base);
+        return false;
+    }
+
+    *source = &impl->base;
+    return true;
+}
+
+void scope_source_async_stats(const scope_source_t *source, scope_async_stats_t *stats) {
+    assert(source && source->interface.acquire == async_acquire);
+    assert(stats);
+
+    async_source_t *impl = (async_source_t *)source;
+    *stats = (scope_async_stats_t){
+        .captured = scope_atomic_load64(&impl->captured),
+        .dropped = scope_atomic_load64(&impl->dropped),
+        .failed = scope_atomic_load64(&impl->failed),
+        .scoped = impl->scoped,
+        .latency_last = impl->latency_last,
+        .latency_mean = impl->scoped > 0 ? impl->latency_sum / (double)impl->scoped : 0.0,
+        .latency_max = impl->latency_max,
+    };
+}
+
+static void producer_main(void *user_data) {
+    async_source_t *impl = user_data;
+
+    while (!scope_atomic_load(&impl->quit)) {
+        scope_frame_t frame;
+        scope_acquire_result_t result = scope_source_acquire(impl->inner, PRODUCER_TIMEOUT_MS, &frame);
+        if (result == SCOPE_ACQUIRE_END) break;
+        if (result == SCOPE_ACQUIRE_TIMEOUT) continue;
+        if (result == SCOPE_ACQUIRE_ERROR) {
+            scope_atomic_add64(&impl->failed, 1);
+            continue;
+        }
+
+        double captured_at = scope_cpu_time_seconds();
+        async_slot_t *slot = &impl->slots[impl->triple.back];
+        bool copied = copy_image(slot, &frame.image) && merge_dirty(impl, slot, &frame);
+        scope_source_release(impl->inner);
+        if (!copied) {
+            scope_atomic_add64(&impl->failed, 1);
+            continue;
+        }
+
+        slot->timestamp = frame.timestamp;
+        slot->captured_at = captured_at;
+        impl->published_generation = slot->image.generation;
+
+        bool dropped = scope_triple_publish(&impl->triple);
+        scope_atomic_add64(&impl->captured, 1);
+        if (dropped) scope_atomic_add64(&impl->dropped, 1);
+    }
+
+    scope_atomic_store(&impl->ended, 1);
+}
+
+// Copies the pixels into the slot's own buffer, tightly packed, with the planes of Y'CbCr frames back to back
+static bool copy_image(async_slot_t *slot, const scope_image_t *image) {
+    const bool ycbcr = scope_pixel_format_is_ycbcr(image->format);
+    const scope_ycbcr_layout_t layout = scope_ycbcr_layout(image->format);
+
+    const uint32_t row_size = image->width * scope_pixel_format_bytes(image->format);
+    const uint32_t chroma_height = (image->height + (1u << layout.y_shift) - 1) >> layout.y_shift;
+    const uint32_t chroma_row_size = ((image->width + (1u << layout.x_shift) - 1) >> layout.x_shift) * layout.sample_bytes * (layout.interleaved ? 2 : 1);
+    const uint32_t chroma_planes = ycbcr ? (layout.interleaved ? 1 : 2) : 0;
+
+    const size_t luma_size = (size_t)row_size * image->height;
+    const size_t chroma_size = (size_t)chroma_row_size * chroma_height;
+    const size_t size = luma_size + chroma_planes * chroma_size;
+
+    if (size > slot->capacity) {
+        uint8_t *pixels = realloc(slot->pixels, size);
+        if (!pixels) {
+            return false;
+        }
+        slot->pixels = pixels;
+        slot->capacity = size;
+    }
+
+    slot->image = *image;
+    slot->image.data = slot->pixels;
+    slot->image.stride = row_size;
+    for (uint32_t y = 0; y < image->height; ++y) {
+        memcpy(slot->pixels + (size_t)row_size * y, scope_image_row(image, y), row_size);
+    }
+
+    for (uint32_t p = 0; p < chroma_planes; ++p) {
+        uint8_t *plane = slot->pixels + luma_size + p * chroma_size;
+        for (uint32_t y = 0; y < chroma_height; ++y) {
+            memcpy(plane + (size_t)chroma_row_size * y, image->chroma[p] + (size_t)image->chroma_stride * y, chroma_row_size);
+        }
+        slot->image.chroma[p] = plane;
+    }
+    if (ycbcr) {
+        slot->image.chroma_stride = chroma_row_size;
+    }
+
+    return true;
+}
+
+// The consumer may skip frames, so each published frame carries every rect since the last frame
+// it is known to have acquired. Acquiring while this runs only makes the rects too generous.
+static bool merge_dirty(async_source_t *impl, async_slot_t *slot, const scope_frame_t *frame) {
+    if (scope_atomic_load64(&impl->consumed_generation) == impl->published_generation) {
+        impl->pending_count = 0;
+    }
+
+    if (impl->pending_count + frame->dirty_count > MAX_PENDING_RECTS) {
+        if (!reserve_rects(&impl->pending, &impl->pending_capacity, 1)) {
+            return false;
+        }
+        impl->pending[0] = (scope_rect_t){0, 0, frame->image.width, frame->image.height};
+        impl->pending_count = 1;
+    } else {
+        if (!reserve_rects(&impl->pending, &impl->pending_capacity, impl->pending_count + frame->dirty_count)) {
+            return false;
+        }
+        memcpy(impl->pending + impl->pending_count, frame->dirty, frame->dirty_count * sizeof(scope_rect_t));
+        impl->pending_count += frame->dirty_count;
+    }
+
+    if (!reserve_rects(&slot->dirty, &slot->dirty_capacity, impl->pending_count)) {
+        return false;
+    }
+    memcpy(slot->dirty, impl->pending, impl->pending_count * sizeof(scope_rect_t));
+    slot->dirty_count = impl->pending_count;
+    return true;
+}
+
+static bool reserve_rects(scope_rect_t **rects, uint32_t *capacity, uint32_t count) {
+    if (count <= *capacity) {
+        return true;
+    }
+
+    scope_rect_t *grown = realloc(*rects, count * sizeof(scope_rect_t));
+    if (!grown) {
+        return false;
+    }
+    *rects = grown;
+    *capacity = count;
+    return true;
+}
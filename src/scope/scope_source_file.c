@@ -0,0 +1,373 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "scope_source.h"
+
+#include "scope_cpu.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// The kernel is asked to read this far ahead of the frame being analyzed
+#define READAHEAD_FRAMES 4
+#define READAHEAD_MIN_BYTES (8 * 1024 * 1024)
+
+// Y4M frame headers are "FRAME", optional parameters and a newline
+#define Y4M_MAGIC "YUV4MPEG2 "
+#define Y4M_FRAME_MAGIC "FRAME"
+#define Y4M_MAX_HEADER 1024
+
+typedef struct y4m_chroma {
+    const char *tag;
+    uint32_t x_shift; // chroma subsampling
+    uint32_t y_shift;
+    uint32_t planes;
+    uint32_t sample_bytes;
+    scope_pixel_format_t format; // SCOPE_PIXEL_FORMAT_COUNT if the scopes can't read it
+} y4m_chroma_t;
+
+// The 4:2:0 variants only differ in chroma siting, which binning ignores
+static const y4m_chroma_t y4m_chromas[] = {
+    {"420jpeg", 1, 1, 3, 1, SCOPE_PIXEL_FORMAT_YUV420P},
+    {"420mpeg2", 1, 1, 3, 1, SCOPE_PIXEL_FORMAT_YUV420P},
+    {"420paldv", 1, 1, 3, 1, SCOPE_PIXEL_FORMAT_YUV420P},
+    {"420", 1, 1, 3, 1, SCOPE_PIXEL_FORMAT_YUV420P},
+    {"422", 1, 0, 3, 1, SCOPE_PIXEL_FORMAT_YUV422P},
+    {"444", 0, 0, 3, 1, SCOPE_PIXEL_FORMAT_YUV444P},
+    {"420p10", 1, 1, 3, 2, SCOPE_PIXEL_FORMAT_YUV420P10},
+    {"422p10", 1, 0, 3, 2, SCOPE_PIXEL_FORMAT_YUV422P10},
+    {"444p10", 0, 0, 3, 2, SCOPE_PIXEL_FORMAT_YUV444P10},
+    {"mono", 0, 0, 1, 1, SCOPE_PIXEL_FORMAT_COUNT},
+};
+
+typedef struct file_source {
+    scope_source_t base;
+
+    const uint8_t *map;
+    size_t size;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+    size_t page_size;
+
+    bool y4m;
+    bool ended;
+    size_t offset;      // of the next frame, or of its FRAME header in Y4M files
+    size_t frame_size;  // pixel bytes of a frame
+    size_t cb_offset;   // of the chroma planes within a Y4M frame
+    size_t cr_offset;
+    size_t advised_end; // read-ahead was requested up to here
+    size_t readahead;
+
+    scope_image_t image;
+    scope_rect_t full;
+    double frame_rate;
+
+    bool realtime;
+    double start_time; // wall clock of the first frame
+} file_source_t;
+
+static void sleep_seconds(double seconds) {
+#if defined(_WIN32)
+    Sleep((DWORD)(seconds * 1000.0));
+#else
+    struct timespec duration = {
+        .tv_sec = (time_t)seconds,
+        .tv_nsec = (long)((seconds - (double)(time_t)seconds) * 1e9),
+    };
+    nanosleep(&duration, NULL);
+#endif
+}
+
+static bool map_file(file_source_t *impl, const char *path) {
+#if defined(_WIN32)
+    impl->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (impl->file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(impl->file, &size) || size.QuadPart == 0) return false;
+    impl->size = (size_t)size.QuadPart;
+
+    impl->mapping = CreateFileMappingA(impl->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!impl->mapping) return false;
+
+    impl->map = MapViewOfFile(impl->mapping, FILE_MAP_READ, 0, 0, 0);
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    impl->page_size = info.dwPageSize;
+    return impl->map != NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    impl->size = (size_t)st.st_size;
+
+    // The mapping keeps the file referenced
+    void *map = mmap(NULL, impl->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    impl->map = map;
+    impl->page_size = (size_t)sysconf(_SC_PAGESIZE);
+    posix_madvise(map, impl->size, POSIX_MADV_SEQUENTIAL);
+    return true;
+#endif
+}
+
+static void unmap_file(file_source_t *impl) {
+#if defined(_WIN32)
+    if (impl->map) UnmapViewOfFile(impl->map);
+    if (impl->mapping) CloseHandle(impl->mapping);
+    if (impl->file && impl->file != INVALID_HANDLE_VALUE) CloseHandle(impl->file);
+#else
+    if (impl->map) munmap((void *)impl->map, impl->size);
+#endif
+}
+
+// Asks for the next frames to be paged in while the current one is analyzed
+static void read_ahead(file_source_t *impl, size_t frame_end) {
+    if (frame_end + impl->readahead / 2 <= impl->advised_end) return;
+
+    size_t begin = MAX(impl->offset, impl->advised_end) & ~(impl->page_size - 1);
+    size_t end = MIN(impl->size, impl->offset + impl->readahead);
+    if (begin >= end) return;
+
+#if defined(_WIN32)
+    (void)begin;
+#else
+    posix_madvise((void *)(impl->map + begin), end - begin, POSIX_MADV_WILLNEED);
+#endif
+    impl->advised_end = end;
+}
+
+static bool parse_y4m_header(file_source_t *impl, const char *path) {
+    const char *header = (const char *)impl->map;
+    size_t limit = MIN(impl->size, (size_t)Y4M_MAX_HEADER);
+    const char *end = memchr(header, '\n', limit);
+    if (!end) {
+        fprintf(stderr, "%s: Y4M header is not terminated\n", path);
+        return false;
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t rate_num = 0;
+    uint32_t rate_den = 0;
+    const y4m_chroma_t *chroma = &y4m_chromas[0];
+    scope_color_range_t range = SCOPE_COLOR_RANGE_LIMITED;
+
+    // Space separated tags, each starting with its one letter name
+    for (const char *tag = header + strlen(Y4M_MAGIC); tag < end;) {
+        const char *tag_end = tag;
+        while (tag_end < end && *tag_end != ' ') tag_end++;
+
+        char value[64];
+        size_t length = MIN((size_t)(tag_end - tag), sizeof(value));
+        if (length > 1) {
+            memcpy(value, tag + 1, length - 1);
+            value[length - 1] = '\0';
+
+            switch (*tag) {
+            case 'W': width = (uint32_t)strtoul(value, NULL, 10); break;
+            case 'H': height = (uint32_t)strtoul(value, NULL, 10); break;
+            case 'F': sscanf(value, "%u:%u", &rate_num, &rate_den); break;
+            case 'C':
+                chroma = NULL;
+                for (uint32_t i = 0; i < ARRAY_LENGTH(y4m_chromas); ++i) {
+                    if (strcmp(value, y4m_chromas[i].tag) == 0) chroma = &y4m_chromas[i];
+                }
+                if (!chroma) {
+                    fprintf(stderr, "%s: unsupported Y4M colorspace '%s'\n", path, value);
+                    return false;
+                }
+                break;
+            case 'X':
+                // Written by ffmpeg, everything else is limited range
+                if (strcmp(value, "COLORRANGE=FULL") == 0) range = SCOPE_COLOR_RANGE_FULL;
+                break;
+            default: break;
+            }
+        }
+        tag = tag_end + 1;
+    }
+
+    if (width == 0 || height == 0) {
+        fprintf(stderr, "%s: Y4M header has no frame size\n", path);
+        return false;
+    }
+    if (rate_num > 0 && rate_den > 0) {
+        impl->frame_rate = (double)rate_num / rate_den;
+    }
+
+    if (chroma->format == SCOPE_PIXEL_FORMAT_COUNT) {
+        fprintf(stderr, "%s: Y4M C%s frames have no chroma to scope\n", path, chroma->tag);
+        return false;
+    }
+
+    size_t chroma_width = (width + (1u << chroma->x_shift) - 1) >> chroma->x_shift;
+    size_t chroma_height = (height + (1u << chroma->y_shift) - 1) >> chroma->y_shift;
+    impl->frame_size = ((size_t)width * height + (chroma->planes - 1) * chroma_width * chroma_height) * chroma->sample_bytes;
+    impl->cb_offset = (size_t)width * height * chroma->sample_bytes;
+    impl->cr_offset = impl->cb_offset + chroma_width * chroma_height * chroma->sample_bytes;
+    impl->offset = (size_t)(end + 1 - header);
+
+    // The planes are analyzed in place, no conversion to RGB
+    impl->image = (scope_image_t){
+        .width = width,
+        .height = height,
+        .stride = width * chroma->sample_bytes,
+        .format = chroma->format,
+        .chroma_stride = (uint32_t)(chroma_width * chroma->sample_bytes),
+        .range = range,
+    };
+    return true;
+}
+
+// Skips the FRAME header at the offset, returns false if there is none
+static bool skip_y4m_frame_header(file_source_t *impl) {
+    size_t remaining = impl->size - impl->offset;
+    const char *header = (const char *)impl->map + impl->offset;
+    if (remaining < strlen(Y4M_FRAME_MAGIC) || memcmp(header, Y4M_FRAME_MAGIC, strlen(Y4M_FRAME_MAGIC)) != 0) {
+        return false;
+    }
+
+    const char *end = memchr(header, '\n', MIN(remaining, (size_t)Y4M_MAX_HEADER));
+    if (!end) {
+        return false;
+    }
+
+    impl->offset += (size_t)(end + 1 - header);
+    return true;
+}
+
+static scope_acquire_result_t file_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    file_source_t *impl = (file_source_t *)source;
+
+    if (impl->ended || impl->offset >= impl->size) {
+        return SCOPE_ACQUIRE_END;
+    }
+
+    double timestamp = (double)impl->image.generation / impl->frame_rate;
+    if (impl->realtime) {
+        double now = scope_cpu_time_seconds();
+        if (impl->image.generation == 0) {
+            impl->start_time = now;
+        }
+
+        double wait = impl->start_time + timestamp - now;
+        if (wait * 1000.0 > timeout_ms) {
+            sleep_seconds(timeout_ms / 1000.0);
+            return SCOPE_ACQUIRE_TIMEOUT;
+        }
+        if (wait > 0.0) {
+            sleep_seconds(wait);
+        }
+    }
+
+    if (impl->y4m && !skip_y4m_frame_header(impl)) {
+        impl->ended = true;
+        return SCOPE_ACQUIRE_ERROR;
+    }
+    if (impl->size - impl->offset < impl->frame_size) {
+        impl->ended = true;
+        return SCOPE_ACQUIRE_END;
+    }
+
+    impl->image.data = impl->map + impl->offset;
+    if (impl->y4m) {
+        impl->image.chroma[0] = impl->image.data + impl->cb_offset;
+        impl->image.chroma[1] = impl->image.data + impl->cr_offset;
+    }
+    impl->image.generation++;
+    impl->offset += impl->frame_size;
+    read_ahead(impl, impl->offset);
+
+    *frame = (scope_frame_t){
+        .image = impl->image,
+        .dirty = &impl->full,
+        .dirty_count = 1,
+        .timestamp = timestamp,
+    };
+    return SCOPE_ACQUIRE_OK;
+}
+
+static void file_release(scope_source_t *source) {
+    // Frames stay mapped until the source is destroyed
+    (void)source;
+}
+
+static void file_destroy(scope_source_t *source) {
+    file_source_t *impl = (file_source_t *)source;
+    unmap_file(impl);
+    free(impl);
+}
+
+bool scope_source_file_create(const char *path, const scope_file_desc_t *desc, scope_source_t **source) {
+    assert(path && desc && source);
+
+    file_source_t *impl = malloc(sizeof(file_source_t));
+    if (!impl) return false;
+
+    *impl = (file_source_t){
+        .base = {
+            .name = "file",
+            .interface = {file_acquire, file_release, file_destroy},
+        },
+        .frame_rate = desc->frame_rate > 0.0 ? desc->frame_rate : 25.0,
+        .realtime = desc->realtime,
+    };
+
+    if (!map_file(impl, path)) {
+        fprintf(stderr, "%s: couldn't map the file\n", path);
+        file_destroy(&impl->base);
+        return false;
+    }
+
+    impl->y4m = impl->size >= strlen(Y4M_MAGIC) && memcmp(impl->map, Y4M_MAGIC, strlen(Y4M_MAGIC)) == 0;
+    if (impl->y4m) {
+        if (!parse_y4m_header(impl, path)) {
+            file_destroy(&impl->base);
+            return false;
+        }
+    } else {
+        assert(desc->width > 0 && desc->height > 0);
+        assert(!scope_pixel_format_is_ycbcr(desc->format));
+        impl->image = (scope_image_t){
+            .width = desc->width,
+            .height = desc->height,
+            .stride = desc->width * scope_pixel_format_bytes(desc->format),
+            .format = desc->format,
+            .transfer = desc->transfer,
+        };
+        impl->frame_size = (size_t)impl->image.stride * impl->image.height;
+    }
+
+    impl->full = (scope_rect_t){0, 0, impl->image.width, impl->image.height};
+    impl->readahead = MAX(impl->frame_size * READAHEAD_FRAMES, (size_t)READAHEAD_MIN_BYTES);
+
+    *source = &impl->base;
+    return true;
+}
@@ -0,0 +1,130 @@
+#include "scope_synthetic.h"
+
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Mostly flat greys with a few saturated panels, so the scopes have distinct clusters
+static void base_pixel(const scope_synthetic_source_t *source, uint32_t x, uint32_t y, uint8_t rgb[3]) {
+    uint32_t panel = (x * 4 / source->image.width) + 4 * (y * 3 / source->image.height);
+    uint8_t shade = (uint8_t)(48 + 160 * y / source->image.height);
+
+    rgb[0] = rgb[1] = rgb[2] = shade;
+    switch (panel % 5) {
+    case 1: rgb[0] = 220; break;
+    case 3: rgb[2] = 200; rgb[1] = shade / 2; break;
+    default: break;
+    }
+}
+
+static void fill_rect(scope_synthetic_source_t *source, scope_rect_t rect, uint32_t seed) {
+    const scope_rgb8_layout_t layout = scope_rgb8_layout(source->image.format);
+
+    for (uint32_t y = rect.y; y < rect.y + rect.height; ++y) {
+        uint8_t *px = source->pixels + (size_t)y * source->image.stride + (size_t)rect.x * 4;
+        for (uint32_t x = rect.x; x < rect.x + rect.width; ++x, px += 4) {
+            uint8_t rgb[3];
+            if (seed == 0) {
+                base_pixel(source, x, y, rgb);
+            } else {
+                uint32_t h = scope_hash32(seed ^ scope_hash32(y * source->image.width + x));
+                rgb[0] = (uint8_t)h;
+                rgb[1] = (uint8_t)(h >> 8);
+                rgb[2] = (uint8_t)(h >> 16);
+            }
+
+            px[layout.r] = rgb[0];
+            px[layout.g] = rgb[1];
+            px[layout.b] = rgb[2];
+            px[3] = 255;
+        }
+    }
+}
+
+static bool push_dirty(scope_synthetic_source_t *source, scope_rect_t rect) {
+    if (source->dirty_count == source->dirty_capacity) {
+        uint32_t capacity = MAX(16u, source->dirty_capacity * 2);
+        scope_rect_t *dirty = realloc(source->dirty, capacity * sizeof(scope_rect_t));
+        if (!dirty) {
+            return false;
+        }
+        source->dirty = dirty;
+        source->dirty_capacity = capacity;
+    }
+
+    source->dirty[source->dirty_count++] = rect;
+    return true;
+}
+
+bool scope_synthetic_create(scope_synthetic_source_t *source, uint32_t width, uint32_t height, scope_pixel_format_t format,
+                            const scope_synthetic_change_t *script, uint32_t script_length, uint32_t script_period) {
+    assert(source);
+    assert(width > 0 && height > 0);
+    assert(scope_pixel_format_is_rgb8(format));
+    assert(script || script_length == 0);
+
+    *source = (scope_synthetic_source_t){
+        .image = {
+            .width = width,
+            .height = height,
+            .stride = width * 4,
+            .format = format,
+        },
+        .script = script,
+        .script_length = script_length,
+        .script_period = script_period,
+        .frame_index = UINT32_MAX,
+    };
+
+    source->pixels = malloc((size_t)width * height * 4);
+    source->image.data = source->pixels;
+    return source->pixels != NULL;
+}
+
+void scope_synthetic_destroy(scope_synthetic_source_t *source) {
+    if (source) {
+        free(source->pixels);
+        free(source->dirty);
+        *source = (scope_synthetic_source_t){0};
+    }
+}
+
+bool scope_synthetic_next(scope_synthetic_source_t *source) {
+    assert(source && source->pixels);
+
+    source->frame_index++;
+    source->dirty_count = 0;
+    source->image.generation = (uint64_t)source->frame_index + 1;
+
+    if (source->frame_index == 0) {
+        scope_rect_t full = {0, 0, source->image.width, source->image.height};
+        fill_rect(source, full, 0);
+        return push_dirty(source, full);
+    }
+
+    uint32_t time = source->frame_index - 1;
+    if (source->script_period > 0) {
+        time %= source->script_period;
+    }
+
+    for (uint32_t i = 0; i < source->script_length; ++i) {
+        const scope_synthetic_change_t *change = &source->script[i];
+        if (change->frame != time) continue;
+        if (change->rect.x >= source->image.width || change->rect.y >= source->image.height) continue;
+
+        scope_rect_t rect = change->rect;
+        rect.width = MIN(rect.width, source->image.width - rect.x);
+        rect.height = MIN(rect.height, source->image.height - rect.y);
+
+        fill_rect(source, rect, change->seed);
+        if (!push_dirty(source, rect)) {
+            return false;
+        }
+    }
+
+    return true;
+}
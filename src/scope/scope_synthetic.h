@@ -0,0 +1,37 @@
+#pragma once
+
+#include "scope.h"
+
+// Deterministic frame source for exercising the scopes without a capture device. The first frame
+// is a static desktop-like image, every following frame applies the changes the script lists for
+// it and reports exactly the rects it touched as dirty, like DXGI desktop duplication does.
+
+typedef struct scope_synthetic_change {
+    uint32_t frame; // script time the change is applied at, frame 1 is time 0
+    scope_rect_t rect;
+    uint32_t seed; // fills the rect with noise from this seed, 0 restores the base image
+} scope_synthetic_change_t;
+
+typedef struct scope_synthetic_source {
+    uint8_t *pixels;
+    scope_image_t image; // current frame
+
+    const scope_synthetic_change_t *script;
+    uint32_t script_length;
+    uint32_t script_period; // script time wraps after this many frames, 0 plays it once
+
+    uint32_t frame_index; // of the current frame, UINT32_MAX before the first one
+
+    // Rects changed by the current frame
+    scope_rect_t *dirty;
+    uint32_t dirty_count;
+    uint32_t dirty_capacity;
+} scope_synthetic_source_t;
+
+/* @brief Allocates the frame. The script is not copied and has to outlive the source. */
+bool scope_synthetic_create(scope_synthetic_source_t *source, uint32_t width, uint32_t height, scope_pixel_format_t format,
+                            const scope_synthetic_change_t *script, uint32_t script_length, uint32_t script_period);
+void scope_synthetic_destroy(scope_synthetic_source_t *source);
+
+/* @brief Advances to the next frame. Returns false on allocation failure. */
+bool scope_synthetic_next(scope_synthetic_source_t *source);
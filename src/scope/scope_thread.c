@@ -0,0 +1,272 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "scope_thread.h"
+
+#include "scope_cpu.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef HANDLE thread_t;
+typedef SRWLOCK mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+
+#define THREAD_PROC DWORD WINAPI
+#define THREAD_PROC_RESULT 0
+typedef LPTHREAD_START_ROUTINE thread_proc_t;
+
+static void mutex_init(mutex_t *m) { InitializeSRWLock(m); }
+static void mutex_destroy(mutex_t *m) { (void)m; }
+static void mutex_lock(mutex_t *m) { AcquireSRWLockExclusive(m); }
+static void mutex_unlock(mutex_t *m) { ReleaseSRWLockExclusive(m); }
+static void cond_init(cond_t *c) { InitializeConditionVariable(c); }
+static void cond_destroy(cond_t *c) { (void)c; }
+static void cond_wait(cond_t *c, mutex_t *m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static void cond_signal(cond_t *c) { WakeConditionVariable(c); }
+static void cond_broadcast(cond_t *c) { WakeAllConditionVariable(c); }
+#else
+#include <pthread.h>
+#include <time.h>
+
+typedef pthread_t thread_t;
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+
+#define THREAD_PROC void *
+#define THREAD_PROC_RESULT NULL
+typedef void *(*thread_proc_t)(void *);
+
+static void mutex_init(mutex_t *m) { pthread_mutex_init(m, NULL); }
+static void mutex_destroy(mutex_t *m) { pthread_mutex_destroy(m); }
+static void mutex_lock(mutex_t *m) { pthread_mutex_lock(m); }
+static void mutex_unlock(mutex_t *m) { pthread_mutex_unlock(m); }
+static void cond_init(cond_t *c) { pthread_cond_init(c, NULL); }
+static void cond_destroy(cond_t *c) { pthread_cond_destroy(c); }
+static void cond_wait(cond_t *c, mutex_t *m) { pthread_cond_wait(c, m); }
+static void cond_signal(cond_t *c) { pthread_cond_signal(c); }
+static void cond_broadcast(cond_t *c) { pthread_cond_broadcast(c); }
+#endif
+
+struct scope_thread_pool {
+    uint32_t thread_count; // including the thread calling run
+    thread_t *workers;
+    uint32_t worker_count;
+
+    mutex_t mutex;
+    cond_t work_cond;
+    cond_t done_cond;
+
+    // Current batch, all guarded by the mutex
+    uint64_t generation;
+    scope_task_fn fn;
+    void *user_data;
+    uint32_t task_count;
+    uint32_t next_task;
+    uint32_t pending_tasks;
+    bool quit;
+};
+
+struct scope_thread {
+    thread_t thread;
+    scope_thread_fn fn;
+    void *user_data;
+};
+
+static THREAD_PROC worker_main(void *arg);
+static THREAD_PROC single_main(void *arg);
+static void process_tasks(scope_thread_pool_t *pool);
+static bool thread_start(thread_t *thread, thread_proc_t proc, void *arg);
+static void thread_join(thread_t thread);
+
+bool scope_thread_pool_create(uint32_t thread_count, scope_thread_pool_t **out_pool) {
+    assert(out_pool);
+
+    if (thread_count == 0) {
+        thread_count = scope_cpu_core_count();
+    }
+
+    scope_thread_pool_t *pool = calloc(1, sizeof(scope_thread_pool_t));
+    if (!pool) {
+        return false;
+    }
+
+    pool->thread_count = thread_count;
+    mutex_init(&pool->mutex);
+    cond_init(&pool->work_cond);
+    cond_init(&pool->done_cond);
+
+    if (thread_count > 1) {
+        pool->workers = calloc(thread_count - 1, sizeof(thread_t));
+        if (!pool->workers) {
+            scope_thread_pool_destroy(pool);
+            return false;
+        }
+
+        for (uint32_t i = 0; i < thread_count - 1; ++i) {
+            if (!thread_start(&pool->workers[i], worker_main, pool)) {
+                scope_thread_pool_destroy(pool);
+                return false;
+            }
+            pool->worker_count++;
+        }
+    }
+
+    *out_pool = pool;
+    return true;
+}
+
+void scope_thread_pool_destroy(scope_thread_pool_t *pool) {
+    if (!pool) return;
+
+    mutex_lock(&pool->mutex);
+    pool->quit = true;
+    cond_broadcast(&pool->work_cond);
+    mutex_unlock(&pool->mutex);
+
+    for (uint32_t i = 0; i < pool->worker_count; ++i) {
+        thread_join(pool->workers[i]);
+    }
+
+    cond_destroy(&pool->done_cond);
+    cond_destroy(&pool->work_cond);
+    mutex_destroy(&pool->mutex);
+    free(pool->workers);
+    free(pool);
+}
+
+uint32_t scope_thread_pool_size(const scope_thread_pool_t *pool) {
+    return pool ? pool->thread_count : 1;
+}
+
+void scope_thread_pool_run(scope_thread_pool_t *pool, uint32_t task_count, scope_task_fn fn, void *user_data) {
+    assert(fn);
+
+    if (!pool || pool->worker_count == 0 || task_count <= 1) {
+        for (uint32_t i = 0; i < task_count; ++i) {
+            fn(user_data, i);
+        }
+        return;
+    }
+
+    mutex_lock(&pool->mutex);
+    pool->fn = fn;
+    pool->user_data = user_data;
+    pool->task_count = task_count;
+    pool->next_task = 0;
+    pool->pending_tasks = task_count;
+    pool->generation++;
+    cond_broadcast(&pool->work_cond);
+
+    // The caller works on the batch too instead of idling
+    process_tasks(pool);
+
+    while (pool->pending_tasks > 0) {
+        cond_wait(&pool->done_cond, &pool->mutex);
+    }
+    mutex_unlock(&pool->mutex);
+}
+
+bool scope_thread_create(scope_thread_fn fn, void *user_data, scope_thread_t **out_thread) {
+    assert(fn && out_thread);
+
+    scope_thread_t *thread = malloc(sizeof(scope_thread_t));
+    if (!thread) {
+        return false;
+    }
+
+    *thread = (scope_thread_t){.fn = fn, .user_data = user_data};
+    if (!thread_start(&thread->thread, single_main, thread)) {
+        free(thread);
+        return false;
+    }
+
+    *out_thread = thread;
+    return true;
+}
+
+void scope_thread_join(scope_thread_t *thread) {
+    if (thread) {
+        thread_join(thread->thread);
+        free(thread);
+    }
+}
+
+static THREAD_PROC single_main(void *arg) {
+    scope_thread_t *thread = arg;
+    thread->fn(thread->user_data);
+    return THREAD_PROC_RESULT;
+}
+
+static THREAD_PROC worker_main(void *arg) {
+    scope_thread_pool_t *pool = arg;
+    uint64_t seen_generation = 0;
+
+    mutex_lock(&pool->mutex);
+    while (true) {
+        while (!pool->quit && pool->generation == seen_generation) {
+            cond_wait(&pool->work_cond, &pool->mutex);
+        }
+        if (pool->quit) break;
+
+        seen_generation = pool->generation;
+        process_tasks(pool);
+    }
+    mutex_unlock(&pool->mutex);
+
+    return THREAD_PROC_RESULT;
+}
+
+// Claims and runs tasks of the current batch until none are left. Called with the mutex held.
+static void process_tasks(scope_thread_pool_t *pool) {
+    while (pool->next_task < pool->task_count) {
+        uint32_t task = pool->next_task++;
+        scope_task_fn fn = pool->fn;
+        void *user_data = pool->user_data;
+
+        mutex_unlock(&pool->mutex);
+        fn(user_data, task);
+        mutex_lock(&pool->mutex);
+
+        if (--pool->pending_tasks == 0) {
+            cond_signal(&pool->done_cond);
+        }
+    }
+}
+
+#if defined(_WIN32)
+static bool thread_start(thread_t *thread, thread_proc_t proc, void *arg) {
+    *thread = CreateThread(NULL, 0, proc, arg, 0, NULL);
+    return *thread != NULL;
+}
+
+static void thread_join(thread_t thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+void scope_thread_sleep_ms(uint32_t ms) {
+    Sleep(ms);
+}
+#else
+static bool thread_start(thread_t *thread, thread_proc_t proc, void *arg) {
+    return pthread_create(thread, NULL, proc, arg) == 0;
+}
+
+static void thread_join(thread_t thread) {
+    pthread_join(thread, NULL);
+}
+
+void scope_thread_sleep_ms(uint32_t ms) {
+    struct timespec duration = {
+        .tv_sec = (time_t)(ms / 1000),
+        .tv_nsec = (long)(ms % 1000) * 1000000L,
+    };
+    nanosleep(&duration, NULL);
+}
+#endif
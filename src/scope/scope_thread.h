@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct scope_thread_pool scope_thread_pool_t;
+
+// A task receives the index of the work item it should process, in [0, task_count)
+typedef void (*scope_task_fn)(void *user_data, uint32_t task_index);
+
+/* @brief Creates a pool that runs work on `thread_count` threads, the calling thread included.
+ * Passing 0 uses one thread per logical processor. */
+bool scope_thread_pool_create(uint32_t thread_count, scope_thread_pool_t **out_pool);
+void scope_thread_pool_destroy(scope_thread_pool_t *pool);
+uint32_t scope_thread_pool_size(const scope_thread_pool_t *pool);
+
+/* @brief Runs `task_count` tasks spread over the pool and blocks until all of them finished.
+ * A NULL pool runs every task on the calling thread. */
+void scope_thread_pool_run(scope_thread_pool_t *pool, uint32_t task_count, scope_task_fn fn, void *user_data);
+
+// A single long running thread, e.g. a capture producer
+typedef struct scope_thread scope_thread_t;
+typedef void (*scope_thread_fn)(void *user_data);
+
+bool scope_thread_create(scope_thread_fn fn, void *user_data, scope_thread_t **out_thread);
+/* @brief Waits for the thread to return and frees it. Accepts NULL. */
+void scope_thread_join(scope_thread_t *thread);
+
+/* @brief Sleeps the calling thread for at least `ms` milliseconds */
+void scope_thread_sleep_ms(uint32_t ms);
@@ -0,0 +1,225 @@
+#include "scope_tiles.h"
+
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TILE_WORDS (SCOPE_TILE_SIZE / 2) // 8-byte words in a row of a tile
+
+struct hash_job {
+    scope_tiles_t *tiles;
+    const scope_image_t *image;
+    bool compare; // against the hashes of the previous frame
+    uint32_t band_count;
+    scope_tile_row_fn row_fn;
+};
+
+static scope_tile_row_fn get_row_kernel(scope_isa_t isa);
+static bool reserve(scope_tiles_t *tiles, size_t tile_count);
+static void hash_band_task(void *user_data, uint32_t band);
+static void collect_rects(scope_tiles_t *tiles, const scope_image_t *image);
+
+// splitmix64 finalizer
+static inline uint64_t mix64(uint64_t v) {
+    v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9ull;
+    v = (v ^ (v >> 27)) * 0x94d049bb133111ebull;
+    return v ^ (v >> 31);
+}
+
+static inline uint32_t div_ceil(uint32_t a, uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+void scope_tiles_create(scope_tiles_t *tiles) {
+    assert(tiles);
+
+    *tiles = (scope_tiles_t){.isa = scope_cpu_best_isa()};
+    for (uint32_t i = 0; i < ARRAY_LENGTH(tiles->keys); ++i) {
+        tiles->keys[i] = mix64(0x9e3779b97f4a7c15ull * (i + 1));
+    }
+}
+
+void scope_tiles_destroy(scope_tiles_t *tiles) {
+    if (tiles) {
+        free(tiles->hashes);
+        free(tiles->state);
+        free(tiles->changed);
+        free(tiles->rects);
+        *tiles = (scope_tiles_t){0};
+    }
+}
+
+void scope_tiles_invalidate(scope_tiles_t *tiles) {
+    assert(tiles);
+    tiles->valid = false;
+}
+
+bool scope_tiles_update(scope_tiles_t *tiles, const scope_image_t *image, scope_thread_pool_t *pool) {
+    assert(tiles);
+    assert(image && image->data);
+    assert(scope_pixel_format_is_rgb8(image->format));
+
+    if (tiles->valid && image->generation != 0 && image->generation == tiles->generation) {
+        tiles->rect_count = 0;
+        tiles->changed_count = 0;
+        memset(tiles->changed, 0, (size_t)tiles->columns * tiles->rows);
+        return true;
+    }
+
+    const bool compare = tiles->valid &&
+                         tiles->width == image->width &&
+                         tiles->height == image->height &&
+                         tiles->format == image->format;
+
+    const uint32_t columns = div_ceil(image->width, SCOPE_TILE_SIZE);
+    const uint32_t rows = div_ceil(image->height, SCOPE_TILE_SIZE);
+    if (!reserve(tiles, (size_t)columns * rows)) {
+        tiles->valid = false;
+        return false;
+    }
+
+    tiles->width = image->width;
+    tiles->height = image->height;
+    tiles->format = image->format;
+    tiles->columns = columns;
+    tiles->rows = rows;
+
+    struct hash_job job = {
+        .tiles = tiles,
+        .image = image,
+        .compare = compare,
+        .band_count = MIN(scope_thread_pool_size(pool), rows),
+        .row_fn = get_row_kernel(tiles->isa),
+    };
+    scope_thread_pool_run(job.band_count > 1 ? pool : NULL, job.band_count, hash_band_task, &job);
+
+    tiles->changed_count = 0;
+    for (size_t i = 0; i < (size_t)columns * rows; ++i) {
+        tiles->changed_count += tiles->changed[i];
+    }
+
+    if (compare) {
+        collect_rects(tiles, image);
+    } else {
+        tiles->rects[0] = (scope_rect_t){0, 0, image->width, image->height};
+        tiles->rect_count = 1;
+    }
+
+    tiles->valid = true;
+    tiles->generation = image->generation;
+    return true;
+}
+
+void scope_tile_row_scalar(uint64_t *state, const uint8_t *row, uint32_t width, const uint64_t *keys) {
+    const size_t size = (size_t)width * 4;
+
+    for (size_t begin = 0; begin < size; begin += TILE_WORDS * 8, state += 4) {
+        const size_t end = MIN(begin + TILE_WORDS * 8, size);
+        for (size_t offset = begin; offset < end; offset += 8) {
+            uint64_t word = 0;
+            memcpy(&word, row + offset, MIN((size_t)8, end - offset));
+
+            const uint32_t j = (uint32_t)(offset - begin) / 8;
+            state[j & 3] += scope_tile_word(word, keys[j]);
+        }
+    }
+}
+
+static bool reserve(scope_tiles_t *tiles, size_t tile_count) {
+    if (tile_count <= tiles->tile_capacity) {
+        return true;
+    }
+
+    // A row of n tiles has at most (n + 1) / 2 runs, so one rect per tile is plenty
+    uint64_t *hashes = realloc(tiles->hashes, tile_count * sizeof(uint64_t));
+    if (hashes) tiles->hashes = hashes;
+    uint64_t *state = realloc(tiles->state, tile_count * 4 * sizeof(uint64_t));
+    if (state) tiles->state = state;
+    uint8_t *changed = realloc(tiles->changed, tile_count);
+    if (changed) tiles->changed = changed;
+    scope_rect_t *rects = realloc(tiles->rects, tile_count * sizeof(scope_rect_t));
+    if (rects) tiles->rects = rects;
+
+    if (!hashes || !state || !changed || !rects) {
+        return false;
+    }
+    tiles->tile_capacity = tile_count;
+    return true;
+}
+
+// Tile rows are split into bands, the rows of a band are read top to bottom and each one is folded
+// into every tile it crosses, so memory is read in order
+static void hash_band_task(void *user_data, uint32_t band) {
+    const struct hash_job *job = user_data;
+    scope_tiles_t *tiles = job->tiles;
+    const scope_image_t *image = job->image;
+
+    const uint32_t row_begin = (uint32_t)((uint64_t)tiles->rows * band / job->band_count);
+    const uint32_t row_end = (uint32_t)((uint64_t)tiles->rows * (band + 1) / job->band_count);
+
+    for (uint32_t tile_row = row_begin; tile_row < row_end; ++tile_row) {
+        const size_t first = (size_t)tile_row * tiles->columns;
+        uint64_t *state = tiles->state + first * 4;
+        memset(state, 0, (size_t)tiles->columns * 4 * sizeof(uint64_t));
+
+        const uint32_t y_begin = tile_row * SCOPE_TILE_SIZE;
+        const uint32_t y_end = MIN(y_begin + SCOPE_TILE_SIZE, image->height);
+        for (uint32_t y = y_begin; y < y_end; ++y) {
+            job->row_fn(state, scope_image_row(image, y), image->width, tiles->keys + (y - y_begin) * TILE_WORDS);
+        }
+
+        for (uint32_t x = 0; x < tiles->columns; ++x) {
+            const uint64_t *s = state + (size_t)x * 4;
+            const uint64_t hash = mix64(s[0] + mix64(s[1] + mix64(s[2] + mix64(s[3]))));
+
+            tiles->changed[first + x] = !job->compare || hash != tiles->hashes[first + x];
+            tiles->hashes[first + x] = hash;
+        }
+    }
+}
+
+static void collect_rects(scope_tiles_t *tiles, const scope_image_t *image) {
+    tiles->rect_count = 0;
+
+    for (uint32_t tile_row = 0; tile_row < tiles->rows; ++tile_row) {
+        const uint8_t *changed = tiles->changed + (size_t)tile_row * tiles->columns;
+        const uint32_t y = tile_row * SCOPE_TILE_SIZE;
+
+        for (uint32_t x = 0; x < tiles->columns;) {
+            if (!changed[x]) {
+                ++x;
+                continue;
+            }
+
+            uint32_t run_end = x + 1;
+            while (run_end < tiles->columns && changed[run_end]) ++run_end;
+
+            tiles->rects[tiles->rect_count++] = (scope_rect_t){
+                .x = x * SCOPE_TILE_SIZE,
+                .y = y,
+                .width = MIN(run_end * SCOPE_TILE_SIZE, image->width) - x * SCOPE_TILE_SIZE,
+                .height = MIN(y + SCOPE_TILE_SIZE, image->height) - y,
+            };
+            x = run_end;
+        }
+    }
+}
+
+static scope_tile_row_fn get_row_kernel(scope_isa_t isa) {
+    if (!scope_cpu_supports(isa)) {
+        isa = scope_cpu_best_isa();
+    }
+
+    switch (isa) {
+#if SCOPE_X86_SIMD
+        case SCOPE_ISA_AVX512:
+        case SCOPE_ISA_AVX2: return scope_tile_row_avx2;
+        case SCOPE_ISA_SSE41: return scope_tile_row_sse41;
+#endif
+        default: return scope_tile_row_scalar;
+    }
+}
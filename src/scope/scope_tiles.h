@@ -0,0 +1,54 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_cpu.h"
+#include "scope_thread.h"
+
+// Change detection for sources without dirty rects (files, X11 without DAMAGE, memory) or with
+// coarse ones. Frames are cut into SCOPE_TILE_SIZE x SCOPE_TILE_SIZE tiles, each tile gets a 64-bit
+// hash, and the tiles whose hash differs from the previous frame are turned into dirty rects.
+// The hash is a non-cryptographic multiply-accumulate over 8-byte words with position dependent
+// keys, so it reads memory once at SIMD speed. It is not a 64-bit quality hash: a lane sums
+// `lo32 * hi32 + word` terms of the mixed keys, so a change that stays within one lane goes
+// unnoticed with a chance of about 2^-32, whatever the final mix of the 4 lanes does.
+
+#define SCOPE_TILE_SIZE 64
+
+typedef struct scope_tiles {
+    // Kernel used for hashing, picked at creation from the CPU features
+    scope_isa_t isa;
+
+    // Layout of the last frame
+    uint32_t width;
+    uint32_t height;
+    scope_pixel_format_t format;
+    uint32_t columns;
+    uint32_t rows;
+    bool valid;
+    uint64_t generation;
+
+    uint64_t *hashes;   // per tile, row by row
+    uint64_t *state;    // 4 accumulator lanes per tile
+    uint8_t *changed;   // per tile, nonzero if the last update found it changed
+    size_t tile_capacity;
+
+    // Last update: runs of changed tiles in a row as rects clipped to the frame, a single rect
+    // covering everything if the previous frame was missing or laid out differently
+    scope_rect_t *rects;
+    uint32_t rect_count;
+    uint32_t changed_count; // tiles
+
+    // Keys of the 8-byte words of a tile, SCOPE_TILE_SIZE rows of SCOPE_TILE_SIZE / 2 words
+    uint64_t keys[SCOPE_TILE_SIZE * SCOPE_TILE_SIZE / 2];
+} scope_tiles_t;
+
+void scope_tiles_create(scope_tiles_t *tiles);
+void scope_tiles_destroy(scope_tiles_t *tiles);
+/* @brief Forces the next update to report the whole frame as changed. */
+void scope_tiles_invalidate(scope_tiles_t *tiles);
+
+/* @brief Hashes the tiles of an 8-bit RGB frame and compares them against the previous one. A frame
+ * with the generation of the previous one is skipped and reports no changes. Bands of tile rows
+ * are spread over the pool.
+ * Returns false on allocation failure, in which case the next update reports everything. */
+bool scope_tiles_update(scope_tiles_t *tiles, const scope_image_t *image, scope_thread_pool_t *pool);
@@ -0,0 +1,66 @@
+#include "scope_internal.h"
+#include "scope_tiles.h"
+
+// SIMD versions of scope_tile_row_scalar. Full tiles are hashed four words at a time, the
+// partial tile at the right edge goes through the scalar kernel. The lanes are sums, so the
+// state comes out identical.
+
+#if SCOPE_X86_SIMD
+
+#include <immintrin.h>
+
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+#define TILE_BYTES (SCOPE_TILE_SIZE * 4)
+
+TARGET_SSE41 static inline __m128i tile_word_sse41(__m128i word, __m128i key) {
+    __m128i mixed = _mm_xor_si128(word, key);
+    return _mm_add_epi64(_mm_mul_epu32(mixed, _mm_srli_epi64(mixed, 32)), word);
+}
+
+TARGET_SSE41 void scope_tile_row_sse41(uint64_t *state, const uint8_t *row, uint32_t width, const uint64_t *keys) {
+    const uint32_t full_tiles = width / SCOPE_TILE_SIZE;
+
+    for (uint32_t t = 0; t < full_tiles; ++t, row += TILE_BYTES, state += 4) {
+        __m128i acc01 = _mm_loadu_si128((const __m128i *)state);
+        __m128i acc23 = _mm_loadu_si128((const __m128i *)(state + 2));
+        for (uint32_t offset = 0; offset < TILE_BYTES; offset += 32) {
+            const uint64_t *k = keys + offset / 8;
+            acc01 = _mm_add_epi64(acc01, tile_word_sse41(_mm_loadu_si128((const __m128i *)(row + offset)), _mm_loadu_si128((const __m128i *)k)));
+            acc23 = _mm_add_epi64(acc23, tile_word_sse41(_mm_loadu_si128((const __m128i *)(row + offset + 16)), _mm_loadu_si128((const __m128i *)(k + 2))));
+        }
+        _mm_storeu_si128((__m128i *)state, acc01);
+        _mm_storeu_si128((__m128i *)(state + 2), acc23);
+    }
+
+    if (width > full_tiles * SCOPE_TILE_SIZE) {
+        scope_tile_row_scalar(state, row, width - full_tiles * SCOPE_TILE_SIZE, keys);
+    }
+}
+
+TARGET_AVX2 void scope_tile_row_avx2(uint64_t *state, const uint8_t *row, uint32_t width, const uint64_t *keys) {
+    const uint32_t full_tiles = width / SCOPE_TILE_SIZE;
+
+    for (uint32_t t = 0; t < full_tiles; ++t, row += TILE_BYTES, state += 4) {
+        // Two accumulators break the dependency chain, folded before storing
+        __m256i acc0 = _mm256_loadu_si256((const __m256i *)state);
+        __m256i acc1 = _mm256_setzero_si256();
+        for (uint32_t offset = 0; offset < TILE_BYTES; offset += 64) {
+            const uint64_t *k = keys + offset / 8;
+            __m256i word0 = _mm256_loadu_si256((const __m256i *)(row + offset));
+            __m256i word1 = _mm256_loadu_si256((const __m256i *)(row + offset + 32));
+            __m256i mixed0 = _mm256_xor_si256(word0, _mm256_loadu_si256((const __m256i *)k));
+            __m256i mixed1 = _mm256_xor_si256(word1, _mm256_loadu_si256((const __m256i *)(k + 4)));
+            acc0 = _mm256_add_epi64(acc0, _mm256_add_epi64(_mm256_mul_epu32(mixed0, _mm256_srli_epi64(mixed0, 32)), word0));
+            acc1 = _mm256_add_epi64(acc1, _mm256_add_epi64(_mm256_mul_epu32(mixed1, _mm256_srli_epi64(mixed1, 32)), word1));
+        }
+        _mm256_storeu_si256((__m256i *)state, _mm256_add_epi64(acc0, acc1));
+    }
+
+    if (width > full_tiles * SCOPE_TILE_SIZE) {
+        scope_tile_row_scalar(state, row, width - full_tiles * SCOPE_TILE_SIZE, keys);
+    }
+}
+
+#endif
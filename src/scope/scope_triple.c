@@ -0,0 +1,30 @@
+#include "scope_triple.h"
+
+#include "scope_internal.h"
+
+#include <assert.h>
+
+#define SLOT_MASK 0x3u
+
+void scope_triple_init(scope_triple_t *triple) {
+    assert(triple);
+    *triple = (scope_triple_t){.middle = 1, .back = 0, .front = 2};
+}
+
+bool scope_triple_publish(scope_triple_t *triple) {
+    // Releases the writes to the back slot to whoever fetches it
+    uint32_t previous = scope_atomic_exchange(&triple->middle, triple->back | SCOPE_TRIPLE_FRESH);
+    triple->back = previous & SLOT_MASK;
+    return (previous & SCOPE_TRIPLE_FRESH) != 0;
+}
+
+bool scope_triple_fetch(scope_triple_t *triple) {
+    if ((scope_atomic_load(&triple->middle) & SCOPE_TRIPLE_FRESH) == 0) {
+        return false;
+    }
+
+    // Only the consumer clears FRESH, so the middle slot is still a fresh one after the check
+    uint32_t previous = scope_atomic_exchange(&triple->middle, triple->front);
+    triple->front = previous & SLOT_MASK;
+    return true;
+}
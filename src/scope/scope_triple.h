@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Lock-free single producer, single consumer triple buffer of slot indices. The producer writes
+// the back slot, the consumer reads the front slot, and the middle slot holds the newest
+// published one. Publishing swaps back and middle, fetching swaps middle and front, each with a
+// single atomic exchange, so neither side ever waits. The newest frame always wins; frames the
+// consumer didn't get to in time are overwritten.
+
+typedef struct scope_triple {
+    volatile uint32_t middle; // slot index, plus SCOPE_TRIPLE_FRESH if not fetched yet
+    uint32_t back;            // producer only
+    uint32_t front;           // consumer only
+} scope_triple_t;
+
+#define SCOPE_TRIPLE_FRESH 0x4u
+
+/* @brief Starts with slot 0 at the back, 1 in the middle and 2 at the front, nothing published. */
+void scope_triple_init(scope_triple_t *triple);
+
+/* @brief Producer: publishes the back slot as the newest frame and moves on to a free one.
+ * Returns true if the frame published before it was dropped without ever being fetched. */
+bool scope_triple_publish(scope_triple_t *triple);
+
+/* @brief Consumer: makes the newest published frame the front slot. Returns false, keeping the
+ * current front slot, if nothing was published since the last fetch. */
+bool scope_triple_fetch(scope_triple_t *triple);
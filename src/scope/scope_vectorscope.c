@@ -0,0 +1,620 @@
+#include "scope_vectorscope.h"
+
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Smallest slice of bins a merge task adds up, so tiny tasks don't drown in scheduling overhead
+#define MERGE_MIN_CHUNK (64 * 1024)
+
+// Row kernel of HDR frames
+typedef void (*row_hdr_fn)(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_pixel_format_t format, const scope_signal_lut_t *lut);
+
+struct accumulate_job {
+    scope_vectorscope_t *vs;
+    const scope_image_t *image;
+    scope_vs_grid_t grid;
+    scope_matrix_weights_t weights; // of vs->encoding, for the per pixel paths
+    scope_vs_row_fn row_fn;
+    row_hdr_fn hdr_fn;
+    const scope_chroma_lut_t *lut; // NULL for the float kernels
+    scope_rgb8_layout_t layout;
+    const scope_code_lut_t *code_lut; // Y'CbCr frames only
+    scope_ycbcr_layout_t ycbcr;
+    const scope_signal_lut_t *signal_lut; // HDR frames only
+    uint32_t band_count;
+
+    // Current merge round
+    uint32_t merge_stride;
+    uint32_t merge_chunks;
+};
+
+SCOPE_FORCE_INLINE bool bin_rgb(float r, float g, float b, scope_vs_grid_t grid, scope_matrix_weights_t w, uint32_t *index) {
+    // Convert to CbCr
+    float cb = r * w.cb[0] + g * w.cb[1] + b * w.cb[2];
+    float cr = r * w.cr[0] + g * w.cr[1] + b * w.cr[2];
+
+    int bx = (int)((cb + 0.5f) * grid.scale) - grid.offset;
+    int by = (int)((cr + 0.5f) * grid.scale) - grid.offset;
+
+    *index = (uint32_t)(by * grid.res + bx);
+    return bx >= 0 && bx < grid.res && by >= 0 && by < grid.res;
+}
+
+// Bin of a single pixel, false if it falls outside the scope
+SCOPE_FORCE_INLINE bool bin_float(const uint8_t *px, scope_rgb8_layout_t layout, scope_vs_grid_t grid, scope_matrix_weights_t w, uint32_t *index) {
+    return bin_rgb(px[layout.r] / 255.0f, px[layout.g] / 255.0f, px[layout.b] / 255.0f, grid, w, index);
+}
+
+SCOPE_FORCE_INLINE bool bin_hdr(const uint8_t *px, scope_pixel_format_t format, const scope_signal_lut_t *lut, scope_vs_grid_t grid, scope_matrix_weights_t w, uint32_t *index) {
+    uint32_t signal[3];
+    scope_hdr_signals(px, format, lut, signal);
+    return bin_rgb(signal[0] / 65535.0f, signal[1] / 65535.0f, signal[2] / 65535.0f, grid, w, index);
+}
+
+// The float kernels of a whole row, instanced per encoding below
+SCOPE_FORCE_INLINE void row_float(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, scope_encoding_t encoding) {
+    const scope_matrix_weights_t w = scope_encoding_weights(encoding);
+    const uint8_t *px = row;
+
+    for (uint32_t x = 0; x < width; ++x, px += 4) {
+        uint32_t index;
+        if (bin_float(px, layout, grid, w, &index)) {
+            scope_vs_add(bins, tiles, (uint32_t)grid.res, index, 1);
+        }
+    }
+}
+
+SCOPE_FORCE_INLINE void row_hdr(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_pixel_format_t format, const scope_signal_lut_t *lut, scope_encoding_t encoding) {
+    const scope_matrix_weights_t w = scope_encoding_weights(encoding);
+    const uint32_t pixel_bytes = scope_pixel_format_bytes(format);
+    const uint8_t *px = row;
+
+    for (uint32_t x = 0; x < width; ++x, px += pixel_bytes) {
+        uint32_t index;
+        if (bin_hdr(px, format, lut, grid, w, &index)) {
+            scope_vs_add(bins, tiles, (uint32_t)grid.res, index, 1);
+        }
+    }
+}
+
+#define ROW_VARIANTS(name, matrix, range) \
+    static void row_scalar_##name(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout) { \
+        row_float(bins, tiles, grid, row, width, layout, (scope_encoding_t){matrix, range}); \
+    } \
+    static void row_hdr_##name(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_pixel_format_t format, const scope_signal_lut_t *lut) { \
+        row_hdr(bins, tiles, grid, row, width, format, lut, (scope_encoding_t){matrix, range}); \
+    }
+#define ROW_SCALAR_ENTRY(name, matrix, range) row_scalar_##name,
+#define ROW_HDR_ENTRY(name, matrix, range) row_hdr_##name,
+
+SCOPE_ENCODINGS(ROW_VARIANTS)
+
+const scope_vs_row_fn scope_vs_rows_scalar[SCOPE_ENCODING_COUNT] = {SCOPE_ENCODINGS(ROW_SCALAR_ENTRY)};
+static const row_hdr_fn row_hdr_variants[SCOPE_ENCODING_COUNT] = {SCOPE_ENCODINGS(ROW_HDR_ENTRY)};
+
+static inline bool bin_lut(const uint8_t *px, scope_rgb8_layout_t layout, const scope_chroma_lut_t *lut, int res, uint32_t *index) {
+    uint32_t cb = (uint32_t)(lut->cb[0][px[layout.r]] + lut->cb[1][px[layout.g]] + lut->cb[2][px[layout.b]]);
+    uint32_t cr = (uint32_t)(lut->cr[0][px[layout.r]] + lut->cr[1][px[layout.g]] + lut->cr[2][px[layout.b]]);
+
+    // Sums below zero wrap to huge unsigned values, so one compare covers both ends of the range
+    const uint32_t limit = (uint32_t)res << SCOPE_LUT_FRAC_BITS;
+
+    *index = (cr >> SCOPE_LUT_FRAC_BITS) * (uint32_t)res + (cb >> SCOPE_LUT_FRAC_BITS);
+    return cb < limit && cr < limit;
+}
+
+// Cb/Cr bin of the chroma sample covering pixel (x, y) of a Y'CbCr frame
+static inline bool bin_ycbcr(const scope_image_t *image, scope_ycbcr_layout_t l, const uint16_t *index, uint32_t res, uint32_t x, uint32_t y, uint32_t *out) {
+    const uint32_t step = l.interleaved ? 2 * l.sample_bytes : l.sample_bytes;
+    const size_t offset = (size_t)(y >> l.y_shift) * image->chroma_stride + (size_t)(x >> l.x_shift) * step;
+    const uint8_t *cb = image->chroma[0] + offset;
+    const uint8_t *cr = l.interleaved ? cb + l.sample_bytes : image->chroma[1] + offset;
+
+    uint32_t bx = index[scope_ycbcr_sample(cb, l.sample_bytes, l.sample_shift, l.bits)];
+    uint32_t by = index[scope_ycbcr_sample(cr, l.sample_bytes, l.sample_shift, l.bits)];
+
+    *out = by * res + bx;
+    return bx < res && by < res;
+}
+
+static struct accumulate_job prepare_job(scope_vectorscope_t *vs, const scope_image_t *image);
+static void clear_tiles(const scope_vectorscope_t *vs, uint32_t *bins, uint8_t *tiles);
+static void accumulate_rows(const struct accumulate_job *job, uint32_t *bins, uint8_t *tiles, uint32_t row_begin, uint32_t row_end);
+static void row_lut(uint32_t *bins, uint8_t *tiles, int res, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, const scope_chroma_lut_t *lut);
+static void accumulate_ycbcr_rows(const struct accumulate_job *job, uint32_t *bins, uint8_t *tiles, uint32_t row_begin, uint32_t row_end);
+static scope_vs_row_fn get_row_kernel(scope_isa_t isa, scope_encoding_t encoding);
+static bool reserve_private_bins(scope_vectorscope_t *vs, uint32_t count);
+static uint32_t *band_bins(scope_vectorscope_t *vs, uint32_t band);
+static uint8_t *band_tiles(scope_vectorscope_t *vs, uint32_t band);
+static void accumulate_band_task(void *user_data, uint32_t band);
+static void merge_task(void *user_data, uint32_t task);
+
+bool scope_vectorscope_create(scope_vectorscope_t *vs) {
+    assert(vs);
+
+    *vs = (scope_vectorscope_t){
+        .resolution = SCOPE_VS_RESOLUTION,
+        .zoom = 1,
+        .encoding = scope_config_preset(SCOPE_QUALITY_DEFAULT).encoding,
+        .isa = scope_cpu_best_isa(),
+        .kernel = SCOPE_KERNEL_LUT,
+    };
+
+    vs->tiles_per_row = scope_vs_tiles_per_row(vs->resolution);
+    vs->bins = calloc((size_t)vs->resolution * vs->resolution, sizeof(uint32_t));
+    vs->tiles = calloc((size_t)vs->tiles_per_row * vs->tiles_per_row, 1);
+    vs->signal_lut = calloc(1, sizeof(scope_signal_lut_t));
+    if (!vs->bins || !vs->tiles || !vs->signal_lut) {
+        free(vs->bins);
+        free(vs->tiles);
+        free(vs->signal_lut);
+        vs->bins = NULL;
+        vs->tiles = NULL;
+        vs->signal_lut = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void scope_vectorscope_destroy(scope_vectorscope_t *vs) {
+    if (vs) {
+        free(vs->bins);
+        free(vs->tiles);
+        free(vs->private_bins);
+        free(vs->private_tiles);
+        free(vs->signal_lut);
+        vs->bins = NULL;
+        vs->tiles = NULL;
+        vs->private_bins = NULL;
+        vs->private_tiles = NULL;
+        vs->signal_lut = NULL;
+        vs->private_count = 0;
+        vs->resolution = 0;
+        vs->tiles_per_row = 0;
+    }
+}
+
+bool scope_vectorscope_configure(scope_vectorscope_t *vs, const scope_config_t *config) {
+    assert(vs && vs->bins);
+    assert(config && config->vs_resolution > 0);
+    assert(config->vs_zoom >= 1 && config->vs_zoom <= SCOPE_VS_MAX_ZOOM);
+
+    if (config->vs_resolution == vs->resolution) {
+        if (config->vs_zoom != vs->zoom || scope_encoding_index(config->encoding) != scope_encoding_index(vs->encoding)) {
+            // Same grid over another part of the plane, or other colors in it, the next
+            // accumulation starts over
+            scope_vectorscope_clear(vs);
+            vs->zoom = config->vs_zoom;
+            vs->encoding = config->encoding;
+        }
+        return true;
+    }
+
+    const uint32_t tiles_per_row = scope_vs_tiles_per_row(config->vs_resolution);
+    uint32_t *bins = calloc((size_t)config->vs_resolution * config->vs_resolution, sizeof(uint32_t));
+    uint8_t *tiles = calloc((size_t)tiles_per_row * tiles_per_row, 1);
+    if (!bins || !tiles) {
+        free(bins);
+        free(tiles);
+        return false;
+    }
+
+    // The private histograms come back at the new size with the next parallel update, the
+    // tables are rebuilt for the new resolution by the next accumulation
+    free(vs->bins);
+    free(vs->tiles);
+    free(vs->private_bins);
+    free(vs->private_tiles);
+    vs->bins = bins;
+    vs->tiles = tiles;
+    vs->private_bins = NULL;
+    vs->private_tiles = NULL;
+    vs->private_count = 0;
+    vs->resolution = config->vs_resolution;
+    vs->zoom = config->vs_zoom;
+    vs->encoding = config->encoding;
+    vs->tiles_per_row = tiles_per_row;
+    vs->generation = 0;
+    return true;
+}
+
+void scope_vectorscope_clear(scope_vectorscope_t *vs) {
+    assert(vs && vs->bins);
+    clear_tiles(vs, vs->bins, vs->tiles);
+    vs->generation = 0;
+}
+
+bool scope_vectorscope_bounds(const scope_vectorscope_t *vs, scope_rect_t *bounds) {
+    assert(vs && vs->tiles);
+    assert(bounds);
+
+    uint32_t x_min = UINT32_MAX, y_min = UINT32_MAX, x_max = 0, y_max = 0;
+    for (uint32_t ty = 0; ty < vs->tiles_per_row; ++ty) {
+        const uint8_t *row = vs->tiles + (size_t)ty * vs->tiles_per_row;
+        for (uint32_t tx = 0; tx < vs->tiles_per_row; ++tx) {
+            if (!row[tx]) continue;
+
+            x_min = MIN(x_min, tx);
+            x_max = MAX(x_max, tx);
+            y_min = MIN(y_min, ty);
+            y_max = MAX(y_max, ty);
+        }
+    }
+
+    if (x_min == UINT32_MAX) {
+        *bounds = (scope_rect_t){0};
+        return false;
+    }
+
+    const uint32_t x = x_min * SCOPE_VS_TILE_SIZE;
+    const uint32_t y = y_min * SCOPE_VS_TILE_SIZE;
+    *bounds = (scope_rect_t){
+        .x = x,
+        .y = y,
+        .width = MIN((x_max + 1) * SCOPE_VS_TILE_SIZE, vs->resolution) - x,
+        .height = MIN((y_max + 1) * SCOPE_VS_TILE_SIZE, vs->resolution) - y,
+    };
+    return true;
+}
+
+void scope_vectorscope_accumulate(scope_vectorscope_t *vs, const scope_image_t *image) {
+    assert(vs && vs->bins);
+    assert(image && image->data);
+
+    struct accumulate_job job = prepare_job(vs, image);
+    accumulate_rows(&job, vs->bins, vs->tiles, 0, image->height);
+}
+
+bool scope_vectorscope_update(scope_vectorscope_t *vs, const scope_image_t *image, scope_thread_pool_t *pool) {
+    assert(vs && vs->bins);
+    assert(image && image->data);
+
+    if (image->generation != 0 && image->generation == vs->generation) {
+        return false;
+    }
+
+    scope_vectorscope_clear(vs);
+    if (!scope_vectorscope_accumulate_parallel(vs, image, pool)) {
+        // Not enough memory for the private histograms
+        scope_vectorscope_accumulate(vs, image);
+    }
+
+    vs->generation = image->generation;
+    return true;
+}
+
+bool scope_vectorscope_accumulate_parallel(scope_vectorscope_t *vs, const scope_image_t *image, scope_thread_pool_t *pool) {
+    assert(vs && vs->bins);
+    assert(image && image->data);
+
+    uint32_t band_count = MIN(scope_thread_pool_size(pool), image->height);
+    if (band_count <= 1) {
+        scope_vectorscope_accumulate(vs, image);
+        return true;
+    }
+
+    if (!reserve_private_bins(vs, band_count - 1)) {
+        return false;
+    }
+
+    struct accumulate_job job = prepare_job(vs, image);
+    job.band_count = band_count;
+
+    scope_thread_pool_run(pool, band_count, accumulate_band_task, &job);
+
+    // Tree merge: each round adds histogram i + stride into i for every i that is a multiple of
+    // 2 * stride, until everything ends up in band 0 (vs->bins). Pairs are additionally split
+    // into ranges of tiles so the last rounds, with only a few pairs left, still use every thread.
+    const uint32_t tile_count = vs->tiles_per_row * vs->tiles_per_row;
+    const uint32_t max_chunks = CLAMP(vs->resolution * vs->resolution / MERGE_MIN_CHUNK, 1u, tile_count);
+    for (uint32_t stride = 1; stride < band_count; stride *= 2) {
+        uint32_t pairs = (band_count - stride + 2 * stride - 1) / (2 * stride);
+        uint32_t chunks = (scope_thread_pool_size(pool) + pairs - 1) / pairs;
+
+        job.merge_stride = stride;
+        job.merge_chunks = MIN(chunks, max_chunks);
+        scope_thread_pool_run(pool, pairs * job.merge_chunks, merge_task, &job);
+    }
+
+    return true;
+}
+
+void scope_vectorscope_accumulate_sampled(scope_vectorscope_t *vs, const scope_image_t *image, const scope_sampling_t *sampling) {
+    assert(vs && vs->bins);
+    assert(image && image->data);
+    assert(sampling);
+
+    const struct accumulate_job job = prepare_job(vs, image);
+    const scope_sample_plan_t plan = scope_sample_plan(sampling, image->width, image->height);
+    const int res = job.grid.res;
+
+    for (uint32_t i = 0; i < plan.count; ++i) {
+        uint32_t x, y, index;
+        const uint32_t weight = scope_sample_position(&plan, i, &x, &y);
+
+        bool hit;
+        if (job.code_lut) {
+            hit = bin_ycbcr(image, job.ycbcr, job.code_lut->index, (uint32_t)res, x, y, &index);
+        } else if (job.signal_lut) {
+            const uint8_t *px = scope_image_row(image, y) + (size_t)x * scope_pixel_format_bytes(image->format);
+            hit = bin_hdr(px, image->format, job.signal_lut, job.grid, job.weights, &index);
+        } else {
+            const uint8_t *px = scope_image_row(image, y) + (size_t)x * 4;
+            hit = job.lut ? bin_lut(px, job.layout, job.lut, res, &index) : bin_float(px, job.layout, job.grid, job.weights, &index);
+        }
+        if (hit) {
+            scope_vs_add(vs->bins, vs->tiles, (uint32_t)res, index, weight);
+        }
+    }
+}
+
+void scope_vectorscope_replace_span(scope_vectorscope_t *vs, const scope_image_t *old_frame, const scope_image_t *new_frame, uint32_t y, uint32_t x_begin, uint32_t x_end) {
+    assert(vs && vs->bins);
+    assert(old_frame && new_frame);
+    assert(old_frame->width == new_frame->width && old_frame->format == new_frame->format);
+    assert(scope_pixel_format_is_rgb8(new_frame->format));
+    assert(x_end <= new_frame->width && y < new_frame->height);
+
+    const struct accumulate_job job = prepare_job(vs, new_frame);
+    const int res = job.grid.res;
+    const uint8_t *old_px = scope_image_row(old_frame, y) + (size_t)x_begin * 4;
+    const uint8_t *new_px = scope_image_row(new_frame, y) + (size_t)x_begin * 4;
+
+    for (uint32_t x = x_begin; x < x_end; ++x, old_px += 4, new_px += 4) {
+        // Dirty rects are coarse, most of their pixels usually did not change
+        if (memcmp(old_px, new_px, 4) == 0) continue;
+
+        uint32_t index;
+        bool hit = job.lut ? bin_lut(old_px, job.layout, job.lut, res, &index) : bin_float(old_px, job.layout, job.grid, job.weights, &index);
+        if (hit) {
+            // The bins have to hold old_frame exactly, anything else would wrap here
+            assert(vs->bins[index] > 0);
+            vs->bins[index]--;
+        }
+
+        hit = job.lut ? bin_lut(new_px, job.layout, job.lut, res, &index) : bin_float(new_px, job.layout, job.grid, job.weights, &index);
+        if (hit) {
+            scope_vs_add(vs->bins, vs->tiles, (uint32_t)res, index, 1);
+        }
+    }
+}
+
+static struct accumulate_job prepare_job(scope_vectorscope_t *vs, const scope_image_t *image) {
+    struct accumulate_job job = {
+        .vs = vs,
+        .image = image,
+        .grid = scope_vs_grid(vs->resolution, vs->zoom),
+        .weights = scope_encoding_weights(vs->encoding),
+        .layout = scope_rgb8_layout(image->format),
+        .band_count = 1,
+    };
+
+    if (scope_pixel_format_is_hdr(image->format)) {
+        scope_signal_lut_update(vs->signal_lut, image->format, image->transfer);
+        job.signal_lut = vs->signal_lut;
+        job.hdr_fn = row_hdr_variants[scope_encoding_index(vs->encoding)];
+    } else if (scope_pixel_format_is_ycbcr(image->format)) {
+        job.ycbcr = scope_ycbcr_layout(image->format);
+        scope_code_lut_update(&vs->code_lut, true, vs->resolution, vs->zoom, job.ycbcr.bits, image->range, vs->encoding.range);
+        job.code_lut = &vs->code_lut;
+    } else if (vs->kernel == SCOPE_KERNEL_LUT) {
+        // Has to happen before any worker reads the tables
+        scope_chroma_lut_update(&vs->lut, vs->resolution, vs->zoom, vs->encoding);
+        job.lut = &vs->lut;
+    } else {
+        job.row_fn = get_row_kernel(vs->isa, vs->encoding);
+    }
+
+    return job;
+}
+
+// Zeroes the bins of the marked tiles of one histogram and unmarks them
+static void clear_tiles(const scope_vectorscope_t *vs, uint32_t *bins, uint8_t *tiles) {
+    const uint32_t res = vs->resolution;
+
+    for (uint32_t ty = 0; ty < vs->tiles_per_row; ++ty) {
+        for (uint32_t tx = 0; tx < vs->tiles_per_row; ++tx) {
+            uint8_t *tile = tiles + (size_t)ty * vs->tiles_per_row + tx;
+            if (!*tile) continue;
+            *tile = 0;
+
+            const uint32_t x = tx * SCOPE_VS_TILE_SIZE;
+            const uint32_t width = MIN(SCOPE_VS_TILE_SIZE, res - x);
+            const uint32_t y_end = MIN((ty + 1) * SCOPE_VS_TILE_SIZE, res);
+            for (uint32_t y = ty * SCOPE_VS_TILE_SIZE; y < y_end; ++y) {
+                memset(bins + (size_t)y * res + x, 0, width * sizeof(uint32_t));
+            }
+        }
+    }
+}
+
+static void accumulate_rows(const struct accumulate_job *job, uint32_t *bins, uint8_t *tiles, uint32_t row_begin, uint32_t row_end) {
+    const scope_image_t *image = job->image;
+    const int res = job->grid.res;
+
+    if (job->code_lut) {
+        accumulate_ycbcr_rows(job, bins, tiles, row_begin, row_end);
+        return;
+    }
+
+    for (uint32_t y = row_begin; y < row_end; ++y) {
+        if (job->signal_lut) {
+            job->hdr_fn(bins, tiles, job->grid, scope_image_row(image, y), image->width, image->format, job->signal_lut);
+        } else if (job->lut) {
+            row_lut(bins, tiles, res, scope_image_row(image, y), image->width, job->layout, job->lut);
+        } else {
+            job->row_fn(bins, tiles, job->grid, scope_image_row(image, y), image->width, job->layout);
+        }
+    }
+}
+
+static void row_lut(uint32_t *bins, uint8_t *tiles, int res, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, const scope_chroma_lut_t *lut) {
+    const uint8_t *px = row;
+
+    for (uint32_t x = 0; x < width; ++x, px += 4) {
+        uint32_t index;
+        if (bin_lut(px, layout, lut, res, &index)) {
+            scope_vs_add(bins, tiles, (uint32_t)res, index, 1);
+        }
+    }
+}
+
+// One row of chroma samples, every one but the last covering `weight` pixels. Called with constant
+// sample sizes, so each depth gets its own loop without per-sample branches.
+static inline void chroma_row(uint32_t *bins, uint8_t *tiles, uint32_t res, const uint16_t *index, const uint8_t *cb, const uint8_t *cr, uint32_t step,
+                              uint32_t sample_bytes, uint32_t shift, uint32_t bits, uint32_t count, uint32_t weight, uint32_t last_weight) {
+    for (uint32_t x = 0; x < count; ++x, cb += step, cr += step) {
+        uint32_t bx = index[scope_ycbcr_sample(cb, sample_bytes, shift, bits)];
+        uint32_t by = index[scope_ycbcr_sample(cr, sample_bytes, shift, bits)];
+        if (bx < res && by < res) {
+            scope_vs_add(bins, tiles, res, by * res + bx, x + 1 < count ? weight : last_weight);
+        }
+    }
+}
+
+// Bins the chroma rows whose first pixel row is in [row_begin, row_end). Samples at the right and
+// bottom edge of odd sized frames cover fewer pixels and are weighted accordingly.
+static void accumulate_ycbcr_rows(const struct accumulate_job *job, uint32_t *bins, uint8_t *tiles, uint32_t row_begin, uint32_t row_end) {
+    const scope_image_t *image = job->image;
+    const scope_ycbcr_layout_t l = job->ycbcr;
+    const uint32_t res = job->vs->resolution;
+    const uint16_t *index = job->code_lut->index;
+
+    const uint32_t sub_x = 1u << l.x_shift;
+    const uint32_t sub_y = 1u << l.y_shift;
+    const uint32_t chroma_width = (image->width + sub_x - 1) >> l.x_shift;
+    const uint32_t last_width = image->width - ((chroma_width - 1) << l.x_shift);
+    const uint32_t step = l.interleaved ? 2 * l.sample_bytes : l.sample_bytes;
+
+    for (uint32_t cy = (row_begin + sub_y - 1) >> l.y_shift; cy < (row_end + sub_y - 1) >> l.y_shift; ++cy) {
+        const uint32_t rows = MIN(sub_y, image->height - (cy << l.y_shift));
+        const uint8_t *cb = image->chroma[0] + (size_t)cy * image->chroma_stride;
+        const uint8_t *cr = l.interleaved ? cb + l.sample_bytes : image->chroma[1] + (size_t)cy * image->chroma_stride;
+
+        if (l.sample_bytes == 1) {
+            chroma_row(bins, tiles, res, index, cb, cr, step, 1, 0, 8, chroma_width, rows * sub_x, rows * last_width);
+        } else {
+            chroma_row(bins, tiles, res, index, cb, cr, step, 2, l.sample_shift, l.bits, chroma_width, rows * sub_x, rows * last_width);
+        }
+    }
+}
+
+static bool reserve_private_bins(scope_vectorscope_t *vs, uint32_t count) {
+    if (vs->private_count >= count) {
+        return true;
+    }
+
+    size_t bin_count = (size_t)vs->resolution * vs->resolution;
+    size_t tile_count = (size_t)vs->tiles_per_row * vs->tiles_per_row;
+    uint32_t *bins = realloc(vs->private_bins, bin_count * count * sizeof(uint32_t));
+    if (!bins) {
+        return false;
+    }
+    vs->private_bins = bins;
+
+    uint8_t *tiles = realloc(vs->private_tiles, tile_count * count);
+    if (!tiles) {
+        return false;
+    }
+    vs->private_tiles = tiles;
+
+    // New histograms start out empty, after that clearing only has to visit their marked tiles
+    memset(bins + bin_count * vs->private_count, 0, bin_count * (count - vs->private_count) * sizeof(uint32_t));
+    memset(tiles + tile_count * vs->private_count, 0, tile_count * (count - vs->private_count));
+    vs->private_count = count;
+    return true;
+}
+
+static uint32_t *band_bins(scope_vectorscope_t *vs, uint32_t band) {
+    if (band == 0) {
+        return vs->bins;
+    }
+    return vs->private_bins + (size_t)(band - 1) * vs->resolution * vs->resolution;
+}
+
+static uint8_t *band_tiles(scope_vectorscope_t *vs, uint32_t band) {
+    if (band == 0) {
+        return vs->tiles;
+    }
+    return vs->private_tiles + (size_t)(band - 1) * vs->tiles_per_row * vs->tiles_per_row;
+}
+
+static void accumulate_band_task(void *user_data, uint32_t band) {
+    struct accumulate_job *job = user_data;
+    scope_vectorscope_t *vs = job->vs;
+    const scope_image_t *image = job->image;
+
+    uint32_t *bins = band_bins(vs, band);
+    uint8_t *tiles = band_tiles(vs, band);
+    if (band > 0) {
+        // Private histograms start from zero, the shared one keeps what it already had
+        clear_tiles(vs, bins, tiles);
+    }
+
+    uint32_t row_begin = (uint32_t)((uint64_t)image->height * band / job->band_count);
+    uint32_t row_end = (uint32_t)((uint64_t)image->height * (band + 1) / job->band_count);
+    accumulate_rows(job, bins, tiles, row_begin, row_end);
+}
+
+static void merge_task(void *user_data, uint32_t task) {
+    struct accumulate_job *job = user_data;
+    scope_vectorscope_t *vs = job->vs;
+
+    uint32_t pair = task / job->merge_chunks;
+    uint32_t chunk = task % job->merge_chunks;
+    uint32_t dst_band = pair * 2 * job->merge_stride;
+    uint32_t src_band = dst_band + job->merge_stride;
+    if (src_band >= job->band_count) {
+        return;
+    }
+
+    const uint32_t res = vs->resolution;
+    const uint32_t tile_count = vs->tiles_per_row * vs->tiles_per_row;
+    const uint32_t begin = (uint32_t)((uint64_t)tile_count * chunk / job->merge_chunks);
+    const uint32_t end = (uint32_t)((uint64_t)tile_count * (chunk + 1) / job->merge_chunks);
+
+    uint32_t *restrict dst = band_bins(vs, dst_band);
+    const uint32_t *restrict src = band_bins(vs, src_band);
+    uint8_t *dst_tiles = band_tiles(vs, dst_band);
+    const uint8_t *src_tiles = band_tiles(vs, src_band);
+
+    // Only the tiles the band above filled have anything to add
+    for (uint32_t t = begin; t < end; ++t) {
+        if (!src_tiles[t]) continue;
+        dst_tiles[t] = 1;
+
+        const uint32_t x = t % vs->tiles_per_row * SCOPE_VS_TILE_SIZE;
+        const uint32_t width = MIN(SCOPE_VS_TILE_SIZE, res - x);
+        const uint32_t y_begin = t / vs->tiles_per_row * SCOPE_VS_TILE_SIZE;
+        const uint32_t y_end = MIN(y_begin + SCOPE_VS_TILE_SIZE, res);
+        for (uint32_t y = y_begin; y < y_end; ++y) {
+            const size_t row = (size_t)y * res + x;
+            for (uint32_t i = 0; i < width; ++i) {
+                dst[row + i] += src[row + i];
+            }
+        }
+    }
+}
+
+static scope_vs_row_fn get_row_kernel(scope_isa_t isa, scope_encoding_t encoding) {
+    // Never run a kernel the CPU can't execute, even if the caller asked for it
+    if (!scope_cpu_supports(isa)) {
+        isa = scope_cpu_best_isa();
+    }
+
+    const uint32_t variant = scope_encoding_index(encoding);
+    switch (isa) {
+#if SCOPE_X86_SIMD
+        case SCOPE_ISA_AVX512: return scope_vs_rows_avx512[variant];
+        case SCOPE_ISA_AVX2: return scope_vs_rows_avx2[variant];
+        case SCOPE_ISA_SSE41: return scope_vs_rows_sse41[variant];
+#endif
+        default: return scope_vs_rows_scalar[variant];
+    }
+}
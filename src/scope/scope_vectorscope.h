@@ -0,0 +1,78 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_cpu.h"
+#include "scope_lut.h"
+#include "scope_sample.h"
+#include "scope_thread.h"
+
+typedef struct scope_vectorscope {
+    // resolution x resolution hit counts, row index is Cr and column index is Cb. Created at
+    // SCOPE_VS_RESOLUTION, scope_vectorscope_configure() changes it.
+    uint32_t *bins;
+    uint32_t resolution;
+    // Magnification around neutral, 1 to SCOPE_VS_MAX_ZOOM: the bins are the centered window of a
+    // grid zoom times as fine, pixels outside it are dropped before they reach a bin
+    uint32_t zoom;
+    // What Cb/Cr are measured in, every kernel is specialized for it (see SCOPE_ENCODINGS)
+    scope_encoding_t encoding;
+
+    // Occupancy of the bins in tiles of 32 x 32, row-major like the bins: non-zero for every tile
+    // that has been hit since the last clear, so every non-zero bin lies in a marked tile. Graded
+    // footage fills a small part of the plane, clearing and merging only visit the marked tiles
+    // and the blur only their bounds (scope_vectorscope_bounds()).
+    uint8_t *tiles;
+    uint32_t tiles_per_row;
+
+    // Kernel used for accumulation, picked at creation from the CPU features.
+    // Can be lowered afterwards, e.g. to compare against the scalar path.
+    scope_isa_t isa;
+
+    // The LUT kernel only needs the tables, which are rebuilt when the resolution, zoom or
+    // encoding changes
+    scope_kernel_t kernel;
+    scope_chroma_lut_t lut;
+
+    // Y'CbCr frames are binned straight from their Cb/Cr samples through this table, whatever
+    // the kernel. Each sample counts once for every pixel it covers.
+    scope_code_lut_t code_lut;
+
+    // HDR frames are binned from their signals (see scope_hdr.h) with the float math, whatever the
+    // kernel. The table is allocated with the bins.
+    scope_signal_lut_t *signal_lut;
+
+    // Private histograms for parallel accumulation, one per extra worker band.
+    // The first band always accumulates straight into `bins`.
+    uint32_t *private_bins;
+    uint8_t *private_tiles;
+    uint32_t private_count;
+
+    // Generation of the frame the bins were last built from by scope_vectorscope_update(), 0 if none
+    uint64_t generation;
+} scope_vectorscope_t;
+
+bool scope_vectorscope_create(scope_vectorscope_t *vs);
+void scope_vectorscope_destroy(scope_vectorscope_t *vs);
+/* @brief Switches to the vectorscope resolution, zoom and encoding of `config`. The bins are
+ * reallocated, or cleared for a new zoom or encoding, if any changed, so a scope_incremental_t
+ * using them has to be invalidated.
+ * Returns false on allocation failure, keeping the current bins. */
+bool scope_vectorscope_configure(scope_vectorscope_t *vs, const scope_config_t *config);
+/* @brief Zeroes the bins of the marked tiles and unmarks them */
+void scope_vectorscope_clear(scope_vectorscope_t *vs);
+void scope_vectorscope_accumulate(scope_vectorscope_t *vs, const scope_image_t *image);
+/* @brief Rebuilds the bins from `image`, unless they already hold the frame with the same non-zero
+ * generation. Returns false if the frame was unchanged and nothing was done. `pool` may be NULL. */
+bool scope_vectorscope_update(scope_vectorscope_t *vs, const scope_image_t *image, scope_thread_pool_t *pool);
+/* @brief Splits the image into row bands, bins each band into a private histogram on its own
+ * thread and combines them with a parallel tree merge. No bin is ever shared between threads. */
+bool scope_vectorscope_accumulate_parallel(scope_vectorscope_t *vs, const scope_image_t *image, scope_thread_pool_t *pool);
+/* @brief Bins at most `sampling->budget` pixels, each weighted by the number of pixels it represents */
+void scope_vectorscope_accumulate_sampled(scope_vectorscope_t *vs, const scope_image_t *image, const scope_sampling_t *sampling);
+/* @brief Moves the hits of pixels [x_begin, x_end) on row y from their bins in `old_frame` to their bins
+ * in `new_frame`. Both frames have the same size and 8-bit RGB format, and the histogram must already
+ * contain the old pixels, binned with the same kernel. */
+void scope_vectorscope_replace_span(scope_vectorscope_t *vs, const scope_image_t *old_frame, const scope_image_t *new_frame, uint32_t y, uint32_t x_begin, uint32_t x_end);
+/* @brief Bounds of the marked tiles in bins, clipped to the grid. Every bin outside is zero.
+ * Returns false, with an empty rect, if no tile is marked. */
+bool scope_vectorscope_bounds(const scope_vectorscope_t *vs, scope_rect_t *bounds);
@@ -0,0 +1,189 @@
+#include "scope_internal.h"
+
+// SIMD versions of the scalar row kernels, instanced per encoding like them. Every lane performs
+// the exact same sequence of IEEE single precision operations as the scalar kernel (convert,
+// divide, multiply, add, truncate) with the same weights and integer window offset, so the
+// resulting bins are bit-identical. Only the final increment, which also marks the tile of a bin
+// it fills, is done per lane, since the scatter into the histogram can't be vectorized without
+// conflict handling.
+
+#if SCOPE_X86_SIMD
+
+#include <immintrin.h>
+
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+SCOPE_FORCE_INLINE TARGET_SSE41 void vs_row_sse41(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, scope_encoding_t encoding) {
+    const scope_matrix_weights_t w = scope_encoding_weights(encoding);
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+    const __m128i shift_r = _mm_cvtsi32_si128((int)layout.r * 8);
+    const __m128i shift_g = _mm_cvtsi32_si128((int)layout.g * 8);
+    const __m128i shift_b = _mm_cvtsi32_si128((int)layout.b * 8);
+    const __m128 unorm_div = _mm_set1_ps(255.0f);
+    const __m128 cb_r = _mm_set1_ps(w.cb[0]);
+    const __m128 cb_g = _mm_set1_ps(w.cb[1]);
+    const __m128 cb_b = _mm_set1_ps(w.cb[2]);
+    const __m128 cr_r = _mm_set1_ps(w.cr[0]);
+    const __m128 cr_g = _mm_set1_ps(w.cr[1]);
+    const __m128 cr_b = _mm_set1_ps(w.cr[2]);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 scale = _mm_set1_ps(grid.scale);
+    const __m128i offset = _mm_set1_epi32(grid.offset);
+    const __m128i res_i = _mm_set1_epi32(grid.res);
+    const __m128i minus_one = _mm_set1_epi32(-1);
+
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i *)(row + x * 4));
+
+        __m128 r = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(px, shift_r), byte_mask)), unorm_div);
+        __m128 g = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(px, shift_g), byte_mask)), unorm_div);
+        __m128 b = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(px, shift_b), byte_mask)), unorm_div);
+
+        __m128 cb = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, cb_r), _mm_mul_ps(g, cb_g)), _mm_mul_ps(b, cb_b));
+        __m128 cr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, cr_r), _mm_mul_ps(g, cr_g)), _mm_mul_ps(b, cr_b));
+
+        __m128i bx = _mm_sub_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(cb, half), scale)), offset);
+        __m128i by = _mm_sub_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(cr, half), scale)), offset);
+
+        __m128i valid = _mm_and_si128(
+            _mm_and_si128(_mm_cmpgt_epi32(bx, minus_one), _mm_cmplt_epi32(bx, res_i)),
+            _mm_and_si128(_mm_cmpgt_epi32(by, minus_one), _mm_cmplt_epi32(by, res_i)));
+
+        // Out of range lanes hit bin 0 with an increment of 0
+        __m128i index = _mm_and_si128(_mm_add_epi32(_mm_mullo_epi32(by, res_i), bx), valid);
+        __m128i inc = _mm_srli_epi32(valid, 31);
+
+        uint32_t lane_index[4], lane_inc[4];
+        _mm_storeu_si128((__m128i *)lane_index, index);
+        _mm_storeu_si128((__m128i *)lane_inc, inc);
+        for (int i = 0; i < 4; ++i) {
+            scope_vs_add(bins, tiles, (uint32_t)grid.res, lane_index[i], lane_inc[i]);
+        }
+    }
+
+    scope_vs_rows_scalar[scope_encoding_index(encoding)](bins, tiles, grid, row + x * 4, width - x, layout);
+}
+
+SCOPE_FORCE_INLINE TARGET_AVX2 void vs_row_avx2(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, scope_encoding_t encoding) {
+    const scope_matrix_weights_t w = scope_encoding_weights(encoding);
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m128i shift_r = _mm_cvtsi32_si128((int)layout.r * 8);
+    const __m128i shift_g = _mm_cvtsi32_si128((int)layout.g * 8);
+    const __m128i shift_b = _mm_cvtsi32_si128((int)layout.b * 8);
+    const __m256 unorm_div = _mm256_set1_ps(255.0f);
+    const __m256 cb_r = _mm256_set1_ps(w.cb[0]);
+    const __m256 cb_g = _mm256_set1_ps(w.cb[1]);
+    const __m256 cb_b = _mm256_set1_ps(w.cb[2]);
+    const __m256 cr_r = _mm256_set1_ps(w.cr[0]);
+    const __m256 cr_g = _mm256_set1_ps(w.cr[1]);
+    const __m256 cr_b = _mm256_set1_ps(w.cr[2]);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 scale = _mm256_set1_ps(grid.scale);
+    const __m256i offset = _mm256_set1_epi32(grid.offset);
+    const __m256i res_i = _mm256_set1_epi32(grid.res);
+    const __m256i minus_one = _mm256_set1_epi32(-1);
+
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i px = _mm256_loadu_si256((const __m256i *)(row + x * 4));
+
+        __m256 r = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(px, shift_r), byte_mask)), unorm_div);
+        __m256 g = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(px, shift_g), byte_mask)), unorm_div);
+        __m256 b = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(px, shift_b), byte_mask)), unorm_div);
+
+        __m256 cb = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, cb_r), _mm256_mul_ps(g, cb_g)), _mm256_mul_ps(b, cb_b));
+        __m256 cr = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, cr_r), _mm256_mul_ps(g, cr_g)), _mm256_mul_ps(b, cr_b));
+
+        __m256i bx = _mm256_sub_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(cb, half), scale)), offset);
+        __m256i by = _mm256_sub_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(cr, half), scale)), offset);
+
+        __m256i valid = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(bx, minus_one), _mm256_cmpgt_epi32(res_i, bx)),
+            _mm256_and_si256(_mm256_cmpgt_epi32(by, minus_one), _mm256_cmpgt_epi32(res_i, by)));
+
+        __m256i index = _mm256_and_si256(_mm256_add_epi32(_mm256_mullo_epi32(by, res_i), bx), valid);
+        __m256i inc = _mm256_srli_epi32(valid, 31);
+
+        uint32_t lane_index[8], lane_inc[8];
+        _mm256_storeu_si256((__m256i *)lane_index, index);
+        _mm256_storeu_si256((__m256i *)lane_inc, inc);
+        for (int i = 0; i < 8; ++i) {
+            scope_vs_add(bins, tiles, (uint32_t)grid.res, lane_index[i], lane_inc[i]);
+        }
+    }
+
+    scope_vs_rows_scalar[scope_encoding_index(encoding)](bins, tiles, grid, row + x * 4, width - x, layout);
+}
+
+SCOPE_FORCE_INLINE TARGET_AVX512 void vs_row_avx512(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout, scope_encoding_t encoding) {
+    const scope_matrix_weights_t w = scope_encoding_weights(encoding);
+    const __m512i byte_mask = _mm512_set1_epi32(0xFF);
+    const __m128i shift_r = _mm_cvtsi32_si128((int)layout.r * 8);
+    const __m128i shift_g = _mm_cvtsi32_si128((int)layout.g * 8);
+    const __m128i shift_b = _mm_cvtsi32_si128((int)layout.b * 8);
+    const __m512 unorm_div = _mm512_set1_ps(255.0f);
+    const __m512 cb_r = _mm512_set1_ps(w.cb[0]);
+    const __m512 cb_g = _mm512_set1_ps(w.cb[1]);
+    const __m512 cb_b = _mm512_set1_ps(w.cb[2]);
+    const __m512 cr_r = _mm512_set1_ps(w.cr[0]);
+    const __m512 cr_g = _mm512_set1_ps(w.cr[1]);
+    const __m512 cr_b = _mm512_set1_ps(w.cr[2]);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 scale = _mm512_set1_ps(grid.scale);
+    const __m512i offset = _mm512_set1_epi32(grid.offset);
+    const __m512i res_i = _mm512_set1_epi32(grid.res);
+    const __m512i zero = _mm512_setzero_si512();
+
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m512i px = _mm512_loadu_si512((const void *)(row + x * 4));
+
+        __m512 r = _mm512_div_ps(_mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srl_epi32(px, shift_r), byte_mask)), unorm_div);
+        __m512 g = _mm512_div_ps(_mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srl_epi32(px, shift_g), byte_mask)), unorm_div);
+        __m512 b = _mm512_div_ps(_mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srl_epi32(px, shift_b), byte_mask)), unorm_div);
+
+        __m512 cb = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(r, cb_r), _mm512_mul_ps(g, cb_g)), _mm512_mul_ps(b, cb_b));
+        __m512 cr = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(r, cr_r), _mm512_mul_ps(g, cr_g)), _mm512_mul_ps(b, cr_b));
+
+        __m512i bx = _mm512_sub_epi32(_mm512_cvttps_epi32(_mm512_mul_ps(_mm512_add_ps(cb, half), scale)), offset);
+        __m512i by = _mm512_sub_epi32(_mm512_cvttps_epi32(_mm512_mul_ps(_mm512_add_ps(cr, half), scale)), offset);
+
+        __mmask16 valid = _mm512_cmpge_epi32_mask(bx, zero) & _mm512_cmplt_epi32_mask(bx, res_i) &
+                          _mm512_cmpge_epi32_mask(by, zero) & _mm512_cmplt_epi32_mask(by, res_i);
+
+        __m512i index = _mm512_maskz_mov_epi32(valid, _mm512_add_epi32(_mm512_mullo_epi32(by, res_i), bx));
+
+        uint32_t lane_index[16];
+        _mm512_storeu_si512((void *)lane_index, index);
+        for (int i = 0; i < 16; ++i) {
+            scope_vs_add(bins, tiles, (uint32_t)grid.res, lane_index[i], (valid >> i) & 1u);
+        }
+    }
+
+    scope_vs_rows_scalar[scope_encoding_index(encoding)](bins, tiles, grid, row + x * 4, width - x, layout);
+}
+
+#define ROW_VARIANTS(name, matrix, range) \
+    TARGET_SSE41 static void row_sse41_##name(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout) { \
+        vs_row_sse41(bins, tiles, grid, row, width, layout, (scope_encoding_t){matrix, range}); \
+    } \
+    TARGET_AVX2 static void row_avx2_##name(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout) { \
+        vs_row_avx2(bins, tiles, grid, row, width, layout, (scope_encoding_t){matrix, range}); \
+    } \
+    TARGET_AVX512 static void row_avx512_##name(uint32_t *bins, uint8_t *tiles, scope_vs_grid_t grid, const uint8_t *row, uint32_t width, scope_rgb8_layout_t layout) { \
+        vs_row_avx512(bins, tiles, grid, row, width, layout, (scope_encoding_t){matrix, range}); \
+    }
+#define ROW_SSE41_ENTRY(name, matrix, range) row_sse41_##name,
+#define ROW_AVX2_ENTRY(name, matrix, range) row_avx2_##name,
+#define ROW_AVX512_ENTRY(name, matrix, range) row_avx512_##name,
+
+SCOPE_ENCODINGS(ROW_VARIANTS)
+
+const scope_vs_row_fn scope_vs_rows_sse41[SCOPE_ENCODING_COUNT] = {SCOPE_ENCODINGS(ROW_SSE41_ENTRY)};
+const scope_vs_row_fn scope_vs_rows_avx2[SCOPE_ENCODING_COUNT] = {SCOPE_ENCODINGS(ROW_AVX2_ENTRY)};
+const scope_vs_row_fn scope_vs_rows_avx512[SCOPE_ENCODING_COUNT] = {SCOPE_ENCODINGS(ROW_AVX512_ENTRY)};
+
+#endif
@@ -0,0 +1,491 @@
+#include "scope_waveform.h"
+
+#include "scope_internal.h"
+
+#include "../macros.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Columns per 64 bytes of a channel plane row
+#define STRIPE_ALIGN ((uint32_t)(64 / sizeof(uint32_t)))
+
+struct stripe_job {
+    scope_waveform_t *wf;
+    const scope_image_t *image;
+    uint32_t stripe_count;
+    uint32_t line_count;
+};
+
+// Input columns processed together over all rows. Working in blocks keeps the touched part of
+// the channel planes small, and the column ranges only have to be computed once per block.
+#define BLOCK_COLUMNS 128
+
+// Input columns [x_begin, x_end) and the output columns each of them is binned into
+struct column_block {
+    uint32_t x_begin;
+    uint32_t x_end;
+    uint32_t col_begin[BLOCK_COLUMNS];
+    uint32_t col_end[BLOCK_COLUMNS];
+};
+
+static void prepare_kernel(scope_waveform_t *wf, const scope_image_t *image);
+static void accumulate_stripe(scope_waveform_t *wf, const scope_image_t *image, uint32_t col_min, uint32_t col_max);
+static void block_lut(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block);
+static void block_ycbcr(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block);
+static void accumulate_stripe_task(void *user_data, uint32_t stripe);
+
+static inline uint32_t bucket_index(float v, uint32_t buckets) {
+    // Same as clamp((uint)(saturate(v) * BUCKETS), 0, BUCKETS - 1) in wf_accum
+    uint32_t bucket = (uint32_t)(v * (float)buckets);
+    return bucket < buckets ? bucket : buckets - 1;
+}
+
+SCOPE_FORCE_INLINE void buckets_rgb(float r, float g, float b, uint32_t buckets, scope_matrix_weights_t w, scope_color_range_t range, uint32_t out[SCOPE_WF_CHANNEL_COUNT]) {
+    float luma = r * w.luma[0] + g * w.luma[1] + b * w.luma[2];
+
+    out[SCOPE_WF_CHANNEL_R] = bucket_index(scope_encode_level(r, range), buckets);
+    out[SCOPE_WF_CHANNEL_G] = bucket_index(scope_encode_level(g, range), buckets);
+    out[SCOPE_WF_CHANNEL_B] = bucket_index(scope_encode_level(b, range), buckets);
+    out[SCOPE_WF_CHANNEL_LUMA] = bucket_index(scope_encode_level(luma, range), buckets);
+}
+
+// Bucket of every channel of a single pixel
+SCOPE_FORCE_INLINE void buckets_float(const uint8_t *px, scope_rgb8_layout_t layout, uint32_t buckets, scope_matrix_weights_t w, scope_color_range_t range, uint32_t out[SCOPE_WF_CHANNEL_COUNT]) {
+    buckets_rgb(px[layout.r] / 255.0f, px[layout.g] / 255.0f, px[layout.b] / 255.0f, buckets, w, range, out);
+}
+
+// Same for an HDR pixel, whose signals go through the float math whatever the kernel. Luma is
+// then Y' of the signals, like the Y' of BT.2100 Y'CbCr.
+SCOPE_FORCE_INLINE void buckets_hdr(const uint8_t *px, scope_pixel_format_t format, const scope_signal_lut_t *lut, uint32_t buckets, scope_matrix_weights_t w, scope_color_range_t range, uint32_t out[SCOPE_WF_CHANNEL_COUNT]) {
+    uint32_t signal[3];
+    scope_hdr_signals(px, format, lut, signal);
+    buckets_rgb(signal[0] / 65535.0f, signal[1] / 65535.0f, signal[2] / 65535.0f, buckets, w, range, out);
+}
+
+static inline void buckets_lut(const uint8_t *px, scope_rgb8_layout_t layout, const scope_luma_lut_t *lut, uint32_t max_bucket, uint32_t out[SCOPE_WF_CHANNEL_COUNT]) {
+    uint8_t r = px[layout.r];
+    uint8_t g = px[layout.g];
+    uint8_t b = px[layout.b];
+    uint32_t luma = (uint32_t)(lut->luma[0][r] + lut->luma[1][g] + lut->luma[2][b]) >> SCOPE_LUT_FRAC_BITS;
+
+    out[SCOPE_WF_CHANNEL_R] = lut->bucket[r];
+    out[SCOPE_WF_CHANNEL_G] = lut->bucket[g];
+    out[SCOPE_WF_CHANNEL_B] = lut->bucket[b];
+    out[SCOPE_WF_CHANNEL_LUMA] = MIN(luma, max_bucket);
+}
+
+static inline float column_scale(const scope_waveform_t *wf, const scope_image_t *image) {
+    return (float)wf->width / (float)image->width;
+}
+
+// Output columns [begin, end) input column x maps to, same float math as wf_accum
+static inline uint32_t column_begin(uint32_t x, float x_scale) {
+    return (uint32_t)floorf((float)x * x_scale);
+}
+
+static inline uint32_t column_end(uint32_t x, float x_scale) {
+    return (uint32_t)ceilf((float)(x + 1) * x_scale);
+}
+
+// The float kernels of a block, instanced per encoding below
+SCOPE_FORCE_INLINE void block_float(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block, scope_encoding_t encoding) {
+    const scope_matrix_weights_t w = scope_encoding_weights(encoding);
+    const scope_rgb8_layout_t layout = scope_rgb8_layout(image->format);
+    const uint32_t width = wf->width;
+    const uint32_t buckets = wf->buckets;
+    uint32_t *out_r = wf->channels[SCOPE_WF_CHANNEL_R];
+    uint32_t *out_g = wf->channels[SCOPE_WF_CHANNEL_G];
+    uint32_t *out_b = wf->channels[SCOPE_WF_CHANNEL_B];
+    uint32_t *out_l = wf->channels[SCOPE_WF_CHANNEL_LUMA];
+
+    for (uint32_t y = 0; y < image->height; ++y) {
+        const uint8_t *px = scope_image_row(image, y) + (size_t)block->x_begin * 4;
+
+        for (uint32_t i = 0; i < block->x_end - block->x_begin; ++i, px += 4) {
+            uint32_t bucket[SCOPE_WF_CHANNEL_COUNT];
+            buckets_float(px, layout, buckets, w, encoding.range, bucket);
+
+            for (uint32_t col = block->col_begin[i]; col < block->col_end[i]; ++col) {
+                out_r[bucket[SCOPE_WF_CHANNEL_R] * width + col]++;
+                out_g[bucket[SCOPE_WF_CHANNEL_G] * width + col]++;
+                out_b[bucket[SCOPE_WF_CHANNEL_B] * width + col]++;
+                out_l[bucket[SCOPE_WF_CHANNEL_LUMA] * width + col]++;
+            }
+        }
+    }
+}
+
+SCOPE_FORCE_INLINE void block_hdr(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block, scope_encoding_t encoding) {
+    const scope_matrix_weights_t w = scope_encoding_weights(encoding);
+    const scope_signal_lut_t *lut = wf->signal_lut;
+    const uint32_t pixel_bytes = scope_pixel_format_bytes(image->format);
+    const uint32_t width = wf->width;
+    const uint32_t buckets = wf->buckets;
+    uint32_t *out_r = wf->channels[SCOPE_WF_CHANNEL_R];
+    uint32_t *out_g = wf->channels[SCOPE_WF_CHANNEL_G];
+    uint32_t *out_b = wf->channels[SCOPE_WF_CHANNEL_B];
+    uint32_t *out_l = wf->channels[SCOPE_WF_CHANNEL_LUMA];
+
+    for (uint32_t y = 0; y < image->height; ++y) {
+        const uint8_t *px = scope_image_row(image, y) + (size_t)block->x_begin * pixel_bytes;
+
+        for (uint32_t i = 0; i < block->x_end - block->x_begin; ++i, px += pixel_bytes) {
+            uint32_t bucket[SCOPE_WF_CHANNEL_COUNT];
+            buckets_hdr(px, image->format, lut, buckets, w, encoding.range, bucket);
+
+            for (uint32_t col = block->col_begin[i]; col < block->col_end[i]; ++col) {
+                out_r[bucket[SCOPE_WF_CHANNEL_R] * width + col]++;
+                out_g[bucket[SCOPE_WF_CHANNEL_G] * width + col]++;
+                out_b[bucket[SCOPE_WF_CHANNEL_B] * width + col]++;
+                out_l[bucket[SCOPE_WF_CHANNEL_LUMA] * width + col]++;
+            }
+        }
+    }
+}
+
+typedef void (*block_fn)(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block);
+
+#define BLOCK_VARIANTS(name, matrix, range) \
+    static void block_float_##name(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block) { \
+        block_float(wf, image, block, (scope_encoding_t){matrix, range}); \
+    } \
+    static void block_hdr_##name(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block) { \
+        block_hdr(wf, image, block, (scope_encoding_t){matrix, range}); \
+    }
+#define BLOCK_FLOAT_ENTRY(name, matrix, range) block_float_##name,
+#define BLOCK_HDR_ENTRY(name, matrix, range) block_hdr_##name,
+
+SCOPE_ENCODINGS(BLOCK_VARIANTS)
+
+static const block_fn block_float_variants[SCOPE_ENCODING_COUNT] = {SCOPE_ENCODINGS(BLOCK_FLOAT_ENTRY)};
+static const block_fn block_hdr_variants[SCOPE_ENCODING_COUNT] = {SCOPE_ENCODINGS(BLOCK_HDR_ENTRY)};
+
+bool scope_waveform_create(scope_waveform_t *wf) {
+    assert(wf);
+
+    *wf = (scope_waveform_t){
+        .width = SCOPE_WF_WIDTH,
+        .buckets = SCOPE_WF_BUCKETS,
+        .kernel = SCOPE_KERNEL_LUT,
+        .encoding = scope_config_preset(SCOPE_QUALITY_DEFAULT).encoding,
+    };
+
+    // All channel planes live in one allocation
+    size_t plane_size = (size_t)wf->width * wf->buckets;
+    uint32_t *planes = calloc(plane_size * SCOPE_WF_CHANNEL_COUNT, sizeof(uint32_t));
+    wf->signal_lut = calloc(1, sizeof(scope_signal_lut_t));
+    if (!planes || !wf->signal_lut) {
+        free(planes);
+        free(wf->signal_lut);
+        wf->signal_lut = NULL;
+        return false;
+    }
+
+    for (uint32_t c = 0; c < SCOPE_WF_CHANNEL_COUNT; ++c) {
+        wf->channels[c] = planes + c * plane_size;
+    }
+
+    return true;
+}
+
+bool scope_waveform_configure(scope_waveform_t *wf, const scope_config_t *config) {
+    assert(wf && wf->channels[0]);
+    assert(config && config->wf_width > 0 && config->wf_buckets > 0);
+
+    if (config->wf_width == wf->width && config->wf_buckets == wf->buckets) {
+        if (scope_encoding_index(config->encoding) != scope_encoding_index(wf->encoding)) {
+            // Other levels in the same planes, the next accumulation starts over
+            scope_waveform_clear(wf);
+            wf->encoding = config->encoding;
+        }
+        return true;
+    }
+
+    size_t plane_size = (size_t)config->wf_width * config->wf_buckets;
+    uint32_t *planes = calloc(plane_size * SCOPE_WF_CHANNEL_COUNT, sizeof(uint32_t));
+    if (!planes) {
+        return false;
+    }
+
+    // The tables are rebuilt for the new bucket count by the next accumulation
+    free(wf->channels[0]);
+    for (uint32_t c = 0; c < SCOPE_WF_CHANNEL_COUNT; ++c) {
+        wf->channels[c] = planes + c * plane_size;
+    }
+    wf->width = config->wf_width;
+    wf->buckets = config->wf_buckets;
+    wf->encoding = config->encoding;
+    wf->generation = 0;
+    return true;
+}
+
+void scope_waveform_destroy(scope_waveform_t *wf) {
+    if (wf) {
+        free(wf->channels[0]);
+        free(wf->signal_lut);
+        memset(wf, 0, sizeof(*wf));
+    }
+}
+
+void scope_waveform_clear(scope_waveform_t *wf) {
+    assert(wf && wf->channels[0]);
+    memset(wf->channels[0], 0, (size_t)wf->width * wf->buckets * SCOPE_WF_CHANNEL_COUNT * sizeof(uint32_t));
+    wf->generation = 0;
+}
+
+void scope_waveform_accumulate(scope_waveform_t *wf, const scope_image_t *image) {
+    assert(wf && wf->channels[0]);
+    assert(image && image->data);
+
+    prepare_kernel(wf, image);
+    accumulate_stripe(wf, image, 0, wf->width);
+}
+
+bool scope_waveform_update(scope_waveform_t *wf, const scope_image_t *image, scope_thread_pool_t *pool) {
+    assert(wf && wf->channels[0]);
+    assert(image && image->data);
+
+    if (image->generation != 0 && image->generation == wf->generation) {
+        return false;
+    }
+
+    scope_waveform_clear(wf);
+    scope_waveform_accumulate_parallel(wf, image, pool);
+
+    wf->generation = image->generation;
+    return true;
+}
+
+void scope_waveform_accumulate_parallel(scope_waveform_t *wf, const scope_image_t *image, scope_thread_pool_t *pool) {
+    assert(wf && wf->channels[0]);
+    assert(image && image->data);
+
+    // Stripes are whole 64-byte runs of every bucket row. The planes come from calloc, which does not
+    // align them to cache lines, so two neighbours can still share one line at their boundary.
+    uint32_t line_count = (wf->width + STRIPE_ALIGN - 1) / STRIPE_ALIGN;
+    uint32_t stripe_count = MIN(scope_thread_pool_size(pool), line_count);
+
+    prepare_kernel(wf, image);
+
+    struct stripe_job job = {
+        .wf = wf,
+        .image = image,
+        .stripe_count = stripe_count,
+        .line_count = line_count,
+    };
+    scope_thread_pool_run(pool, stripe_count, accumulate_stripe_task, &job);
+}
+
+void scope_waveform_accumulate_sampled(scope_waveform_t *wf, const scope_image_t *image, const scope_sampling_t *sampling) {
+    assert(wf && wf->channels[0]);
+    assert(image && image->data);
+    assert(sampling);
+
+    prepare_kernel(wf, image);
+
+    const scope_rgb8_layout_t layout = scope_rgb8_layout(image->format);
+    const scope_ycbcr_layout_t ycbcr = scope_ycbcr_layout(image->format);
+    const bool luma_only = scope_pixel_format_is_ycbcr(image->format);
+    const bool hdr = scope_pixel_format_is_hdr(image->format);
+    const uint32_t pixel_bytes = scope_pixel_format_bytes(image->format);
+    const scope_sample_plan_t plan = scope_sample_plan(sampling, image->width, image->height);
+    const float x_scale = column_scale(wf, image);
+    const uint32_t width = wf->width;
+    const scope_matrix_weights_t w = scope_encoding_weights(wf->encoding);
+
+    for (uint32_t i = 0; i < plan.count; ++i) {
+        uint32_t x, y;
+        const uint32_t weight = scope_sample_position(&plan, i, &x, &y);
+
+        uint32_t col_end = MIN(column_end(x, x_scale), width);
+        if (luma_only) {
+            const uint8_t *sample = scope_image_row(image, y) + (size_t)x * ycbcr.sample_bytes;
+            uint32_t bucket = wf->code_lut.index[scope_ycbcr_sample(sample, ycbcr.sample_bytes, ycbcr.sample_shift, ycbcr.bits)];
+            for (uint32_t col = column_begin(x, x_scale); col < col_end; ++col) {
+                wf->channels[SCOPE_WF_CHANNEL_LUMA][bucket * width + col] += weight;
+            }
+            continue;
+        }
+
+        const uint8_t *px = scope_image_row(image, y) + (size_t)x * pixel_bytes;
+        uint32_t bucket[SCOPE_WF_CHANNEL_COUNT];
+        if (hdr) {
+            buckets_hdr(px, image->format, wf->signal_lut, wf->buckets, w, wf->encoding.range, bucket);
+        } else if (wf->kernel == SCOPE_KERNEL_LUT) {
+            buckets_lut(px, layout, &wf->lut, wf->buckets - 1, bucket);
+        } else {
+            buckets_float(px, layout, wf->buckets, w, wf->encoding.range, bucket);
+        }
+
+        for (uint32_t col = column_begin(x, x_scale); col < col_end; ++col) {
+            for (uint32_t c = 0; c < SCOPE_WF_CHANNEL_COUNT; ++c) {
+                wf->channels[c][bucket[c] * width + col] += weight;
+            }
+        }
+    }
+}
+
+void scope_waveform_replace_span(scope_waveform_t *wf, const scope_image_t *old_frame, const scope_image_t *new_frame, uint32_t y, uint32_t x_begin, uint32_t x_end) {
+    assert(wf && wf->channels[0]);
+    assert(old_frame && new_frame);
+    assert(old_frame->width == new_frame->width && old_frame->format == new_frame->format);
+    assert(scope_pixel_format_is_rgb8(new_frame->format));
+    assert(x_end <= new_frame->width && y < new_frame->height);
+
+    prepare_kernel(wf, new_frame);
+
+    const scope_rgb8_layout_t layout = scope_rgb8_layout(new_frame->format);
+    const float x_scale = column_scale(wf, new_frame);
+    const uint32_t width = wf->width;
+    const scope_matrix_weights_t w = scope_encoding_weights(wf->encoding);
+    const uint8_t *old_px = scope_image_row(old_frame, y) + (size_t)x_begin * 4;
+    const uint8_t *new_px = scope_image_row(new_frame, y) + (size_t)x_begin * 4;
+
+    for (uint32_t x = x_begin; x < x_end; ++x, old_px += 4, new_px += 4) {
+        if (memcmp(old_px, new_px, 4) == 0) continue;
+
+        uint32_t old_bucket[SCOPE_WF_CHANNEL_COUNT];
+        uint32_t new_bucket[SCOPE_WF_CHANNEL_COUNT];
+        if (wf->kernel == SCOPE_KERNEL_LUT) {
+            buckets_lut(old_px, layout, &wf->lut, wf->buckets - 1, old_bucket);
+            buckets_lut(new_px, layout, &wf->lut, wf->buckets - 1, new_bucket);
+        } else {
+            buckets_float(old_px, layout, wf->buckets, w, wf->encoding.range, old_bucket);
+            buckets_float(new_px, layout, wf->buckets, w, wf->encoding.range, new_bucket);
+        }
+
+        uint32_t col_end = MIN(column_end(x, x_scale), width);
+        for (uint32_t col = column_begin(x, x_scale); col < col_end; ++col) {
+            for (uint32_t c = 0; c < SCOPE_WF_CHANNEL_COUNT; ++c) {
+                assert(wf->channels[c][old_bucket[c] * width + col] > 0);
+                wf->channels[c][old_bucket[c] * width + col]--;
+                wf->channels[c][new_bucket[c] * width + col]++;
+            }
+        }
+    }
+}
+
+// First input column whose output range reaches past column `col`
+static uint32_t first_input_column(uint32_t col, float x_scale, uint32_t input_width) {
+    uint32_t x = MIN((uint32_t)((float)col / x_scale), input_width);
+    while (x > 0 && column_end(x - 1, x_scale) > col) x--;
+    while (x < input_width && column_end(x, x_scale) <= col) x++;
+    return x;
+}
+
+// First input column that maps entirely at or after column `col`
+static uint32_t end_input_column(uint32_t col, float x_scale, uint32_t input_width) {
+    uint32_t x = MIN((uint32_t)((float)col / x_scale), input_width);
+    while (x > 0 && column_begin(x - 1, x_scale) >= col) x--;
+    while (x < input_width && column_begin(x, x_scale) < col) x++;
+    return x;
+}
+
+static void prepare_kernel(scope_waveform_t *wf, const scope_image_t *image) {
+    // Has to happen before any worker reads the tables
+    wf->axis = SCOPE_TRANSFER_SDR;
+    if (scope_pixel_format_is_hdr(image->format)) {
+        scope_signal_lut_update(wf->signal_lut, image->format, image->transfer);
+        wf->axis = scope_transfer_axis(image->transfer);
+    } else if (scope_pixel_format_is_ycbcr(image->format)) {
+        scope_code_lut_update(&wf->code_lut, false, wf->buckets, 1, scope_ycbcr_layout(image->format).bits, image->range, wf->encoding.range);
+    } else if (wf->kernel == SCOPE_KERNEL_LUT) {
+        scope_luma_lut_update(&wf->lut, wf->buckets, wf->encoding);
+    }
+}
+
+// Accumulates every pixel that lands in output columns [col_min, col_max). Writes never leave the stripe.
+static void accumulate_stripe(scope_waveform_t *wf, const scope_image_t *image, uint32_t col_min, uint32_t col_max) {
+    const float x_scale = column_scale(wf, image);
+    const uint32_t x_begin = first_input_column(col_min, x_scale, image->width);
+    const uint32_t x_end = end_input_column(col_max, x_scale, image->width);
+
+    struct column_block block;
+    for (block.x_begin = x_begin; block.x_begin < x_end; block.x_begin = block.x_end) {
+        block.x_end = MIN(block.x_begin + BLOCK_COLUMNS, x_end);
+
+        for (uint32_t x = block.x_begin; x < block.x_end; ++x) {
+            block.col_begin[x - block.x_begin] = MAX(column_begin(x, x_scale), col_min);
+            block.col_end[x - block.x_begin] = MIN(column_end(x, x_scale), col_max);
+        }
+
+        if (scope_pixel_format_is_hdr(image->format)) {
+            block_hdr_variants[scope_encoding_index(wf->encoding)](wf, image, &block);
+        } else if (scope_pixel_format_is_ycbcr(image->format)) {
+            block_ycbcr(wf, image, &block);
+        } else if (wf->kernel == SCOPE_KERNEL_LUT) {
+            block_lut(wf, image, &block);
+        } else {
+            block_float_variants[scope_encoding_index(wf->encoding)](wf, image, &block);
+        }
+    }
+}
+
+static void block_lut(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block) {
+    const scope_rgb8_layout_t layout = scope_rgb8_layout(image->format);
+    const scope_luma_lut_t *lut = &wf->lut;
+    const uint32_t width = wf->width;
+    const uint32_t max_bucket = wf->buckets - 1;
+    uint32_t *out_r = wf->channels[SCOPE_WF_CHANNEL_R];
+    uint32_t *out_g = wf->channels[SCOPE_WF_CHANNEL_G];
+    uint32_t *out_b = wf->channels[SCOPE_WF_CHANNEL_B];
+    uint32_t *out_l = wf->channels[SCOPE_WF_CHANNEL_LUMA];
+
+    for (uint32_t y = 0; y < image->height; ++y) {
+        const uint8_t *px = scope_image_row(image, y) + (size_t)block->x_begin * 4;
+
+        for (uint32_t i = 0; i < block->x_end - block->x_begin; ++i, px += 4) {
+            uint32_t bucket[SCOPE_WF_CHANNEL_COUNT];
+            buckets_lut(px, layout, lut, max_bucket, bucket);
+
+            for (uint32_t col = block->col_begin[i]; col < block->col_end[i]; ++col) {
+                out_r[bucket[SCOPE_WF_CHANNEL_R] * width + col]++;
+                out_g[bucket[SCOPE_WF_CHANNEL_G] * width + col]++;
+                out_b[bucket[SCOPE_WF_CHANNEL_B] * width + col]++;
+                out_l[bucket[SCOPE_WF_CHANNEL_LUMA] * width + col]++;
+            }
+        }
+    }
+}
+
+// Y' samples of a block, with constant sample sizes so each depth gets its own loop
+static inline void block_luma_rows(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block,
+                                   uint32_t sample_bytes, uint32_t shift, uint32_t bits) {
+    const uint16_t *index = wf->code_lut.index;
+    const uint32_t width = wf->width;
+    uint32_t *out_l = wf->channels[SCOPE_WF_CHANNEL_LUMA];
+
+    for (uint32_t y = 0; y < image->height; ++y) {
+        const uint8_t *sample = scope_image_row(image, y) + (size_t)block->x_begin * sample_bytes;
+
+        for (uint32_t i = 0; i < block->x_end - block->x_begin; ++i, sample += sample_bytes) {
+            uint32_t bucket = index[scope_ycbcr_sample(sample, sample_bytes, shift, bits)];
+            for (uint32_t col = block->col_begin[i]; col < block->col_end[i]; ++col) {
+                out_l[bucket * width + col]++;
+            }
+        }
+    }
+}
+
+static void block_ycbcr(scope_waveform_t *wf, const scope_image_t *image, const struct column_block *block) {
+    const scope_ycbcr_layout_t layout = scope_ycbcr_layout(image->format);
+    if (layout.sample_bytes == 1) {
+        block_luma_rows(wf, image, block, 1, 0, 8);
+    } else {
+        block_luma_rows(wf, image, block, 2, layout.sample_shift, layout.bits);
+    }
+}
+
+static void accumulate_stripe_task(void *user_data, uint32_t stripe) {
+    struct stripe_job *job = user_data;
+
+    uint32_t line_begin = job->line_count * stripe / job->stripe_count;
+    uint32_t line_end = job->line_count * (stripe + 1) / job->stripe_count;
+    uint32_t col_min = line_begin * STRIPE_ALIGN;
+    uint32_t col_max = MIN(line_end * STRIPE_ALIGN, job->wf->width);
+
+    accumulate_stripe(job->wf, job->image, col_min, col_max);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "scope.h"
+#include "scope_lut.h"
+#include "scope_sample.h"
+#include "scope_thread.h"
+
+typedef enum scope_wf_channel {
+    SCOPE_WF_CHANNEL_R,
+    SCOPE_WF_CHANNEL_G,
+    SCOPE_WF_CHANNEL_B,
+    SCOPE_WF_CHANNEL_LUMA,
+    SCOPE_WF_CHANNEL_COUNT
+} scope_wf_channel_t;
+
+typedef struct scope_waveform {
+    // One width x buckets plane per channel, indexed as [bucket * width + column]. Created at
+    // SCOPE_WF_WIDTH x SCOPE_WF_BUCKETS, scope_waveform_configure() changes it.
+    uint32_t *channels[SCOPE_WF_CHANNEL_COUNT];
+    uint32_t width;
+    uint32_t buckets;
+
+    // The LUT kernel only needs the tables, which are rebuilt when the bucket count changes
+    scope_kernel_t kernel;
+    scope_luma_lut_t lut;
+
+    // What luma and the levels are measured in, every kernel is specialized for it (see SCOPE_ENCODINGS)
+    scope_encoding_t encoding;
+
+    // Y'CbCr frames are bucketed straight from their Y' samples. They only fill the luma plane,
+    // the R, G and B planes stay empty.
+    scope_code_lut_t code_lut;
+
+    // HDR frames are bucketed by signal on `axis`, their own transfer or PQ for linear light. The
+    // table is allocated with the planes, SDR frames are on the SDR axis.
+    scope_signal_lut_t *signal_lut;
+    scope_transfer_t axis;
+
+    // Generation of the frame the planes were last built from by scope_waveform_update(), 0 if none
+    uint64_t generation;
+} scope_waveform_t;
+
+bool scope_waveform_create(scope_waveform_t *wf);
+void scope_waveform_destroy(scope_waveform_t *wf);
+/* @brief Switches to the waveform size and encoding of `config`. The planes are reallocated, and
+ * empty, if the size changed, and cleared if only the encoding did. Returns false on allocation
+ * failure, keeping the current planes. */
+bool scope_waveform_configure(scope_waveform_t *wf, const scope_config_t *config);
+void scope_waveform_clear(scope_waveform_t *wf);
+void scope_waveform_accumulate(scope_waveform_t *wf, const scope_image_t *image);
+/* @brief Rebuilds the planes from `image`, unless they already hold the frame with the same non-zero
+ * generation. Returns false if the frame was unchanged and nothing was done. `pool` may be NULL. */
+bool scope_waveform_update(scope_waveform_t *wf, const scope_image_t *image, scope_thread_pool_t *pool);
+/* @brief Gives each pool thread a disjoint stripe of output columns and only the input columns
+ * that map into it. Threads never touch each other's bins, so there are no atomics and no merge. */
+void scope_waveform_accumulate_parallel(scope_waveform_t *wf, const scope_image_t *image, scope_thread_pool_t *pool);
+/* @brief Bins at most `sampling->budget` pixels, each weighted by the number of pixels it represents */
+void scope_waveform_accumulate_sampled(scope_waveform_t *wf, const scope_image_t *image, const scope_sampling_t *sampling);
+/* @brief Moves the hits of pixels [x_begin, x_end) on row y from their buckets in `old_frame` to their
+ * buckets in `new_frame`. Same requirements as scope_vectorscope_replace_span(). */
+void scope_waveform_replace_span(scope_waveform_t *wf, const scope_image_t *old_frame, const scope_image_t *new_frame, uint32_t y, uint32_t x_begin, uint32_t x_end);
@@ -0,0 +1,295 @@
+#define _XOPEN_SOURCE 700 // shmget, poll
+
+#include "scope_source_x11.h"
+
+#include "scope_cpu.h"
+
+#include "../../macros.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xdamage.h>
+
+#include <assert.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+// Beyond this many damage rects per frame only their bounding box is reported
+#define X11_MAX_DIRTY_RECTS 256
+
+typedef struct x11_source {
+    scope_source_t base;
+
+    Display *display;
+    Window root;
+    XImage *image;
+    XShmSegmentInfo shm;
+    bool attached;
+
+    scope_rect_t area;
+    scope_pixel_format_t format;
+    bool every_acquire;
+    uint64_t generation;
+
+    // Damage is reported as raw rectangles, so reading it needs no round trip or allocation
+    bool has_damage;
+    int damage_event_base;
+    Damage damage;
+
+    scope_rect_t *dirty;
+    uint32_t dirty_count;
+    uint32_t dirty_capacity;
+} x11_source_t;
+
+static bool push_dirty(x11_source_t *impl, const XRectangle *rect) {
+    int32_t left = MAX((int32_t)rect->x, (int32_t)impl->area.x);
+    int32_t top = MAX((int32_t)rect->y, (int32_t)impl->area.y);
+    int32_t right = MIN((int32_t)rect->x + rect->width, (int32_t)(impl->area.x + impl->area.width));
+    int32_t bottom = MIN((int32_t)rect->y + rect->height, (int32_t)(impl->area.y + impl->area.height));
+    if (left >= right || top >= bottom) {
+        return true;
+    }
+
+    scope_rect_t clipped = {
+        .x = (uint32_t)left - impl->area.x,
+        .y = (uint32_t)top - impl->area.y,
+        .width = (uint32_t)(right - left),
+        .height = (uint32_t)(bottom - top),
+    };
+
+    // Storms of tiny rects (e.g. text rendering) collapse into their bounding box
+    if (impl->dirty_count == X11_MAX_DIRTY_RECTS) {
+        scope_rect_t *box = &impl->dirty[0];
+        for (uint32_t i = 1; i < impl->dirty_count; ++i) {
+            const scope_rect_t *r = &impl->dirty[i];
+            uint32_t x1 = MAX(box->x + box->width, r->x + r->width);
+            uint32_t y1 = MAX(box->y + box->height, r->y + r->height);
+            box->x = MIN(box->x, r->x);
+            box->y = MIN(box->y, r->y);
+            box->width = x1 - box->x;
+            box->height = y1 - box->y;
+        }
+        impl->dirty_count = 1;
+    }
+
+    if (impl->dirty_count == impl->dirty_capacity) {
+        uint32_t capacity = MAX(16u, impl->dirty_capacity * 2);
+        scope_rect_t *dirty = realloc(impl->dirty, capacity * sizeof(scope_rect_t));
+        if (!dirty) {
+            return false;
+        }
+        impl->dirty = dirty;
+        impl->dirty_capacity = capacity;
+    }
+
+    impl->dirty[impl->dirty_count++] = clipped;
+    return true;
+}
+
+// Collects the damage that arrived within the timeout, returns false on allocation failure
+static bool wait_for_damage(x11_source_t *impl, uint32_t timeout_ms) {
+    if (XPending(impl->display) == 0 && timeout_ms > 0) {
+        struct pollfd fd = {.fd = ConnectionNumber(impl->display), .events = POLLIN};
+        poll(&fd, 1, (int)timeout_ms);
+    }
+
+    bool ok = true;
+    bool damaged = false;
+    while (XPending(impl->display) > 0) {
+        XEvent event;
+        XNextEvent(impl->display, &event);
+        if (event.type != impl->damage_event_base + XDamageNotify) continue;
+
+        const XDamageNotifyEvent *notify = (const XDamageNotifyEvent *)&event;
+        ok = push_dirty(impl, &notify->area) && ok;
+        damaged = true;
+    }
+
+    // The rects were already delivered, only keep the server side region from growing
+    if (damaged) {
+        XDamageSubtract(impl->display, impl->damage, None, None);
+    }
+    return ok;
+}
+
+static scope_acquire_result_t x11_acquire(scope_source_t *source, uint32_t timeout_ms, scope_frame_t *frame) {
+    x11_source_t *impl = (x11_source_t *)source;
+    scope_rect_t full = {0, 0, impl->area.width, impl->area.height};
+
+    impl->dirty_count = 0;
+    if (impl->generation == 0 || !impl->has_damage) {
+        impl->dirty[impl->dirty_count++] = full;
+    } else {
+        if (!wait_for_damage(impl, impl->every_acquire ? 0 : timeout_ms)) {
+            // Lost rects, the whole frame may have changed
+            impl->dirty_count = 0;
+            impl->dirty[impl->dirty_count++] = full;
+        }
+        if (impl->dirty_count == 0 && !impl->every_acquire) {
+            return SCOPE_ACQUIRE_TIMEOUT;
+        }
+    }
+
+    double timestamp = scope_cpu_time_seconds();
+    if (!XShmGetImage(impl->display, impl->root, impl->image, (int)impl->area.x, (int)impl->area.y, AllPlanes)) {
+        return SCOPE_ACQUIRE_ERROR;
+    }
+
+    *frame = (scope_frame_t){
+        .image = {
+            .data = (const uint8_t *)impl->image->data,
+            .width = impl->area.width,
+            .height = impl->area.height,
+            .stride = (uint32_t)impl->image->bytes_per_line,
+            .format = impl->format,
+            .generation = ++impl->generation,
+        },
+        .dirty = impl->dirty,
+        .dirty_count = impl->dirty_count,
+        .timestamp = timestamp,
+    };
+    return SCOPE_ACQUIRE_OK;
+}
+
+static void x11_release(scope_source_t *source) {
+    // The next XShmGetImage overwrites the segment, nothing to hand back
+    (void)source;
+}
+
+static void x11_destroy(scope_source_t *source) {
+    x11_source_t *impl = (x11_source_t *)source;
+
+    if (impl->display) {
+        if (impl->damage) {
+            XDamageDestroy(impl->display, impl->damage);
+        }
+        if (impl->attached) {
+            XShmDetach(impl->display, &impl->shm);
+        }
+        if (impl->image) {
+            // The pixels belong to the segment, not to Xlib's allocator
+            impl->image->data = NULL;
+            XDestroyImage(impl->image);
+        }
+        XCloseDisplay(impl->display);
+    }
+    if (impl->shm.shmaddr && impl->shm.shmaddr != (char *)-1) {
+        shmdt(impl->shm.shmaddr);
+    }
+
+    free(impl->dirty);
+    free(impl);
+}
+
+static bool pixel_format(const Visual *visual, const XImage *image, scope_pixel_format_t *format) {
+    if (image->bits_per_pixel != 32 || image->byte_order != LSBFirst) {
+        return false;
+    }
+
+    if (visual->red_mask == 0xff0000 && visual->green_mask == 0xff00 && visual->blue_mask == 0xff) {
+        *format = SCOPE_PIXEL_FORMAT_BGRA8;
+        return true;
+    }
+    if (visual->red_mask == 0xff && visual->green_mask == 0xff00 && visual->blue_mask == 0xff0000) {
+        *format = SCOPE_PIXEL_FORMAT_RGBA8;
+        return true;
+    }
+    return false;
+}
+
+static bool x11_setup(x11_source_t *impl, const scope_x11_desc_t *desc) {
+    impl->display = XOpenDisplay(desc->display);
+    if (!impl->display) {
+        fprintf(stderr, "x11: couldn't open display '%s'\n", desc->display ? desc->display : XDisplayName(NULL));
+        return false;
+    }
+
+    if (!XShmQueryExtension(impl->display)) {
+        fprintf(stderr, "x11: the server has no MIT-SHM support\n");
+        return false;
+    }
+
+    int screen = DefaultScreen(impl->display);
+    impl->root = RootWindow(impl->display, screen);
+    uint32_t screen_width = (uint32_t)DisplayWidth(impl->display, screen);
+    uint32_t screen_height = (uint32_t)DisplayHeight(impl->display, screen);
+
+    impl->area = desc->area;
+    if (impl->area.width == 0 || impl->area.height == 0) {
+        impl->area = (scope_rect_t){0, 0, screen_width, screen_height};
+    }
+    if (impl->area.x >= screen_width || impl->area.y >= screen_height ||
+        impl->area.width > screen_width - impl->area.x || impl->area.height > screen_height - impl->area.y) {
+        fprintf(stderr, "x11: capture area %ux%u+%u+%u is outside the %ux%u screen\n",
+                impl->area.width, impl->area.height, impl->area.x, impl->area.y, screen_width, screen_height);
+        return false;
+    }
+
+    Visual *visual = DefaultVisual(impl->display, screen);
+    impl->image = XShmCreateImage(impl->display, visual, (unsigned)DefaultDepth(impl->display, screen), ZPixmap, NULL,
+                                  &impl->shm, impl->area.width, impl->area.height);
+    if (!impl->image) {
+        fprintf(stderr, "x11: couldn't create the shared memory image\n");
+        return false;
+    }
+    if (!pixel_format(visual, impl->image, &impl->format)) {
+        fprintf(stderr, "x11: unsupported visual, needs 8 bits per channel in 32 bit pixels\n");
+        return false;
+    }
+
+    impl->shm.shmid = shmget(IPC_PRIVATE, (size_t)impl->image->bytes_per_line * impl->image->height, IPC_CREAT | 0600);
+    if (impl->shm.shmid < 0) {
+        fprintf(stderr, "x11: couldn't allocate the shared memory segment\n");
+        return false;
+    }
+    impl->shm.shmaddr = impl->image->data = shmat(impl->shm.shmid, NULL, 0);
+    impl->shm.readOnly = False;
+
+    bool attached = impl->shm.shmaddr != (char *)-1 && XShmAttach(impl->display, &impl->shm);
+    XSync(impl->display, False);
+
+    // Marked for removal right away, it goes away with the last detach even if we crash
+    shmctl(impl->shm.shmid, IPC_RMID, NULL);
+    if (!attached) {
+        fprintf(stderr, "x11: couldn't attach the shared memory segment\n");
+        return false;
+    }
+    impl->attached = true;
+
+    int damage_error_base;
+    if (XDamageQueryExtension(impl->display, &impl->damage_event_base, &damage_error_base)) {
+        impl->damage = XDamageCreate(impl->display, impl->root, XDamageReportRawRectangles);
+        impl->has_damage = impl->damage != None;
+    }
+
+    impl->dirty = malloc(16 * sizeof(scope_rect_t));
+    impl->dirty_capacity = impl->dirty ? 16 : 0;
+    return impl->dirty != NULL;
+}
+
+bool scope_source_x11_create(const scope_x11_desc_t *desc, scope_source_t **source) {
+    assert(desc && source);
+
+    x11_source_t *impl = malloc(sizeof(x11_source_t));
+    if (!impl) return false;
+
+    *impl = (x11_source_t){
+        .base = {
+            .name = "x11",
+            .interface = {x11_acquire, x11_release, x11_destroy},
+        },
+        .every_acquire = desc->every_acquire,
+    };
+
+    if (!x11_setup(impl, desc)) {
+        x11_destroy(&impl->base);
+        return false;
+    }
+
+    *source = &impl->base;
+    return true;
+}
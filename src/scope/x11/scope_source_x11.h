@@ -0,0 +1,16 @@
+#pragma once
+
+#include "scope_source.h"
+
+// Live capture of an X11 screen (see scope_source.h). Pixels are read with MIT-SHM into one shared
+// memory segment that is handed out as the frame, so capturing allocates nothing per frame.
+// Changed regions come from the DAMAGE extension; without it every frame is reported fully dirty.
+// Xlib is used from whichever thread acquires, one thread at a time.
+
+typedef struct scope_x11_desc {
+    const char *display; // NULL uses $DISPLAY
+    scope_rect_t area;   // of the root window, a zero width or height captures all of it
+    bool every_acquire;  // capture even if nothing was damaged, e.g. for throughput benchmarks
+} scope_x11_desc_t;
+
+bool scope_source_x11_create(const scope_x11_desc_t *desc, scope_source_t **source);
@@ -11,6 +11,10 @@
 #include <winerror.h>
 
 bool shader_create_from_file(ID3D11Device1 *device, const char *path, shader_stage_t stage, const char *entry_point, shader_t *out_shader) {
+    return shader_create_permutation_from_file(device, path, stage, entry_point, NULL, out_shader);
+}
+
+bool shader_create_permutation_from_file(ID3D11Device1 *device, const char *path, shader_stage_t stage, const char *entry_point, const D3D_SHADER_MACRO *defines, shader_t *out_shader) {
     assert(out_shader && "Out shader cannot be NULL");
     assert(device && "ID3D11Device cannot be NULL");
 
@@ -34,7 +38,7 @@ bool shader_create_from_file(ID3D11Device1 *device, const char *path, shader_sta
     // Compile the file from file using d3dcompiler
     hr = D3DCompileFromFile(
         path_wide,
-        NULL,
+        defines,
         D3D_COMPILE_STANDARD_FILE_INCLUDE,
         entry_point,
         shader_target[stage],
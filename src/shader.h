@@ -31,6 +31,8 @@ typedef struct shader_pipeline {
 } shader_pipeline_t;
 
 bool shader_create_from_file(ID3D11Device1 *device, const char *path, shader_stage_t stage, const char *entry_point, shader_t *out_shader);
+// Same with preprocessor `defines`, terminated by a {NULL, NULL} entry, for permutations of a shader
+bool shader_create_permutation_from_file(ID3D11Device1 *device, const char *path, shader_stage_t stage, const char *entry_point, const D3D_SHADER_MACRO *defines, shader_t *out_shader);
 bool shader_create_from_bytecode(ID3D11Device1 *device, shader_stage_t stage, const void *bytecode, size_t bytecode_size, shader_t *out_shader);
 void shader_destroy(shader_t *shader);
 bool shader_bind(shader_t *shader);
@@ -1,27 +1,38 @@
 #include "vectorscope.h"
 
 #include "logger.h"
+#include "macros.h"
 #include "renderer.h"
 #include "texture.h"
 
 #include <assert.h>
 #include <string.h>
 
-#define VS_INT_RES 1024
-
 struct vs_cbuffer {
     float2_t resolution;
     float padding[2];
 };
 
+struct blur_pass_cbuffer {
+    uint32_t pass_radius;
+    uint32_t last_pass;
+    uint32_t padding[2];
+};
+
+static uint32_t blur_table_size(uint32_t resolution, scope_blur_shape_t shape, uint32_t radius);
+static bool create_blur_texture(ID3D11Device1 *device, uint32_t size, texture_t *tex);
+static bool resize_blur_tables(vectorscope_t *vs, struct renderer *renderer, uint32_t size);
+static void blur(vectorscope_t *vs, struct renderer *renderer);
+
 bool vectorscope_setup(vectorscope_t *vs, struct renderer *renderer) {
     ID3D11Device1 *device = renderer->device;
+    const uint32_t resolution = renderer->scope_config.vs_resolution;
 
     // Create necessary textures
     {
         const texture_desc_t accum_tex_desc = {
-            .width = VS_INT_RES,
-            .height = VS_INT_RES,
+            .width = resolution,
+            .height = resolution,
             .format = DXGI_FORMAT_R32_UINT,
             .array_size = 1,
             .bind_flags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS,
@@ -36,8 +47,8 @@ bool vectorscope_setup(vectorscope_t *vs, struct renderer *renderer) {
         }
 
         const texture_desc_t blur_tex_desc = {
-            .width = VS_INT_RES,
-            .height = VS_INT_RES,
+            .width = resolution,
+            .height = resolution,
             .format = DXGI_FORMAT_R32_FLOAT,
             .array_size = 1,
             .bind_flags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS,
@@ -67,6 +78,15 @@ bool vectorscope_setup(vectorscope_t *vs, struct renderer *renderer) {
             return false;
         }
 
+        const uint32_t table_size = blur_table_size(resolution, renderer->vs_blur_shape, renderer->vs_blur_radius);
+        if (!create_blur_texture(device, table_size, &vs->blur_prefix_tex) ||
+            !create_blur_texture(device, table_size, &vs->blur_table_tex[0]) ||
+            !create_blur_texture(device, table_size, &vs->blur_table_tex[1]) ||
+            !create_blur_texture(device, resolution, &vs->blur_average_tex)) {
+            LOG("Failed to create blur textures for vectorscope");
+            return false;
+        }
+
         LOG("Vectorscope textures created");
     }
 
@@ -85,46 +105,113 @@ bool vectorscope_setup(vectorscope_t *vs, struct renderer *renderer) {
             return false;
         }
 
+        desc.ByteWidth = sizeof(struct blur_pass_cbuffer);
+        hr = device->lpVtbl->CreateBuffer(device, &desc, NULL, &vs->blur_cbuffer);
+        if (FAILED(hr)) {
+            LOG("Failed to create constant buffer for vectorscope blur");
+            return false;
+        }
+
         LOG("Vectorscope constant buffers created");
     }
 
+    if (!persistence_setup(&vs->persistence, renderer)) {
+        return false;
+    }
+
+    return true;
+}
+
+bool vectorscope_configure(vectorscope_t *vs, struct renderer *renderer, const scope_config_t *config) {
+    const uint32_t resolution = config->vs_resolution;
+
+    // The config changed, if not the resolution then maybe the zoom or the encoding. Either way
+    // the trails are of other bins.
+    vs->has_output = false;
+    if ((uint32_t)vs->accum_tex.width != resolution) {
+        if (!texture_resize(renderer->device, &vs->accum_tex, (uint16_t)resolution, (uint16_t)resolution) ||
+            !texture_resize(renderer->device, &vs->blur_tex, (uint16_t)resolution, (uint16_t)resolution) ||
+            !texture_resize(renderer->device, &vs->blur_average_tex, (uint16_t)resolution, (uint16_t)resolution)) {
+            LOG("Failed to resize textures for vectorscope");
+            return false;
+        }
+
+        LOG("Vectorscope textures resized to %u", resolution);
+    }
+
+    if (!resize_blur_tables(vs, renderer, blur_table_size(resolution, renderer->vs_blur_shape, renderer->vs_blur_radius))) {
+        return false;
+    }
+
+    if (!persistence_configure(&vs->persistence, renderer, resolution * resolution, vs->persistence.half_life)) {
+        LOG("Failed to resize persistence for vectorscope");
+        return false;
+    }
     return true;
 }
 
-void vectorscope_render(vectorscope_t *vs, struct renderer *renderer, texture_t *capture_texture) {
+bool vectorscope_set_persistence(vectorscope_t *vs, struct renderer *renderer, float half_life) {
+    const uint32_t resolution = (uint32_t)vs->accum_tex.width;
+
+    // accum_tex may hold resolved trails, the capture is accumulated again
+    vs->has_output = false;
+    if (!persistence_configure(&vs->persistence, renderer, resolution * resolution, half_life)) {
+        LOG("Failed to create persistence for vectorscope");
+        return false;
+    }
+    return true;
+}
+
+bool vectorscope_set_blur(vectorscope_t *vs, struct renderer *renderer, scope_blur_shape_t shape, uint32_t radius) {
+    vs->has_output = false;
+    return resize_blur_tables(vs, renderer, blur_table_size((uint32_t)vs->accum_tex.width, shape, radius));
+}
+
+void vectorscope_render(vectorscope_t *vs, struct renderer *renderer, texture_t *capture_texture, uint64_t generation) {
+    // Same frame as last time, composite_tex still holds its result unless trails are fading
+    const bool captured = !vs->has_output || vs->generation != generation;
+    if (!captured && !persistence_is_decaying(&vs->persistence)) {
+        return;
+    }
+    vs->generation = generation;
+    vs->has_output = true;
+
     ID3D11DeviceContext1 *context = renderer->context;
     unsigned int clear_color_uint[4] = {0, 0, 0, 0};
     float clear_color_float[4] = {0.0f, 0.0f, 0.0f, 0.0f};
     ID3D11UnorderedAccessView *nulluav = NULL;
     uint32_t thread_groups[] = {8, 8, 1};
+    const uint32_t encoding = scope_encoding_index(renderer->scope_config.encoding);
 
     // 1. Accumulate samples
-    shader_pipeline_bind(context, &renderer->passes.vs_accum);
-    context->lpVtbl->CSSetSamplers(context, 0, 1, &renderer->sampler_states[SAMPLER_LINEAR_CLAMP]);
-    context->lpVtbl->CSSetShaderResources(context, 0, 1, &capture_texture->srv);
-    context->lpVtbl->ClearUnorderedAccessViewUint(context, vs->accum_tex.uav[0], clear_color_uint);
-    context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &vs->accum_tex.uav[0], NULL);
-    context->lpVtbl->Dispatch(
-        context,
-        (capture_texture->width + (thread_groups[0] - 1)) / thread_groups[0],
-        (capture_texture->width + (thread_groups[1] - 1)) / thread_groups[1],
-        thread_groups[2]);
-    context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &nulluav, NULL);
+    if (captured) {
+        shader_pipeline_bind(context, &renderer->passes.vs_accum[encoding]);
+        context->lpVtbl->CSSetSamplers(context, 0, 1, &renderer->sampler_states[SAMPLER_LINEAR_CLAMP]);
+        context->lpVtbl->CSSetShaderResources(context, 0, 1, &capture_texture->srv);
+        context->lpVtbl->ClearUnorderedAccessViewUint(context, vs->accum_tex.uav[0], clear_color_uint);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &vs->accum_tex.uav[0], NULL);
+        context->lpVtbl->Dispatch(
+            context,
+            (capture_texture->width + (thread_groups[0] - 1)) / thread_groups[0],
+            (capture_texture->width + (thread_groups[1] - 1)) / thread_groups[1],
+            thread_groups[2]);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &nulluav, NULL);
+    }
 
-    // 2. Blur samples
-    shader_pipeline_bind(context, &renderer->passes.vs_blur);
-    context->lpVtbl->CSSetShaderResources(context, 0, 1, &vs->accum_tex.srv);
-    context->lpVtbl->ClearUnorderedAccessViewFloat(context, vs->blur_tex.uav[0], clear_color_float);
-    context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &vs->blur_tex.uav[0], NULL);
-    context->lpVtbl->Dispatch(
-        context,
-        (vs->blur_tex.width + (thread_groups[0] - 1)) / thread_groups[0],
-        (vs->blur_tex.width + (thread_groups[1] - 1)) / thread_groups[1],
-        thread_groups[2]);
-    context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &nulluav, NULL);
+    // 2. Add them to the trails, or only fade those, nothing while persistence is off
+    const uint32_t persist_groups[] = {
+        (vs->accum_tex.width + (thread_groups[0] - 1)) / thread_groups[0],
+        (vs->accum_tex.width + (thread_groups[1] - 1)) / thread_groups[1],
+        thread_groups[2],
+    };
+    persistence_apply(&vs->persistence, renderer, &renderer->passes.vs_persist, vs->accum_tex.uav[0], captured,
+                      (uint64_t)capture_texture->width * capture_texture->height, persist_groups);
+
+    // 3. Blur samples
+    blur(vs, renderer);
 
-    // 3. Composite with overlay into final texture
-    shader_pipeline_bind(context, &renderer->passes.vs_comp);
+    // 4. Composite with overlay into final texture
+    shader_pipeline_bind(context, &renderer->passes.vs_comp[encoding]);
     context->lpVtbl->CSSetShaderResources(context, 0, 1, &vs->blur_tex.srv);
     context->lpVtbl->ClearUnorderedAccessViewFloat(context, vs->composite_tex.uav[0], clear_color_float);
     context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &vs->composite_tex.uav[0], NULL);
@@ -150,3 +237,96 @@ texture_t *vectorscope_get_texture(vectorscope_t *vs) {
     assert(vs);
     return &vs->composite_tex;
 }
+
+// Side of the blur tables, the bins padded for the widest pass
+static uint32_t blur_table_size(uint32_t resolution, scope_blur_shape_t shape, uint32_t radius) {
+    uint32_t radii[SCOPE_BLUR_MAX_PASSES];
+    const uint32_t pass_count = scope_blur_passes(shape, radius, radii);
+
+    uint32_t max_radius = 0;
+    for (uint32_t p = 0; p < pass_count; ++p) {
+        max_radius = MAX(max_radius, radii[p]);
+    }
+    return resolution + 2 * (max_radius + 1);
+}
+
+static bool create_blur_texture(ID3D11Device1 *device, uint32_t size, texture_t *tex) {
+    const texture_desc_t desc = {
+        .width = size,
+        .height = size,
+        .format = DXGI_FORMAT_R32_UINT,
+        .array_size = 1,
+        .bind_flags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS,
+        .mip_levels = 1,
+        .msaa_samples = 1,
+        .generate_srv = true,
+    };
+    return texture_create(device, &desc, tex);
+}
+
+static bool resize_blur_tables(vectorscope_t *vs, struct renderer *renderer, uint32_t size) {
+    if ((uint32_t)vs->blur_prefix_tex.width == size) {
+        return true;
+    }
+
+    if (!texture_resize(renderer->device, &vs->blur_prefix_tex, (uint16_t)size, (uint16_t)size) ||
+        !texture_resize(renderer->device, &vs->blur_table_tex[0], (uint16_t)size, (uint16_t)size) ||
+        !texture_resize(renderer->device, &vs->blur_table_tex[1], (uint16_t)size, (uint16_t)size)) {
+        LOG("Failed to resize blur tables for vectorscope");
+        return false;
+    }
+    return true;
+}
+
+// accum_tex into blur_tex, each box or diamond pass of the blur building its tables of running
+// sums (rows, scan) and averaging over them (main). Every bin is written, blur_tex isn't cleared.
+static void blur(vectorscope_t *vs, struct renderer *renderer) {
+    ID3D11DeviceContext1 *context = renderer->context;
+    ID3D11ShaderResourceView *nullsrvs[4] = {NULL};
+    ID3D11UnorderedAccessView *nulluavs[5] = {NULL};
+    const uint32_t resolution = (uint32_t)vs->blur_tex.width;
+    const bool diamond = renderer->vs_blur_shape == SCOPE_BLUR_DIAMOND;
+
+    uint32_t radii[SCOPE_BLUR_MAX_PASSES];
+    const uint32_t pass_count = scope_blur_passes(renderer->vs_blur_shape, renderer->vs_blur_radius, radii);
+
+    context->lpVtbl->CSSetConstantBuffers(context, 0, 1, &vs->blur_cbuffer);
+    for (uint32_t p = 0; p < pass_count; ++p) {
+        const uint32_t size = resolution + 2 * (radii[p] + 1);
+        const bool last = p + 1 == pass_count;
+
+        const struct blur_pass_cbuffer cb = {.pass_radius = radii[p], .last_pass = last};
+        D3D11_MAPPED_SUBRESOURCE map;
+        context->lpVtbl->Map(context, (ID3D11Resource *)vs->blur_cbuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
+        memcpy(map.pData, &cb, sizeof(cb));
+        context->lpVtbl->Unmap(context, (ID3D11Resource *)vs->blur_cbuffer, 0);
+
+        // Prefix sums of the padded rows, of the bins or the averages of the pass before
+        shader_pipeline_bind(context, &renderer->passes.vs_blur_rows);
+        context->lpVtbl->CSSetShaderResources(context, 0, 1, p == 0 ? &vs->accum_tex.srv : &vs->blur_average_tex.srv);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 1, 1, &vs->blur_prefix_tex.uav[0], NULL);
+        context->lpVtbl->Dispatch(context, (size + 63) / 64, 1, 1);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 1, 1, nulluavs, NULL);
+        context->lpVtbl->CSSetShaderResources(context, 0, 1, nullsrvs);
+
+        // Down the columns, or along the diagonals of both diamond tables
+        ID3D11UnorderedAccessView *table_uavs[] = {vs->blur_table_tex[0].uav[0], vs->blur_table_tex[1].uav[0]};
+        const uint32_t scan_threads = diamond ? 2 * (2 * size - 1) : size;
+        shader_pipeline_bind(context, &renderer->passes.vs_blur_scan);
+        context->lpVtbl->CSSetShaderResources(context, 1, 1, &vs->blur_prefix_tex.srv);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 2, 2, table_uavs, NULL);
+        context->lpVtbl->Dispatch(context, (scan_threads + 63) / 64, 1, 1);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 2, 2, nulluavs, NULL);
+        context->lpVtbl->CSSetShaderResources(context, 1, 1, nullsrvs);
+
+        // Sums over the shape, averaged into blur_tex or, before the last pass, blur_average_tex
+        ID3D11ShaderResourceView *table_srvs[] = {vs->blur_table_tex[0].srv, vs->blur_table_tex[1].srv};
+        ID3D11UnorderedAccessView *out_uavs[] = {vs->blur_tex.uav[0], NULL, NULL, NULL, vs->blur_average_tex.uav[0]};
+        shader_pipeline_bind(context, &renderer->passes.vs_blur);
+        context->lpVtbl->CSSetShaderResources(context, 2, 2, table_srvs);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 0, ARRAY_LENGTH(out_uavs), out_uavs, NULL);
+        context->lpVtbl->Dispatch(context, (resolution + 7) / 8, (resolution + 7) / 8, 1);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 0, ARRAY_LENGTH(nulluavs), nulluavs, NULL);
+        context->lpVtbl->CSSetShaderResources(context, 2, 2, nullsrvs);
+    }
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "persistence.h"
+#include "scope.h"
+#include "scope_blur.h"
 #include "texture.h"
 
 #include <stdbool.h>
@@ -11,9 +14,31 @@ typedef struct vectorscope {
     texture_t blur_tex;
     texture_t composite_tex;
 
+    // Tables of running sums vs_blur builds for each pass, padded for the widest pass of the blur,
+    // and the box averages between the passes of a Gaussian
+    texture_t blur_prefix_tex;
+    texture_t blur_table_tex[2];
+    texture_t blur_average_tex;
+
     ID3D11Buffer *cbuffer;
+    ID3D11Buffer *blur_cbuffer; // BlurPass in vs_blur.cs.hlsl
+
+    // Trails of earlier captures, kept in place of the hits of accum_tex while the half-life is non-zero
+    persistence_t persistence;
+
+    // Capture generation composite_tex was rendered from, rendering is skipped while it doesn't
+    // change and no trails are fading
+    uint64_t generation;
+    bool has_output;
 } vectorscope_t;
 
 bool vectorscope_setup(vectorscope_t *vs, struct renderer *renderer);
-void vectorscope_render(vectorscope_t *vs, struct renderer *renderer, texture_t *capture_texture);
+// Recreates the accumulation and blur textures at the resolution of `config`, and renders again
+// for a new zoom. The trails start over.
+bool vectorscope_configure(vectorscope_t *vs, struct renderer *renderer, const scope_config_t *config);
+// Fades the hits of every capture to half over `half_life` rendered frames, 0 shows each capture on its own
+bool vectorscope_set_persistence(vectorscope_t *vs, struct renderer *renderer, float half_life);
+// Sizes the blur tables for the passes of `shape` at `radius` and renders again
+bool vectorscope_set_blur(vectorscope_t *vs, struct renderer *renderer, scope_blur_shape_t shape, uint32_t radius);
+void vectorscope_render(vectorscope_t *vs, struct renderer *renderer, texture_t *capture_texture, uint64_t generation);
 texture_t *vectorscope_get_texture(vectorscope_t *vs);
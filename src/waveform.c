@@ -7,8 +7,12 @@
 
 #include <assert.h>
 
-#define WF_INT_RES_X 1024
-#define WF_INT_RES_Y 512
+// The composites keep this size whatever the accumulation resolution, wf_comp and parade_comp sample it
+#define WF_COMPOSITE_WIDTH 1024
+#define WF_COMPOSITE_HEIGHT 512
+
+static bool create_accum_buffer(waveform_t *wf, ID3D11Device1 *device, uint32_t width, uint32_t buckets);
+static void destroy_accum_buffer(waveform_t *wf);
 
 bool waveform_setup(waveform_t *wf, struct renderer *renderer) {
     ID3D11Device1 *device = renderer->device;
@@ -16,8 +20,8 @@ bool waveform_setup(waveform_t *wf, struct renderer *renderer) {
     // Create necessary textures
     {
         const texture_desc_t composite_tex_desc = {
-            .width = WF_INT_RES_X,
-            .height = WF_INT_RES_Y,
+            .width = WF_COMPOSITE_WIDTH,
+            .height = WF_COMPOSITE_HEIGHT,
             .format = DXGI_FORMAT_R8G8B8A8_UNORM,
             .array_size = 1,
             .bind_flags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS,
@@ -40,60 +44,130 @@ bool waveform_setup(waveform_t *wf, struct renderer *renderer) {
     }
 
     // Set up structured buffer fo accumulation
-    {
-        struct buffer_data {
-            uint32_t r, g, b;
-        };
+    if (!create_accum_buffer(wf, device, renderer->scope_config.wf_width, renderer->scope_config.wf_buckets)) {
+        return false;
+    }
 
-        D3D11_BUFFER_DESC buffer_desc = {
-            .Usage = D3D11_USAGE_DEFAULT,
-            .ByteWidth = sizeof(struct buffer_data) * WF_INT_RES_X * WF_INT_RES_Y,
-            .BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE,
-            .MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED,
-            .StructureByteStride = sizeof(struct buffer_data),
-        };
+    if (!persistence_setup(&wf->persistence, renderer)) {
+        return false;
+    }
 
-        HRESULT hr = device->lpVtbl->CreateBuffer(device, &buffer_desc, NULL, &wf->accum_buffer);
-        if (FAILED(hr)) {
-            LOG("Failed to create structured buffer for Waveform");
+    return true;
+}
+
+bool waveform_configure(waveform_t *wf, struct renderer *renderer, const scope_config_t *config) {
+    // The config changed, if not the size then the encoding, both composites have to be rendered
+    // again and the trails start over
+    wf->has_output = false;
+    wf->has_parade_output = false;
+    if (wf->accum_width != config->wf_width || wf->accum_buckets != config->wf_buckets) {
+        destroy_accum_buffer(wf);
+        if (!create_accum_buffer(wf, renderer->device, config->wf_width, config->wf_buckets)) {
             return false;
         }
 
-        D3D11_UNORDERED_ACCESS_VIEW_DESC uav_desc = {
-            .Format = DXGI_FORMAT_UNKNOWN,
-            .ViewDimension = D3D11_UAV_DIMENSION_BUFFER,
-            .Buffer = {
-                .FirstElement = 0,
-                .NumElements = WF_INT_RES_X * WF_INT_RES_Y,
-            },
-        };
+        LOG("Waveform buffer resized to %ux%u", config->wf_width, config->wf_buckets);
+    }
 
-        hr = device->lpVtbl->CreateUnorderedAccessView(device, (ID3D11Resource *)wf->accum_buffer, &uav_desc, &wf->accum_uav);
-        if (FAILED(hr)) {
-            LOG("Failed to create UAV for Waveform's Structured Buffer");
-            return false;
-        }
+    if (!persistence_configure(&wf->persistence, renderer, 3 * wf->accum_width * wf->accum_buckets, wf->persistence.half_life)) {
+        LOG("Failed to resize persistence for waveform");
+        return false;
+    }
+    return true;
+}
 
-        D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc = {
-            .Format = DXGI_FORMAT_UNKNOWN,
-            .ViewDimension = D3D11_SRV_DIMENSION_BUFFER,
-            .Buffer = {
-                .FirstElement = 0,
-                .NumElements = WF_INT_RES_X * WF_INT_RES_Y,
-            },
-        };
+bool waveform_set_persistence(waveform_t *wf, struct renderer *renderer, float half_life) {
+    // The buffer may hold resolved trails, the capture is accumulated again
+    wf->has_output = false;
+    if (!persistence_configure(&wf->persistence, renderer, 3 * wf->accum_width * wf->accum_buckets, half_life)) {
+        LOG("Failed to create persistence for waveform");
+        return false;
+    }
+    return true;
+}
 
-        hr = device->lpVtbl->CreateShaderResourceView(device, (ID3D11Resource *)wf->accum_buffer, &srv_desc, &wf->accum_srv);
-        if (FAILED(hr)) {
-            LOG("Failed to create UAV for Waveform's Structured Buffer");
-            return false;
-        }
+static bool create_accum_buffer(waveform_t *wf, ID3D11Device1 *device, uint32_t width, uint32_t buckets) {
+    struct buffer_data {
+        uint32_t r, g, b;
+    };
+
+    D3D11_BUFFER_DESC buffer_desc = {
+        .Usage = D3D11_USAGE_DEFAULT,
+        .ByteWidth = sizeof(struct buffer_data) * width * buckets,
+        .BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE,
+        .MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED,
+        .StructureByteStride = sizeof(struct buffer_data),
+    };
+
+    HRESULT hr = device->lpVtbl->CreateBuffer(device, &buffer_desc, NULL, &wf->accum_buffer);
+    if (FAILED(hr)) {
+        LOG("Failed to create structured buffer for Waveform");
+        return false;
     }
 
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uav_desc = {
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .ViewDimension = D3D11_UAV_DIMENSION_BUFFER,
+        .Buffer = {
+            .FirstElement = 0,
+            .NumElements = width * buckets,
+        },
+    };
+
+    hr = device->lpVtbl->CreateUnorderedAccessView(device, (ID3D11Resource *)wf->accum_buffer, &uav_desc, &wf->accum_uav);
+    if (FAILED(hr)) {
+        LOG("Failed to create UAV for Waveform's Structured Buffer");
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc = {
+        .Format = DXGI_FORMAT_UNKNOWN,
+        .ViewDimension = D3D11_SRV_DIMENSION_BUFFER,
+        .Buffer = {
+            .FirstElement = 0,
+            .NumElements = width * buckets,
+        },
+    };
+
+    hr = device->lpVtbl->CreateShaderResourceView(device, (ID3D11Resource *)wf->accum_buffer, &srv_desc, &wf->accum_srv);
+    if (FAILED(hr)) {
+        LOG("Failed to create UAV for Waveform's Structured Buffer");
+        return false;
+    }
+
+    wf->accum_width = width;
+    wf->accum_buckets = buckets;
     return true;
 }
 
-void waveform_render(waveform_t *wf, struct renderer *renderer, texture_t *capture_texture) {
+static void destroy_accum_buffer(waveform_t *wf) {
+    if (wf->accum_srv) {
+        wf->accum_srv->lpVtbl->Release(wf->accum_srv);
+        wf->accum_srv = NULL;
+    }
+
+    if (wf->accum_uav) {
+        wf->accum_uav->lpVtbl->Release(wf->accum_uav);
+        wf->accum_uav = NULL;
+    }
+
+    if (wf->accum_buffer) {
+        wf->accum_buffer->lpVtbl->Release(wf->accum_buffer);
+        wf->accum_buffer = NULL;
+    }
+}
+
+void waveform_render(waveform_t *wf, struct renderer *renderer, texture_t *capture_texture, uint64_t generation) {
+    // Same frame as last time, the accumulation buffer and composite_tex still hold its result
+    // unless trails are fading
+    const bool captured = !wf->has_output || wf->generation != generation;
+    if (!captured && !persistence_is_decaying(&wf->persistence)) {
+        return;
+    }
+    wf->generation = generation;
+    wf->revision++;
+    wf->has_output = true;
+
     ID3D11DeviceContext1 *context = renderer->context;
     unsigned int clear_color_uint[4] = {0, 0, 0, 0};
     float clear_color_float[4] = {0.0f, 0.0f, 0.0f, 0.0f};
@@ -101,19 +175,27 @@ void waveform_render(waveform_t *wf, struct renderer *renderer, texture_t *captu
     uint32_t thread_groups[] = {8, 8, 1};
 
     // 1. Accumulate samples
-    shader_pipeline_bind(context, &renderer->passes.wf_accum);
-    context->lpVtbl->CSSetSamplers(context, 0, 1, &renderer->sampler_states[SAMPLER_LINEAR_CLAMP]);
-    context->lpVtbl->CSSetShaderResources(context, 0, 1, &capture_texture->srv);
-    context->lpVtbl->ClearUnorderedAccessViewUint(context, wf->accum_uav, clear_color_uint);
-    context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &wf->accum_uav, NULL);
-    context->lpVtbl->Dispatch(
-        context,
-        (capture_texture->width + (thread_groups[0] - 1)) / thread_groups[0],
-        (capture_texture->width + (thread_groups[1] - 1)) / thread_groups[1],
-        thread_groups[2]);
-    context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &nulluav, NULL);
+    if (captured) {
+        shader_pipeline_bind(context, &renderer->passes.wf_accum[scope_encoding_index(renderer->scope_config.encoding)]);
+        context->lpVtbl->CSSetSamplers(context, 0, 1, &renderer->sampler_states[SAMPLER_LINEAR_CLAMP]);
+        context->lpVtbl->CSSetShaderResources(context, 0, 1, &capture_texture->srv);
+        context->lpVtbl->ClearUnorderedAccessViewUint(context, wf->accum_uav, clear_color_uint);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &wf->accum_uav, NULL);
+        context->lpVtbl->Dispatch(
+            context,
+            (capture_texture->width + (thread_groups[0] - 1)) / thread_groups[0],
+            (capture_texture->width + (thread_groups[1] - 1)) / thread_groups[1],
+            thread_groups[2]);
+        context->lpVtbl->CSSetUnorderedAccessViews(context, 0, 1, &nulluav, NULL);
+    }
+
+    // 2. Add them to the trails, or only fade those, nothing while persistence is off. One
+    // thread per cell, 64 to a group.
+    const uint32_t persist_groups[] = {(wf->accum_width * wf->accum_buckets + 63) / 64, 1, 1};
+    persistence_apply(&wf->persistence, renderer, &renderer->passes.wf_persist, wf->accum_uav, captured,
+                      (uint64_t)capture_texture->width * capture_texture->height, persist_groups);
 
-    // 2. Composite with overlay into final texture
+    // 3. Composite with overlay into final texture
     shader_pipeline_bind(context, &renderer->passes.wf_comp);
     context->lpVtbl->CSSetShaderResources(context, 0, 1, &wf->accum_srv);
     context->lpVtbl->ClearUnorderedAccessViewFloat(context, wf->composite_tex.uav[0], clear_color_float);
@@ -127,6 +209,13 @@ void waveform_render(waveform_t *wf, struct renderer *renderer, texture_t *captu
 }
 
 void parade_render(waveform_t *wf, struct renderer *renderer) {
+    // The parade is built from the waveform's accumulation buffer, so it only changes along with it
+    if (wf->has_parade_output && wf->parade_revision == wf->revision) {
+        return;
+    }
+    wf->parade_revision = wf->revision;
+    wf->has_parade_output = true;
+
     ID3D11DeviceContext1 *context = renderer->context;
     float clear_color_float[4] = {0.0f, 0.0f, 0.0f, 0.0f};
     ID3D11UnorderedAccessView *nulluav = NULL;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "persistence.h"
+#include "scope.h"
 #include "texture.h"
 
 #include <stdbool.h>
@@ -10,16 +12,34 @@ typedef struct waveform {
     ID3D11Buffer *accum_buffer;
     ID3D11UnorderedAccessView *accum_uav;
     ID3D11ShaderResourceView *accum_srv;
+    uint32_t accum_width; // columns and rows of accum_buffer, from the renderer's scope_config
+    uint32_t accum_buckets;
 
     texture_t blur_tex;
     texture_t composite_tex;
     texture_t parade_tex;
 
     ID3D11Buffer *cbuffer;
+
+    // Trails of earlier captures, kept in place of the counts of accum_buffer while the half-life is non-zero
+    persistence_t persistence;
+
+    // Capture generation the waveform was rendered from, rendering is skipped while it doesn't
+    // change and no trails are fading. Every render bumps the revision, the parade is rendered
+    // again when it differs from the one it was built from.
+    uint64_t generation;
+    uint64_t revision;
+    uint64_t parade_revision;
+    bool has_output;
+    bool has_parade_output;
 } waveform_t;
 
 bool waveform_setup(waveform_t *wf, struct renderer *renderer);
-void waveform_render(waveform_t *wf, struct renderer *renderer, texture_t *capture_texture);
+// Recreates the accumulation buffer at the size of `config`. The trails start over.
+bool waveform_configure(waveform_t *wf, struct renderer *renderer, const scope_config_t *config);
+// Fades the counts of every capture to half over `half_life` rendered frames, 0 shows each capture on its own
+bool waveform_set_persistence(waveform_t *wf, struct renderer *renderer, float half_life);
+void waveform_render(waveform_t *wf, struct renderer *renderer, texture_t *capture_texture, uint64_t generation);
 void parade_render(waveform_t *wf, struct renderer *renderer);
 texture_t *waveform_get_texture(waveform_t *wf);
 texture_t *parade_get_texture(waveform_t *wf);
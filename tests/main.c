@@ -0,0 +1,127 @@
+// Unit tests of scope-core.
+//
+// Usage: scope-test [name...]
+// Without arguments every test runs, otherwise those whose name contains one of the arguments.
+// Exits non-zero if any check failed.
+
+#include "scope_test.h"
+
+#include "../src/macros.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct scope_test {
+    const char *name;
+    void (*run)(void);
+} scope_test_t;
+
+#define SCOPE_TEST_ENTRY(name) {#name, test_##name},
+static const scope_test_t tests[] = {SCOPE_TESTS(SCOPE_TEST_ENTRY)};
+#undef SCOPE_TEST_ENTRY
+
+static uint32_t failures = 0;
+static char context[256] = "";
+
+static bool selected(const char *name, int argc, char **argv);
+
+int main(int argc, char **argv) {
+    uint32_t failed_tests = 0;
+    uint32_t run = 0;
+
+    for (size_t i = 0; i < ARRAY_LENGTH(tests); ++i) {
+        if (!selected(tests[i].name, argc, argv)) continue;
+
+        uint32_t before = failures;
+        context[0] = '\0';
+        tests[i].run();
+        run++;
+
+        bool ok = failures == before;
+        printf("%-32s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+        failed_tests += !ok;
+    }
+
+    printf("%u of %u tests passed\n", run - failed_tests, run);
+    return failed_tests ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+bool scope_test_check(bool ok, const char *expression, const char *file, int line) {
+    if (!ok) {
+        failures++;
+        fprintf(stderr, "%s:%d: %s failed%s%s\n", file, line, expression, context[0] ? " for " : "", context);
+    }
+    return ok;
+}
+
+bool scope_test_check_same_u32(const uint32_t *actual, const uint32_t *expected, size_t count, const char *expression, const char *file, int line) {
+    for (size_t i = 0; i < count; ++i) {
+        if (actual[i] != expected[i]) {
+            failures++;
+            fprintf(stderr, "%s:%d: %s[%zu] is %u, expected %u%s%s\n", file, line, expression, i, actual[i], expected[i], context[0] ? " for " : "", context);
+            return false;
+        }
+    }
+    return true;
+}
+
+void scope_test_context(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(context, sizeof(context), format, args);
+    va_end(args);
+}
+
+static bool selected(const char *name, int argc, char **argv) {
+    if (argc < 2) return true;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strstr(name, argv[i])) return true;
+    }
+    return false;
+}
+
+uint32_t scope_test_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+uint8_t *scope_test_rgb8_frame(scope_image_t *image, uint32_t width, uint32_t height, uint32_t padding, scope_pixel_format_t format, uint32_t seed) {
+    static const uint8_t edges[][3] = {
+        {0, 0, 0}, {255, 255, 255}, {255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {0, 255, 255}, {255, 0, 255}, {255, 255, 0}};
+
+    const uint32_t stride = width * 4 + padding;
+    uint8_t *pixels = malloc((size_t)stride * height);
+    if (!pixels) {
+        fprintf(stderr, "out of memory for a %ux%u frame\n", width, height);
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t state = seed ? seed : 1;
+    for (size_t i = 0; i < (size_t)stride * height; ++i) {
+        pixels[i] = (uint8_t)scope_test_random(&state);
+    }
+
+    // Edge colors at the start, in the channel order of the format
+    const bool bgra = format == SCOPE_PIXEL_FORMAT_BGRA8;
+    for (uint32_t i = 0; i < ARRAY_LENGTH(edges) && i < width * height; ++i) {
+        uint8_t *px = pixels + (size_t)(i / width) * stride + (i % width) * 4;
+        px[bgra ? 2 : 0] = edges[i][0];
+        px[1] = edges[i][1];
+        px[bgra ? 0 : 2] = edges[i][2];
+    }
+
+    *image = (scope_image_t){
+        .data = pixels,
+        .width = width,
+        .height = height,
+        .stride = stride,
+        .format = format,
+    };
+    return pixels;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "scope.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Every test of scope-test, in the order they run. Each is a void test_<name>(void) in one of
+// the tests/*.c files that reports through the CHECK macros.
+#define SCOPE_TESTS(X) \
+    X(vectorscope_shader) \
+    X(waveform_shader) \
+    X(vectorscope_isa) \
+    X(vectorscope_zoom) \
+    X(vectorscope_lut) \
+    X(vectorscope_chroma_weights) \
+    X(vectorscope_parallel) \
+    X(vectorscope_generation) \
+    X(waveform_kernels) \
+    X(waveform_parallel) \
+    X(waveform_generation) \
+    X(convert_isa) \
+    X(convert_matrix) \
+    X(hdr_half) \
+    X(hdr_levels) \
+    X(hdr_signal) \
+    X(blur_diamond) \
+    X(encoding_levels) \
+    X(encoding_chroma) \
+    X(encoding_switch) \
+    X(encoding_composite) \
+    X(pyramid_isa) \
+    X(pyramid_clamp) \
+    X(pyramid_map_rect) \
+    X(sample_weights) \
+    X(sample_halton) \
+    X(persistence_decay) \
+    X(persistence_vectorscope) \
+    X(persistence_waveform) \
+    X(persistence_shader) \
+    X(x11_source) \
+    X(triple_buffer) \
+    X(triple_threads) \
+    X(async_source) \
+    X(file_y4m) \
+    X(file_malformed) \
+    X(file_raw) \
+    X(tiles_isa) \
+    X(tiles_change) \
+    X(incremental_rects) \
+    X(multi_views)
+
+#define SCOPE_TEST_DECLARE(name) void test_##name(void);
+SCOPE_TESTS(SCOPE_TEST_DECLARE)
+#undef SCOPE_TEST_DECLARE
+
+/* @brief Records a failed check, printing it with the current context. Returns `ok`. */
+bool scope_test_check(bool ok, const char *expression, const char *file, int line);
+/* @brief Compares `count` values, a failure names the first index that differs */
+bool scope_test_check_same_u32(const uint32_t *actual, const uint32_t *expected, size_t count, const char *expression, const char *file, int line);
+/* @brief Describes what is being checked, printed with every failure until the next call */
+void scope_test_context(const char *format, ...);
+
+#define CHECK(expression) scope_test_check((expression), #expression, __FILE__, __LINE__)
+#define CHECK_SAME_U32(actual, expected, count) scope_test_check_same_u32((actual), (expected), (count), #actual, __FILE__, __LINE__)
+
+/* @brief xorshift32, the test frames are reproducible */
+uint32_t scope_test_random(uint32_t *state);
+/* @brief Allocates an 8-bit RGB frame of random pixels with `padding` unused bytes at the end of
+ * every row. The first pixels are black, white, the primaries and the secondaries so the edges
+ * of the scopes are always hit. Free the returned pixels with free(). */
+uint8_t *scope_test_rgb8_frame(scope_image_t *image, uint32_t width, uint32_t height, uint32_t padding, scope_pixel_format_t format, uint32_t seed);
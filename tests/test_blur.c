@@ -0,0 +1,105 @@
+#include "scope_test.h"
+
+#include "scope_blur.h"
+#include "scope_internal.h"
+#include "scope_render.h"
+#include "scope_vectorscope.h"
+
+#include "../src/macros.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Tiles hit by a layout of bins, as [x, y, width, height] in tiles, the rest of the plane empty
+typedef struct tile_layout {
+    const char *name;
+    uint32_t rects[2][4];
+    uint32_t rect_count;
+} tile_layout_t;
+
+static void fill_tiles(scope_vectorscope_t *vs, const tile_layout_t *layout, uint32_t seed);
+
+// The radius 2 diamond against scope_vectorscope_blur(), bit for bit: over the whole plane and
+// over the bounds of bins inside the plane, in the corners of the grid or nowhere, summed in one
+// band and in several
+void test_blur_diamond(void) {
+    static const scope_quality_t qualities[] = {SCOPE_QUALITY_256, SCOPE_QUALITY_DEFAULT};
+    static const uint32_t thread_counts[] = {1, 3, 8};
+    static const tile_layout_t layouts[] = {
+        {"whole plane", {{0, 0, UINT32_MAX, UINT32_MAX}}, 1},
+        {"inside", {{3, 3, 2, 2}}, 1},
+        {"corners", {{0, 0, 1, 1}, {UINT32_MAX, UINT32_MAX, 1, 1}}, 2},
+        {"empty", {{0}}, 0},
+    };
+
+    scope_vectorscope_t vs;
+    if (!CHECK(scope_vectorscope_create(&vs))) return;
+
+    scope_blur_t blur;
+    scope_blur_create(&blur, SCOPE_BLUR_DIAMOND, 2);
+
+    for (size_t q = 0; q < ARRAY_LENGTH(qualities); ++q) {
+        const scope_config_t config = scope_config_preset(qualities[q]);
+        if (!CHECK(scope_vectorscope_configure(&vs, &config))) continue;
+
+        const size_t count = (size_t)vs.resolution * vs.resolution;
+        float *expected = malloc(count * sizeof(float));
+        float *actual = malloc(count * sizeof(float));
+        for (size_t l = 0; expected && actual && l < ARRAY_LENGTH(layouts); ++l) {
+            fill_tiles(&vs, &layouts[l], (uint32_t)(q * ARRAY_LENGTH(layouts) + l + 1));
+            scope_vectorscope_blur(&vs, expected);
+
+            scope_rect_t occupied;
+            scope_vectorscope_bounds(&vs, &occupied);
+
+            for (size_t t = 0; t < ARRAY_LENGTH(thread_counts); ++t) {
+                scope_thread_pool_t *pool = NULL;
+                if (!CHECK(scope_thread_pool_create(thread_counts[t], &pool))) continue;
+
+                for (uint32_t bounded = 0; bounded < 2; ++bounded) {
+                    scope_test_context("resolution %u, %s, %u threads, %s", vs.resolution, layouts[l].name, thread_counts[t], bounded ? "occupied rect" : "whole grid");
+                    memset(actual, 0xff, count * sizeof(float));
+                    if (!CHECK(scope_blur_apply(&blur, vs.bins, vs.resolution, bounded ? &occupied : NULL, actual, pool))) continue;
+                    CHECK(memcmp(actual, expected, count * sizeof(float)) == 0);
+                }
+                scope_thread_pool_destroy(pool);
+            }
+        }
+
+        CHECK(expected && actual);
+        free(actual);
+        free(expected);
+    }
+
+    scope_blur_destroy(&blur);
+    scope_vectorscope_destroy(&vs);
+}
+
+// Clears the bins and fills a third of those in the rects with random counts, the edge bins of
+// each rect always. Rects are clipped to the grid, UINT32_MAX is the last tile.
+static void fill_tiles(scope_vectorscope_t *vs, const tile_layout_t *layout, uint32_t seed) {
+    const uint32_t res = vs->resolution;
+    const uint32_t tiles = vs->tiles_per_row;
+    memset(vs->bins, 0, (size_t)res * res * sizeof(uint32_t));
+    memset(vs->tiles, 0, (size_t)tiles * tiles);
+
+    for (uint32_t i = 0; i < layout->rect_count; ++i) {
+        const uint32_t *rect = layout->rects[i];
+        const uint32_t tx = MIN(rect[0], tiles - 1), ty = MIN(rect[1], tiles - 1);
+        const uint32_t tx_end = MIN(tx + MIN(rect[2], tiles), tiles), ty_end = MIN(ty + MIN(rect[3], tiles), tiles);
+
+        for (uint32_t y = ty; y < ty_end; ++y) {
+            memset(vs->tiles + (size_t)y * tiles + tx, 1, tx_end - tx);
+        }
+
+        const uint32_t x_begin = tx * SCOPE_VS_TILE_SIZE, x_end = MIN(tx_end * SCOPE_VS_TILE_SIZE, res);
+        const uint32_t y_begin = ty * SCOPE_VS_TILE_SIZE, y_end = MIN(ty_end * SCOPE_VS_TILE_SIZE, res);
+        for (uint32_t y = y_begin; y < y_end; ++y) {
+            for (uint32_t x = x_begin; x < x_end; ++x) {
+                const uint32_t r = scope_test_random(&seed);
+                const bool edge = x == x_begin || x + 1 == x_end || y == y_begin || y + 1 == y_end;
+                vs->bins[(size_t)y * res + x] = edge || r % 3 == 0 ? (r >> 8) % 4096 + 1 : 0;
+            }
+        }
+    }
+}
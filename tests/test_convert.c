@@ -0,0 +1,252 @@
+#include "scope_test.h"
+
+#include "scope_convert.h"
+#include "scope_internal.h"
+
+#include "../src/macros.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Destinations of scope_convert(), the packed formats
+static const scope_pixel_format_t packed_formats[] = {
+    SCOPE_PIXEL_FORMAT_BGRA8,
+    SCOPE_PIXEL_FORMAT_RGBA8,
+    SCOPE_PIXEL_FORMAT_RGBA16F,
+    SCOPE_PIXEL_FORMAT_RGB10A2,
+};
+
+// Floats the half and 10-bit encoders round, clamp or overflow on
+static const float edge_values[] = {
+    -1.0f, -0.0f, 0.0f, 1.0f, 1.5f, 0.5f / 1023.0f, 1.0f / 510.0f, 3e-6f, 6e-8f, 2e-8f, 65504.0f, 65519.0f, 65520.0f, 1e9f, -1e9f,
+};
+
+typedef struct test_frame {
+    scope_image_t image;
+    uint8_t *planes[3];
+} test_frame_t;
+
+static void random_frame(test_frame_t *frame, uint32_t width, uint32_t height, scope_pixel_format_t format, uint32_t seed);
+static void free_frame(test_frame_t *frame);
+static void check_conversions(scope_converter_t *converter, scope_converter_t *scalar, const scope_image_t *image);
+static void check_from_planes(scope_converter_t *converter, scope_converter_t *scalar, uint32_t width, uint32_t height, uint32_t seed);
+
+// The SIMD kernels against the scalar ones, byte for byte: every source format into float planes
+// and every packed format, and float planes with values past every edge into the packed formats.
+// Widths up to 67 and 3 rows cover the vector tails and the odd chroma row and column.
+void test_convert_isa(void) {
+    scope_converter_t converter, scalar;
+    scope_converter_create(&converter);
+    scope_converter_create(&scalar);
+    scalar.isa = SCOPE_ISA_SCALAR;
+
+    for (scope_isa_t isa = SCOPE_ISA_SSE41; isa < SCOPE_ISA_COUNT; ++isa) {
+        if (!scope_cpu_supports(isa)) continue;
+        converter.isa = isa;
+
+        for (uint32_t width = 1; width <= 67; ++width) {
+            for (uint32_t format = 0; format < SCOPE_PIXEL_FORMAT_COUNT; ++format) {
+                test_frame_t frame;
+                random_frame(&frame, width, 3, (scope_pixel_format_t)format, width * SCOPE_PIXEL_FORMAT_COUNT + format);
+                if (!CHECK(frame.planes[0] != NULL)) continue;
+
+                const bool ycbcr = scope_pixel_format_is_ycbcr(frame.image.format);
+                for (uint32_t e = 0; e < (ycbcr ? SCOPE_ENCODING_COUNT : 1); ++e) {
+                    const scope_encoding_t encoding = scope_encoding_from_index(e);
+                    frame.image.range = encoding.range;
+                    converter.matrix = scalar.matrix = encoding.matrix;
+                    scope_test_context("%s, width %u, format %u, encoding %u", scope_isa_name(isa), width, format, e);
+                    check_conversions(&converter, &scalar, &frame.image);
+                }
+                free_frame(&frame);
+            }
+
+            scope_test_context("%s, width %u, from planes", scope_isa_name(isa), width);
+            check_from_planes(&converter, &scalar, width, 3, width);
+        }
+    }
+
+    scope_converter_destroy(&scalar);
+    scope_converter_destroy(&converter);
+}
+
+// Full range 10-bit 4:4:4 encoded from known R'G'B' with the Cb and Cr rows of each matrix has to
+// decode back to it with that matrix, to within the rounding of the codes
+void test_convert_matrix(void) {
+    enum { width = 64, height = 2 };
+
+    scope_converter_t converter;
+    scope_converter_create(&converter);
+
+    uint16_t *samples = malloc(sizeof(uint16_t) * width * height * 3);
+    float *decoded = malloc(sizeof(float) * width * height * 3);
+    float(*rgb)[3] = malloc(sizeof(float[3]) * width * height);
+    if (!CHECK(samples && decoded && rgb)) goto done;
+
+    uint32_t state = 17;
+    for (uint32_t i = 0; i < width * height; ++i) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            // The primaries and secondaries first, they are the furthest from gray
+            rgb[i][c] = i < 8 ? (float)((i >> c) & 1) : (float)(scope_test_random(&state) % 1001) / 1000.0f;
+        }
+    }
+
+    for (uint32_t m = 0; m < SCOPE_MATRIX_COUNT; ++m) {
+        const scope_matrix_weights_t weights = scope_matrix_weights((scope_matrix_t)m);
+        const float *rows[3] = {weights.luma, weights.cb, weights.cr};
+        for (uint32_t i = 0; i < width * height; ++i) {
+            for (uint32_t p = 0; p < 3; ++p) {
+                const float v = rows[p][0] * rgb[i][0] + rows[p][1] * rgb[i][1] + rows[p][2] * rgb[i][2];
+                const long code = lroundf(v * 1023.0f + (p ? 512.0f : 0.0f));
+                samples[p * width * height + i] = (uint16_t)MIN(code, 1023); // Cr of red is half a code past the top
+            }
+        }
+
+        const scope_image_t image = {
+            .data = (const uint8_t *)samples,
+            .width = width,
+            .height = height,
+            .stride = width * 2,
+            .format = SCOPE_PIXEL_FORMAT_YUV444P10,
+            .chroma = {(const uint8_t *)(samples + width * height), (const uint8_t *)(samples + 2 * width * height)},
+            .chroma_stride = width * 2,
+            .range = SCOPE_COLOR_RANGE_FULL,
+        };
+        const scope_float_planes_t planes = {
+            {decoded, decoded + width * height, decoded + 2 * width * height}, width, height, width, 1,
+        };
+
+        converter.matrix = (scope_matrix_t)m;
+        if (!CHECK(scope_convert_to_planes(&converter, &image, &planes, NULL))) continue;
+        for (uint32_t i = 0; i < width * height; ++i) {
+            scope_test_context("matrix %u, pixel %u", m, i);
+            bool close = true;
+            for (uint32_t c = 0; c < 3; ++c) {
+                close = close && fabsf(decoded[c * width * height + i] - rgb[i][c]) < 0.004f;
+            }
+            if (!CHECK(close)) break;
+        }
+    }
+
+done:
+    free(rgb);
+    free(decoded);
+    free(samples);
+    scope_converter_destroy(&converter);
+}
+
+// Random bytes with row padding. Half floats stay finite, the kernels need not agree on NaNs. The
+// 10-bit Y'CbCr formats keep their garbage high or low bits, the decoders mask them off.
+static void random_frame(test_frame_t *frame, uint32_t width, uint32_t height, scope_pixel_format_t format, uint32_t seed) {
+    *frame = (test_frame_t){0};
+    frame->image = (scope_image_t){
+        .width = width,
+        .height = height,
+        .stride = width * scope_pixel_format_bytes(format) + 4 * (width % 3),
+        .format = format,
+    };
+
+    const scope_ycbcr_layout_t layout = scope_ycbcr_layout(format);
+    const bool ycbcr = scope_pixel_format_is_ycbcr(format);
+    const uint32_t chroma_width = (width + layout.x_shift) >> layout.x_shift;
+    const uint32_t chroma_height = (height + layout.y_shift) >> layout.y_shift;
+    frame->image.chroma_stride = chroma_width * layout.sample_bytes * (layout.interleaved ? 2 : 1) + 2 * (width % 4);
+
+    const size_t sizes[3] = {
+        (size_t)frame->image.stride * height,
+        ycbcr ? (size_t)frame->image.chroma_stride * chroma_height : 0,
+        ycbcr && !layout.interleaved ? (size_t)frame->image.chroma_stride * chroma_height : 0,
+    };
+    for (uint32_t p = 0; p < 3; ++p) {
+        if (!sizes[p]) continue;
+        frame->planes[p] = malloc(sizes[p]);
+        if (!frame->planes[p]) {
+            free_frame(frame);
+            *frame = (test_frame_t){0};
+            return;
+        }
+        for (size_t i = 0; i < sizes[p]; ++i) {
+            frame->planes[p][i] = (uint8_t)scope_test_random(&seed);
+        }
+    }
+
+    if (format == SCOPE_PIXEL_FORMAT_RGBA16F) {
+        for (size_t i = 1; i < sizes[0]; i += 2) {
+            if ((frame->planes[0][i] & 0x7c) == 0x7c) frame->planes[0][i] &= ~0x40;
+        }
+    }
+
+    frame->image.data = frame->planes[0];
+    frame->image.chroma[0] = frame->planes[1];
+    frame->image.chroma[1] = frame->planes[2];
+}
+
+static void free_frame(test_frame_t *frame) {
+    for (uint32_t p = 0; p < 3; ++p) {
+        free(frame->planes[p]);
+    }
+}
+
+// Both converters into the same destinations, prefilled so that writes past a row show up too
+static void check_conversions(scope_converter_t *converter, scope_converter_t *scalar, const scope_image_t *image) {
+    const uint32_t width = image->width, height = image->height;
+    const size_t size = (size_t)(width * 4 + 3) * height * 8;
+    uint8_t *actual = malloc(size);
+    uint8_t *expected = malloc(size);
+    if (!CHECK(actual && expected)) goto done;
+
+    // Separate planes, then interleaved RGBA
+    for (uint32_t step = 1; step <= 4; step += 3) {
+        float *a = (float *)actual, *b = (float *)expected;
+        const uint32_t stride = step == 1 ? width + 3 : width * 4;
+        const scope_float_planes_t actual_planes = {{a, a + (step == 1 ? stride * height : 1), a + (step == 1 ? 2 * stride * height : 2)}, width, height, stride, step};
+        const scope_float_planes_t expected_planes = {{b, b + (step == 1 ? stride * height : 1), b + (step == 1 ? 2 * stride * height : 2)}, width, height, stride, step};
+
+        memset(actual, 0x5a, size);
+        memset(expected, 0x5a, size);
+        if (!CHECK(scope_convert_to_planes(converter, image, &actual_planes, NULL) && scope_convert_to_planes(scalar, image, &expected_planes, NULL))) continue;
+        CHECK(memcmp(actual, expected, size) == 0);
+    }
+
+    for (size_t f = 0; f < ARRAY_LENGTH(packed_formats); ++f) {
+        const uint32_t stride = width * scope_pixel_format_bytes(packed_formats[f]) + 8;
+        memset(actual, 0x5a, size);
+        memset(expected, 0x5a, size);
+        if (!CHECK(scope_convert(converter, image, packed_formats[f], actual, stride, NULL) && scope_convert(scalar, image, packed_formats[f], expected, stride, NULL))) continue;
+        CHECK(memcmp(actual, expected, (size_t)stride * height) == 0);
+    }
+
+done:
+    free(expected);
+    free(actual);
+}
+
+static void check_from_planes(scope_converter_t *converter, scope_converter_t *scalar, uint32_t width, uint32_t height, uint32_t seed) {
+    const size_t count = (size_t)width * height * 3;
+    float *values = malloc(count * sizeof(float));
+    const size_t size = (size_t)(width * 8 + 8) * height;
+    uint8_t *actual = malloc(size);
+    uint8_t *expected = malloc(size);
+    if (!CHECK(values && actual && expected)) goto done;
+
+    // Mostly 0-1 and a little past it, with every edge value somewhere
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t r = scope_test_random(&seed);
+        values[i] = r % 4 ? (float)(r >> 8) / (float)(1u << 24) * 1.25f - 0.125f : edge_values[(r >> 2) % ARRAY_LENGTH(edge_values)];
+    }
+    const scope_float_planes_t planes = {{values, values + width * height, values + 2 * width * height}, width, height, width, 1};
+
+    for (size_t f = 0; f < ARRAY_LENGTH(packed_formats); ++f) {
+        const uint32_t stride = width * scope_pixel_format_bytes(packed_formats[f]) + 8;
+        memset(actual, 0x5a, size);
+        memset(expected, 0x5a, size);
+        if (!CHECK(scope_convert_from_planes(converter, &planes, packed_formats[f], actual, stride, NULL) && scope_convert_from_planes(scalar, &planes, packed_formats[f], expected, stride, NULL))) continue;
+        CHECK(memcmp(actual, expected, (size_t)stride * height) == 0);
+    }
+
+done:
+    free(expected);
+    free(actual);
+    free(values);
+}
@@ -0,0 +1,294 @@
+#include "scope_test.h"
+
+#include "scope_render.h"
+#include "scope_vectorscope.h"
+#include "scope_waveform.h"
+
+#include "../src/macros.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool bucket_span(const scope_waveform_t *wf, uint32_t channel, uint32_t *low, uint32_t *high);
+static uint32_t hit_bin(const scope_vectorscope_t *vs);
+static bool solve_rgb(const scope_matrix_weights_t *weights, float cb, float cr, float rgb[3]);
+
+// Limited range puts black at 16 and white at 235 of 255 with both kernels. Limited range Y'CbCr
+// keeps its sub-blacks and super-whites on a limited range scope, and clips on a full range one.
+void test_encoding_levels(void) {
+    static const uint8_t black_white[8] = {0, 0, 0, 255, 255, 255, 255, 255};
+    static const uint8_t luma[4] = {4, 16, 235, 250};
+    static const uint8_t chroma[4] = {128, 128, 128, 128};
+    const scope_image_t rgb = {.data = black_white, .width = 2, .height = 1, .stride = 8, .format = SCOPE_PIXEL_FORMAT_RGBA8};
+    const scope_image_t nv12 = {
+        .data = luma, .width = 4, .height = 1, .stride = 4, .format = SCOPE_PIXEL_FORMAT_NV12,
+        .chroma = {chroma}, .chroma_stride = 4, .range = SCOPE_COLOR_RANGE_LIMITED,
+    };
+
+    scope_waveform_t wf;
+    if (!CHECK(scope_waveform_create(&wf))) return;
+
+    scope_config_t config = scope_config_preset(SCOPE_QUALITY_1024);
+    config.encoding.range = SCOPE_COLOR_RANGE_LIMITED;
+    const uint32_t buckets = config.wf_buckets;
+    const uint32_t black = (uint32_t)(16.0f / 255.0f * (float)buckets), white = (uint32_t)(235.0f / 255.0f * (float)buckets);
+
+    for (uint32_t kernel = 0; kernel < 2; ++kernel) {
+        wf.kernel = kernel ? SCOPE_KERNEL_FLOAT : SCOPE_KERNEL_LUT;
+        if (!CHECK(scope_waveform_configure(&wf, &config))) break;
+        scope_waveform_clear(&wf);
+        scope_waveform_accumulate(&wf, &rgb);
+
+        for (uint32_t c = 0; c < SCOPE_WF_CHANNEL_COUNT; ++c) {
+            uint32_t low, high;
+            scope_test_context("%s kernel, channel %u", kernel ? "float" : "LUT", c);
+            if (!CHECK(bucket_span(&wf, c, &low, &high))) continue;
+            CHECK(low + 1 >= black && low <= black + 1);
+            CHECK(high + 1 >= white && high <= white + 1);
+        }
+    }
+
+    for (uint32_t range = SCOPE_COLOR_RANGE_LIMITED; range <= SCOPE_COLOR_RANGE_FULL; ++range) {
+        config.encoding.range = (scope_color_range_t)range;
+        if (!CHECK(scope_waveform_configure(&wf, &config))) break;
+        scope_waveform_clear(&wf);
+        scope_waveform_accumulate(&wf, &nv12);
+
+        uint32_t low, high;
+        scope_test_context("NV12 on a %s range scope", range == SCOPE_COLOR_RANGE_FULL ? "full" : "limited");
+        if (!CHECK(bucket_span(&wf, SCOPE_WF_CHANNEL_LUMA, &low, &high))) continue;
+        if (range == SCOPE_COLOR_RANGE_FULL) {
+            CHECK(low == 0 && high == buckets - 1);
+        } else {
+            CHECK(low == (uint32_t)(4.0f / 255.0f * (float)buckets));
+            CHECK(high == (uint32_t)(250.0f / 255.0f * (float)buckets));
+        }
+    }
+
+    scope_waveform_destroy(&wf);
+}
+
+// Neutral Y'CbCr lands in the bin of RGB gray in both ranges. Red moves with the matrix, and comes
+// closer to neutral in limited range, where Cb/Cr span 224 of 255 codes.
+void test_encoding_chroma(void) {
+    static const uint8_t luma[4] = {4, 16, 235, 250};
+    static const uint8_t chroma[4] = {128, 128, 128, 128};
+    static const uint8_t gray[4] = {128, 128, 128, 255};
+    static const uint8_t red[4] = {200, 0, 0, 255};
+    const scope_image_t nv12 = {
+        .data = luma, .width = 4, .height = 1, .stride = 4, .format = SCOPE_PIXEL_FORMAT_NV12,
+        .chroma = {chroma}, .chroma_stride = 4, .range = SCOPE_COLOR_RANGE_LIMITED,
+    };
+    const scope_image_t gray_image = {.data = gray, .width = 1, .height = 1, .stride = 4, .format = SCOPE_PIXEL_FORMAT_RGBA8};
+    const scope_image_t red_image = {.data = red, .width = 1, .height = 1, .stride = 4, .format = SCOPE_PIXEL_FORMAT_RGBA8};
+
+    scope_vectorscope_t vs;
+    if (!CHECK(scope_vectorscope_create(&vs))) return;
+
+    int red_at[SCOPE_ENCODING_COUNT][2] = {{0}};
+    for (uint32_t e = 0; e < SCOPE_ENCODING_COUNT; ++e) {
+        scope_config_t config = scope_config_preset(SCOPE_QUALITY_512);
+        config.encoding = scope_encoding_from_index(e);
+        if (!CHECK(scope_vectorscope_configure(&vs, &config))) break;
+        const int center = (int)vs.resolution / 2;
+
+        scope_test_context("encoding %u", e);
+        scope_vectorscope_clear(&vs);
+        scope_vectorscope_accumulate(&vs, &gray_image);
+        const uint32_t gray_bin = hit_bin(&vs);
+        scope_vectorscope_clear(&vs);
+        scope_vectorscope_accumulate(&vs, &nv12);
+        CHECK(hit_bin(&vs) == gray_bin);
+
+        scope_vectorscope_clear(&vs);
+        scope_vectorscope_accumulate(&vs, &red_image);
+        const uint32_t red_bin = hit_bin(&vs);
+        red_at[e][0] = (int)(red_bin % vs.resolution) - center;
+        red_at[e][1] = (int)(red_bin / vs.resolution) - center;
+    }
+
+    scope_test_context("red across the encodings");
+    for (uint32_t m = 0; m < SCOPE_MATRIX_COUNT; ++m) {
+        const uint32_t limited = m * 2, full = m * 2 + 1;
+        CHECK(abs(red_at[limited][0]) < abs(red_at[full][0]) && abs(red_at[limited][1]) < abs(red_at[full][1]));
+        CHECK(red_at[full][0] != red_at[(full + 2) % SCOPE_ENCODING_COUNT][0]);
+    }
+
+    scope_vectorscope_destroy(&vs);
+}
+
+// Configuring the same encoding keeps the bins, another one clears them and bins like a new scope
+void test_encoding_switch(void) {
+    scope_image_t image;
+    uint8_t *pixels = scope_test_rgb8_frame(&image, 611, 197, 0, SCOPE_PIXEL_FORMAT_BGRA8, 7);
+
+    scope_config_t config = scope_config_preset(SCOPE_QUALITY_512);
+    config.encoding = (scope_encoding_t){SCOPE_MATRIX_BT709, SCOPE_COLOR_RANGE_FULL};
+
+    scope_vectorscope_t vs, fresh_vs;
+    scope_waveform_t wf, fresh_wf;
+    const bool created = scope_vectorscope_create(&vs) + scope_vectorscope_create(&fresh_vs) + scope_waveform_create(&wf) + scope_waveform_create(&fresh_wf) == 4;
+    if (!CHECK(pixels && created && scope_vectorscope_configure(&vs, &config) && scope_waveform_configure(&wf, &config))) goto done;
+
+    const size_t bin_count = (size_t)vs.resolution * vs.resolution;
+    const size_t bucket_count = (size_t)wf.width * wf.buckets * SCOPE_WF_CHANNEL_COUNT;
+    scope_vectorscope_accumulate(&vs, &image);
+    scope_waveform_accumulate(&wf, &image);
+
+    uint64_t binned = 0;
+    for (size_t i = 0; i < bin_count; ++i) {
+        binned += vs.bins[i];
+    }
+
+    scope_test_context("same encoding");
+    CHECK(scope_vectorscope_configure(&vs, &config) && scope_waveform_configure(&wf, &config));
+    uint64_t total = 0;
+    for (size_t i = 0; i < bin_count; ++i) {
+        total += vs.bins[i];
+    }
+    CHECK(total > 0 && total == binned);
+
+    scope_test_context("BT.2020");
+    config.encoding.matrix = SCOPE_MATRIX_BT2020;
+    CHECK(scope_vectorscope_configure(&vs, &config) && scope_waveform_configure(&wf, &config));
+    total = 0;
+    for (size_t i = 0; i < bin_count; ++i) {
+        total += vs.bins[i];
+    }
+    for (size_t i = 0; i < bucket_count; ++i) {
+        total += wf.channels[0][i];
+    }
+    CHECK(total == 0);
+
+    if (CHECK(scope_vectorscope_configure(&fresh_vs, &config) && scope_waveform_configure(&fresh_wf, &config))) {
+        scope_vectorscope_accumulate(&vs, &image);
+        scope_waveform_accumulate(&wf, &image);
+        scope_vectorscope_accumulate(&fresh_vs, &image);
+        scope_waveform_accumulate(&fresh_wf, &image);
+        CHECK_SAME_U32(vs.bins, fresh_vs.bins, bin_count);
+        CHECK_SAME_U32(wf.channels[0], fresh_wf.channels[0], bucket_count);
+    }
+
+done:
+    scope_waveform_destroy(&fresh_wf);
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&fresh_vs);
+    scope_vectorscope_destroy(&vs);
+    free(pixels);
+}
+
+// The plane of the composite is colored with the R'G'B' whose Y' is 0.5 and whose Cb/Cr, through the
+// Cb and Cr rows of the encoding's matrix, are those of the bins at the position, at every zoom.
+// Rendered once without hits for the overlay, and once with as many hits everywhere as give an
+// intensity of 1, so the plane shows its colors as they are where there is no overlay.
+void test_encoding_composite(void) {
+    enum { resolution = 64 };
+    static const uint32_t zooms[] = {1, 2, SCOPE_VS_MAX_ZOOM};
+    const uint32_t width = SCOPE_VS_COMPOSITE_WIDTH, height = SCOPE_VS_COMPOSITE_HEIGHT;
+    const size_t size = (size_t)width * height * 4;
+    const float side = (float)MIN(width, height);
+
+    float *blurred = malloc((size_t)resolution * resolution * sizeof(float));
+    uint8_t *overlay = malloc(size);
+    uint8_t *lit = malloc(size);
+    if (!CHECK(blurred && overlay && lit)) goto done;
+
+    const float hits = expm1f(logf(1.0f + (float)resolution * resolution) / 8.0f);
+    const float square_min[2] = {(float)width * 0.5f - side * 0.5f, (float)height * 0.5f - side * 0.5f};
+
+    for (uint32_t n = 0; n < SCOPE_ENCODING_COUNT * ARRAY_LENGTH(zooms); ++n) {
+        const uint32_t e = n / ARRAY_LENGTH(zooms), zoom = zooms[n % ARRAY_LENGTH(zooms)];
+        const scope_encoding_t encoding = scope_encoding_from_index(e);
+        const scope_matrix_weights_t weights = scope_matrix_weights(encoding.matrix);
+
+        memset(blurred, 0, (size_t)resolution * resolution * sizeof(float));
+        scope_render_vectorscope(blurred, resolution, zoom, encoding, overlay, width, height);
+        for (uint32_t i = 0; i < resolution * resolution; ++i) {
+            blurred[i] = hits;
+        }
+        scope_render_vectorscope(blurred, resolution, zoom, encoding, lit, width, height);
+
+        // Within the bins, which span 0.3 around neutral
+        uint32_t compared = 0;
+        for (int j = -7; j <= 7; ++j) {
+            for (int i = -7; i <= 7; ++i) {
+                const uint32_t x = (uint32_t)(square_min[0] + (0.5f + 0.04f * (float)i) * side);
+                const uint32_t y = (uint32_t)(square_min[1] + (0.5f + 0.04f * (float)j) * side);
+                const size_t offset = ((size_t)y * width + x) * 4;
+                if (overlay[offset] || overlay[offset + 1] || overlay[offset + 2]) continue;
+
+                float rgb[3];
+                const float cb = (((float)x - square_min[0]) / side - 0.5f) / (SCOPE_VS_SCOPE_SCALE * (float)zoom);
+                const float cr = (((float)y - square_min[1]) / side - 0.5f) / (SCOPE_VS_SCOPE_SCALE * (float)zoom);
+                if (!CHECK(solve_rgb(&weights, cb, cr, rgb))) break;
+
+                scope_test_context("encoding %u, zoom %u, Cb %g, Cr %g", e, zoom, cb, cr);
+                for (uint32_t c = 0; c < 3; ++c) {
+                    const float expected = CLAMP(rgb[c], 0.0f, 1.0f) * 255.0f;
+                    CHECK(fabsf((float)lit[offset + c] - expected) <= 1.5f);
+                }
+                compared++;
+            }
+        }
+        scope_test_context("encoding %u, zoom %u", e, zoom);
+        CHECK(compared > 150);
+    }
+
+done:
+    free(lit);
+    free(overlay);
+    free(blurred);
+}
+
+// Lowest and highest bucket hit in any column of a channel
+static bool bucket_span(const scope_waveform_t *wf, uint32_t channel, uint32_t *low, uint32_t *high) {
+    *low = UINT32_MAX;
+    *high = 0;
+    for (uint32_t b = 0; b < wf->buckets; ++b) {
+        for (uint32_t x = 0; x < wf->width; ++x) {
+            if (!wf->channels[channel][(size_t)b * wf->width + x]) continue;
+            *low = MIN(*low, b);
+            *high = MAX(*high, b);
+        }
+    }
+    return *low != UINT32_MAX;
+}
+
+// The last bin that was hit, the only one for a frame of one color
+static uint32_t hit_bin(const scope_vectorscope_t *vs) {
+    uint32_t bin = UINT32_MAX;
+    for (uint32_t i = 0; i < vs->resolution * vs->resolution; ++i) {
+        if (vs->bins[i]) bin = i;
+    }
+    return bin;
+}
+
+// R'G'B' with Y' = 0.5 and the given Cb/Cr under the weights of a matrix, by Cramer's rule
+static bool solve_rgb(const scope_matrix_weights_t *weights, float cb, float cr, float rgb[3]) {
+    const float *rows[3] = {weights->luma, weights->cb, weights->cr};
+    const double values[3] = {0.5, cb, cr};
+
+    double m[3][3];
+    for (uint32_t r = 0; r < 3; ++r) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            m[r][c] = rows[r][c];
+        }
+    }
+#define DET3(a) ((a)[0][0] * ((a)[1][1] * (a)[2][2] - (a)[1][2] * (a)[2][1]) - \
+                 (a)[0][1] * ((a)[1][0] * (a)[2][2] - (a)[1][2] * (a)[2][0]) + \
+                 (a)[0][2] * ((a)[1][0] * (a)[2][1] - (a)[1][1] * (a)[2][0]))
+    const double det = DET3(m);
+    if (fabs(det) < 1e-6) return false;
+
+    for (uint32_t c = 0; c < 3; ++c) {
+        double replaced[3][3];
+        memcpy(replaced, m, sizeof(m));
+        for (uint32_t r = 0; r < 3; ++r) {
+            replaced[r][c] = values[r];
+        }
+        rgb[c] = (float)(DET3(replaced) / det);
+    }
+#undef DET3
+    return true;
+}
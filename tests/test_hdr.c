@@ -0,0 +1,175 @@
+#include "scope_test.h"
+
+#include "scope_convert.h"
+#include "scope_hdr.h"
+#include "scope_lut.h"
+
+#include "../src/macros.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint16_t random_half(uint32_t *state);
+static float reference_level(const uint8_t *px);
+
+// Every half through the float planes of each ISA against scope_half_to_float(), bit for bit, the
+// patterns spread over R, G and B of an odd width so the vector tails convert them too, and back
+// through scope_float_to_half()
+void test_hdr_half(void) {
+    enum { width = 127, height = (65536 / 3 + width) / width };
+    const size_t count = (size_t)width * height;
+
+    uint16_t *halves = malloc(count * 4 * sizeof(uint16_t));
+    float *planes = malloc(count * 3 * sizeof(float));
+    scope_converter_t converter;
+    scope_converter_create(&converter);
+    if (!CHECK(halves && planes)) goto done;
+
+    for (size_t i = 0; i < count; ++i) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            halves[i * 4 + c] = (uint16_t)(i * 3 + c);
+        }
+        halves[i * 4 + 3] = 0x3c00;
+    }
+    const scope_image_t image = {
+        .data = (const uint8_t *)halves,
+        .width = width,
+        .height = height,
+        .stride = width * 8,
+        .format = SCOPE_PIXEL_FORMAT_RGBA16F,
+        .transfer = SCOPE_TRANSFER_LINEAR,
+    };
+    const scope_float_planes_t float_planes = {{planes, planes + count, planes + 2 * count}, width, height, width, 1};
+
+    for (scope_isa_t isa = SCOPE_ISA_SCALAR; isa < SCOPE_ISA_COUNT; ++isa) {
+        if (!scope_cpu_supports(isa)) continue;
+
+        scope_test_context("%s", scope_isa_name(isa));
+        converter.isa = isa;
+        if (!CHECK(scope_convert_to_planes(&converter, &image, &float_planes, NULL))) continue;
+
+        uint32_t mismatches = 0;
+        for (size_t i = 0; i < count * 3; ++i) {
+            const float expected = scope_half_to_float((uint16_t)i);
+            mismatches += memcmp(&float_planes.planes[i % 3][i / 3], &expected, sizeof(float)) != 0;
+        }
+        CHECK(mismatches == 0);
+    }
+
+    // NaN comes back quiet
+    scope_test_context("round trip");
+    uint32_t mismatches = 0;
+    for (uint32_t h = 0; h < 65536; ++h) {
+        const bool nan = (h & 0x7c00u) == 0x7c00u && (h & 0x3ffu) != 0;
+        mismatches += scope_float_to_half(scope_half_to_float((uint16_t)h)) != (nan ? h | 0x200u : h);
+    }
+    CHECK(mismatches == 0);
+
+done:
+    scope_converter_destroy(&converter);
+    free(planes);
+    free(halves);
+}
+
+// Light levels of scRGB frames with every ISA against the scalar kernel, bit for bit, and MaxCLL
+// against the brightest component found pixel by pixel. Widths up to 37 leave every tail after the
+// vectors; negative values, NaN, infinities and subnormals are among the pixels.
+void test_hdr_levels(void) {
+    enum { max_width = 37, height = 3 };
+
+    uint16_t *halves = malloc((size_t)max_width * height * 4 * sizeof(uint16_t));
+    if (!CHECK(halves)) return;
+
+    uint32_t state = 41;
+    for (uint32_t width = 1; width <= max_width; ++width) {
+        for (uint32_t i = 0; i < width * height * 4; ++i) {
+            halves[i] = random_half(&state);
+        }
+        const scope_image_t image = {
+            .data = (const uint8_t *)halves,
+            .width = width,
+            .height = height,
+            .stride = width * 8,
+            .format = SCOPE_PIXEL_FORMAT_RGBA16F,
+            .transfer = SCOPE_TRANSFER_LINEAR,
+        };
+
+        float max = 0.0f;
+        for (uint32_t i = 0; i < width * height; ++i) {
+            max = MAX(max, reference_level((const uint8_t *)(halves + i * 4)));
+        }
+
+        scope_light_level_t expected;
+        scope_light_level_measure(&image, SCOPE_ISA_SCALAR, &expected);
+        scope_test_context("width %u, scalar", width);
+        CHECK(expected.max_nits == max * SCOPE_SCRGB_WHITE_NITS);
+
+        for (scope_isa_t isa = SCOPE_ISA_SSE41; isa < SCOPE_ISA_COUNT; ++isa) {
+            if (!scope_cpu_supports(isa)) continue;
+
+            scope_light_level_t level;
+            scope_test_context("width %u, %s", width, scope_isa_name(isa));
+            scope_light_level_measure(&image, isa, &level);
+            CHECK(memcmp(&level, &expected, sizeof(level)) == 0);
+        }
+    }
+
+    free(halves);
+}
+
+// The axis the HDR scopes draw on, pinned where the graticule has its labels: PQ at 100 and 1000
+// nits, as a transfer and through the table of scRGB halves, and HLG reference white at 75% and
+// 203 nits. 10-bit codes are signals already and go through unchanged.
+void test_hdr_signal(void) {
+    static const uint32_t codes[] = {0, 520, 767, 1023};
+
+    scope_test_context("transfers");
+    CHECK(fabsf(scope_transfer_signal(SCOPE_TRANSFER_PQ, 100.0f) - 0.5080784f) < 1e-5f);
+    CHECK(fabsf(scope_transfer_signal(SCOPE_TRANSFER_PQ, 1000.0f) - 0.7518271f) < 1e-5f);
+    CHECK(scope_transfer_signal(SCOPE_TRANSFER_PQ, SCOPE_PQ_PEAK_NITS) == 1.0f);
+    CHECK(fabsf(scope_transfer_signal(SCOPE_TRANSFER_HLG, 203.0f) - 0.75f) < 1e-3f);
+    CHECK(fabsf(scope_transfer_nits(SCOPE_TRANSFER_HLG, 0.75f) - 203.0f) < 0.5f);
+
+    scope_signal_lut_t *lut = calloc(1, sizeof(scope_signal_lut_t));
+    if (!CHECK(lut)) return;
+
+    // scRGB 1.0 is 80 nits
+    scope_test_context("scRGB table");
+    if (CHECK(scope_signal_lut_update(lut, SCOPE_PIXEL_FORMAT_RGBA16F, SCOPE_TRANSFER_LINEAR))) {
+        CHECK(ABS((int32_t)scope_signal_half(lut, scope_float_to_half(1.25f)) - 33297) <= 1);
+        CHECK(ABS((int32_t)scope_signal_half(lut, scope_float_to_half(12.5f)) - 49271) <= 1);
+        CHECK(scope_signal_half(lut, scope_float_to_half(-1.0f)) == 0);
+        CHECK(scope_signal_half(lut, 0x7c00) == 65535);
+    }
+
+    for (uint32_t hlg = 0; hlg < 2; ++hlg) {
+        scope_test_context("10-bit %s table", hlg ? "HLG" : "PQ");
+        if (!CHECK(scope_signal_lut_update(lut, SCOPE_PIXEL_FORMAT_RGB10A2, hlg ? SCOPE_TRANSFER_HLG : SCOPE_TRANSFER_PQ))) continue;
+        for (size_t i = 0; i < ARRAY_LENGTH(codes); ++i) {
+            CHECK(lut->signal[codes[i]] == (uint16_t)lroundf((float)codes[i] / 1023.0f * 65535.0f));
+        }
+    }
+
+    free(lut);
+}
+
+// Mostly light up to a few thousand nits, with the patterns the clamps have to resolve in between
+static uint16_t random_half(uint32_t *state) {
+    static const uint16_t specials[] = {0x0000, 0x8000, 0x0001, 0x03ff, 0xbc00, 0x7bff, 0x7c00, 0xfc00, 0x7e00, 0x7c01, 0xfe00};
+
+    const uint32_t r = scope_test_random(state);
+    return r % 5 == 0 ? specials[(r >> 8) % ARRAY_LENGTH(specials)] : (uint16_t)((r >> 8) % 0x5800);
+}
+
+// Brightest of R, G and B with negative values and NaN as 0 and infinities as the largest half
+static float reference_level(const uint8_t *px) {
+    float level = 0.0f;
+    for (uint32_t c = 0; c < 3; ++c) {
+        const float v = scope_half_to_float((uint16_t)(px[2 * c] | (px[2 * c + 1] << 8)));
+        if (v > level) {
+            level = MIN(v, SCOPE_HALF_MAX);
+        }
+    }
+    return level;
+}
@@ -0,0 +1,91 @@
+#include "scope_test.h"
+
+#include "scope_incremental.h"
+#include "scope_synthetic.h"
+#include "scope_vectorscope.h"
+#include "scope_waveform.h"
+
+#include "../src/macros.h"
+
+// Script time of the first change after the scopes were reconfigured behind the incremental path
+#define RECONFIGURE_FRAME 7
+
+// Scripted dirty rects over several frames against rebuilding both scopes from every frame: a
+// cursor blinking on and off, windows overlapping each other and the edge of the frame, a frame
+// with no changes, a scroll over most of the frame that has to fall back to a rebuild, and new
+// scope settings the incremental path has to notice on its own
+void test_incremental_rects(void) {
+    enum { width = 97, height = 61 };
+    static const scope_synthetic_change_t script[] = {
+        {.frame = 0, .rect = {10, 10, 2, 12}, .seed = 1},
+        {.frame = 0, .rect = {30, 20, 20, 15}, .seed = 2},
+        {.frame = 1, .rect = {10, 10, 2, 12}, .seed = 0},
+        {.frame = 1, .rect = {40, 25, 20, 15}, .seed = 3},
+        {.frame = 1, .rect = {90, 50, 20, 20}, .seed = 4},
+        {.frame = 2, .rect = {0, 0, 30, 5}, .seed = 5},
+        {.frame = 2, .rect = {20, 0, 30, 8}, .seed = 6},
+        {.frame = 3, .rect = {0, 10, width, 40}, .seed = 7},
+        {.frame = 4, .rect = {50, 40, 10, 10}, .seed = 8},
+        {.frame = RECONFIGURE_FRAME - 1, .rect = {5, 45, 12, 9}, .seed = 9},
+        {.frame = RECONFIGURE_FRAME, .rect = {60, 5, 7, 30}, .seed = 10},
+    };
+    // Whether each frame rebuilds, the first one has nothing to start from
+    static const bool rebuilds[] = {true, false, false, false, true, false, false, false, true, false};
+
+    scope_vectorscope_t vs, vs_full;
+    scope_waveform_t wf, wf_full;
+    const bool created[] = {
+        scope_vectorscope_create(&vs), scope_vectorscope_create(&vs_full), scope_waveform_create(&wf), scope_waveform_create(&wf_full),
+    };
+    if (!CHECK(created[0] && created[1] && created[2] && created[3])) goto done;
+
+    for (uint32_t kernel = 0; kernel < 2; ++kernel) {
+        scope_config_t config = scope_config_preset(SCOPE_QUALITY_256);
+        if (!CHECK(scope_vectorscope_configure(&vs, &config) && scope_vectorscope_configure(&vs_full, &config) &&
+                   scope_waveform_configure(&wf, &config) && scope_waveform_configure(&wf_full, &config))) {
+            continue;
+        }
+        vs.kernel = vs_full.kernel = wf.kernel = wf_full.kernel = kernel ? SCOPE_KERNEL_LUT : SCOPE_KERNEL_FLOAT;
+
+        scope_synthetic_source_t source;
+        if (!CHECK(scope_synthetic_create(&source, width, height, SCOPE_PIXEL_FORMAT_BGRA8, script, ARRAY_LENGTH(script), 0))) continue;
+
+        scope_incremental_t inc;
+        scope_incremental_create(&inc, &vs, &wf);
+
+        for (uint32_t frame = 0; frame < ARRAY_LENGTH(rebuilds); ++frame) {
+            if (!CHECK(scope_synthetic_next(&source))) break;
+
+            if (frame == RECONFIGURE_FRAME + 1) {
+                // Zoomed in with another encoding and fewer buckets, without invalidating
+                config.vs_zoom = 2;
+                config.wf_buckets /= 2;
+                config.encoding = scope_encoding_from_index(scope_encoding_index(config.encoding) + 1);
+                if (!CHECK(scope_vectorscope_configure(&vs, &config) && scope_vectorscope_configure(&vs_full, &config) &&
+                           scope_waveform_configure(&wf, &config) && scope_waveform_configure(&wf_full, &config))) {
+                    break;
+                }
+            }
+
+            scope_test_context("kernel %u, frame %u", kernel, frame);
+            CHECK(scope_incremental_update(&inc, &source.image, source.dirty, source.dirty_count));
+            CHECK(inc.rebuilt == rebuilds[frame]);
+
+            scope_vectorscope_clear(&vs_full);
+            scope_vectorscope_accumulate(&vs_full, &source.image);
+            scope_waveform_clear(&wf_full);
+            scope_waveform_accumulate(&wf_full, &source.image);
+            CHECK_SAME_U32(vs.bins, vs_full.bins, (size_t)vs.resolution * vs.resolution);
+            CHECK_SAME_U32(wf.channels[0], wf_full.channels[0], (size_t)wf.width * wf.buckets * SCOPE_WF_CHANNEL_COUNT);
+        }
+
+        scope_incremental_destroy(&inc);
+        scope_synthetic_destroy(&source);
+    }
+
+done:
+    scope_waveform_destroy(&wf_full);
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs_full);
+    scope_vectorscope_destroy(&vs);
+}
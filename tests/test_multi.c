@@ -0,0 +1,106 @@
+#include "scope_test.h"
+
+#include "scope_multi.h"
+#include "scope_vectorscope.h"
+#include "scope_waveform.h"
+
+#include "../src/macros.h"
+
+#include <stdlib.h>
+
+#define MULTI_SOURCES 3
+
+// Sources of different sizes and lengths scoped together, with a serial pool and one thread per
+// view, against scoping every frame on its own. A view keeps the description of its last frame.
+void test_multi_views(void) {
+    static const uint32_t sizes[MULTI_SOURCES][2] = {{61, 7}, {33, 20}, {128, 3}};
+    static const uint32_t repeats[MULTI_SOURCES] = {1, 3, 2}; // of their 2 frames
+    static const uint32_t thread_counts[] = {1, MULTI_SOURCES};
+    const scope_config_t config = scope_config_preset(SCOPE_QUALITY_256);
+
+    scope_image_t frames[MULTI_SOURCES][2];
+    uint8_t *pixels[MULTI_SOURCES][2];
+    for (uint32_t s = 0; s < MULTI_SOURCES; ++s) {
+        for (uint32_t f = 0; f < 2; ++f) {
+            pixels[s][f] = scope_test_rgb8_frame(&frames[s][f], sizes[s][0], sizes[s][1], 8, SCOPE_PIXEL_FORMAT_BGRA8, 3 + s * 2 + f);
+        }
+    }
+
+    scope_vectorscope_t vs;
+    scope_waveform_t wf;
+    if (!CHECK(scope_vectorscope_create(&vs) && scope_waveform_create(&wf) &&
+               scope_vectorscope_configure(&vs, &config) && scope_waveform_configure(&wf, &config))) {
+        goto done;
+    }
+
+    for (size_t t = 0; t < ARRAY_LENGTH(thread_counts); ++t) {
+        scope_thread_pool_t *pool = NULL;
+        if (!CHECK(scope_thread_pool_create(thread_counts[t], &pool))) continue;
+
+        scope_source_t *sources[MULTI_SOURCES];
+        uint32_t created = 0;
+        while (created < MULTI_SOURCES && scope_source_memory_create(frames[created], 2, repeats[created], 60.0, &sources[created])) {
+            created++;
+        }
+        if (!CHECK(created == MULTI_SOURCES)) {
+            for (uint32_t s = 0; s < created; ++s) {
+                scope_source_destroy(sources[s]);
+            }
+            scope_thread_pool_destroy(pool);
+            continue;
+        }
+
+        scope_multi_t multi;
+        if (!CHECK(scope_multi_create(&multi, sources, created))) {
+            scope_thread_pool_destroy(pool);
+            continue;
+        }
+        CHECK(scope_multi_configure(&multi, &config));
+
+        uint32_t update = 0;
+        for (; !scope_multi_ended(&multi) && update < 8; ++update) {
+            uint32_t scoped = scope_multi_update(&multi, 0, pool);
+
+            uint32_t running = 0;
+            for (uint32_t s = 0; s < MULTI_SOURCES; ++s) {
+                const scope_multi_view_t *view = &multi.views[s];
+                const scope_image_t *expected = &frames[s][update % 2];
+                const bool ended = update >= 2 * repeats[s];
+                scope_test_context("%u threads, update %u, view %u", thread_counts[t], update, s);
+
+                // Ended views keep the scopes and the description of their last frame
+                CHECK(view->result == (ended ? SCOPE_ACQUIRE_END : SCOPE_ACQUIRE_OK));
+                CHECK(view->scoped == (ended ? 2 * repeats[s] : update + 1));
+                CHECK(view->frame.image.data == NULL && view->frame.dirty == NULL);
+                if (ended || !CHECK(!view->failed)) continue;
+
+                running++;
+                CHECK(view->frame.image.width == expected->width && view->frame.image.height == expected->height);
+                CHECK(view->frame.image.format == expected->format);
+                CHECK(view->frame.image.generation == update + 1);
+
+                scope_vectorscope_clear(&vs);
+                scope_waveform_clear(&wf);
+                scope_vectorscope_accumulate(&vs, expected);
+                scope_waveform_accumulate(&wf, expected);
+                CHECK_SAME_U32(view->vs.bins, vs.bins, (size_t)vs.resolution * vs.resolution);
+                CHECK_SAME_U32(view->wf.channels[0], wf.channels[0], (size_t)wf.width * wf.buckets * SCOPE_WF_CHANNEL_COUNT);
+            }
+            CHECK(scoped == running);
+        }
+        scope_test_context("%u threads", thread_counts[t]);
+        CHECK(scope_multi_ended(&multi) && update == 7);
+
+        scope_multi_destroy(&multi);
+        scope_thread_pool_destroy(pool);
+    }
+
+done:
+    scope_waveform_destroy(&wf);
+    scope_vectorscope_destroy(&vs);
+    for (uint32_t s = 0; s < MULTI_SOURCES; ++s) {
+        for (uint32_t f = 0; f < 2; ++f) {
+            free(pixels[s][f]);
+        }
+    }
+}
@@ -0,0 +1,335 @@
+#include "scope_test.h"
+
+#include "scope_persistence.h"
+#include "scope_vectorscope.h"
+#include "scope_waveform.h"
+
+#include "../src/macros.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TILE_SIZE 32 // SCOPE_VS_TILE_SIZE
+
+static bool tiles_cover_bins(const scope_vectorscope_t *vs);
+static void shader_step(uint32_t sum[2], uint32_t hits, uint32_t keep, bool add);
+static uint32_t shader_resolve(const uint32_t sum[2]);
+
+// A hit loses half its weight every half-life, decayed frame by frame or all at once, a frame
+// added every frame settles at H / (1 - k), and the trails of a single frame reach zero. The
+// sums always round down but never lose a whole hit.
+void test_persistence_decay(void) {
+    static const float half_lives[] = {1.0f, 2.5f, 8.0f, 30.0f};
+    static const uint32_t hits[] = {1000000, 12345, 7};
+
+    for (size_t h = 0; h < ARRAY_LENGTH(half_lives); ++h) {
+        const float half_life = half_lives[h];
+        scope_persistence_t stepped, at_once;
+        if (!CHECK(scope_persistence_create(&stepped, ARRAY_LENGTH(hits), half_life))) return;
+        if (!CHECK(scope_persistence_create(&at_once, ARRAY_LENGTH(hits), half_life))) {
+            scope_persistence_destroy(&stepped);
+            return;
+        }
+
+        uint32_t out_stepped[ARRAY_LENGTH(hits)], out_at_once[ARRAY_LENGTH(hits)];
+        for (uint32_t frames = 1; frames <= (uint32_t)(4.0f * half_life); ++frames) {
+            scope_test_context("half-life %g, %u frames", half_life, frames);
+            scope_persistence_clear(&stepped);
+            scope_persistence_clear(&at_once);
+            scope_persistence_add(&stepped, hits);
+            scope_persistence_add(&at_once, hits);
+            for (uint32_t f = 0; f < frames; ++f) {
+                scope_persistence_decay(&stepped, 1.0f);
+            }
+            scope_persistence_decay(&at_once, (float)frames);
+            scope_persistence_resolve(&stepped, out_stepped);
+            scope_persistence_resolve(&at_once, out_at_once);
+
+            for (size_t i = 0; i < ARRAY_LENGTH(hits); ++i) {
+                double expected = hits[i] * exp2(-(double)frames / half_life);
+                CHECK(fabs(out_stepped[i] - expected) <= 1.0);
+                CHECK(fabs(out_at_once[i] - expected) <= 1.0);
+            }
+        }
+
+        // The geometric series, long after the first frame stopped counting
+        scope_test_context("half-life %g, steady", half_life);
+        scope_persistence_clear(&stepped);
+        for (uint32_t f = 0; f < (uint32_t)(64.0f * half_life); ++f) {
+            scope_persistence_add(&stepped, hits);
+        }
+        scope_persistence_resolve(&stepped, out_stepped);
+        for (size_t i = 0; i < ARRAY_LENGTH(hits); ++i) {
+            double expected = hits[i] / (1.0 - exp2(-1.0 / half_life));
+            CHECK(fabs(out_stepped[i] - expected) <= 1.0);
+        }
+
+        // A million hits are 2^36 in fixed point, gone after 36 half-lives and a few frames
+        scope_test_context("half-life %g, fading out", half_life);
+        scope_persistence_clear(&stepped);
+        scope_persistence_add(&stepped, hits);
+        uint32_t frames = 0;
+        while (!stepped.empty && frames < (uint32_t)(38.0f * half_life) + 2) {
+            scope_persistence_decay(&stepped, 1.0f);
+            frames++;
+        }
+        CHECK(stepped.empty);
+        scope_persistence_resolve(&stepped, out_stepped);
+        CHECK(out_stepped[0] == 0 && out_stepped[1] == 0 && out_stepped[2] == 0);
+
+        scope_persistence_destroy(&at_once);
+        scope_persistence_destroy(&stepped);
+    }
+}
+
+// Persistence of a vectorscope only visits the tiles marked in the sums or the frame, and has to
+// match decaying every bin. A new zoom starts the sums over.
+void test_persistence_vectorscope(void) {
+    // Frames of a few pixels mark a few tiles, the large one most of them
+    static const uint32_t sizes[][2] = {{3, 1}, {17, 5}, {2, 1}, {64, 48}, {5, 3}};
+    scope_config_t config = scope_config_preset(SCOPE_QUALITY_256);
+
+    scope_vectorscope_t vs;
+    scope_persistence_t tiled, flat;
+    if (!CHECK(scope_vectorscope_create(&vs))) return;
+    const size_t count = (size_t)config.vs_resolution * config.vs_resolution;
+    uint32_t *histogram = malloc(count * sizeof(uint32_t));
+    uint32_t *expected = malloc(count * sizeof(uint32_t));
+    if (!CHECK(histogram && expected && scope_vectorscope_configure(&vs, &config) &&
+               scope_persistence_create(&tiled, 0, 3.0f))) {
+        free(histogram);
+        free(expected);
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+    if (!CHECK(scope_persistence_create(&flat, count, 3.0f))) {
+        scope_persistence_destroy(&tiled);
+        free(histogram);
+        free(expected);
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+
+    for (uint32_t step = 0; step < 3 * ARRAY_LENGTH(sizes); ++step) {
+        scope_test_context("step %u", step);
+        if (step % 3 == 2) {
+            // No new frame
+            scope_persistence_decay(&flat, 1.0f);
+            CHECK(scope_persistence_decay_vectorscope(&tiled, &vs, 1.0f));
+        } else {
+            const uint32_t *size = sizes[step / 3 % ARRAY_LENGTH(sizes)];
+            scope_image_t image;
+            uint8_t *pixels = scope_test_rgb8_frame(&image, size[0], size[1], 4, SCOPE_PIXEL_FORMAT_RGBA8, 101 + step);
+            scope_vectorscope_clear(&vs);
+            scope_vectorscope_accumulate(&vs, &image);
+            memcpy(histogram, vs.bins, count * sizeof(uint32_t));
+            free(pixels);
+
+            scope_persistence_add(&flat, histogram);
+            CHECK(scope_persistence_add_vectorscope(&tiled, &vs));
+        }
+
+        scope_persistence_resolve(&flat, expected);
+        CHECK_SAME_U32(vs.bins, expected, count);
+        CHECK(tiles_cover_bins(&vs));
+    }
+
+    // Once the trails are gone no tile is left marked
+    scope_test_context("fading out");
+    for (uint32_t frame = 0; frame < 200 && !tiled.empty; ++frame) {
+        CHECK(scope_persistence_decay_vectorscope(&tiled, &vs, 1.0f));
+    }
+    scope_rect_t bounds;
+    CHECK(tiled.empty);
+    CHECK(!scope_vectorscope_bounds(&vs, &bounds));
+
+    // Trails at one zoom are meaningless at another
+    scope_test_context("new zoom");
+    scope_image_t image;
+    uint8_t *pixels = scope_test_rgb8_frame(&image, 40, 20, 4, SCOPE_PIXEL_FORMAT_BGRA8, 7);
+    scope_vectorscope_accumulate(&vs, &image);
+    CHECK(scope_persistence_add_vectorscope(&tiled, &vs));
+    config.vs_zoom = 2;
+    if (CHECK(scope_vectorscope_configure(&vs, &config))) {
+        scope_vectorscope_accumulate(&vs, &image);
+        memcpy(histogram, vs.bins, count * sizeof(uint32_t));
+        CHECK(scope_persistence_add_vectorscope(&tiled, &vs));
+        CHECK_SAME_U32(vs.bins, histogram, count);
+    }
+    free(pixels);
+
+    scope_persistence_destroy(&flat);
+    scope_persistence_destroy(&tiled);
+    free(expected);
+    free(histogram);
+    scope_vectorscope_destroy(&vs);
+}
+
+// Every plane of a waveform decays like a flat histogram, and starts over for a new encoding
+void test_persistence_waveform(void) {
+    scope_config_t config = scope_config_preset(SCOPE_QUALITY_256);
+
+    scope_waveform_t wf;
+    scope_persistence_t persistence, flat;
+    if (!CHECK(scope_waveform_create(&wf))) return;
+    const size_t count = (size_t)config.wf_width * config.wf_buckets * SCOPE_WF_CHANNEL_COUNT;
+    uint32_t *histogram = malloc(count * sizeof(uint32_t));
+    uint32_t *expected = malloc(count * sizeof(uint32_t));
+    if (!CHECK(histogram && expected && scope_waveform_configure(&wf, &config) &&
+               scope_persistence_create(&persistence, 0, 2.0f))) {
+        free(histogram);
+        free(expected);
+        scope_waveform_destroy(&wf);
+        return;
+    }
+    if (!CHECK(scope_persistence_create(&flat, count, 2.0f))) {
+        scope_persistence_destroy(&persistence);
+        free(histogram);
+        free(expected);
+        scope_waveform_destroy(&wf);
+        return;
+    }
+
+    scope_image_t image;
+    for (uint32_t step = 0; step < 8; ++step) {
+        scope_test_context("step %u", step);
+        if (step % 3 == 2) {
+            scope_persistence_decay(&flat, 2.0f);
+            CHECK(scope_persistence_decay_waveform(&persistence, &wf, 2.0f));
+        } else {
+            uint8_t *pixels = scope_test_rgb8_frame(&image, 61 + step, 7, 8, SCOPE_PIXEL_FORMAT_BGRA8, 31 + step);
+            scope_waveform_clear(&wf);
+            scope_waveform_accumulate(&wf, &image);
+            memcpy(histogram, wf.channels[0], count * sizeof(uint32_t));
+            free(pixels);
+
+            scope_persistence_add(&flat, histogram);
+            CHECK(scope_persistence_add_waveform(&persistence, &wf));
+        }
+
+        scope_persistence_resolve(&flat, expected);
+        CHECK_SAME_U32(wf.channels[0], expected, count);
+    }
+
+    scope_test_context("new encoding");
+    config.encoding.matrix = SCOPE_MATRIX_BT2020;
+    uint8_t *pixels = scope_test_rgb8_frame(&image, 50, 9, 0, SCOPE_PIXEL_FORMAT_RGBA8, 3);
+    if (CHECK(scope_waveform_configure(&wf, &config))) {
+        scope_waveform_accumulate(&wf, &image);
+        memcpy(histogram, wf.channels[0], count * sizeof(uint32_t));
+        CHECK(scope_persistence_add_waveform(&persistence, &wf));
+        CHECK_SAME_U32(wf.channels[0], histogram, count);
+    }
+    free(pixels);
+
+    scope_persistence_destroy(&flat);
+    scope_persistence_destroy(&persistence);
+    free(expected);
+    free(histogram);
+    scope_waveform_destroy(&wf);
+}
+
+// The 32-bit arithmetic of scope_persistence.hlsli against the 64-bit sums, for sums of every
+// magnitude, new frames and decay-only frames
+void test_persistence_shader(void) {
+    static const float half_lives[] = {0.5f, 1.0f, 4.0f, 15.0f, 60.0f, 1000.0f};
+    enum { COUNT = 4096 };
+
+    scope_persistence_t persistence;
+    uint32_t *histogram = malloc(COUNT * sizeof(uint32_t));
+    uint32_t *resolved = malloc(COUNT * sizeof(uint32_t));
+    uint32_t (*sums)[2] = malloc(COUNT * sizeof(*sums));
+    if (!CHECK(histogram && resolved && sums && scope_persistence_create(&persistence, COUNT, 1.0f))) {
+        free(histogram);
+        free(resolved);
+        free(sums);
+        return;
+    }
+
+    uint32_t state = 77;
+    for (size_t h = 0; h < ARRAY_LENGTH(half_lives); ++h) {
+        for (uint32_t add = 0; add <= 1; ++add) {
+            scope_test_context("half-life %g, %s", half_lives[h], add ? "new frame" : "decay only");
+            persistence.half_life = half_lives[h];
+            persistence.empty = false;
+            for (size_t i = 0; i < COUNT; ++i) {
+                uint64_t s = (uint64_t)scope_test_random(&state) << 32 | scope_test_random(&state);
+                persistence.sums[i] = s >> (i % 63 + 1);
+                histogram[i] = scope_test_random(&state) >> (i % 32);
+                sums[i][0] = (uint32_t)(persistence.sums[i] >> 32);
+                sums[i][1] = (uint32_t)persistence.sums[i];
+            }
+
+            if (add) {
+                scope_persistence_add(&persistence, histogram);
+            } else {
+                scope_persistence_decay(&persistence, 1.0f);
+            }
+            scope_persistence_resolve(&persistence, resolved);
+
+            const uint32_t keep = (uint32_t)scope_persistence_keep(half_lives[h], 1.0f);
+            bool same = true;
+            for (size_t i = 0; i < COUNT && same; ++i) {
+                shader_step(sums[i], histogram[i], keep, add);
+                same = sums[i][0] == (uint32_t)(persistence.sums[i] >> 32) && sums[i][1] == (uint32_t)persistence.sums[i] &&
+                       shader_resolve(sums[i]) == resolved[i];
+            }
+            CHECK(same);
+        }
+    }
+
+    scope_persistence_destroy(&persistence);
+    free(sums);
+    free(resolved);
+    free(histogram);
+}
+
+static bool tiles_cover_bins(const scope_vectorscope_t *vs) {
+    for (uint32_t y = 0; y < vs->resolution; ++y) {
+        for (uint32_t x = 0; x < vs->resolution; ++x) {
+            if (vs->bins[y * vs->resolution + x] && !vs->tiles[y / TILE_SIZE * vs->tiles_per_row + x / TILE_SIZE]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// mul_wide of scope_persistence.hlsli, {high, low}
+static void shader_mul_wide(uint32_t a, uint32_t b, uint32_t out[2]) {
+    uint32_t ll = (a & 0xffff) * (b & 0xffff);
+    uint32_t lh = (a & 0xffff) * (b >> 16);
+    uint32_t hl = (a >> 16) * (b & 0xffff);
+    uint32_t hh = (a >> 16) * (b >> 16);
+    uint32_t mid = (ll >> 16) + (lh & 0xffff) + (hl & 0xffff);
+    out[0] = hh + (lh >> 16) + (hl >> 16) + (mid >> 16);
+    out[1] = (mid << 16) | (ll & 0xffff);
+}
+
+static void shader_add_wide(uint32_t a[2], uint32_t b_high, uint32_t b_low) {
+    uint32_t low = a[1] + b_low;
+    a[0] = a[0] + b_high + (low < a[1] ? 1 : 0);
+    a[1] = low;
+}
+
+// persistence_step
+static void shader_step(uint32_t sum[2], uint32_t hits, uint32_t keep, bool add) {
+    uint32_t s[2], low_product[2];
+    shader_mul_wide(sum[0], keep, s);
+    shader_mul_wide(sum[1], keep, low_product);
+    shader_add_wide(s, 0, low_product[0]);
+    if (add) {
+        shader_add_wide(s, hits >> (32 - SCOPE_PERSISTENCE_FRAC_BITS), hits << SCOPE_PERSISTENCE_FRAC_BITS);
+    }
+    sum[0] = s[0];
+    sum[1] = s[1];
+}
+
+// persistence_resolve
+static uint32_t shader_resolve(const uint32_t sum[2]) {
+    uint32_t s[2] = {sum[0], sum[1]};
+    shader_add_wide(s, 0, 1u << (SCOPE_PERSISTENCE_FRAC_BITS - 1));
+    if ((s[0] >> (32 - SCOPE_PERSISTENCE_FRAC_BITS)) != 0) return 0xffffffff;
+    return (s[0] << SCOPE_PERSISTENCE_FRAC_BITS) | (s[1] >> (32 - SCOPE_PERSISTENCE_FRAC_BITS));
+}
@@ -0,0 +1,167 @@
+#include "scope_test.h"
+
+#include "scope_pyramid.h"
+
+#include "../src/macros.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool build_level0(scope_pyramid_t *pyramid, const scope_image_t *image, scope_isa_t isa, uint32_t factor);
+static bool check_box_average(const scope_image_t *image, const scope_image_t *level, uint32_t factor);
+
+// Level 0 of every ISA against the scalar kernel, and the scalar kernel against the rounded
+// average of each box, for every factor up to the largest and output widths that leave every row
+// tail after the vectors. Rows past the last whole box are in the frame too.
+void test_pyramid_isa(void) {
+    enum { max_width = 35 };
+
+    for (uint32_t factor = 2; factor <= SCOPE_PYRAMID_MAX_FACTOR; ++factor) {
+        for (uint32_t out_width = 1; out_width <= max_width; out_width += factor % 2 ? 3 : 2) {
+            scope_image_t image;
+            uint8_t *pixels = scope_test_rgb8_frame(&image, out_width * factor, 2 * factor + factor / 2, 4 * (out_width % 3), SCOPE_PIXEL_FORMAT_BGRA8, factor * 64 + out_width);
+
+            scope_pyramid_t scalar, pyramid;
+            scope_pyramid_create(&scalar, out_width, image.height, 1);
+            scope_pyramid_create(&pyramid, out_width, image.height, 1);
+
+            scope_test_context("factor %u, width %u, scalar", factor, out_width);
+            if (CHECK(build_level0(&scalar, &image, SCOPE_ISA_SCALAR, factor))) {
+                const scope_image_t *expected = scope_pyramid_level(&scalar, 0);
+                CHECK(check_box_average(&image, expected, factor));
+
+                for (scope_isa_t isa = SCOPE_ISA_SSE41; isa < SCOPE_ISA_COUNT; ++isa) {
+                    if (!scope_cpu_supports(isa)) continue;
+
+                    scope_test_context("factor %u, width %u, %s", factor, out_width, scope_isa_name(isa));
+                    if (!CHECK(build_level0(&pyramid, &image, isa, factor))) continue;
+                    const scope_image_t *actual = scope_pyramid_level(&pyramid, 0);
+                    CHECK(memcmp(actual->data, expected->data, (size_t)expected->stride * expected->height) == 0);
+                }
+            }
+
+            scope_pyramid_destroy(&pyramid);
+            scope_pyramid_destroy(&scalar);
+            free(pixels);
+        }
+    }
+}
+
+// Frames more than 16 times the analysis size are boxed by 16 and leave a larger level 0, and a
+// frame narrower than the factor it would need is boxed by its own width
+void test_pyramid_clamp(void) {
+    static const struct {
+        uint32_t width, height;          // of the frame
+        uint32_t fit_width, fit_height;  // analysis size
+        uint32_t factor;
+    } cases[] = {
+        {40 * 17 + 5, 33, 2, 2, SCOPE_PYRAMID_MAX_FACTOR},
+        {16 * 9, 16 * 4, 9, 4, SCOPE_PYRAMID_MAX_FACTOR},
+        {16 * 9 + 1, 16 * 4, 9, 4, SCOPE_PYRAMID_MAX_FACTOR},
+        {3, 50, 1, 1, 3},
+        {30, 30, 30, 30, 1},
+    };
+
+    for (size_t i = 0; i < ARRAY_LENGTH(cases); ++i) {
+        scope_image_t image;
+        uint8_t *pixels = scope_test_rgb8_frame(&image, cases[i].width, cases[i].height, 0, SCOPE_PIXEL_FORMAT_RGBA8, 7 + (uint32_t)i);
+
+        scope_pyramid_t pyramid;
+        scope_pyramid_create(&pyramid, cases[i].fit_width, cases[i].fit_height, 2);
+
+        scope_test_context("%ux%u into %ux%u", cases[i].width, cases[i].height, cases[i].fit_width, cases[i].fit_height);
+        if (CHECK(scope_pyramid_update(&pyramid, &image, NULL))) {
+            const scope_image_t *level = scope_pyramid_level(&pyramid, 0);
+            CHECK(pyramid.factor == cases[i].factor);
+            CHECK(level->width == cases[i].width / cases[i].factor && level->height == cases[i].height / cases[i].factor);
+            CHECK(check_box_average(&image, level, pyramid.factor));
+        }
+
+        scope_pyramid_destroy(&pyramid);
+        free(pixels);
+    }
+}
+
+// Dirty rects mapped onto every level against the bounds of the level pixels whose boxes they
+// touch, found pixel by pixel: rects inside, on box edges, past the frame, in the dropped columns
+// and rows past the last whole box, and empty ones
+void test_pyramid_map_rect(void) {
+    // Boxed by 3 into 37x21, two columns and a row left over
+    enum { width = 3 * 37 + 2, height = 3 * 21 + 1, rect_count = 400 };
+
+    scope_image_t image;
+    uint8_t *pixels = scope_test_rgb8_frame(&image, width, height, 0, SCOPE_PIXEL_FORMAT_BGRA8, 3);
+
+    scope_pyramid_t pyramid;
+    scope_pyramid_create(&pyramid, 38, 22, 4);
+    if (!CHECK(scope_pyramid_update(&pyramid, &image, NULL) && pyramid.factor == 3 && pyramid.built_count == 4)) goto done;
+
+    uint32_t state = 5;
+    for (uint32_t i = 0; i < rect_count; ++i) {
+        const scope_rect_t rect = {
+            scope_test_random(&state) % (width + 8),
+            scope_test_random(&state) % (height + 8),
+            i % 10 == 0 ? 0 : scope_test_random(&state) % (width / 2),
+            i % 10 == 1 ? 0 : scope_test_random(&state) % (height / 2),
+        };
+
+        for (uint32_t l = 0; l <= pyramid.built_count; ++l) {
+            // Past the last level maps onto the last one
+            const scope_image_t *level = scope_pyramid_level(&pyramid, l);
+            const uint32_t scale = pyramid.factor << MIN(l, pyramid.built_count - 1);
+
+            uint32_t x_min = UINT32_MAX, y_min = UINT32_MAX, x_max = 0, y_max = 0;
+            for (uint32_t y = 0; y < level->height; ++y) {
+                for (uint32_t x = 0; x < level->width; ++x) {
+                    const bool touched = x * scale < rect.x + rect.width && rect.x < (x + 1) * scale &&
+                                         y * scale < rect.y + rect.height && rect.y < (y + 1) * scale;
+                    if (touched) {
+                        x_min = MIN(x_min, x);
+                        y_min = MIN(y_min, y);
+                        x_max = MAX(x_max, x + 1);
+                        y_max = MAX(y_max, y + 1);
+                    }
+                }
+            }
+
+            scope_rect_t mapped;
+            scope_test_context("rect %u,%u %ux%u, level %u", rect.x, rect.y, rect.width, rect.height, l);
+            if (x_min == UINT32_MAX) {
+                CHECK(!scope_pyramid_map_rect(&pyramid, l, &rect, &mapped));
+            } else if (CHECK(scope_pyramid_map_rect(&pyramid, l, &rect, &mapped))) {
+                CHECK(mapped.x == x_min && mapped.y == y_min && mapped.width == x_max - x_min && mapped.height == y_max - y_min);
+            }
+        }
+    }
+
+done:
+    scope_pyramid_destroy(&pyramid);
+    free(pixels);
+}
+
+// Level 0 of `image` filtered with the kernel of `isa` by the given factor, by fitting the width
+static bool build_level0(scope_pyramid_t *pyramid, const scope_image_t *image, scope_isa_t isa, uint32_t factor) {
+    pyramid->isa = isa;
+    pyramid->generation = 0;
+    return scope_pyramid_update(pyramid, image, NULL) && pyramid->factor == factor;
+}
+
+// Every level pixel is the average of its box, rounded half up
+static bool check_box_average(const scope_image_t *image, const scope_image_t *level, uint32_t factor) {
+    const uint32_t area = factor * factor;
+    for (uint32_t y = 0; y < level->height; ++y) {
+        for (uint32_t x = 0; x < level->width; ++x) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                uint32_t sum = 0;
+                for (uint32_t by = 0; by < factor; ++by) {
+                    const uint8_t *row = scope_image_row(image, y * factor + by) + (size_t)x * factor * 4;
+                    for (uint32_t bx = 0; bx < factor; ++bx) {
+                        sum += row[bx * 4 + c];
+                    }
+                }
+                if (scope_image_row(level, y)[x * 4 + c] != (sum + area / 2) / area) return false;
+            }
+        }
+    }
+    return true;
+}
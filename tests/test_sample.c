@@ -0,0 +1,74 @@
+#include "scope_test.h"
+
+#include "scope_sample.h"
+
+#include "../src/macros.h"
+
+// Stratified weights add up to exactly the pixel count, clipped edge cells included
+void test_sample_weights(void) {
+    static const uint32_t sizes[][2] = {{1920, 1080}, {1001, 997}, {37, 5}, {7, 3}};
+    static const uint32_t budgets[] = {1, 10, 1000, 65536, 400000};
+
+    for (size_t s = 0; s < ARRAY_LENGTH(sizes); ++s) {
+        for (size_t b = 0; b < ARRAY_LENGTH(budgets); ++b) {
+            const uint32_t width = sizes[s][0], height = sizes[s][1];
+            const scope_sampling_t sampling = {.budget = budgets[b], .pattern = SCOPE_SAMPLE_STRATIFIED, .frame_index = 3};
+            const scope_sample_plan_t plan = scope_sample_plan(&sampling, width, height);
+            scope_test_context("%ux%u, budget %u", width, height, budgets[b]);
+
+            CHECK(plan.count <= budgets[b] || plan.count == width * height);
+
+            uint64_t total = 0;
+            bool inside = true;
+            for (uint32_t i = 0; i < plan.count; ++i) {
+                uint32_t x, y;
+                total += scope_sample_position(&plan, i, &x, &y);
+                inside &= x / plan.cell_size == i % plan.cells_x && y / plan.cell_size == i / plan.cells_x && x < width && y < height;
+            }
+            CHECK(inside);
+            CHECK(total == (uint64_t)width * height);
+        }
+    }
+}
+
+static uint64_t reverse_bits(uint64_t v) {
+    uint64_t r = 0;
+    for (int bit = 0; bit < 64; ++bit, v >>= 1) {
+        r = (r << 1) | (v & 1);
+    }
+    return r;
+}
+
+// Halton indices of late frames pass 2^24 and, with large budgets, 2^32. Every digit has to count.
+void test_sample_halton(void) {
+    static const struct {
+        uint32_t width, height, budget;
+    } cases[] = {
+        {2048, 1080, 2000000},   // indices up to 32M, past float precision
+        {16384, 24576, 300000000} // sequence offsets past 2^32
+    };
+
+    for (size_t c = 0; c < ARRAY_LENGTH(cases); ++c) {
+        for (uint32_t frame = 0; frame < 32; frame += 7) {
+            const scope_sampling_t sampling = {.budget = cases[c].budget, .pattern = SCOPE_SAMPLE_HALTON, .frame_index = frame};
+            const scope_sample_plan_t plan = scope_sample_plan(&sampling, cases[c].width, cases[c].height);
+            scope_test_context("%ux%u, budget %u, frame %u", cases[c].width, cases[c].height, cases[c].budget, frame);
+
+            CHECK(plan.count == cases[c].budget);
+            CHECK(plan.sequence_offset == (uint64_t)(frame % 16) * cases[c].budget);
+
+            // Samples at the start and the end of the frame's run of the sequence. The widths are
+            // powers of two, so x is exactly the top bits of the reversed index.
+            bool exact = true;
+            for (uint32_t i = 0; i < 4096; ++i) {
+                const uint32_t index = i < 2048 ? i : plan.count - 4096 + i;
+                uint32_t x, y;
+                const uint32_t weight = scope_sample_position(&plan, index, &x, &y);
+
+                const uint64_t n = plan.sequence_offset + index + 1;
+                exact &= x == (uint32_t)((reverse_bits(n) >> 11) / (((uint64_t)1 << 53) / cases[c].width)) && y < cases[c].height && weight == plan.weight;
+            }
+            CHECK(exact);
+        }
+    }
+}
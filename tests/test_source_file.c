@@ -0,0 +1,230 @@
+#include "scope_test.h"
+
+#include "scope_source.h"
+
+#include "../src/macros.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Written to the working directory and removed again by every test
+#define TEST_FILE_PATH "scope-test-file.tmp"
+#define TEST_FILE_CAPACITY 4096
+
+enum { test_width = 5, test_height = 3 };
+
+typedef struct test_file {
+    uint8_t bytes[TEST_FILE_CAPACITY];
+    size_t size;
+} test_file_t;
+
+static void append(test_file_t *file, const void *bytes, size_t size);
+static void append_text(test_file_t *file, const char *text);
+static void append_frame(test_file_t *file, uint32_t frame, size_t size);
+static bool write_file(const test_file_t *file);
+static bool open_file(const test_file_t *file, const scope_file_desc_t *desc, scope_source_t **source);
+static uint8_t frame_byte(uint32_t frame, size_t i);
+static bool same_bytes(const uint8_t *actual, uint32_t frame, size_t offset, size_t size);
+
+// Y4M files with each chroma tag, frame markers with and without parameters and a truncated last
+// frame. The planes are handed out in place: luma, then Cb and Cr at the chroma plane size.
+void test_file_y4m(void) {
+    static const struct {
+        const char *tag; // "" leaves the default 4:2:0
+        scope_pixel_format_t format;
+        uint32_t chroma_width;
+        uint32_t chroma_height;
+        scope_color_range_t range;
+    } chromas[] = {
+        {"", SCOPE_PIXEL_FORMAT_YUV420P, 3, 2, SCOPE_COLOR_RANGE_LIMITED},
+        {" C420jpeg", SCOPE_PIXEL_FORMAT_YUV420P, 3, 2, SCOPE_COLOR_RANGE_LIMITED},
+        {" C420", SCOPE_PIXEL_FORMAT_YUV420P, 3, 2, SCOPE_COLOR_RANGE_FULL},
+        {" C422", SCOPE_PIXEL_FORMAT_YUV422P, 3, 3, SCOPE_COLOR_RANGE_LIMITED},
+        {" C444", SCOPE_PIXEL_FORMAT_YUV444P, 5, 3, SCOPE_COLOR_RANGE_FULL},
+    };
+    static const char *const markers[] = {"FRAME\n", "FRAME Ip XYSCSS=420JPEG\n", "FRAME\n"};
+    const scope_file_desc_t desc = {0};
+
+    for (size_t c = 0; c < ARRAY_LENGTH(chromas); ++c) {
+        const size_t luma_size = test_width * test_height;
+        const size_t chroma_size = (size_t)chromas[c].chroma_width * chromas[c].chroma_height;
+        const size_t frame_size = luma_size + 2 * chroma_size;
+
+        test_file_t file = {0};
+        char header[128];
+        snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F30:1 Ip A1:1%s%s\n", test_width, test_height, chromas[c].tag,
+                 chromas[c].range == SCOPE_COLOR_RANGE_FULL ? " XCOLORRANGE=FULL" : "");
+        append_text(&file, header);
+        for (uint32_t f = 0; f < ARRAY_LENGTH(markers); ++f) {
+            append_text(&file, markers[f]);
+            append_frame(&file, f, f + 1 < ARRAY_LENGTH(markers) ? frame_size : frame_size - 1);
+        }
+
+        scope_source_t *source = NULL;
+        scope_test_context("Y4M%s", chromas[c].tag);
+        if (!CHECK(open_file(&file, &desc, &source))) continue;
+
+        for (uint32_t f = 0; f + 1 < ARRAY_LENGTH(markers); ++f) {
+            scope_frame_t frame;
+            scope_test_context("Y4M%s, frame %u", chromas[c].tag, f);
+            if (!CHECK(scope_source_acquire(source, 0, &frame) == SCOPE_ACQUIRE_OK)) break;
+
+            const scope_image_t *image = &frame.image;
+            CHECK(image->width == test_width && image->height == test_height && image->stride == test_width);
+            CHECK(image->format == chromas[c].format && image->range == chromas[c].range);
+            CHECK(image->chroma_stride == chromas[c].chroma_width);
+            CHECK(image->generation == f + 1 && fabs(frame.timestamp - f / 30.0) < 1e-9);
+            CHECK(frame.dirty_count == 1 && frame.dirty[0].width == test_width && frame.dirty[0].height == test_height);
+            CHECK(same_bytes(image->data, f, 0, luma_size));
+            CHECK(same_bytes(image->chroma[0], f, luma_size, chroma_size));
+            CHECK(same_bytes(image->chroma[1], f, luma_size + chroma_size, chroma_size));
+            scope_source_release(source);
+        }
+
+        // The last frame is one byte short
+        scope_frame_t frame;
+        CHECK(scope_source_acquire(source, 0, &frame) == SCOPE_ACQUIRE_END);
+        CHECK(scope_source_acquire(source, 0, &frame) == SCOPE_ACQUIRE_END);
+        scope_source_destroy(source);
+    }
+
+    remove(TEST_FILE_PATH);
+}
+
+// Headers the source has to refuse, and a frame without its marker
+void test_file_malformed(void) {
+    static const char *const headers[] = {
+        "YUV4MPEG2 W5 H3 F30:1 C420",
+        "YUV4MPEG2 H3 F30:1 C420\n",
+        "YUV4MPEG2 W5 H0 C420\n",
+        "YUV4MPEG2 W5 H3 C411\n",
+        "YUV4MPEG2 W5 H3 Cmono\n",
+    };
+    const scope_file_desc_t desc = {0};
+
+    for (size_t h = 0; h < ARRAY_LENGTH(headers); ++h) {
+        // The unterminated header is all there is, a frame would end it
+        test_file_t file = {0};
+        append_text(&file, headers[h]);
+        if (strchr(headers[h], '\n')) {
+            append_text(&file, "FRAME\n");
+            append_frame(&file, 0, 45);
+        }
+
+        scope_source_t *source = NULL;
+        scope_test_context("header %zu", h);
+        CHECK(!open_file(&file, &desc, &source) && source == NULL);
+        scope_source_destroy(source);
+    }
+
+    // The second frame has lost its marker, the source stops there
+    test_file_t file = {0};
+    append_text(&file, "YUV4MPEG2 W5 H3 C444\nFRAME\n");
+    append_frame(&file, 0, 45);
+    append_text(&file, "FRAMS\n");
+    append_frame(&file, 1, 45);
+
+    scope_source_t *source = NULL;
+    scope_test_context("missing frame marker");
+    if (CHECK(open_file(&file, &desc, &source))) {
+        scope_frame_t frame;
+        if (CHECK(scope_source_acquire(source, 0, &frame) == SCOPE_ACQUIRE_OK)) {
+            scope_source_release(source);
+        }
+        CHECK(scope_source_acquire(source, 0, &frame) == SCOPE_ACQUIRE_ERROR);
+        CHECK(scope_source_acquire(source, 0, &frame) == SCOPE_ACQUIRE_END);
+        scope_source_destroy(source);
+    }
+
+    remove(TEST_FILE_PATH);
+}
+
+// Headerless frames of the size the description gives, the trailing partial frame ignored
+void test_file_raw(void) {
+    static const scope_pixel_format_t formats[] = {SCOPE_PIXEL_FORMAT_BGRA8, SCOPE_PIXEL_FORMAT_RGBA16F};
+
+    for (size_t i = 0; i < ARRAY_LENGTH(formats); ++i) {
+        const scope_file_desc_t desc = {
+            .width = test_width,
+            .height = test_height,
+            .format = formats[i],
+            .transfer = formats[i] == SCOPE_PIXEL_FORMAT_RGBA16F ? SCOPE_TRANSFER_PQ : SCOPE_TRANSFER_SDR,
+            .frame_rate = 50.0,
+        };
+        const size_t stride = test_width * scope_pixel_format_bytes(formats[i]);
+        const size_t frame_size = stride * test_height;
+
+        test_file_t file = {0};
+        append_frame(&file, 0, frame_size);
+        append_frame(&file, 1, frame_size);
+        append_frame(&file, 2, frame_size / 2);
+
+        scope_source_t *source = NULL;
+        scope_test_context("raw format %u", (uint32_t)formats[i]);
+        if (!CHECK(open_file(&file, &desc, &source))) continue;
+
+        for (uint32_t f = 0; f < 2; ++f) {
+            scope_frame_t frame;
+            scope_test_context("raw format %u, frame %u", (uint32_t)formats[i], f);
+            if (!CHECK(scope_source_acquire(source, 0, &frame) == SCOPE_ACQUIRE_OK)) break;
+
+            const scope_image_t *image = &frame.image;
+            CHECK(image->width == test_width && image->height == test_height && image->stride == stride);
+            CHECK(image->format == formats[i] && image->transfer == desc.transfer);
+            CHECK(image->generation == f + 1 && fabs(frame.timestamp - f / 50.0) < 1e-9);
+            CHECK(same_bytes(image->data, f, 0, frame_size));
+            scope_source_release(source);
+        }
+
+        scope_frame_t frame;
+        CHECK(scope_source_acquire(source, 0, &frame) == SCOPE_ACQUIRE_END);
+        scope_source_destroy(source);
+    }
+
+    remove(TEST_FILE_PATH);
+}
+
+static void append(test_file_t *file, const void *bytes, size_t size) {
+    if (!CHECK(file->size + size <= TEST_FILE_CAPACITY)) return;
+    memcpy(file->bytes + file->size, bytes, size);
+    file->size += size;
+}
+
+static void append_text(test_file_t *file, const char *text) {
+    append(file, text, strlen(text));
+}
+
+// `size` bytes of frame `frame`, the first `size` of frame_byte()
+static void append_frame(test_file_t *file, uint32_t frame, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        const uint8_t byte = frame_byte(frame, i);
+        append(file, &byte, 1);
+    }
+}
+
+static bool write_file(const test_file_t *file) {
+    FILE *out = fopen(TEST_FILE_PATH, "wb");
+    if (!out) return false;
+
+    bool written = fwrite(file->bytes, 1, file->size, out) == file->size;
+    return fclose(out) == 0 && written;
+}
+
+static bool open_file(const test_file_t *file, const scope_file_desc_t *desc, scope_source_t **source) {
+    *source = NULL;
+    if (!CHECK(write_file(file))) return false;
+    return scope_source_file_create(TEST_FILE_PATH, desc, source);
+}
+
+// Distinct in every frame and within a frame, with the same values at each frame offset
+static uint8_t frame_byte(uint32_t frame, size_t i) {
+    return (uint8_t)(frame * 101 + i * 7 + 1);
+}
+
+static bool same_bytes(const uint8_t *actual, uint32_t frame, size_t offset, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        if (actual[i] != frame_byte(frame, offset + i)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+#include "scope_test.h"
+
+#include "scope_tiles.h"
+
+#include "../src/macros.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool update_tiles(scope_tiles_t *tiles, scope_image_t *image, scope_thread_pool_t *pool);
+
+// Every ISA against the scalar kernel, hash for hash. Widths up to 140 end the last tile of a row
+// on every 8-byte word and within the vectors, the padding holds bytes that must not be hashed.
+void test_tiles_isa(void) {
+    static const uint32_t heights[] = {1, 3, SCOPE_TILE_SIZE + 5};
+
+    for (uint32_t width = 1; width <= 140; ++width) {
+        for (size_t h = 0; h < ARRAY_LENGTH(heights); ++h) {
+            if (heights[h] > 3 && width % 7 != 0) continue;
+
+            scope_image_t image;
+            uint8_t *pixels = scope_test_rgb8_frame(&image, width, heights[h], 4 * (width % 3) + 4, SCOPE_PIXEL_FORMAT_BGRA8, width * 3 + (uint32_t)h);
+
+            scope_tiles_t scalar, tiles;
+            scope_tiles_create(&scalar);
+            scope_tiles_create(&tiles);
+            scalar.isa = SCOPE_ISA_SCALAR;
+
+            scope_test_context("%ux%u, scalar", width, heights[h]);
+            if (CHECK(scope_tiles_update(&scalar, &image, NULL))) {
+                const size_t count = (size_t)scalar.columns * scalar.rows;
+                for (scope_isa_t isa = SCOPE_ISA_SSE41; isa < SCOPE_ISA_COUNT; ++isa) {
+                    if (!scope_cpu_supports(isa)) continue;
+
+                    scope_test_context("%ux%u, %s", width, heights[h], scope_isa_name(isa));
+                    tiles.isa = isa;
+                    scope_tiles_invalidate(&tiles);
+                    if (!CHECK(scope_tiles_update(&tiles, &image, NULL))) continue;
+                    CHECK(memcmp(tiles.hashes, scalar.hashes, count * sizeof(uint64_t)) == 0);
+                }
+            }
+
+            scope_tiles_destroy(&tiles);
+            scope_tiles_destroy(&scalar);
+            free(pixels);
+        }
+    }
+}
+
+// Changing one byte of one pixel marks exactly the tile holding it and reports it as the only
+// rect, clipped to the frame for the partial tiles on the right and bottom edge, and changing it
+// back marks the same tile again. Corners of every tile and a pixel inside, with each ISA, in one
+// band and in several.
+void test_tiles_change(void) {
+    enum { width = 2 * SCOPE_TILE_SIZE + 22, height = SCOPE_TILE_SIZE + 36 };
+    const uint32_t columns = (width + SCOPE_TILE_SIZE - 1) / SCOPE_TILE_SIZE;
+    const uint32_t rows = (height + SCOPE_TILE_SIZE - 1) / SCOPE_TILE_SIZE;
+
+    scope_image_t image;
+    uint8_t *pixels = scope_test_rgb8_frame(&image, width, height, 12, SCOPE_PIXEL_FORMAT_RGBA8, 19);
+    scope_thread_pool_t *pool = NULL;
+    if (!CHECK(scope_thread_pool_create(2, &pool))) goto done;
+
+    for (scope_isa_t isa = SCOPE_ISA_SCALAR; isa < SCOPE_ISA_COUNT; ++isa) {
+        if (!scope_cpu_supports(isa)) continue;
+
+        scope_tiles_t tiles;
+        scope_tiles_create(&tiles);
+        tiles.isa = isa;
+
+        // The first frame is all new, the same pixels again nothing
+        scope_test_context("%s, first frames", scope_isa_name(isa));
+        if (!CHECK(update_tiles(&tiles, &image, pool) && tiles.rect_count == 1 && tiles.changed_count == columns * rows)) {
+            scope_tiles_destroy(&tiles);
+            continue;
+        }
+        CHECK(tiles.rects[0].width == width && tiles.rects[0].height == height);
+        CHECK(update_tiles(&tiles, &image, NULL) && tiles.rect_count == 0 && tiles.changed_count == 0);
+
+        uint32_t state = 23;
+        for (uint32_t ty = 0; ty < rows; ++ty) {
+            for (uint32_t tx = 0; tx < columns; ++tx) {
+                const uint32_t x_begin = tx * SCOPE_TILE_SIZE, x_end = MIN(x_begin + SCOPE_TILE_SIZE, (uint32_t)width);
+                const uint32_t y_begin = ty * SCOPE_TILE_SIZE, y_end = MIN(y_begin + SCOPE_TILE_SIZE, (uint32_t)height);
+                const uint32_t positions[][2] = {
+                    {x_begin, y_begin},
+                    {x_end - 1, y_begin},
+                    {x_begin, y_end - 1},
+                    {x_end - 1, y_end - 1},
+                    {x_begin + scope_test_random(&state) % (x_end - x_begin), y_begin + scope_test_random(&state) % (y_end - y_begin)},
+                };
+
+                for (size_t p = 0; p < ARRAY_LENGTH(positions); ++p) {
+                    uint8_t *byte = pixels + (size_t)positions[p][1] * image.stride + positions[p][0] * 4 + p % 4;
+                    const uint8_t original = *byte;
+
+                    for (uint32_t pass = 0; pass < 2; ++pass) {
+                        scope_test_context("%s, pixel %u,%u %s", scope_isa_name(isa), positions[p][0], positions[p][1], pass ? "restored" : "changed");
+                        *byte = pass ? original : (uint8_t)(original ^ (1u << (p + pass) % 8));
+                        if (!CHECK(update_tiles(&tiles, &image, p % 2 ? pool : NULL))) continue;
+
+                        const scope_rect_t *rect = &tiles.rects[0];
+                        CHECK(tiles.changed_count == 1 && tiles.changed[ty * columns + tx]);
+                        CHECK(tiles.rect_count == 1 && rect->x == x_begin && rect->y == y_begin && rect->width == x_end - x_begin && rect->height == y_end - y_begin);
+                    }
+                }
+            }
+        }
+
+        scope_tiles_destroy(&tiles);
+    }
+
+done:
+    scope_thread_pool_destroy(pool);
+    free(pixels);
+}
+
+// Updates with the next generation, so the frame is always hashed
+static bool update_tiles(scope_tiles_t *tiles, scope_image_t *image, scope_thread_pool_t *pool) {
+    image->generation++;
+    return scope_tiles_update(tiles, image, pool);
+}
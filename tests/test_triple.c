@@ -0,0 +1,149 @@
+#include "scope_test.h"
+
+#include "scope_source.h"
+#include "scope_thread.h"
+#include "scope_triple.h"
+
+#include "../src/macros.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STRESS_FRAMES 20000
+#define STRESS_WORDS 64
+
+typedef struct stress {
+    scope_triple_t triple;
+    uint32_t slots[3][STRESS_WORDS];
+} stress_t;
+
+static void stress_producer(void *user_data);
+static bool distinct_slots(const scope_triple_t *triple);
+
+// Publishing and fetching on one thread, step by step
+void test_triple_buffer(void) {
+    scope_triple_t triple;
+    scope_triple_init(&triple);
+    CHECK(distinct_slots(&triple));
+
+    scope_test_context("nothing published");
+    CHECK(!scope_triple_fetch(&triple));
+    CHECK(triple.front == 2);
+
+    scope_test_context("one frame published");
+    uint32_t written = triple.back;
+    CHECK(!scope_triple_publish(&triple));
+    CHECK(distinct_slots(&triple));
+    CHECK(scope_triple_fetch(&triple));
+    CHECK(triple.front == written);
+    CHECK(!scope_triple_fetch(&triple));
+    CHECK(triple.front == written);
+
+    // The second publish overwrites the first before it is fetched, the newest one wins
+    scope_test_context("two frames published");
+    CHECK(!scope_triple_publish(&triple));
+    written = triple.back;
+    CHECK(scope_triple_publish(&triple));
+    CHECK(distinct_slots(&triple));
+    CHECK(scope_triple_fetch(&triple));
+    CHECK(triple.front == written);
+    CHECK(distinct_slots(&triple));
+}
+
+// A producer thread fills whole slots with its frame number as fast as it can. The consumer must
+// only ever see complete slots, and newer frames than the last one it fetched.
+void test_triple_threads(void) {
+    stress_t *stress = calloc(1, sizeof(stress_t));
+    if (!CHECK(stress != NULL)) return;
+    scope_triple_init(&stress->triple);
+
+    scope_thread_t *producer = NULL;
+    if (!CHECK(scope_thread_create(stress_producer, stress, &producer))) {
+        free(stress);
+        return;
+    }
+
+    uint32_t last = 0;
+    while (last < STRESS_FRAMES) {
+        if (!scope_triple_fetch(&stress->triple)) continue;
+
+        const uint32_t *slot = stress->slots[stress->triple.front];
+        scope_test_context("frame %u after %u", slot[0], last);
+        if (!CHECK(slot[0] > last)) break;
+        for (uint32_t i = 1; i < STRESS_WORDS; ++i) {
+            if (!CHECK(slot[i] == slot[0])) break;
+        }
+        last = slot[0];
+    }
+
+    scope_thread_join(producer);
+    free(stress);
+}
+
+// The async source over a memory source, whose frames it has to hand out tightly packed, in order,
+// and all of them accounted for as either scoped or dropped
+void test_async_source(void) {
+    enum { frame_count = 3, repeat_count = 40 };
+
+    scope_image_t frames[frame_count];
+    uint8_t *pixels[frame_count];
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        pixels[i] = scope_test_rgb8_frame(&frames[i], 37, 11, 4 * i, SCOPE_PIXEL_FORMAT_BGRA8, 41 + i);
+    }
+
+    scope_source_t *source = NULL;
+    if (CHECK(scope_source_memory_create(frames, frame_count, repeat_count, 60.0, &source)) &&
+        CHECK(scope_source_async_create(source, &source))) {
+        uint64_t generation = 0;
+        scope_frame_t frame;
+        scope_acquire_result_t result;
+        while ((result = scope_source_acquire(source, 1000, &frame)) == SCOPE_ACQUIRE_OK) {
+            const scope_image_t *expected = &frames[(frame.image.generation - 1) % frame_count];
+            scope_test_context("generation %llu after %llu", (unsigned long long)frame.image.generation, (unsigned long long)generation);
+
+            CHECK(frame.image.generation > generation);
+            CHECK(frame.image.width == expected->width && frame.image.height == expected->height);
+            CHECK(frame.image.stride == expected->width * 4);
+            for (uint32_t y = 0; y < expected->height; ++y) {
+                if (!CHECK(memcmp(frame.image.data + (size_t)y * frame.image.stride, expected->data + (size_t)y * expected->stride, expected->width * 4) == 0)) break;
+            }
+            CHECK(frame.dirty_count > 0);
+
+            generation = frame.image.generation;
+            scope_source_release(source);
+        }
+
+        scope_test_context("after the last frame");
+        CHECK(result == SCOPE_ACQUIRE_END);
+        CHECK(generation == frame_count * repeat_count);
+
+        scope_async_stats_t stats;
+        scope_source_async_stats(source, &stats);
+        CHECK(stats.captured == frame_count * repeat_count);
+        CHECK(stats.failed == 0);
+        CHECK(stats.scoped + stats.dropped == stats.captured);
+        CHECK(stats.latency_max >= stats.latency_mean && stats.latency_mean >= 0.0);
+    }
+
+    scope_source_destroy(source);
+    for (uint32_t i = 0; i < frame_count; ++i) {
+        free(pixels[i]);
+    }
+}
+
+static void stress_producer(void *user_data) {
+    stress_t *stress = user_data;
+    for (uint32_t frame = 1; frame <= STRESS_FRAMES; ++frame) {
+        uint32_t *slot = stress->slots[stress->triple.back];
+        for (uint32_t i = 0; i < STRESS_WORDS; ++i) {
+            slot[i] = frame;
+        }
+        scope_triple_publish(&stress->triple);
+    }
+}
+
+static bool distinct_slots(const scope_triple_t *triple) {
+    uint32_t middle = triple->middle & ~SCOPE_TRIPLE_FRESH;
+    return triple->back < 3 && middle < 3 && triple->front < 3 &&
+           triple->back != middle && middle != triple->front && triple->front != triple->back;
+}
@@ -0,0 +1,595 @@
+#include "scope_test.h"
+
+#include "scope_cpu.h"
+#include "scope_internal.h"
+#include "scope_vectorscope.h"
+
+#include "../src/macros.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// One update of a scope: the frame and its generation, whether the scope is cleared before, and
+// whether the update has to rebuild
+typedef struct update_step {
+    uint32_t frame;
+    uint32_t generation;
+    bool clear;
+    bool rebuilds;
+} update_step_t;
+
+// RGB_to_Cb_full / RGB_to_Cr_full of scope_encoding.hlsli, by SCOPE_MATRIX
+static const float shader_cb[SCOPE_MATRIX_COUNT][3] = {
+    {-0.1687f, -0.3313f, 0.5f},
+    {-0.1146f, -0.3854f, 0.5f},
+    {-0.1396f, -0.3604f, 0.5f},
+};
+static const float shader_cr[SCOPE_MATRIX_COUNT][3] = {
+    {0.5f, -0.4187f, -0.0813f},
+    {0.5f, -0.4542f, -0.0458f},
+    {0.5f, -0.4598f, -0.0402f},
+};
+
+static void shader_vs_accum(const scope_image_t *image, const scope_config_t *config, uint32_t *bins);
+static void check_against_shader(scope_vectorscope_t *vs, const scope_image_t *image, const scope_config_t *config, uint32_t *expected);
+static void accumulate_with_isa(scope_vectorscope_t *vs, const scope_image_t *image, scope_isa_t isa);
+static void check_zoom(const scope_image_t *image, scope_kernel_t kernel, scope_isa_t isa, const scope_config_t *config, scope_thread_pool_t *pool);
+static bool hit_bin(const scope_vectorscope_t *vs, uint32_t *x, uint32_t *y);
+static void store_sample(uint8_t *sample, scope_ycbcr_layout_t layout, uint32_t code);
+static bool sample_bin(scope_vectorscope_t *vs, scope_ycbcr_layout_t layout, uint32_t cb, uint32_t cr, uint32_t *x, uint32_t *y);
+
+// The float kernel against vs_accum.cs.hlsl, line for line, at every encoding
+void test_vectorscope_shader(void) {
+    static const scope_quality_t qualities[] = {SCOPE_QUALITY_256, SCOPE_QUALITY_1024};
+    static const uint32_t sizes[][2] = {{61, 37}, {1500, 9}};
+
+    scope_vectorscope_t vs;
+    if (!CHECK(scope_vectorscope_create(&vs))) return;
+    vs.kernel = SCOPE_KERNEL_FLOAT;
+    vs.isa = SCOPE_ISA_SCALAR;
+
+    uint32_t *expected = malloc((size_t)SCOPE_VS_RESOLUTION * SCOPE_VS_RESOLUTION * sizeof(uint32_t));
+    for (size_t s = 0; expected && s < ARRAY_LENGTH(sizes); ++s) {
+        for (uint32_t format = SCOPE_PIXEL_FORMAT_BGRA8; format <= SCOPE_PIXEL_FORMAT_RGBA8; ++format) {
+            scope_image_t image;
+            uint8_t *pixels = scope_test_rgb8_frame(&image, sizes[s][0], sizes[s][1], 12, (scope_pixel_format_t)format, 17 + (uint32_t)s);
+
+            for (size_t q = 0; q < ARRAY_LENGTH(qualities); ++q) {
+                for (uint32_t e = 0; e < SCOPE_ENCODING_COUNT; ++e) {
+                    scope_config_t config = scope_config_preset(qualities[q]);
+                    config.encoding = scope_encoding_from_index(e);
+                    scope_test_context("%ux%u format %u, %u bins, encoding %u", image.width, image.height, format, config.vs_resolution, e);
+                    check_against_shader(&vs, &image, &config, expected);
+                }
+            }
+            free(pixels);
+        }
+    }
+
+    CHECK(expected != NULL);
+    free(expected);
+    scope_vectorscope_destroy(&vs);
+}
+
+// Every ISA the CPU supports against the scalar kernel. Widths up to 67 leave every possible row
+// tail after the 4, 8 and 16 pixel vectors, and the padding holds pixels that must not be read.
+void test_vectorscope_isa(void) {
+    static const uint32_t zooms[] = {1, 4};
+    scope_config_t config = scope_config_preset(SCOPE_QUALITY_256);
+
+    scope_vectorscope_t vs, scalar;
+    if (!CHECK(scope_vectorscope_create(&vs))) return;
+    if (!CHECK(scope_vectorscope_create(&scalar))) {
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+    vs.kernel = SCOPE_KERNEL_FLOAT;
+    scalar.kernel = SCOPE_KERNEL_FLOAT;
+
+    for (uint32_t width = 1; width <= 67; ++width) {
+        scope_image_t image;
+        uint8_t *pixels = scope_test_rgb8_frame(&image, width, 3, 4 * (width % 5) + 4, width % 2 ? SCOPE_PIXEL_FORMAT_BGRA8 : SCOPE_PIXEL_FORMAT_RGBA8, width);
+
+        for (size_t z = 0; z < ARRAY_LENGTH(zooms); ++z) {
+            for (uint32_t e = 0; e < SCOPE_ENCODING_COUNT; ++e) {
+                config.vs_zoom = zooms[z];
+                config.encoding = scope_encoding_from_index(e);
+                if (!CHECK(scope_vectorscope_configure(&vs, &config) && scope_vectorscope_configure(&scalar, &config))) continue;
+
+                accumulate_with_isa(&scalar, &image, SCOPE_ISA_SCALAR);
+                for (scope_isa_t isa = SCOPE_ISA_SSE41; isa < SCOPE_ISA_COUNT; ++isa) {
+                    if (!scope_cpu_supports(isa)) continue;
+
+                    scope_test_context("%s, width %u, zoom %u, encoding %u", scope_isa_name(isa), width, config.vs_zoom, e);
+                    accumulate_with_isa(&vs, &image, isa);
+                    CHECK_SAME_U32(vs.bins, scalar.bins, (size_t)vs.resolution * vs.resolution);
+                }
+            }
+        }
+        free(pixels);
+    }
+
+    // A whole frame at the default size
+    config = scope_config_preset(SCOPE_QUALITY_DEFAULT);
+    if (CHECK(scope_vectorscope_configure(&vs, &config) && scope_vectorscope_configure(&scalar, &config))) {
+        scope_image_t image;
+        uint8_t *pixels = scope_test_rgb8_frame(&image, 1917, 131, 36, SCOPE_PIXEL_FORMAT_BGRA8, 5);
+
+        accumulate_with_isa(&scalar, &image, SCOPE_ISA_SCALAR);
+        for (scope_isa_t isa = SCOPE_ISA_SSE41; isa < SCOPE_ISA_COUNT; ++isa) {
+            if (!scope_cpu_supports(isa)) continue;
+
+            scope_test_context("%s, %ux%u", scope_isa_name(isa), image.width, image.height);
+            accumulate_with_isa(&vs, &image, isa);
+            CHECK_SAME_U32(vs.bins, scalar.bins, (size_t)vs.resolution * vs.resolution);
+        }
+        free(pixels);
+    }
+
+    scope_vectorscope_destroy(&scalar);
+    scope_vectorscope_destroy(&vs);
+}
+
+// A zoomed grid against a grid zoom times as fine cropped to its window, for the float kernel at
+// every ISA, the LUT kernel, HDR signals and the Y'CbCr code tables. The frames stay close to
+// neutral, except every 7th pixel, so both the window and the pixels dropped around it are hit.
+void test_vectorscope_zoom(void) {
+    enum { width = 517, height = 233 };
+    static const scope_quality_t qualities[] = {SCOPE_QUALITY_256, SCOPE_QUALITY_DEFAULT};
+    static const uint32_t zooms[] = {2, 4};
+    const uint32_t chroma_width = (width + 1) / 2, chroma_height = (height + 1) / 2;
+    uint32_t state = 99;
+
+    uint8_t *rgb8 = malloc((size_t)width * height * 4);
+    uint16_t *half = malloc((size_t)width * height * 8);
+    uint8_t *nv12 = malloc((size_t)width * height + (size_t)chroma_width * 2 * chroma_height);
+    uint16_t *yuv10 = malloc(((size_t)width * height + (size_t)chroma_width * chroma_height * 2) * 2);
+    scope_thread_pool_t *pool = NULL;
+    if (!CHECK(rgb8 && half && nv12 && yuv10 && scope_thread_pool_create(3, &pool))) goto done;
+
+    for (uint32_t i = 0; i < width * height; ++i) {
+        const int base = (int)(scope_test_random(&state) % 256);
+        const int spread = i % 7 == 0 ? 255 : 24;
+        for (uint32_t c = 0; c < 4; ++c) {
+            rgb8[i * 4 + c] = (uint8_t)CLAMP(base + (int)(scope_test_random(&state) % spread) - spread / 2, 0, 255);
+            half[i * 4 + c] = (uint16_t)(0x3000 + scope_test_random(&state) % 0x0e00); // 0.125 to 1.375
+        }
+        nv12[i] = (uint8_t)scope_test_random(&state);
+        yuv10[i] = (uint16_t)(scope_test_random(&state) % 1024);
+    }
+    for (uint32_t i = 0; i < chroma_width * chroma_height * 2; ++i) {
+        const uint32_t spread = i % 7 == 0 ? 255 : 41;
+        nv12[width * height + i] = (uint8_t)(128 - spread / 2 + scope_test_random(&state) % spread);
+        yuv10[width * height + i] = (uint16_t)(512 - 2 * spread + scope_test_random(&state) % (4 * spread + 1));
+    }
+
+    const scope_image_t images[] = {
+        {.data = rgb8, .width = width, .height = height, .stride = width * 4, .format = SCOPE_PIXEL_FORMAT_BGRA8},
+        {.data = (const uint8_t *)half, .width = width, .height = height, .stride = width * 8, .format = SCOPE_PIXEL_FORMAT_RGBA16F, .transfer = SCOPE_TRANSFER_PQ},
+        {
+            .data = nv12, .width = width, .height = height, .stride = width, .format = SCOPE_PIXEL_FORMAT_NV12,
+            .chroma = {nv12 + width * height}, .chroma_stride = chroma_width * 2, .range = SCOPE_COLOR_RANGE_LIMITED,
+        },
+        {
+            .data = (const uint8_t *)yuv10, .width = width, .height = height, .stride = width * 2, .format = SCOPE_PIXEL_FORMAT_YUV420P10,
+            .chroma = {(const uint8_t *)(yuv10 + width * height), (const uint8_t *)(yuv10 + width * height + chroma_width * chroma_height)},
+            .chroma_stride = chroma_width * 2, .range = SCOPE_COLOR_RANGE_FULL,
+        },
+    };
+
+    for (size_t q = 0; q < ARRAY_LENGTH(qualities); ++q) {
+        for (size_t z = 0; z < ARRAY_LENGTH(zooms); ++z) {
+            scope_config_t config = scope_config_preset(qualities[q]);
+            config.vs_zoom = zooms[z];
+
+            // The float kernel per ISA and the LUT kernel on 8-bit RGB, the other formats have one path each
+            for (scope_isa_t isa = SCOPE_ISA_SCALAR; isa < SCOPE_ISA_COUNT; ++isa) {
+                if (!scope_cpu_supports(isa)) continue;
+                scope_test_context("%u bins, zoom %u, float %s", config.vs_resolution, config.vs_zoom, scope_isa_name(isa));
+                check_zoom(&images[0], SCOPE_KERNEL_FLOAT, isa, &config, pool);
+            }
+            for (size_t i = 0; i < ARRAY_LENGTH(images); ++i) {
+                scope_test_context("%u bins, zoom %u, format %u", config.vs_resolution, config.vs_zoom, (uint32_t)images[i].format);
+                check_zoom(&images[i], SCOPE_KERNEL_LUT, scope_cpu_best_isa(), &config, pool);
+            }
+        }
+    }
+
+done:
+    scope_thread_pool_destroy(pool);
+    free(yuv10);
+    free(nv12);
+    free(half);
+    free(rgb8);
+}
+
+// The LUT kernel rounds its 16.16 tables where the float kernel rounds once, so a color that
+// falls next to a bin edge may land one bin over, never further. Every value of the gray and
+// primary ramps, one pixel at a time, at every encoding and zoomed. A color the kernels disagree
+// on at the edge of the window is hit by one of them in the outermost bins.
+void test_vectorscope_lut(void) {
+    static const scope_quality_t qualities[] = {SCOPE_QUALITY_256, SCOPE_QUALITY_DEFAULT, SCOPE_QUALITY_2048};
+    static const uint32_t zooms[] = {1, 4};
+    static const uint8_t ramps[][3] = {{1, 1, 1}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+    scope_vectorscope_t lut, reference;
+    if (!CHECK(scope_vectorscope_create(&lut))) return;
+    if (!CHECK(scope_vectorscope_create(&reference))) {
+        scope_vectorscope_destroy(&lut);
+        return;
+    }
+    lut.kernel = SCOPE_KERNEL_LUT;
+    reference.kernel = SCOPE_KERNEL_FLOAT;
+
+    for (size_t q = 0; q < ARRAY_LENGTH(qualities); ++q) {
+        for (size_t z = 0; z < ARRAY_LENGTH(zooms); ++z) {
+            for (uint32_t e = 0; e < SCOPE_ENCODING_COUNT; ++e) {
+                scope_config_t config = scope_config_preset(qualities[q]);
+                config.vs_zoom = zooms[z];
+                config.encoding = scope_encoding_from_index(e);
+                if (!CHECK(scope_vectorscope_configure(&lut, &config) && scope_vectorscope_configure(&reference, &config))) continue;
+
+                const uint32_t last = lut.resolution - 1;
+                for (size_t r = 0; r < ARRAY_LENGTH(ramps); ++r) {
+                    const bool bgra = r % 2 == 0;
+                    for (uint32_t v = 0; v < 256; ++v) {
+                        const uint8_t px[4] = {(uint8_t)(ramps[r][bgra ? 2 : 0] * v), (uint8_t)(ramps[r][1] * v), (uint8_t)(ramps[r][bgra ? 0 : 2] * v), 255};
+                        const scope_image_t image = {
+                            .data = px, .width = 1, .height = 1, .stride = 4, .format = bgra ? SCOPE_PIXEL_FORMAT_BGRA8 : SCOPE_PIXEL_FORMAT_RGBA8,
+                        };
+
+                        uint32_t lx, ly, rx, ry;
+                        scope_vectorscope_clear(&lut);
+                        scope_vectorscope_clear(&reference);
+                        scope_vectorscope_accumulate(&lut, &image);
+                        scope_vectorscope_accumulate(&reference, &image);
+                        const bool lut_hit = hit_bin(&lut, &lx, &ly);
+                        const bool reference_hit = hit_bin(&reference, &rx, &ry);
+
+                        scope_test_context("%u bins, zoom %u, encoding %u, ramp %zu, value %u", lut.resolution, config.vs_zoom, e, r, v);
+                        if (lut_hit && reference_hit) {
+                            CHECK(ABS((int)lx - (int)rx) <= 1 && ABS((int)ly - (int)ry) <= 1);
+                        } else if (lut_hit) {
+                            CHECK(lx == 0 || ly == 0 || lx == last || ly == last);
+                        } else if (reference_hit) {
+                            CHECK(rx == 0 || ry == 0 || rx == last || ry == last);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    scope_vectorscope_destroy(&reference);
+    scope_vectorscope_destroy(&lut);
+}
+
+// scope_vectorscope_update() skips a frame with the generation it was last built from, unless
+// that is 0, which always rebuilds. Clearing forgets the generation.
+void test_vectorscope_generation(void) {
+    static const update_step_t steps[] = {
+        {0, 5, false, true}, {1, 5, false, false}, {1, 6, false, true}, {1, 6, false, false},
+        {0, 0, false, true}, {0, 0, false, true}, {1, 0, false, true}, {1, 6, true, true},
+    };
+
+    scope_vectorscope_t vs, reference;
+    if (!CHECK(scope_vectorscope_create(&vs))) return;
+    if (!CHECK(scope_vectorscope_create(&reference))) {
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+
+    scope_image_t images[2];
+    uint8_t *pixels[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        pixels[i] = scope_test_rgb8_frame(&images[i], 45, 23, 4, SCOPE_PIXEL_FORMAT_BGRA8, 71 + i);
+    }
+
+    const size_t count = (size_t)vs.resolution * vs.resolution;
+    uint32_t holds = 0;
+    for (size_t s = 0; s < ARRAY_LENGTH(steps); ++s) {
+        scope_image_t image = images[steps[s].frame];
+        image.generation = steps[s].generation;
+        if (steps[s].clear) {
+            scope_vectorscope_clear(&vs);
+        }
+
+        scope_test_context("step %zu, frame %u, generation %u", s, steps[s].frame, steps[s].generation);
+        CHECK(scope_vectorscope_update(&vs, &image, NULL) == steps[s].rebuilds);
+        CHECK(vs.generation == steps[s].generation);
+        holds = steps[s].rebuilds ? steps[s].frame : holds;
+
+        scope_vectorscope_clear(&reference);
+        scope_vectorscope_accumulate(&reference, &images[holds]);
+        CHECK_SAME_U32(vs.bins, reference.bins, count);
+    }
+
+    free(pixels[1]);
+    free(pixels[0]);
+    scope_vectorscope_destroy(&reference);
+    scope_vectorscope_destroy(&vs);
+}
+
+// Each chroma sample of a subsampled frame stands for the pixels it covers: four inside, two on
+// the odd last row or column and one in the odd corner of 4:2:0, two or one in 4:2:2. Every
+// sample gets a Cb/Cr of its own whose bin comes from a 4:4:4 pixel of the same codes, and an odd
+// frame has to add up to exactly one hit per pixel, serially and split into row bands.
+void test_vectorscope_chroma_weights(void) {
+    static const scope_pixel_format_t formats[] = {
+        SCOPE_PIXEL_FORMAT_YUV420P, SCOPE_PIXEL_FORMAT_NV12, SCOPE_PIXEL_FORMAT_YUV422P, SCOPE_PIXEL_FORMAT_YUV420P10, SCOPE_PIXEL_FORMAT_P010,
+    };
+    static const uint32_t sizes[][2] = {{1, 1}, {7, 5}, {13, 3}, {4, 6}};
+    enum { max_samples = 7 * 5, max_bytes = 2 * (13 * 3 + 2 * max_samples) };
+
+    scope_vectorscope_t vs, reference;
+    if (!CHECK(scope_vectorscope_create(&vs))) return;
+    if (!CHECK(scope_vectorscope_create(&reference))) {
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+
+    const size_t count = (size_t)vs.resolution * vs.resolution;
+    uint32_t *expected = malloc(count * sizeof(uint32_t));
+    scope_thread_pool_t *pool = NULL;
+    if (!CHECK(expected && scope_thread_pool_create(3, &pool))) goto done;
+
+    for (size_t f = 0; f < ARRAY_LENGTH(formats); ++f) {
+        const scope_ycbcr_layout_t layout = scope_ycbcr_layout(formats[f]);
+        for (size_t s = 0; s < ARRAY_LENGTH(sizes); ++s) {
+            const uint32_t width = sizes[s][0], height = sizes[s][1];
+            const uint32_t chroma_width = (width + layout.x_shift) >> layout.x_shift;
+            const uint32_t chroma_height = (height + layout.y_shift) >> layout.y_shift;
+
+            uint8_t bytes[max_bytes] = {0};
+            scope_image_t image = {
+                .data = bytes, .width = width, .height = height, .stride = width * layout.sample_bytes, .format = formats[f],
+                .chroma_stride = chroma_width * layout.sample_bytes * (layout.interleaved ? 2 : 1), .range = SCOPE_COLOR_RANGE_LIMITED,
+            };
+            image.chroma[0] = bytes + (size_t)image.stride * height;
+            image.chroma[1] = layout.interleaved ? NULL : image.chroma[0] + (size_t)image.chroma_stride * chroma_height;
+
+            scope_test_context("format %u, %ux%u", (uint32_t)formats[f], width, height);
+            memset(expected, 0, count * sizeof(uint32_t));
+            for (uint32_t cy = 0; cy < chroma_height; ++cy) {
+                for (uint32_t cx = 0; cx < chroma_width; ++cx) {
+                    // Codes 10 and 9 apart land in bins of their own, all inside the plane
+                    const uint32_t k = cy * chroma_width + cx;
+                    const uint32_t cb = 24 + 10 * k, cr = 232 - 9 * k;
+                    const size_t offset = (size_t)cy * image.chroma_stride + (size_t)cx * layout.sample_bytes * (layout.interleaved ? 2 : 1);
+                    store_sample((uint8_t *)image.chroma[0] + offset, layout, cb);
+                    store_sample(layout.interleaved ? (uint8_t *)image.chroma[0] + offset + layout.sample_bytes : (uint8_t *)image.chroma[1] + offset, layout, cr);
+
+                    uint32_t bx, by;
+                    if (!CHECK(sample_bin(&reference, layout, cb, cr, &bx, &by))) continue;
+                    const uint32_t covered_x = MIN(1u << layout.x_shift, width - (cx << layout.x_shift));
+                    const uint32_t covered_y = MIN(1u << layout.y_shift, height - (cy << layout.y_shift));
+                    expected[(size_t)by * vs.resolution + bx] += covered_x * covered_y;
+                }
+            }
+
+            for (uint32_t parallel = 0; parallel < 2; ++parallel) {
+                scope_test_context("format %u, %ux%u, %s", (uint32_t)formats[f], width, height, parallel ? "3 bands" : "serial");
+                scope_vectorscope_clear(&vs);
+                if (parallel) {
+                    scope_vectorscope_update(&vs, &image, pool);
+                } else {
+                    scope_vectorscope_accumulate(&vs, &image);
+                }
+                CHECK_SAME_U32(vs.bins, expected, count);
+
+                uint64_t total = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    total += vs.bins[i];
+                }
+                CHECK(total == (uint64_t)width * height);
+            }
+        }
+    }
+
+done:
+    scope_thread_pool_destroy(pool);
+    free(expected);
+    scope_vectorscope_destroy(&reference);
+    scope_vectorscope_destroy(&vs);
+}
+
+// Private band histograms and the chunked tree merge against one serial pass, for band counts
+// that do not divide the height, odd NV12 frames whose chroma rows straddle two bands, and bins
+// the shared histogram already held before the parallel pass
+void test_vectorscope_parallel(void) {
+    static const uint32_t thread_counts[] = {1, 2, 3, 8};
+    static const uint32_t heights[] = {5, 37, 131};
+    enum { width = 203 };
+    const uint32_t chroma_width = (width + 1) / 2;
+
+    scope_vectorscope_t vs, serial;
+    if (!CHECK(scope_vectorscope_create(&vs))) return;
+    if (!CHECK(scope_vectorscope_create(&serial))) {
+        scope_vectorscope_destroy(&vs);
+        return;
+    }
+
+    const scope_config_t config = scope_config_preset(SCOPE_QUALITY_DEFAULT);
+    uint8_t *nv12 = malloc((size_t)width * heights[ARRAY_LENGTH(heights) - 1] * 2);
+    if (!CHECK(nv12 && scope_vectorscope_configure(&vs, &config) && scope_vectorscope_configure(&serial, &config))) goto done;
+
+    for (size_t h = 0; h < ARRAY_LENGTH(heights); ++h) {
+        const uint32_t height = heights[h];
+        const uint32_t chroma_height = (height + 1) / 2;
+        uint32_t state = height;
+        for (size_t i = 0; i < (size_t)width * height + (size_t)chroma_width * 2 * chroma_height; ++i) {
+            nv12[i] = (uint8_t)scope_test_random(&state);
+        }
+
+        scope_image_t images[2];
+        uint8_t *pixels = scope_test_rgb8_frame(&images[0], width, height, 8, SCOPE_PIXEL_FORMAT_BGRA8, height);
+        images[1] = (scope_image_t){
+            .data = nv12, .width = width, .height = height, .stride = width, .format = SCOPE_PIXEL_FORMAT_NV12,
+            .chroma = {nv12 + (size_t)width * height}, .chroma_stride = chroma_width * 2, .range = SCOPE_COLOR_RANGE_LIMITED,
+        };
+
+        for (uint32_t kernel = 0; kernel < 2; ++kernel) {
+            for (size_t i = 0; i < ARRAY_LENGTH(images); ++i) {
+                vs.kernel = serial.kernel = kernel ? SCOPE_KERNEL_LUT : SCOPE_KERNEL_FLOAT;
+                scope_vectorscope_clear(&serial);
+                scope_vectorscope_accumulate(&serial, &images[i]);
+                scope_vectorscope_accumulate(&serial, &images[i]);
+
+                for (size_t t = 0; t < ARRAY_LENGTH(thread_counts); ++t) {
+                    scope_thread_pool_t *pool = NULL;
+                    if (!CHECK(scope_thread_pool_create(thread_counts[t], &pool))) continue;
+
+                    scope_test_context("%ux%u format %u, kernel %u, %u threads", width, height, (uint32_t)images[i].format, kernel, thread_counts[t]);
+                    scope_vectorscope_clear(&vs);
+                    scope_vectorscope_accumulate(&vs, &images[i]);
+                    if (CHECK(scope_vectorscope_accumulate_parallel(&vs, &images[i], pool))) {
+                        CHECK_SAME_U32(vs.bins, serial.bins, (size_t)vs.resolution * vs.resolution);
+                        CHECK(memcmp(vs.tiles, serial.tiles, (size_t)vs.tiles_per_row * vs.tiles_per_row) == 0);
+                    }
+                    scope_thread_pool_destroy(pool);
+                }
+            }
+        }
+        free(pixels);
+    }
+
+done:
+    free(nv12);
+    scope_vectorscope_destroy(&serial);
+    scope_vectorscope_destroy(&vs);
+}
+
+static void shader_vs_accum(const scope_image_t *image, const scope_config_t *config, uint32_t *bins) {
+    const bool bgra = image->format == SCOPE_PIXEL_FORMAT_BGRA8;
+    const bool limited = config->encoding.range == SCOPE_COLOR_RANGE_LIMITED;
+
+    float cb_weights[3], cr_weights[3];
+    for (int c = 0; c < 3; ++c) {
+        // RGB_to_Cb_full * (224.0 / 255.0) for SCOPE_RANGE_LIMITED
+        cb_weights[c] = limited ? shader_cb[config->encoding.matrix][c] * (224.0f / 255.0f) : shader_cb[config->encoding.matrix][c];
+        cr_weights[c] = limited ? shader_cr[config->encoding.matrix][c] * (224.0f / 255.0f) : shader_cr[config->encoding.matrix][c];
+    }
+
+    const int size = (int)config->vs_resolution;
+    const float scale = (float)(config->vs_resolution * config->vs_zoom);
+    const int offset = (int)((config->vs_zoom - 1) * config->vs_resolution / 2);
+
+    memset(bins, 0, (size_t)size * size * sizeof(uint32_t));
+    for (uint32_t y = 0; y < image->height; ++y) {
+        for (uint32_t x = 0; x < image->width; ++x) {
+            const uint8_t *px = image->data + (size_t)y * image->stride + x * 4;
+            float r = px[bgra ? 2 : 0] / 255.0f;
+            float g = px[1] / 255.0f;
+            float b = px[bgra ? 0 : 2] / 255.0f;
+
+            float cb = r * cb_weights[0] + g * cb_weights[1] + b * cb_weights[2];
+            float cr = r * cr_weights[0] + g * cr_weights[1] + b * cr_weights[2];
+
+            int bx = (int)((cb + 0.5f) * scale) - offset;
+            int by = (int)((cr + 0.5f) * scale) - offset;
+            if (bx >= 0 && bx < size && by >= 0 && by < size) {
+                bins[by * size + bx]++;
+            }
+        }
+    }
+}
+
+static void check_against_shader(scope_vectorscope_t *vs, const scope_image_t *image, const scope_config_t *config, uint32_t *expected) {
+    if (!CHECK(scope_vectorscope_configure(vs, config))) return;
+
+    scope_vectorscope_clear(vs);
+    scope_vectorscope_accumulate(vs, image);
+    shader_vs_accum(image, config, expected);
+    CHECK_SAME_U32(vs->bins, expected, (size_t)vs->resolution * vs->resolution);
+}
+
+static void accumulate_with_isa(scope_vectorscope_t *vs, const scope_image_t *image, scope_isa_t isa) {
+    vs->isa = isa;
+    scope_vectorscope_clear(vs);
+    scope_vectorscope_accumulate(vs, image);
+}
+
+// Counts pixels in and out of the window, a window that holds all or none of them proves little
+static void check_zoom(const scope_image_t *image, scope_kernel_t kernel, scope_isa_t isa, const scope_config_t *config, scope_thread_pool_t *pool) {
+    scope_config_t fine_config = *config;
+    fine_config.vs_resolution = config->vs_resolution * config->vs_zoom;
+    fine_config.vs_zoom = 1;
+
+    scope_vectorscope_t zoomed, fine;
+    if (!CHECK(scope_vectorscope_create(&zoomed))) return;
+    if (!CHECK(scope_vectorscope_create(&fine))) {
+        scope_vectorscope_destroy(&zoomed);
+        return;
+    }
+    zoomed.kernel = fine.kernel = kernel;
+    zoomed.isa = fine.isa = isa;
+
+    if (CHECK(scope_vectorscope_configure(&zoomed, config) && scope_vectorscope_configure(&fine, &fine_config))) {
+        scope_vectorscope_update(&zoomed, image, pool);
+        scope_vectorscope_accumulate(&fine, image);
+
+        const uint32_t res = zoomed.resolution;
+        const uint32_t offset = (config->vs_zoom - 1) * res / 2;
+        uint64_t inside = 0;
+        bool tiled = true;
+        for (uint32_t y = 0; y < res; ++y) {
+            const uint32_t *row = zoomed.bins + (size_t)y * res;
+            if (!CHECK_SAME_U32(row, fine.bins + (size_t)(y + offset) * fine.resolution + offset, res)) break;
+            for (uint32_t x = 0; x < res; ++x) {
+                inside += row[x];
+                tiled = tiled && (!row[x] || zoomed.tiles[(y / SCOPE_VS_TILE_SIZE) * zoomed.tiles_per_row + x / SCOPE_VS_TILE_SIZE]);
+            }
+        }
+        CHECK(tiled);
+        CHECK(inside > 0 && inside < (uint64_t)image->width * image->height);
+    }
+
+    scope_vectorscope_destroy(&fine);
+    scope_vectorscope_destroy(&zoomed);
+}
+
+// The bin of the single pixel accumulated since the last clear, found through the marked tile
+static bool hit_bin(const scope_vectorscope_t *vs, uint32_t *x, uint32_t *y) {
+    const uint32_t res = vs->resolution;
+    for (uint32_t t = 0; t < vs->tiles_per_row * vs->tiles_per_row; ++t) {
+        if (!vs->tiles[t]) continue;
+
+        const uint32_t x_begin = (t % vs->tiles_per_row) * SCOPE_VS_TILE_SIZE, y_begin = (t / vs->tiles_per_row) * SCOPE_VS_TILE_SIZE;
+        for (uint32_t by = y_begin; by < MIN(y_begin + SCOPE_VS_TILE_SIZE, res); ++by) {
+            for (uint32_t bx = x_begin; bx < MIN(x_begin + SCOPE_VS_TILE_SIZE, res); ++bx) {
+                if (vs->bins[(size_t)by * res + bx]) {
+                    *x = bx;
+                    *y = by;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Stores 8-bit code `code` as a sample of the layout, scaled up to 10 bits for the 10-bit formats
+static void store_sample(uint8_t *sample, scope_ycbcr_layout_t layout, uint32_t code) {
+    const uint32_t value = (code << (layout.bits - 8)) << layout.sample_shift;
+    sample[0] = (uint8_t)value;
+    if (layout.sample_bytes == 2) {
+        sample[1] = (uint8_t)(value >> 8);
+    }
+}
+
+// Bin of one 4:4:4 pixel with the chroma codes at the bit depth of the layout
+static bool sample_bin(scope_vectorscope_t *vs, scope_ycbcr_layout_t layout, uint32_t cb, uint32_t cr, uint32_t *x, uint32_t *y) {
+    const scope_ycbcr_layout_t full = scope_ycbcr_layout(layout.bits == 8 ? SCOPE_PIXEL_FORMAT_YUV444P : SCOPE_PIXEL_FORMAT_YUV444P10);
+    uint8_t luma[2] = {0}, cb_sample[2] = {0}, cr_sample[2] = {0};
+    store_sample(cb_sample, full, cb);
+    store_sample(cr_sample, full, cr);
+
+    const scope_image_t image = {
+        .data = luma, .width = 1, .height = 1, .stride = full.sample_bytes,
+        .format = layout.bits == 8 ? SCOPE_PIXEL_FORMAT_YUV444P : SCOPE_PIXEL_FORMAT_YUV444P10,
+        .chroma = {cb_sample, cr_sample}, .chroma_stride = full.sample_bytes, .range = SCOPE_COLOR_RANGE_LIMITED,
+    };
+    scope_vectorscope_clear(vs);
+    scope_vectorscope_accumulate(vs, &image);
+    return hit_bin(vs, x, y);
+}
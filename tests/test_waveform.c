@@ -0,0 +1,299 @@
+#include "scope_test.h"
+
+#include "scope_waveform.h"
+
+#include "../src/macros.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// One update of a scope: the frame and its generation, whether the scope is cleared before, and
+// whether the update has to rebuild
+typedef struct update_step {
+    uint32_t frame;
+    uint32_t generation;
+    bool clear;
+    bool rebuilds;
+} update_step_t;
+
+// RGB_to_Y of scope_encoding.hlsli, by SCOPE_MATRIX
+static const float shader_luma[SCOPE_MATRIX_COUNT][3] = {
+    {0.299f, 0.587f, 0.114f},
+    {0.2126f, 0.7152f, 0.0722f},
+    {0.2627f, 0.678f, 0.0593f},
+};
+
+static void shader_wf_accum(const scope_image_t *image, const scope_config_t *config, uint32_t *planes);
+static void check_against_shader(scope_waveform_t *wf, const scope_image_t *image, const scope_config_t *config, uint32_t *expected);
+static void check_kernels(scope_waveform_t *wf, scope_waveform_t *reference, const scope_image_t *image, const scope_config_t *config);
+
+// The float kernel against wf_accum.cs.hlsl, line for line, at every encoding. The shader has
+// no luma plane, it is bucketed like the other channels.
+void test_waveform_shader(void) {
+    static const scope_quality_t qualities[] = {SCOPE_QUALITY_256, SCOPE_QUALITY_1024};
+    // Fewer, as many and more pixels per row than columns
+    static const uint32_t sizes[][2] = {{61, 37}, {1024, 5}, {1500, 9}};
+
+    scope_waveform_t wf;
+    if (!CHECK(scope_waveform_create(&wf))) return;
+    wf.kernel = SCOPE_KERNEL_FLOAT;
+
+    uint32_t *expected = malloc((size_t)SCOPE_WF_WIDTH * SCOPE_WF_BUCKETS * SCOPE_WF_CHANNEL_COUNT * sizeof(uint32_t));
+    for (size_t s = 0; expected && s < ARRAY_LENGTH(sizes); ++s) {
+        for (uint32_t format = SCOPE_PIXEL_FORMAT_BGRA8; format <= SCOPE_PIXEL_FORMAT_RGBA8; ++format) {
+            scope_image_t image;
+            uint8_t *pixels = scope_test_rgb8_frame(&image, sizes[s][0], sizes[s][1], 12, (scope_pixel_format_t)format, 29 + (uint32_t)s);
+
+            for (size_t q = 0; q < ARRAY_LENGTH(qualities); ++q) {
+                for (uint32_t e = 0; e < SCOPE_ENCODING_COUNT; ++e) {
+                    scope_config_t config = scope_config_preset(qualities[q]);
+                    config.encoding = scope_encoding_from_index(e);
+                    scope_test_context("%ux%u format %u, %ux%u buckets, encoding %u", image.width, image.height, format, config.wf_width, config.wf_buckets, e);
+                    check_against_shader(&wf, &image, &config, expected);
+                }
+            }
+            free(pixels);
+        }
+    }
+
+    CHECK(expected != NULL);
+    free(expected);
+    scope_waveform_destroy(&wf);
+}
+
+// The waveform has no kernels per ISA, only the float and LUT kernels. Their R, G and B buckets
+// are the same by construction, checked on the frames of the vectorscope ISA test. Luma sums
+// three 16.16 table entries, a color next to a bucket edge may land one bucket over; a slice
+// through the RGB cube at every bucket count has a few of those.
+void test_waveform_kernels(void) {
+    static const scope_quality_t qualities[] = {SCOPE_QUALITY_256, SCOPE_QUALITY_512, SCOPE_QUALITY_1024, SCOPE_QUALITY_2048};
+    scope_config_t config = scope_config_preset(SCOPE_QUALITY_256);
+
+    scope_waveform_t wf, reference;
+    if (!CHECK(scope_waveform_create(&wf))) return;
+    if (!CHECK(scope_waveform_create(&reference))) {
+        scope_waveform_destroy(&wf);
+        return;
+    }
+    wf.kernel = SCOPE_KERNEL_LUT;
+    reference.kernel = SCOPE_KERNEL_FLOAT;
+
+    for (uint32_t width = 1; width <= 67; ++width) {
+        scope_image_t image;
+        uint8_t *pixels = scope_test_rgb8_frame(&image, width, 3, 4 * (width % 5) + 4, width % 2 ? SCOPE_PIXEL_FORMAT_BGRA8 : SCOPE_PIXEL_FORMAT_RGBA8, width);
+
+        for (uint32_t e = 0; e < SCOPE_ENCODING_COUNT; ++e) {
+            config.encoding = scope_encoding_from_index(e);
+            scope_test_context("width %u, encoding %u", width, e);
+            check_kernels(&wf, &reference, &image, &config);
+        }
+        free(pixels);
+    }
+
+    uint8_t *slice = malloc(256 * 256 * 4);
+    for (uint32_t i = 0; slice && i < 256 * 256; ++i) {
+        slice[i * 4 + 0] = (uint8_t)i;
+        slice[i * 4 + 1] = (uint8_t)(i >> 8);
+        slice[i * 4 + 2] = (uint8_t)(i * 7 + (i >> 8) * 13);
+        slice[i * 4 + 3] = 255;
+    }
+    const scope_image_t image = {.data = slice, .width = 256, .height = 256, .stride = 256 * 4, .format = SCOPE_PIXEL_FORMAT_RGBA8};
+    for (size_t q = 0; slice && q < ARRAY_LENGTH(qualities); ++q) {
+        for (uint32_t e = 0; e < SCOPE_ENCODING_COUNT; ++e) {
+            config = scope_config_preset(qualities[q]);
+            config.encoding = scope_encoding_from_index(e);
+            scope_test_context("RGB slice, %ux%u buckets, encoding %u", config.wf_width, config.wf_buckets, e);
+            check_kernels(&wf, &reference, &image, &config);
+        }
+    }
+
+    CHECK(slice != NULL);
+    free(slice);
+    scope_waveform_destroy(&reference);
+    scope_waveform_destroy(&wf);
+}
+
+// scope_waveform_update() skips a frame with the generation it was last built from, unless
+// that is 0, which always rebuilds. Clearing forgets the generation.
+void test_waveform_generation(void) {
+    static const update_step_t steps[] = {
+        {0, 5, false, true}, {1, 5, false, false}, {1, 6, false, true}, {1, 6, false, false},
+        {0, 0, false, true}, {0, 0, false, true}, {1, 0, false, true}, {1, 6, true, true},
+    };
+
+    scope_waveform_t wf, reference;
+    if (!CHECK(scope_waveform_create(&wf))) return;
+    if (!CHECK(scope_waveform_create(&reference))) {
+        scope_waveform_destroy(&wf);
+        return;
+    }
+
+    scope_image_t images[2];
+    uint8_t *pixels[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        pixels[i] = scope_test_rgb8_frame(&images[i], 45, 23, 4, SCOPE_PIXEL_FORMAT_BGRA8, 71 + i);
+    }
+
+    const size_t count = (size_t)wf.width * wf.buckets * SCOPE_WF_CHANNEL_COUNT;
+    uint32_t holds = 0;
+    for (size_t s = 0; s < ARRAY_LENGTH(steps); ++s) {
+        scope_image_t image = images[steps[s].frame];
+        image.generation = steps[s].generation;
+        if (steps[s].clear) {
+            scope_waveform_clear(&wf);
+        }
+
+        scope_test_context("step %zu, frame %u, generation %u", s, steps[s].frame, steps[s].generation);
+        CHECK(scope_waveform_update(&wf, &image, NULL) == steps[s].rebuilds);
+        CHECK(wf.generation == steps[s].generation);
+        holds = steps[s].rebuilds ? steps[s].frame : holds;
+
+        scope_waveform_clear(&reference);
+        scope_waveform_accumulate(&reference, &images[holds]);
+        CHECK_SAME_U32(wf.channels[0], reference.channels[0], count);
+    }
+
+    free(pixels[1]);
+    free(pixels[0]);
+    scope_waveform_destroy(&reference);
+    scope_waveform_destroy(&wf);
+}
+
+// Column stripes against one serial pass for output widths that are not a multiple of the 16
+// column stripe alignment, including fewer stripes than threads, from frames narrower and wider
+// than the output. The planes already hold one frame, the stripes have to add to it.
+void test_waveform_parallel(void) {
+    static const uint32_t thread_counts[] = {1, 2, 3, 8};
+    static const uint32_t wf_widths[] = {1, 17, 250, 1000};
+    static const uint32_t sizes[][2] = {{61, 7}, {517, 13}};
+
+    scope_waveform_t wf, serial;
+    if (!CHECK(scope_waveform_create(&wf))) return;
+    if (!CHECK(scope_waveform_create(&serial))) {
+        scope_waveform_destroy(&wf);
+        return;
+    }
+
+    for (size_t s = 0; s < ARRAY_LENGTH(sizes); ++s) {
+        scope_image_t image;
+        uint8_t *pixels = scope_test_rgb8_frame(&image, sizes[s][0], sizes[s][1], 4, SCOPE_PIXEL_FORMAT_BGRA8, 41 + (uint32_t)s);
+
+        for (size_t w = 0; w < ARRAY_LENGTH(wf_widths); ++w) {
+            for (uint32_t kernel = 0; kernel < 2; ++kernel) {
+                scope_config_t config = scope_config_preset(SCOPE_QUALITY_256);
+                config.wf_width = wf_widths[w];
+                if (!CHECK(scope_waveform_configure(&wf, &config) && scope_waveform_configure(&serial, &config))) continue;
+
+                wf.kernel = serial.kernel = kernel ? SCOPE_KERNEL_LUT : SCOPE_KERNEL_FLOAT;
+                scope_waveform_clear(&serial);
+                scope_waveform_accumulate(&serial, &image);
+                scope_waveform_accumulate(&serial, &image);
+
+                for (size_t t = 0; t < ARRAY_LENGTH(thread_counts); ++t) {
+                    scope_thread_pool_t *pool = NULL;
+                    if (!CHECK(scope_thread_pool_create(thread_counts[t], &pool))) continue;
+
+                    scope_test_context("%ux%u into %u columns, kernel %u, %u threads", image.width, image.height, config.wf_width, kernel, thread_counts[t]);
+                    scope_waveform_clear(&wf);
+                    scope_waveform_accumulate(&wf, &image);
+                    scope_waveform_accumulate_parallel(&wf, &image, pool);
+                    CHECK_SAME_U32(wf.channels[0], serial.channels[0], (size_t)wf.width * wf.buckets * SCOPE_WF_CHANNEL_COUNT);
+                    scope_thread_pool_destroy(pool);
+                }
+            }
+        }
+        free(pixels);
+    }
+
+    scope_waveform_destroy(&serial);
+    scope_waveform_destroy(&wf);
+}
+
+static uint32_t shader_bucket(float v, uint32_t buckets) {
+    uint32_t bucket = (uint32_t)(v * (float)buckets);
+    return MIN(bucket, buckets - 1);
+}
+
+static float shader_levels(float v, bool limited) {
+    // SCOPE_LEVELS
+    return limited ? v * (219.0f / 255.0f) + 16.0f / 255.0f : v;
+}
+
+static void shader_wf_accum(const scope_image_t *image, const scope_config_t *config, uint32_t *planes) {
+    const bool bgra = image->format == SCOPE_PIXEL_FORMAT_BGRA8;
+    const bool limited = config->encoding.range == SCOPE_COLOR_RANGE_LIMITED;
+    const float *y_weights = shader_luma[config->encoding.matrix];
+    const uint32_t width = config->wf_width;
+    const uint32_t buckets = config->wf_buckets;
+    const size_t plane_size = (size_t)width * buckets;
+
+    memset(planes, 0, plane_size * SCOPE_WF_CHANNEL_COUNT * sizeof(uint32_t));
+    for (uint32_t y = 0; y < image->height; ++y) {
+        for (uint32_t x = 0; x < image->width; ++x) {
+            const uint8_t *px = image->data + (size_t)y * image->stride + x * 4;
+            // 8-bit pixels are already in 0-1, saturate() changes nothing
+            float pixel[3] = {px[bgra ? 2 : 0] / 255.0f, px[1] / 255.0f, px[bgra ? 0 : 2] / 255.0f};
+
+            float luma = shader_levels(pixel[0] * y_weights[0] + pixel[1] * y_weights[1] + pixel[2] * y_weights[2], limited);
+            uint32_t bucket[SCOPE_WF_CHANNEL_COUNT] = {
+                shader_bucket(shader_levels(pixel[0], limited), buckets),
+                shader_bucket(shader_levels(pixel[1], limited), buckets),
+                shader_bucket(shader_levels(pixel[2], limited), buckets),
+                shader_bucket(luma, buckets),
+            };
+
+            float x_scale = (float)width / (float)image->width;
+            float out_x_start = (float)x * x_scale;
+            float out_x_end = (float)(x + 1) * x_scale;
+            for (uint32_t col = (uint32_t)floorf(out_x_start); col < (uint32_t)ceilf(out_x_end); ++col) {
+                if (col < width) {
+                    for (uint32_t c = 0; c < SCOPE_WF_CHANNEL_COUNT; ++c) {
+                        planes[c * plane_size + bucket[c] * width + col]++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void check_against_shader(scope_waveform_t *wf, const scope_image_t *image, const scope_config_t *config, uint32_t *expected) {
+    if (!CHECK(scope_waveform_configure(wf, config))) return;
+
+    scope_waveform_clear(wf);
+    scope_waveform_accumulate(wf, image);
+    shader_wf_accum(image, config, expected);
+
+    const size_t plane_size = (size_t)wf->width * wf->buckets;
+    for (uint32_t c = 0; c < SCOPE_WF_CHANNEL_COUNT; ++c) {
+        CHECK_SAME_U32(wf->channels[c], expected + c * plane_size, plane_size);
+    }
+}
+
+// R, G and B bucket for bucket. Luma column by column through running sums: if no hit moved more
+// than one bucket, the first k buckets of the LUT hold at least the float kernel's first k - 1
+// and at most its first k + 1.
+static void check_kernels(scope_waveform_t *wf, scope_waveform_t *reference, const scope_image_t *image, const scope_config_t *config) {
+    if (!CHECK(scope_waveform_configure(wf, config) && scope_waveform_configure(reference, config))) return;
+
+    scope_waveform_clear(wf);
+    scope_waveform_clear(reference);
+    scope_waveform_accumulate(wf, image);
+    scope_waveform_accumulate(reference, image);
+    CHECK_SAME_U32(wf->channels[0], reference->channels[0], (size_t)wf->width * wf->buckets * SCOPE_WF_CHANNEL_LUMA);
+
+    const uint32_t *actual = wf->channels[SCOPE_WF_CHANNEL_LUMA];
+    const uint32_t *expected = reference->channels[SCOPE_WF_CHANNEL_LUMA];
+    for (uint32_t col = 0; col < wf->width; ++col) {
+        uint64_t sum = 0, below = 0, at = 0, above = expected[col];
+        bool close = true;
+        for (uint32_t k = 0; k < wf->buckets; ++k) {
+            sum += actual[(size_t)k * wf->width + col];
+            at += expected[(size_t)k * wf->width + col];
+            above += k + 1 < wf->buckets ? expected[(size_t)(k + 1) * wf->width + col] : 0;
+            close = close && sum >= below && sum <= above;
+            below = at;
+        }
+        if (!CHECK(close && sum == at)) break;
+    }
+}
@@ -0,0 +1,98 @@
+#include "scope_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if SCOPE_ENABLE_X11
+#include "scope_source_x11.h"
+
+#include <X11/Xlib.h>
+
+static void check_filled(const scope_frame_t *frame, const scope_rect_t *rect);
+static void check_dirty(const scope_frame_t *frame, const scope_rect_t *rect);
+#endif
+
+// The X11 source against the screen of $DISPLAY, e.g. Xvfb. Fills a rect of the root window that
+// straddles the captured area and checks that the next frame holds it and reports it dirty.
+// Without a display, or without the x11 option, there is nothing to check.
+void test_x11_source(void) {
+#if SCOPE_ENABLE_X11
+    if (!getenv("DISPLAY")) {
+        printf("x11_source: skipped, no $DISPLAY\n");
+        return;
+    }
+
+    Display *display = XOpenDisplay(NULL);
+    if (!CHECK(display != NULL)) return;
+
+    const scope_x11_desc_t desc = {.area = {16, 8, 48, 32}};
+    scope_source_t *source = NULL;
+    if (!CHECK(scope_source_x11_create(&desc, &source))) {
+        XCloseDisplay(display);
+        return;
+    }
+
+    // The first frame is all dirty
+    scope_frame_t frame;
+    scope_test_context("first frame");
+    if (CHECK(scope_source_acquire(source, 0, &frame) == SCOPE_ACQUIRE_OK)) {
+        CHECK(frame.image.width == desc.area.width && frame.image.height == desc.area.height);
+        CHECK(frame.image.stride >= frame.image.width * 4);
+        CHECK(frame.image.format == SCOPE_PIXEL_FORMAT_BGRA8 || frame.image.format == SCOPE_PIXEL_FORMAT_RGBA8);
+        CHECK(frame.image.generation == 1);
+        CHECK(frame.dirty_count == 1);
+        check_dirty(&frame, &(scope_rect_t){0, 0, desc.area.width, desc.area.height});
+        scope_source_release(source);
+    }
+
+    // Pure red, over any windows on the root too, 8 pixels of it left of the area
+    int screen = DefaultScreen(display);
+    Window root = RootWindow(display, screen);
+    XGCValues values = {
+        .foreground = DefaultVisual(display, screen)->red_mask,
+        .subwindow_mode = IncludeInferiors,
+    };
+    GC gc = XCreateGC(display, root, GCForeground | GCSubwindowMode, &values);
+    XFillRectangle(display, root, gc, 8, 12, 20, 8);
+    XSync(display, False);
+
+    scope_test_context("after filling a rect");
+    if (CHECK(scope_source_acquire(source, 1000, &frame) == SCOPE_ACQUIRE_OK)) {
+        const scope_rect_t filled = {0, 4, 12, 8}; // in pixels of the area
+        CHECK(frame.image.generation == 2);
+        check_filled(&frame, &filled);
+        check_dirty(&frame, &filled);
+        scope_source_release(source);
+    }
+
+    XFreeGC(display, gc);
+    XCloseDisplay(display);
+    scope_source_destroy(source);
+#endif
+}
+
+#if SCOPE_ENABLE_X11
+static void check_filled(const scope_frame_t *frame, const scope_rect_t *rect) {
+    const bool bgra = frame->image.format == SCOPE_PIXEL_FORMAT_BGRA8;
+    for (uint32_t y = rect->y; y < rect->y + rect->height; ++y) {
+        for (uint32_t x = rect->x; x < rect->x + rect->width; ++x) {
+            const uint8_t *px = frame->image.data + (size_t)y * frame->image.stride + x * 4;
+            if (!CHECK(px[bgra ? 2 : 0] == 255 && px[1] == 0 && px[bgra ? 0 : 2] == 0)) return;
+        }
+    }
+}
+
+// The dirty rects may cover more than what changed, never less
+static void check_dirty(const scope_frame_t *frame, const scope_rect_t *rect) {
+    for (uint32_t y = rect->y; y < rect->y + rect->height; ++y) {
+        for (uint32_t x = rect->x; x < rect->x + rect->width; ++x) {
+            bool covered = false;
+            for (uint32_t i = 0; i < frame->dirty_count && !covered; ++i) {
+                const scope_rect_t *dirty = &frame->dirty[i];
+                covered = x >= dirty->x && x < dirty->x + dirty->width && y >= dirty->y && y < dirty->y + dirty->height;
+            }
+            if (!CHECK(covered)) return;
+        }
+    }
+}
+#endif
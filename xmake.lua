@@ -9,8 +9,66 @@ if is_mode("debug") then
     set_policy("build.sanitizer.undefined", true)
 end
 
+-- Portable CPU implementation of the scope passes (no D3D11/Win32 dependencies)
+target("scope-core")
+    set_kind("static")
+    add_files("src/scope/*.c")
+    add_headerfiles("src/scope/*.h")
+    add_includedirs("src/scope", {public = true})
+    -- Bin indices must not depend on whether the compiler fuses multiply-adds
+    add_cflags("-ffp-contract=off")
+    if not is_plat("windows") then
+        add_syslinks("pthread", "m", {public = true})
+    end
+
+-- Found automatically when the X11, XShm and DAMAGE development files are installed
+option("x11")
+    set_showmenu(true)
+    set_description("Build the X11 MIT-SHM screen capture source")
+    add_links("Xdamage", "Xfixes", "Xext", "X11")
+    add_cincludes("X11/Xlib.h", "X11/extensions/XShm.h", "X11/extensions/Xdamage.h")
+option_end()
+
+target("scope-x11")
+    set_kind("static")
+    set_enabled(has_config("x11"))
+    add_deps("scope-core")
+    add_files("src/scope/x11/*.c")
+    add_headerfiles("src/scope/x11/*.h")
+    add_includedirs("src/scope/x11", {public = true})
+    add_defines("SCOPE_ENABLE_X11", {public = true})
+    add_syslinks("Xdamage", "Xfixes", "Xext", "X11", {public = true})
+
+target("scope-bench")
+    set_kind("binary")
+    add_deps("scope-core")
+    if has_config("x11") then
+        add_deps("scope-x11")
+    end
+    add_files("bench/*.c")
+
+-- Unit tests of scope-core: xmake run scope-test [name...]
+target("scope-test")
+    set_kind("binary")
+    add_deps("scope-core")
+    if has_config("x11") then
+        add_deps("scope-x11")
+    end
+    add_files("tests/*.c")
+    -- The reference formulas must round like the kernels they are checked against
+    add_cflags("-ffp-contract=off")
+
+-- Headless batch analysis of stills and image sequences, runs anywhere scope-core does
+target("chroma-scopes-cli")
+    set_kind("binary")
+    add_deps("scope-core")
+    add_includedirs("libs/stb")
+    add_files("cli/*.c")
+
 target("chroma-scopes")
     set_kind("binary")
+    set_enabled(is_plat("windows"))
+    add_deps("scope-core")
     add_includedirs("libs/stb")
     add_files("src/*.c")
     add_syslinks("d3d11", "d3dcompiler", "dxgi", "uuid", "dxguid", "shcore", "winmm", "gdi32")